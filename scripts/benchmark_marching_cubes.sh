@@ -0,0 +1,73 @@
+#!/usr/bin/env bash
+
+# This script benchmarks Marching Cubes surface meshing (via ConvertImageToMeshes) over a range of volume sizes.
+# A sphere occupying most of the volume is rasterized into synthetic images, and only the meshing operation is timed.
+#
+# Usage:
+#   ./benchmark_marching_cubes.sh [max_cores]
+#
+# If 'max_cores' is provided (and taskset is available), each volume is also meshed with 1, 2, 4, ... cores to
+# illustrate how slab-parallel meshing scales.
+
+set -eu
+
+DCMA_BIN="${DCMA_BIN:-dicomautomaton_dispatcher}"
+MAX_CORES="${1:-1}"
+
+if ! command -v "${DCMA_BIN}" &>/dev/null ; then
+    printf 'Unable to find "%s". Refusing to continue.\n' "${DCMA_BIN}" 1>&2
+    exit 1
+fi
+
+function mesh_volume {
+    local N_rows="$1"
+    local N_imgs="$2"
+    local cores="$3"
+
+    local c_x="$(( N_rows / 2 ))"
+    local c_z="$(( N_imgs / 2 ))"
+    local rad="$(( (N_imgs < N_rows ? N_imgs : N_rows) * 2 / 5 ))"
+
+    local pin=()
+    if [ "${cores}" != "all" ] && command -v taskset &>/dev/null ; then
+        pin=( taskset -c "0-$(( cores - 1 ))" )
+    fi
+
+    # Timestamp each line so the meshing step can be isolated from the set-up operations.
+    ${pin[@]+"${pin[@]}"} "${DCMA_BIN}" \
+      -o GenerateSyntheticImages \
+         -p NumberOfImages="${N_imgs}" \
+         -p NumberOfRows="${N_rows}" \
+         -p NumberOfColumns="${N_rows}" \
+         -p VoxelValue=0.0 \
+      -o ContourViaGeometry \
+         -p ROILabel=sphere \
+         -p Shapes="sphere(${c_x}, ${c_x}, ${c_z}, ${rad})" \
+      -o HighlightROIs \
+         -p ExteriorVal=0.0 \
+         -p InteriorVal=1.0 \
+      -o ConvertImageToMeshes \
+         -p Lower=0.5 \
+         -p Upper=1.5 \
+         -p Method=marching 2>&1 |
+      while IFS= read -r line ; do
+          printf '%s %s\n' "$(date +%s.%N)" "${line}"
+      done |
+      awk '/Performing operation .ConvertImageToMeshes. now/{ t0 = $1 } /triangulated surface has/{ t1 = $1 ; sub(/.*has /, "") ; m = $0 }
+           END { if(t0 && t1){ printf "%8.3f s   (%s)\n", t1 - t0, m }else{ print "failed" } }'
+}
+
+printf '%-18s %-6s %s\n' "rows x cols x imgs" "cores" "meshing time"
+for N in 64 128 256 512 ; do
+    N_imgs="$(( N / 2 ))"
+    cores=1
+    while [ "${cores}" -le "${MAX_CORES}" ] ; do
+        printf '%-18s %-6s ' "${N}x${N}x${N_imgs}" "${cores}"
+        mesh_volume "${N}" "${N_imgs}" "${cores}"
+        cores="$(( cores * 2 ))"
+    done
+    if [ "${MAX_CORES}" == "1" ] ; then
+        printf '%-18s %-6s ' "${N}x${N}x${N_imgs}" "all"
+        mesh_volume "${N}" "${N_imgs}" "all"
+    fi
+done
@@ -16,6 +16,10 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
 #ifdef DCMA_USE_EIGEN    
     #include <eigen3/Eigen/Dense>
     #include <eigen3/Eigen/Eigenvalues>
@@ -300,7 +304,43 @@ std::optional<affine_transform<double>>
 AlignViaExhaustiveICP( const point_set<double> & moving,
                        const point_set<double> & stationary,
                        long int max_icp_iters,
-                       double f_rel_tol ){
+                       double f_rel_tol,
+                       long int max_moving_points,
+                       long int resolution_levels ){
+
+    if(moving.points.empty() || stationary.points.empty()){
+        return std::nullopt;
+    }
+
+    // Index the stationary points once so that correspondence can be established with nearest-neighbour queries
+    // rather than a search over all stationary points.
+    using icp_point_t = boost::geometry::model::point<double, 3, boost::geometry::cs::cartesian>;
+    using icp_value_t = std::pair<icp_point_t, size_t>;
+    using icp_rtree_t = boost::geometry::index::rtree<icp_value_t, boost::geometry::index::rstar<16>>;
+
+    std::vector<icp_value_t> s_values;
+    s_values.reserve(stationary.points.size());
+    for(size_t i = 0; i < stationary.points.size(); ++i){
+        const auto &s_p = stationary.points[i];
+        s_values.emplace_back( icp_point_t(s_p.x, s_p.y, s_p.z), i );
+    }
+    const icp_rtree_t s_rtree(s_values.begin(), s_values.end()); // Bulk-loaded (packed), and read-only hereafter.
+
+    // Subsample the moving points by taking every n-th point.
+    //
+    // Point clouds derived from contours and images are spatially ordered, so regular striding retains coverage.
+    const auto subsample = [&](size_t N_target) -> point_set<double> {
+        const auto N = moving.points.size();
+        if( (N_target == 0) || (N <= N_target) ) return moving;
+
+        point_set<double> out;
+        out.points.reserve(N_target);
+        const auto stride = static_cast<double>(N) / static_cast<double>(N_target);
+        for(size_t i = 0; i < N_target; ++i){
+            out.points.push_back( moving.points[ static_cast<size_t>(stride * static_cast<double>(i)) ] );
+        }
+        return out;
+    };
 
     // The WIP transformation.
     affine_transform<double> t;
@@ -309,13 +349,9 @@ AlignViaExhaustiveICP( const point_set<double> & moving,
     affine_transform<double> t_best;
     double f_best = std::numeric_limits<double>::infinity();
 
-    // Compute the centroid for both point clouds.
+    // Compute the centroid for the stationary point cloud.
     const auto centroid_s = stationary.Centroid();
-    const auto centroid_m = moving.Centroid();
 
-    point_set<double> working(moving);
-    point_set<double> corresp(moving);
-    
     // Prime the transformation using a simplistic alignment.
     //
     // Note: The initial transformation will only be used to establish correspondence in the first iteration, so it
@@ -331,163 +367,188 @@ AlignViaExhaustiveICP( const point_set<double> & moving,
     // Fallback:
     //t = AlignViaCentroid(moving, stationary).value();
 
-    double f_prev = std::numeric_limits<double>::quiet_NaN();
-    for(long int icp_iter = 0; icp_iter < max_icp_iters; ++icp_iter){
-        // Copy the original points.
-        working.points = moving.points;
-
-        // Apply the current transformation to the working points.
-        t.apply_to(working);
-        const auto centroid_w = working.Centroid();
+    // Proceed from coarse to fine resolution. Each level uses 1/4 as many moving points as the next finer level, and
+    // is seeded with the best transformation found at the previous (coarser) level.
+    const auto N_levels = std::clamp<long int>(resolution_levels, 1L, 10L);
+    const auto N_finest = (0 < max_moving_points) ? std::min(static_cast<size_t>(max_moving_points), moving.points.size())
+                                                  : moving.points.size();
+    for(long int level = (N_levels - 1); 0 <= level; --level){
+        const auto N_level = std::max<size_t>(3UL, N_finest >> (2L * level));
+        const auto moving_l = subsample(N_level);
+        const auto centroid_m = moving_l.Centroid();
+        if(0 < level){
+            FUNCINFO("Performing ICP at resolution level " << level << " using " << moving_l.points.size() << " moving points");
+        }
 
-        // Exhaustively determine the correspondence between stationary and working points under the current
-        // transformation. Note that multiple working points may correspond to the same stationary point.
-        const auto N_working_points = working.points.size();
-        if(N_working_points != corresp.points.size()) throw std::logic_error("Encountered inconsistent working buffers. Cannot continue.");
-        {
-            asio_thread_pool tp;
-            for(size_t i = 0; i < N_working_points; ++i){
-                tp.submit_task([&,i]() -> void {
-                    const auto w_p = working.points[i];
-                    double min_sq_dist = std::numeric_limits<double>::infinity();
-                    for(const auto &s_p : stationary.points){
-                        const auto sq_dist = w_p.sq_dist(s_p);
-                        if(sq_dist < min_sq_dist){
-                            min_sq_dist = sq_dist;
-                            corresp.points[i] = s_p;
+        point_set<double> working(moving_l);
+        point_set<double> corresp(moving_l);
+
+        // Re-evaluate the cost at each level, since costs computed with different numbers of points are not comparable.
+        f_best = std::numeric_limits<double>::infinity();
+        t_best = t;
+
+        double f_prev = std::numeric_limits<double>::quiet_NaN();
+        for(long int icp_iter = 0; icp_iter < max_icp_iters; ++icp_iter){
+            // Copy the original points.
+            working.points = moving_l.points;
+
+            // Apply the current transformation to the working points.
+            t.apply_to(working);
+            const auto centroid_w = working.Centroid();
+
+            // Determine the correspondence between stationary and working points under the current transformation using
+            // nearest-neighbour queries. Note that multiple working points may correspond to the same stationary point.
+            const auto N_working_points = working.points.size();
+            if(N_working_points != corresp.points.size()) throw std::logic_error("Encountered inconsistent working buffers. Cannot continue.");
+            {
+                // Queries are cheap, so points are batched to amortize task overhead.
+                const size_t batch_size = 1024;
+                asio_thread_pool tp;
+                for(size_t i_begin = 0; i_begin < N_working_points; i_begin += batch_size){
+                    tp.submit_task([&,i_begin]() -> void {
+                        const auto i_end = std::min(N_working_points, i_begin + batch_size);
+                        std::vector<icp_value_t> nearest;
+                        for(size_t i = i_begin; i < i_end; ++i){
+                            const auto w_p = working.points[i];
+                            nearest.clear();
+                            s_rtree.query( boost::geometry::index::nearest(icp_point_t(w_p.x, w_p.y, w_p.z), 1),
+                                           std::back_inserter(nearest) );
+                            if(!nearest.empty()){
+                                corresp.points[i] = stationary.points[ nearest.front().second ];
+                            }
                         }
-                    }
-                }); // thread pool task closure.
-            }
-        } // Wait until all threads are done.
+                    }); // thread pool task closure.
+                }
+            } // Wait until all threads are done.
 
 
-        ///////////////////////////////////
+            ///////////////////////////////////
 
-        // Using the correspondence, estimate the linear transformation that will maximize alignment between
-        // centroid-shifted point clouds.
-        //
-        // Note: the transformation we seek here ignores translations by explicitly subtracting the centroid from each
-        // point cloud. Translations will be added into the full transformation later. 
-        const auto N_rows = 3;
-        const auto N_cols = N_working_points;
-        Eigen::MatrixXd S(N_rows, N_cols);
-        Eigen::MatrixXd M(N_rows, N_cols);
-
-        for(size_t i = 0; i < N_working_points; ++i){
-            // Note: Find the transform using the original point clouds (with a centroid shift) and the updated
-            // correspondence information.
-
-            S(0, i) = corresp.points[i].x - centroid_s.x; // The desired point location.
-            S(1, i) = corresp.points[i].y - centroid_s.y;
-            S(2, i) = corresp.points[i].z - centroid_s.z;
-
-            M(0, i) = moving.points[i].x - centroid_w.x; // The actual point location.
-            M(1, i) = moving.points[i].y - centroid_w.y;
-            M(2, i) = moving.points[i].z - centroid_w.z;
-        }
-        auto ST = S.transpose();
-        auto MST = M * ST;
-
-        //Eigen::JacobiSVD<Eigen::MatrixXd> SVD(MST, Eigen::ComputeThinU | Eigen::ComputeThinV);
-        Eigen::JacobiSVD<Eigen::MatrixXd> SVD(MST, Eigen::ComputeFullU | Eigen::ComputeFullV );
-        auto U = SVD.matrixU();
-        const auto& V = SVD.matrixV();
+            // Using the correspondence, estimate the linear transformation that will maximize alignment between
+            // centroid-shifted point clouds.
+            //
+            // Note: the transformation we seek here ignores translations by explicitly subtracting the centroid from each
+            // point cloud. Translations will be added into the full transformation later. 
+            const auto N_rows = 3;
+            const auto N_cols = N_working_points;
+            Eigen::MatrixXd S(N_rows, N_cols);
+            Eigen::MatrixXd M(N_rows, N_cols);
 
-        // Use the SVD result directly.
-        //
-        // Note that spatial inversions are permitted this way.
-        //auto A = U * V.transpose();
-
-        // Attempt to restrict to rotations only.    NOTE: Does not appear to work?
-        //Eigen::Matrix3d PI;
-        //PI << 1.0 , 0.0 , 0.0,
-        //      0.0 , 1.0 , 0.0,
-        //      0.0 , 0.0 , ( U * V.transpose() ).determinant();
-        //auto A = U * PI * V.transpose();
-
-        // Restrict the solution to rotations only. (Refer to the 'Kabsch algorithm' for more info.)
-        Eigen::Matrix3d PI;
-        PI << 1.0 , 0.0 , 0.0
-            , 0.0 , 1.0 , 0.0
-            , 0.0 , 0.0 , ( V * U.transpose() ).determinant();
-        auto A = V * PI * U.transpose();
-
-/*
-        // Apply the linear transformation to a point directly.
-        auto Apply_Rotation = [&](const vec3<double> &v) -> vec3<double> {
-            Eigen::Vector3f e_vec3(v.x, v.y, v.z);
-            auto new_v = A * e_vec3;
-            return vec3<double>( new_v(0), new_v(1), new_v(2) );
-        };
-*/
-
-        // Transfer the transformation into a full Affine transformation.
-        t = affine_transform<double>();
-
-        // Rotation and scaling components.
-        t.coeff(0,0) = A(0,0);
-        t.coeff(0,1) = A(1,0);
-        t.coeff(0,2) = A(2,0);
-
-        t.coeff(1,0) = A(0,1);
-        t.coeff(1,1) = A(1,1);
-        t.coeff(1,2) = A(2,1);
-
-        t.coeff(2,0) = A(0,2);
-        t.coeff(2,1) = A(1,2);
-        t.coeff(2,2) = A(2,2);
+            for(size_t i = 0; i < N_working_points; ++i){
+                // Note: Find the transform using the original point clouds (with a centroid shift) and the updated
+                // correspondence information.
 
-        // The complete transformation we have found for bringing the moving points $P_{M}$ into alignment with the
-        // stationary points is:
-        //
-        //   $centroid_{S} + A * \left( P_{M} - centroid_{M} \right)$.
-        //
-        // Rearranging, an Affine transformation of the form $A * P_{M} + b$ can be written as:
-        //
-        //   $A * P_{M} + \left( centroid_{S} - A * centroid_{M} \right)$.
-        // 
-        // Specifically, the transformed moving point cloud centroid component needs to be pre-subtracted for each
-        // vector $P_{M}$ to anticipate not having an explicit centroid subtraction step prior to applying the
-        // scale/rotation matrix.
-        {
-            Eigen::Vector3d e_centroid(centroid_m.x, centroid_m.y, centroid_m.z);
-            auto A_e_centroid = A * e_centroid; 
+                S(0, i) = corresp.points[i].x - centroid_s.x; // The desired point location.
+                S(1, i) = corresp.points[i].y - centroid_s.y;
+                S(2, i) = corresp.points[i].z - centroid_s.z;
 
-            t.coeff(3,0) = centroid_s.x - A_e_centroid(0);
-            t.coeff(3,1) = centroid_s.y - A_e_centroid(1);
-            t.coeff(3,2) = centroid_s.z - A_e_centroid(2);
-        }
+                M(0, i) = moving_l.points[i].x - centroid_w.x; // The actual point location.
+                M(1, i) = moving_l.points[i].y - centroid_w.y;
+                M(2, i) = moving_l.points[i].z - centroid_w.z;
+            }
+            auto ST = S.transpose();
+            auto MST = M * ST;
+
+            //Eigen::JacobiSVD<Eigen::MatrixXd> SVD(MST, Eigen::ComputeThinU | Eigen::ComputeThinV);
+            Eigen::JacobiSVD<Eigen::MatrixXd> SVD(MST, Eigen::ComputeFullU | Eigen::ComputeFullV );
+            auto U = SVD.matrixU();
+            const auto& V = SVD.matrixV();
+
+            // Use the SVD result directly.
+            //
+            // Note that spatial inversions are permitted this way.
+            //auto A = U * V.transpose();
+
+            // Attempt to restrict to rotations only.    NOTE: Does not appear to work?
+            //Eigen::Matrix3d PI;
+            //PI << 1.0 , 0.0 , 0.0,
+            //      0.0 , 1.0 , 0.0,
+            //      0.0 , 0.0 , ( U * V.transpose() ).determinant();
+            //auto A = U * PI * V.transpose();
+
+            // Restrict the solution to rotations only. (Refer to the 'Kabsch algorithm' for more info.)
+            Eigen::Matrix3d PI;
+            PI << 1.0 , 0.0 , 0.0
+                , 0.0 , 1.0 , 0.0
+                , 0.0 , 0.0 , ( V * U.transpose() ).determinant();
+            auto A = V * PI * U.transpose();
+
+    /*
+            // Apply the linear transformation to a point directly.
+            auto Apply_Rotation = [&](const vec3<double> &v) -> vec3<double> {
+                Eigen::Vector3f e_vec3(v.x, v.y, v.z);
+                auto new_v = A * e_vec3;
+                return vec3<double>( new_v(0), new_v(1), new_v(2) );
+            };
+    */
+
+            // Transfer the transformation into a full Affine transformation.
+            t = affine_transform<double>();
+
+            // Rotation and scaling components.
+            t.coeff(0,0) = A(0,0);
+            t.coeff(0,1) = A(1,0);
+            t.coeff(0,2) = A(2,0);
+
+            t.coeff(1,0) = A(0,1);
+            t.coeff(1,1) = A(1,1);
+            t.coeff(1,2) = A(2,1);
+
+            t.coeff(2,0) = A(0,2);
+            t.coeff(2,1) = A(1,2);
+            t.coeff(2,2) = A(2,2);
+
+            // The complete transformation we have found for bringing the moving points $P_{M}$ into alignment with the
+            // stationary points is:
+            //
+            //   $centroid_{S} + A * \left( P_{M} - centroid_{M} \right)$.
+            //
+            // Rearranging, an Affine transformation of the form $A * P_{M} + b$ can be written as:
+            //
+            //   $A * P_{M} + \left( centroid_{S} - A * centroid_{M} \right)$.
+            // 
+            // Specifically, the transformed moving point cloud centroid component needs to be pre-subtracted for each
+            // vector $P_{M}$ to anticipate not having an explicit centroid subtraction step prior to applying the
+            // scale/rotation matrix.
+            {
+                Eigen::Vector3d e_centroid(centroid_m.x, centroid_m.y, centroid_m.z);
+                auto A_e_centroid = A * e_centroid; 
+
+                t.coeff(3,0) = centroid_s.x - A_e_centroid(0);
+                t.coeff(3,1) = centroid_s.y - A_e_centroid(1);
+                t.coeff(3,2) = centroid_s.z - A_e_centroid(2);
+            }
 
-        // Evaluate whether the current transformation is sufficient. If so, terminate the loop.
-        working.points = moving.points;
-        t.apply_to(working);
-        double f_curr = 0.0;
-        for(size_t i = 0; i < N_working_points; ++i){
-            const auto w_p = working.points[i];
-            const auto c_p = corresp.points[i];
-            const auto dist = c_p.distance(w_p);
-            f_curr += dist;
-        }
+            // Evaluate whether the current transformation is sufficient. If so, terminate the loop.
+            working.points = moving_l.points;
+            t.apply_to(working);
+            double f_curr = 0.0;
+            for(size_t i = 0; i < N_working_points; ++i){
+                const auto w_p = working.points[i];
+                const auto c_p = corresp.points[i];
+                const auto dist = c_p.distance(w_p);
+                f_curr += dist;
+            }
 
-        FUNCINFO("Global distance using correspondence estimated during iteration " << icp_iter << " is " << f_curr);
+            FUNCINFO("Global distance using correspondence estimated during iteration " << icp_iter << " is " << f_curr);
 
-        if(f_curr < f_best){
-            f_best = f_curr;
-            t_best = t;
-        }
-        if( std::isfinite(f_rel_tol) 
-        &&  std::isfinite(f_curr)
-        &&  std::isfinite(f_prev) ){
-            const auto f_rel = std::fabs( (f_prev - f_curr) / f_prev );
-            FUNCINFO("The relative change in global distance compared to the last iteration is " << f_rel);
-            if(f_rel < f_rel_tol) break;
+            if(f_curr < f_best){
+                f_best = f_curr;
+                t_best = t;
+            }
+            if( std::isfinite(f_rel_tol) 
+            &&  std::isfinite(f_curr)
+            &&  std::isfinite(f_prev) ){
+                const auto f_rel = std::fabs( (f_prev - f_curr) / f_prev );
+                FUNCINFO("The relative change in global distance compared to the last iteration is " << f_rel);
+                if(f_rel < f_rel_tol) break;
+            }
+            f_prev = f_curr;
         }
-        f_prev = f_curr;
-    }
 
-    // Select the best transformation observed so far.
-    t = t_best;
+        // Select the best transformation observed so far.
+        t = t_best;
+    } // Resolution levels.
 
     // Test if the transformation is valid.
     vec3<double> v_test(1.0, 1.0, 1.0);
@@ -38,13 +38,20 @@ AlignViaPCA(const point_set<double> & moving,
 #ifdef DCMA_USE_EIGEN
 // This routine performs an exhaustive iterative closest point (ICP) alignment.
 //
+// Correspondence is established using nearest-neighbour queries against a spatial index of the stationary points.
+// Optionally, the moving points can be subsampled to at most 'max_moving_points' points (non-positive to disable),
+// and a coarse-to-fine schedule of 'resolution_levels' levels can be used, where each coarser level uses 1/4 as many
+// moving points and seeds the next finer level.
+//
 // Note that this routine only identifies a suitable transform, it does not implement it by altering the inputs.
 //
 std::optional<affine_transform<double>>
 AlignViaExhaustiveICP( const point_set<double> & moving,
                        const point_set<double> & stationary,
                        long int max_icp_iters = 100,
-                       double f_rel_tol = std::numeric_limits<double>::quiet_NaN() );
+                       double f_rel_tol = std::numeric_limits<double>::quiet_NaN(),
+                       long int max_moving_points = -1,
+                       long int resolution_levels = 1 );
 #endif // DCMA_USE_EIGEN
 
 
@@ -2,6 +2,7 @@
 
 #include <asio.hpp>
 #include <algorithm>
+#include <atomic>
 #include <optional>
 #include <fstream>
 #include <iterator>
@@ -16,12 +17,18 @@
 #include <utility>            //Needed for std::pair.
 #include <vector>
 
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
 #ifdef DCMA_USE_EIGEN    
     #include <eigen3/Eigen/Dense>
     #include <eigen3/Eigen/Eigenvalues>
     #include <eigen3/Eigen/SVD>
     #include <eigen3/Eigen/QR>
     #include <eigen3/Eigen/Cholesky>
+    #include <eigen3/Eigen/IterativeLinearSolvers>
 #endif
 
 #include "Structs.h"
@@ -321,7 +328,25 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     const auto N_move_points = static_cast<long int>(moving.points.size());
     const auto N_stat_points = static_cast<long int>(stationary.points.size());
 
-    thin_plate_spline t(moving, params.kernel_dimension);
+    // Select the TPS control points.
+    //
+    // Point clouds derived from contours and images are spatially ordered, so regular striding retains coverage.
+    std::vector<long int> ctrl_idx; // The moving point index of each control point.
+    if( (0 < params.N_control_points)
+    &&  (params.N_control_points < N_move_points) ){
+        const auto stride = static_cast<double>(N_move_points) / static_cast<double>(params.N_control_points);
+        for(long int k = 0; k < params.N_control_points; ++k){
+            ctrl_idx.push_back( static_cast<long int>(stride * static_cast<double>(k)) );
+        }
+        FUNCINFO("Using " << params.N_control_points << " of " << N_move_points << " moving points as control points");
+    }else{
+        for(long int i = 0; i < N_move_points; ++i) ctrl_idx.push_back(i);
+    }
+    const auto N_ctrl_points = static_cast<long int>(ctrl_idx.size());
+    point_set<double> ctrl_points;
+    for(const auto &i : ctrl_idx) ctrl_points.points.push_back( moving.points[i] );
+
+    thin_plate_spline t(ctrl_points, params.kernel_dimension);
 
     // Compute the centroid for the stationary point cloud.
     // Stationary point outliers will be assumed to have this location.
@@ -447,20 +472,25 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
 
     // Prepare working buffers.
     //
-    // Main system matrix.
-    Eigen::MatrixXd L = Eigen::MatrixXd::Zero(N_move_points + 4, N_move_points + 4);
+    // Main system matrix. Rows correspond to the moving points (followed by the four side conditions) and columns
+    // correspond to the control points (followed by the four affine terms). When all moving points are used as
+    // control points, this is the usual square, symmetric TPS system matrix.
+    Eigen::MatrixXd L = Eigen::MatrixXd::Zero(N_move_points + 4, N_ctrl_points + 4);
     // Corresponding points working buffer.
     Eigen::MatrixXd Y = Eigen::MatrixXd::Zero(N_move_points + 4, 3); 
-    // Identity matrix used for regularization.
-    Eigen::MatrixXd I_N4 = Eigen::MatrixXd::Identity(N_move_points + 4, N_move_points + 4);
-    // Weighting matrix needed for 'double-sided outlier handling' -- Yang et al. (2011).
-    Eigen::MatrixXd W;
-    if(params.double_sided_outliers){
-        W = Eigen::MatrixXd::Zero(N_move_points + 4, N_move_points + 4);
-    }
+    // Diagonal of the weighting matrix needed for 'double-sided outlier handling' -- Yang et al. (2011).
+    // When double-sided outlier handling is not used, the (implicit) weighting matrix is the identity.
+    Eigen::VectorXd W = Eigen::VectorXd::Ones(N_move_points);
 
-    // Corresponence matrix.
-    Eigen::MatrixXd M = Eigen::MatrixXd::Zero(N_move_points + 1, N_stat_points + 1);
+    // Correspondence matrix.
+    //
+    // The (N_move_points + 1) x (N_stat_points + 1) matrix is stored row-by-row as (column, coefficient) pairs sorted
+    // by column, so that the softassign can be truncated. Each moving point row ends with its stationary outlier
+    // 'gutter' coefficient. The final row (i.e., the moving outlier 'gutter' row) is always stored densely.
+    // Coefficients that are not stored are exactly zero.
+    using corr_row_t = std::vector<std::pair<long int, double>>;
+    std::vector<corr_row_t> M(N_move_points + 1);
+    const bool truncate_softassign = (0.0 < params.softassign_cutoff);
 
     // TPS model parameters.
     //
@@ -469,61 +499,59 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // Note: To avoid a later copy, these coefficients are directly mapped to the transform buffer.
     //
     // Note: These are the parameters that get updated during the transformation update phase.
-    if(static_cast<long int>(t.W_A.size()) != (N_move_points + 4) * 3){
+    if(static_cast<long int>(t.W_A.size()) != (N_ctrl_points + 4) * 3){
         throw std::logic_error("TPS coefficients allocated with incorrect size. Refusing to continue.");
     }
     Eigen::Map<Eigen::Matrix< double,
                               Eigen::Dynamic,
                               Eigen::Dynamic,
                               Eigen::ColMajor >> W_A(&(*(t.W_A.begin())),
-                                                     N_move_points + 4,  3);
+                                                     N_ctrl_points + 4,  3);
     if( (t.W_A.num_rows() != W_A.rows())
     ||  (t.W_A.num_cols() != W_A.cols()) ){
         throw std::logic_error("TPS coefficient matrix dimesions do not match. Refusing to continue.");
     }
 
-
-    Eigen::MatrixXd X(N_move_points, 4); // Stacked matrix of homogeneous moving set points.
-    Eigen::MatrixXd Z(N_move_points, 4); // Stacked matrix of corresponding homogeneous fixed set points.
-    Eigen::MatrixXd k(1, N_move_points); // TPS kernel vector.
-    Eigen::MatrixXd K(N_move_points, N_move_points); // TPS kernel matrix.
-
     // Populate static elements.
     //
     // L matrix: "K" kernel part.
     //
-    // Note: "K"s diagonals are later adjusted using the regularization parameter. They are set to zero initially.
-    for(long int i = 0; i < N_move_points; ++i) L(i, i) = 0.0;
-    for(long int i = 0; i < N_move_points; ++i){
-        const auto P_i = moving.points[i];
-        for(long int j = i + 1; j < N_move_points; ++j){
-            const auto P_j = moving.points[j];
-            const auto dist = P_i.distance(P_j);
-            const auto kij = t.eval_kernel(dist);
-            L(i, j) = kij;
-            L(j, i) = kij;
+    // Note: "K"s control point diagonals are later adjusted using the regularization parameter. They are zero
+    //       initially, since the kernel vanishes at zero separation.
+    t.eval_kernel(1.0); // Ensure the kernel is supported before evaluating it concurrently.
+    {
+        const long int batch_size = 64;
+        asio_thread_pool tp;
+        for(long int i_begin = 0; i_begin < N_move_points; i_begin += batch_size){
+            tp.submit_task([&,i_begin]() -> void {
+                const auto i_end = std::min(N_move_points, i_begin + batch_size);
+                for(long int i = i_begin; i < i_end; ++i){
+                    const auto P_i = moving.points[i];
+                    for(long int k = 0; k < N_ctrl_points; ++k){
+                        if(ctrl_idx[k] == i) continue;
+                        const auto dist = P_i.distance(ctrl_points.points[k]);
+                        L(i, k) = t.eval_kernel(dist);
+                    }
+                }
+            }); // thread pool task closure.
         }
-    }
+    } // Wait until all threads are done.
 
     // L matrix: "P" and "PT" parts.
     for(long int i = 0; i < N_move_points; ++i){
         const auto P_moving = moving.points[i];
-        L(i, N_move_points + 0) = 1.0;
-        L(i, N_move_points + 1) = P_moving.x;
-        L(i, N_move_points + 2) = P_moving.y;
-        L(i, N_move_points + 3) = P_moving.z;
-
-        L(N_move_points + 0, i) = 1.0;
-        L(N_move_points + 1, i) = P_moving.x;
-        L(N_move_points + 2, i) = P_moving.y;
-        L(N_move_points + 3, i) = P_moving.z;
+        L(i, N_ctrl_points + 0) = 1.0;
+        L(i, N_ctrl_points + 1) = P_moving.x;
+        L(i, N_ctrl_points + 2) = P_moving.y;
+        L(i, N_ctrl_points + 3) = P_moving.z;
+    }
+    for(long int k = 0; k < N_ctrl_points; ++k){
+        const auto P_ctrl = ctrl_points.points[k];
+        L(N_move_points + 0, k) = 1.0;
+        L(N_move_points + 1, k) = P_ctrl.x;
+        L(N_move_points + 2, k) = P_ctrl.y;
+        L(N_move_points + 3, k) = P_ctrl.z;
     }
- 
-    // Index matrix that only alters the "K" kernel part of L.
-    I_N4(N_move_points + 0, N_move_points + 0) = 0.0;
-    I_N4(N_move_points + 1, N_move_points + 1) = 0.0;
-    I_N4(N_move_points + 2, N_move_points + 2) = 0.0;
-    I_N4(N_move_points + 3, N_move_points + 3) = 0.0;
 
     // Prime the transformation with an identity affine component and no warp component.
     //
@@ -531,9 +559,9 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // temperature is sufficiently high then something like centroid-matching and PCA-alignment will naturally occur.
     // Conversely, if the temperature is set below the threshold required for global transformations, then only local
     // transformations (waprs) will occur; this may be what the user intends!
-    W_A(N_move_points + 1, 0) = 1.0; // x-component.
-    W_A(N_move_points + 2, 1) = 1.0; // y-component.
-    W_A(N_move_points + 3, 2) = 1.0; // z-component.
+    W_A(N_ctrl_points + 1, 0) = 1.0; // x-component.
+    W_A(N_ctrl_points + 2, 1) = 1.0; // y-component.
+    W_A(N_ctrl_points + 3, 2) = 1.0; // z-component.
 
     if(params.seed_with_centroid_shift){
         // Seed the affine transformation with the output from a simpler rigid registration.
@@ -543,9 +571,9 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             return std::nullopt;
         }
 
-        W_A(N_move_points + 0, 0) = t_com.value().read_coeff(3,0);
-        W_A(N_move_points + 0, 1) = t_com.value().read_coeff(3,1);
-        W_A(N_move_points + 0, 2) = t_com.value().read_coeff(3,2);
+        W_A(N_ctrl_points + 0, 0) = t_com.value().read_coeff(3,0);
+        W_A(N_ctrl_points + 0, 1) = t_com.value().read_coeff(3,1);
+        W_A(N_ctrl_points + 0, 2) = t_com.value().read_coeff(3,2);
     }
 
     // Invert the system matrix.
@@ -557,23 +585,81 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         L_pinv = L.completeOrthogonalDecomposition().pseudoInverse();
     }
 
+    // Pre-compute the normal equations.
+    //
+    // Regularization only alters the control point elements of L, so the regularized normal equations can be
+    // assembled cheaply at each iteration without re-multiplying the full system matrix:
+    //
+    //   (L + lambda*W*S)^T (L + lambda*W*S) = L^T L + lambda*(S^T W L + L^T W S) + lambda^2 S^T W^2 S,
+    //
+    // where S selects the control point elements.
+    //
+    // Note: only necessary for the LDLT and conjugate gradient methods.
+    Eigen::MatrixXd LtL;
+    Eigen::LDLT<Eigen::MatrixXd> LDLT_unregularized; // Factorized once, iff regularization is disabled.
+    long int N_CG_iters = 0; // Total conjugate gradient iterations, for reporting.
+    if( (params.solution_method == AlignViaTPSRPMParams::SolutionMethod::LDLT)
+    ||  (params.solution_method == AlignViaTPSRPMParams::SolutionMethod::ConjugateGradient) ){
+        LtL = L.transpose() * L;
+
+        if( (params.solution_method == AlignViaTPSRPMParams::SolutionMethod::LDLT)
+        &&  (std::abs(L_1_start) == 0.0) ){
+            LDLT_unregularized.compute(LtL);
+            if(LDLT_unregularized.info() != Eigen::Success){
+                throw std::runtime_error("Unable to update transformation: LDLT decomposition failed.");
+            }
+        }
+    }
+
+    // Index the stationary points so that truncated softassign candidates can be located without considering every
+    // stationary point.
+    using tps_point_t = boost::geometry::model::point<double, 3, boost::geometry::cs::cartesian>;
+    using tps_box_t = boost::geometry::model::box<tps_point_t>;
+    using tps_value_t = std::pair<tps_point_t, long int>;
+    using tps_rtree_t = boost::geometry::index::rtree<tps_value_t, boost::geometry::index::rstar<16>>;
+    tps_rtree_t s_rtree;
+    if(truncate_softassign){
+        std::vector<tps_value_t> s_values;
+        s_values.reserve(N_stat_points);
+        for(long int j = 0; j < N_stat_points; ++j){
+            const auto &s_p = stationary.points[j];
+            s_values.emplace_back( tps_point_t(s_p.x, s_p.y, s_p.z), j );
+        }
+        s_rtree = tps_rtree_t(s_values.begin(), s_values.end()); // Bulk-loaded (packed), and read-only hereafter.
+    }
+
     // Prime the correspondence matrix with uniform correspondence terms.
+    //
+    // Note: When the softassign is truncated, the stationary point coefficients are omitted. They are populated in
+    //       the first correspondence update.
     for(long int i = 0; i < N_move_points; ++i){ // row
-        for(long int j = 0; j < N_stat_points; ++j){ // column
-            M(i, j) = 1.0 / static_cast<double>(N_move_points);
+        if(!truncate_softassign){
+            M[i].reserve(N_stat_points + 1);
+            for(long int j = 0; j < N_stat_points; ++j){ // column
+                M[i].emplace_back(j, 1.0 / static_cast<double>(N_move_points));
+            }
         }
+        M[i].emplace_back(N_stat_points, 0.01 / static_cast<double>(N_move_points));
     }
     {
         const auto i = N_move_points; // row
+        M[i].reserve(N_stat_points + 1);
         for(long int j = 0; j < N_stat_points; ++j){ // column
-            M(i, j) = 0.01 / static_cast<double>(N_move_points);
+            M[i].emplace_back(j, 0.01 / static_cast<double>(N_move_points));
         }
+        M[i].emplace_back(N_stat_points, 0.0);
     }
-    for(long int i = 0; i < N_move_points; ++i){ // row
-        const auto j = N_stat_points; // column
-        M(i, j) = 0.01 / static_cast<double>(N_move_points);
+
+    // Identify which stationary points are subject to forced correspondence.
+    std::vector<uint8_t> forced_stat_points(N_stat_points, 0);
+    bool any_forced_stat_points = false;
+    for(const auto &apair : params.forced_correspondence){
+        const auto j_s = apair.second;
+        if(isininc(0, j_s, N_stat_points - 1)){
+            forced_stat_points[j_s] = 1;
+            any_forced_stat_points = true;
+        }
     }
-    M(N_move_points, N_stat_points) = 0.0;
 
     // Implement the user-provided forced correspondences, if any exist, by overwriting the correspondence matrix.
     //
@@ -581,6 +667,24 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     //       provide. Use of correspondence may require fine-tuning of the TPM-RPM algorithm parameters, especially the
     //       number of softassign iterations required.
     const auto implement_forced_correspondence = [&]() -> void {
+        // Zero-out rows and columns.
+        //
+        // Note: since forced correspondences are exclusive, all rows and columns can be zeroed before any of the
+        //       correspondence coefficients are placed.
+        for(const auto &apair : params.forced_correspondence){
+            const auto i_m = apair.first;
+            if( isininc(0, i_m, N_move_points - 1) ){
+                for(auto &c : M[i_m]) c.second = 0.0;
+            }
+        }
+        if(any_forced_stat_points){
+            for(auto &row : M){
+                for(auto &c : row){
+                    if( (c.first < N_stat_points) && (forced_stat_points[c.first] != 0) ) c.second = 0.0;
+                }
+            }
+        }
+
         for(const auto &apair : params.forced_correspondence){
             const auto i_m = apair.first;
             const auto j_s = apair.second;
@@ -589,22 +693,19 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             const auto i_is_valid = isininc(0, i_m, N_move_points - 1);
             const auto j_is_valid = isininc(0, j_s, N_stat_points - 1);
 
-            // Zero-out rows and columns.
-            if( i_is_valid ){
-                for(long int j = 0; j < (N_stat_points + 1); ++j){ // column
-                    M(i_m, j) = 0.0;
-                }
-            }
-            if( j_is_valid ){
-                for(long int i = 0; i < (N_move_points + 1); ++i){ // row
-                    M(i, j_s) = 0.0;
+            // Place the correspondence coefficient.
+            if( i_is_valid && j_is_valid ){
+                // The coefficient may not be present if the softassign is truncated.
+                auto &row = M[i_m];
+                auto it = std::lower_bound(std::begin(row), std::end(row), j_s,
+                                           [](const std::pair<long int, double> &c, long int j){ return c.first < j; });
+                if( (it == std::end(row)) || (it->first != j_s) ){
+                    it = row.insert(it, std::make_pair(j_s, 0.0));
                 }
+                it->second = 1.0;
             }
-
-            // Place the correspondence coefficient.
-            if( i_is_valid && j_is_valid )   M(i_m, j_s) = 1.0;
-            if( !i_is_valid && j_is_valid )  M(N_move_points, j_s) = 1.0;
-            if( i_is_valid && !j_is_valid )  M(i_m, N_stat_points) = 1.0;
+            if( !i_is_valid && j_is_valid )  M[N_move_points][j_s].second = 1.0;
+            if( i_is_valid && !j_is_valid )  M[i_m].back().second = 1.0;
         }
         return;
     };
@@ -622,12 +723,12 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         //       outlier coefficients does *not* seem to salvage the Sinkhorn method in these cases.
         if(!params.permit_move_outliers){
             for(long int i = 0; i < N_move_points; ++i){ // row
-                M(i, N_stat_points) = 0.0;
+                M[i].back().second = 0.0;
             }
         }
         if(!params.permit_stat_outliers){
             for(long int j = 0; j < N_stat_points; ++j){ // column
-                M(N_move_points, j) = 0.0;
+                M[N_move_points][j].second = 0.0;
             }
         }
 
@@ -637,14 +738,21 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     // Report the row- or column-sum (including outlier gutters, but only in the sum part) that deviates the most from
     // the normalization (i.e., every row and every column sums to one, except the row and column including the
     // bottom-right coefficient).
+    std::vector<double> col_sums(N_stat_points, 0.0);
     const auto worst_row_col_sum_deviation = [&]() -> double {
         double w = 0.0;
-        for(long int i = 0; i < N_move_points; ++i){
-            const auto ds = std::abs(M.row(i).sum() - 1.0);
-            if( w < ds ) w = ds;
+        std::fill(std::begin(col_sums), std::end(col_sums), 0.0);
+        for(long int i = 0; i < (N_move_points + 1); ++i){
+            double row_sum = 0.0;
+            for(const auto &c : M[i]){
+                row_sum += c.second;
+                if(c.first < N_stat_points) col_sums[c.first] += c.second;
+            }
+            const auto ds = std::abs(row_sum - 1.0);
+            if( (i < N_move_points) && (w < ds) ) w = ds;
         }
         for(long int j = 0; j < N_stat_points; ++j){
-            const auto ds = std::abs(M.col(j).sum() - 1.0);
+            const auto ds = std::abs(col_sums[j] - 1.0);
             if( w < ds ) w = ds;
         }
         return w;
@@ -656,29 +764,106 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     //
     // Note: This sub-routine implements a 'soft-assign' technique for evaluating the correspondence.
     //       It supports outliers in either point cloud set.
-    const auto update_correspondence = [&](double T_now, double s_reg) -> void {
-        // Non-outlier coefficients.
+    std::vector<vec3<double>> moved(N_move_points);
+    std::vector<Stats::Running_Sum<double>> col_sum_rss;
+    std::vector<double> col_scales(N_stat_points, 1.0); // Cumulative Sinkhorn column scale factors.
+    //
+    // Note: When warm-starting, failures are reported by returning false so that a cold start can be attempted.
+    const auto compute_correspondence = [&](double T_now, double s_reg, bool warm_start) -> bool {
+
+        // Transform the moving points.
+        //
+        // Note: exceptions cannot escape thread pool tasks, so failures are recorded and reported afterward.
+        std::atomic<bool> transform_failed(false);
+        {
+            const long int batch_size = 256;
+            asio_thread_pool tp;
+            for(long int i_begin = 0; i_begin < N_move_points; i_begin += batch_size){
+                tp.submit_task([&,i_begin]() -> void {
+                    const auto i_end = std::min(N_move_points, i_begin + batch_size);
+                    try{
+                        for(long int i = i_begin; i < i_end; ++i){
+                            moved[i] = t.transform(moving.points[i]);
+                        }
+                    }catch(const std::exception &){
+                        transform_failed.store(true);
+                    }
+                }); // thread pool task closure.
+            }
+        } // Wait until all threads are done.
+        if(transform_failed.load()){
+            throw std::runtime_error("Failed to evaluate TPS mapping function. Cannot continue.");
+        }
+
         Stats::Running_Sum<double> com_moved_x;
         Stats::Running_Sum<double> com_moved_y;
         Stats::Running_Sum<double> com_moved_z;
-        for(long int i = 0; i < N_move_points; ++i){ // row
-            const auto P_moving = moving.points[i];
-            const auto P_moved = t.transform(P_moving); // Transform the point.
-            com_moved_x.Digest(P_moved.x);
-            com_moved_y.Digest(P_moved.y);
-            com_moved_z.Digest(P_moved.z);
-            for(long int j = 0; j < N_stat_points; ++j){ // column
-                const auto P_stationary = stationary.points[j];
-                const auto dP = P_stationary - P_moved;
-                M(i, j) = (1.0 / T_now)
-                        * std::exp(s_reg / T_now)
-                        * std::exp( -dP.Dot(dP) / T_now);
-            }
+        for(long int i = 0; i < N_move_points; ++i){
+            com_moved_x.Digest(moved[i].x);
+            com_moved_y.Digest(moved[i].y);
+            com_moved_z.Digest(moved[i].z);
         }
         const vec3<double> com_moved( com_moved_x.Current_Sum() / static_cast<double>(N_move_points), 
                                       com_moved_y.Current_Sum() / static_cast<double>(N_move_points), 
                                       com_moved_z.Current_Sum() / static_cast<double>(N_move_points) );
 
+        // Non-outlier and stationary outlier coefficients.
+        //
+        // When the softassign is truncated, only stationary points within the cutoff distance are considered.
+        const double cutoff = params.softassign_cutoff * std::sqrt(T_now);
+        {
+            const long int batch_size = 64;
+            asio_thread_pool tp;
+            for(long int i_begin = 0; i_begin < N_move_points; i_begin += batch_size){
+                tp.submit_task([&,i_begin]() -> void {
+                    const auto i_end = std::min(N_move_points, i_begin + batch_size);
+                    std::vector<tps_value_t> candidates;
+                    for(long int i = i_begin; i < i_end; ++i){ // row
+                        const auto P_moved = moved[i];
+                        auto &row = M[i];
+                        row.clear();
+
+                        if(truncate_softassign){
+                            candidates.clear();
+                            const tps_box_t bbox( tps_point_t(P_moved.x - cutoff, P_moved.y - cutoff, P_moved.z - cutoff),
+                                                  tps_point_t(P_moved.x + cutoff, P_moved.y + cutoff, P_moved.z + cutoff) );
+                            s_rtree.query( boost::geometry::index::intersects(bbox), std::back_inserter(candidates) );
+                            for(const auto &c : candidates){
+                                const auto j = c.second;
+                                if(P_moved.sq_dist(stationary.points[j]) <= (cutoff * cutoff)) row.emplace_back(j, 0.0);
+                            }
+                            if(row.empty()){
+                                candidates.clear();
+                                s_rtree.query( boost::geometry::index::nearest(tps_point_t(P_moved.x, P_moved.y, P_moved.z), 1),
+                                               std::back_inserter(candidates) );
+                                for(const auto &c : candidates) row.emplace_back(c.second, 0.0);
+                            }
+                            std::sort(std::begin(row), std::end(row));
+
+                        }else{
+                            for(long int j = 0; j < N_stat_points; ++j) row.emplace_back(j, 0.0);
+                        }
+
+                        for(auto &c : row){ // column
+                            const auto P_stationary = stationary.points[c.first];
+                            const auto dP = P_stationary - P_moved;
+                            c.second = (1.0 / T_now)
+                                     * std::exp(s_reg / T_now)
+                                     * std::exp( -dP.Dot(dP) / T_now);
+                        }
+
+                        // Stationary outlier coefficient.
+                        {
+                            const auto& P_stationary = com_stat;
+                            const auto dP = P_stationary - P_moved;
+                            row.emplace_back(N_stat_points, (1.0 / T_start)
+                                                          * std::exp( -dP.Dot(dP) / T_start) );
+                        }
+                    }
+                }); // thread pool task closure.
+            }
+        } // Wait until all threads are done.
+
         // Moving outlier coefficients.
         {
             const auto i = N_move_points; // row
@@ -686,22 +871,11 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             for(long int j = 0; j < N_stat_points; ++j){ // column
                 const auto P_stationary = stationary.points[j];
                 const auto dP = P_stationary - P_moving; // Note: intentionally not transformed.
-                M(i, j) = (1.0 / T_start)
-                        * std::exp( -dP.Dot(dP) / T_start);
+                M[i][j].second = (1.0 / T_start)
+                               * std::exp( -dP.Dot(dP) / T_start);
             }
         }
 
-        // Stationary outlier coefficients.
-        for(long int i = 0; i < N_move_points; ++i){ // row
-            const auto P_moving = moving.points[i];
-            const auto P_moved = t.transform(P_moving); // Transform the point.
-            const auto j = N_stat_points; // column
-            const auto& P_stationary = com_stat;
-            const auto dP = P_stationary - P_moved;
-            M(i, j) = (1.0 / T_start)
-                    * std::exp( -dP.Dot(dP) / T_start);
-        }
-
         // Override forced correspondences and disable outlier detection (iff user specifies to do so).
         //
         // Note: Since the Skinhorn normalization procedure only modifies the coefficients via scaling (i.e.,
@@ -710,6 +884,19 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         implement_forced_correspondence();
         disable_outlier_detection();
 
+        // Warm-start the Sinkhorn procedure by re-applying the column scale factors from the previous normalization.
+        //
+        // Note: The normalized matrix has the form diag(r) * M * diag(c) for scale factors r and c that change only
+        //       slightly between iterations. The row scale factors need not be re-applied, since the first Sinkhorn step
+        //       normalizes the rows. Scaling cannot 'un-zero' coefficients, so hard constraints are unaffected.
+        if(warm_start){
+            for(auto &row : M){
+                for(auto &c : row){
+                    if(c.first < N_stat_points) c.second *= col_scales[c.first];
+                }
+            }
+        }
+
         // Normalize the rows and columns iteratively using the Sinkhorn procedure so that the non-outlier part of M
         // becomes doubly-stochastic.
         {
@@ -720,8 +907,8 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
                 // Tally the current row sums and re-scale the correspondence coefficients.
                 for(long int i = 0; i < N_move_points; ++i){ // row
                     Stats::Running_Sum<double> rs;
-                    for(long int j = 0; j < (N_stat_points+1); ++j){ // column
-                        rs.Digest( M(i,j) );
+                    for(const auto &c : M[i]){ // column
+                        rs.Digest( c.second );
                     }
                     const auto s = rs.Current_Sum();
                     if(s < machine_eps){
@@ -735,31 +922,38 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
                         //row_sums[i] += 1.0;
                         //M(i,N_stat_points) += 1.0;
                     }
-                    for(long int j = 0; j < (N_stat_points+1); ++j){ // column, intentionally ignoring the outlier coeff.
-                        M(i,j) /= s;
+                    for(auto &c : M[i]){ // column, intentionally ignoring the outlier coeff.
+                        c.second /= s;
                     }
                 }
 
                 // Tally the current column sums and re-scale the correspondence coefficients.
-                for(long int j = 0; j < N_stat_points; ++j){ // column
-                    Stats::Running_Sum<double> rs;
-                    for(long int i = 0; i < (N_move_points+1); ++i){ // row
-                        rs.Digest( M(i,j) );
+                col_sum_rss.assign(N_stat_points, Stats::Running_Sum<double>());
+                for(long int i = 0; i < (N_move_points+1); ++i){ // row
+                    for(const auto &c : M[i]){ // column
+                        if(c.first < N_stat_points) col_sum_rss[c.first].Digest( c.second );
                     }
-                    const auto s = rs.Current_Sum();
+                }
+                for(long int j = 0; j < N_stat_points; ++j){ // column
+                    const auto s = col_sum_rss[j].Current_Sum();
                     if(s < machine_eps){
                         // Option A: error.
                         //throw std::runtime_error("Unable to normalize row");
                         // Option B: forgo normalization.
                         // This might ruin the transform scaling, but it might also self-correct (n.b. verified below!).
+                        col_sums[j] = 1.0;
                         continue;
                         // Option C: nominate this point as an outlier.
                         // This may work, but I can't say for sure...
                         //col_sums[j] += 1.0;
                         //M(N_move_points,j) += 1.0;
                     }
-                    for(long int i = 0; i < (N_move_points+1); ++i){ // row, intentionally ignoring the outlier coeff.
-                        M(i,j) /= s;
+                    col_sums[j] = s;
+                    col_scales[j] /= s;
+                }
+                for(long int i = 0; i < (N_move_points+1); ++i){ // row, intentionally ignoring the outlier coeff.
+                    for(auto &c : M[i]){
+                        if(c.first < N_stat_points) c.second /= col_sums[c.first];
                     }
                 }
                 
@@ -773,12 +967,18 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
                 //
                 // Note: Uses *exact* floating-point equality for the most stringent stall check.
                 if(w == w_last){
+                    if(warm_start) return false;
                     throw std::runtime_error("Sinkhorn technique stalled. Unable to normalize correspondence matrix. Cannot continue.");
                 }
                 w_last = w;
+            }
+        }
 
-                //FUNCINFO("On normalization iteration " << norm_iter << " the mean col sum was " << Stats::Mean(col_sums));
-                //FUNCINFO("On normalization iteration " << norm_iter << " the mean row sum was " << Stats::Mean(row_sums));
+        // Discard any scale factors that have become extreme, which can happen for points that are (or were) outliers.
+        for(auto &x : col_scales){
+            if( !std::isfinite(x)
+            ||  !isininc(1.0E-100, x, 1.0E100) ){
+                x = 1.0;
             }
         }
 
@@ -790,13 +990,27 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         {
             const auto w = worst_row_col_sum_deviation();
             if(params.Sinkhorn_tolerance < w){
+                if(warm_start) return false;
                 throw std::runtime_error("Sinkhorn technique failed to normalize correspondence matrix. Consider more Sinkhorn iterations.");
             }
         }
 
-        if(!M.allFinite()){
-            throw std::runtime_error("Failed to compute coefficient matrix.");
+        for(const auto &row : M){
+            for(const auto &c : row){
+                if(!std::isfinite(c.second)){
+                    throw std::runtime_error("Failed to compute coefficient matrix.");
+                }
+            }
         }
+        return true;
+    };
+    const auto update_correspondence = [&](double T_now, double s_reg) -> void {
+        if(compute_correspondence(T_now, s_reg, params.Sinkhorn_warm_start)) return;
+
+        // Warm-starting can fail when a previously dominant column's scale factor suppresses it below the
+        // normalization threshold. Fall back to a cold start.
+        std::fill(std::begin(col_scales), std::end(col_scales), 1.0);
+        compute_correspondence(T_now, s_reg, false);
         return;
     };
 
@@ -805,11 +1019,11 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         for(long int i = 0; i < N_move_points; ++i){ // row
             double max_coeff = -(std::numeric_limits<double>::infinity());
             long int max_j = -1;
-            for(long int j = 0; j < (N_stat_points + 1); ++j){ // column
-                const auto m = M(i,j);
+            for(const auto &c : M[i]){ // column
+                const auto m = c.second;
                 if(max_coeff < m){
                     max_coeff = m;
-                    max_j = j;
+                    max_j = c.first;
                 }
             }
             if(!std::isfinite(max_coeff)){
@@ -818,20 +1032,22 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             params.final_move_correspondence.emplace_back( std::make_pair(i, max_j) );
         }
 
-        for(long int j = 0; j < N_stat_points; ++j){ // column
-            double max_coeff = -(std::numeric_limits<double>::infinity());
-            long int max_i = -1;
-            for(long int i = 0; i < (N_move_points + 1); ++i){ // row
-                const auto m = M(i,j);
-                if(max_coeff < m){
-                    max_coeff = m;
-                    max_i = i;
+        std::vector<double> max_coeffs(N_stat_points, -(std::numeric_limits<double>::infinity()));
+        std::vector<long int> max_is(N_stat_points, -1);
+        for(long int i = 0; i < (N_move_points + 1); ++i){ // row
+            for(const auto &c : M[i]){ // column
+                const auto j = c.first;
+                if( (j < N_stat_points) && (max_coeffs[j] < c.second) ){
+                    max_coeffs[j] = c.second;
+                    max_is[j] = i;
                 }
             }
-            if(!std::isfinite(max_coeff)){
+        }
+        for(long int j = 0; j < N_stat_points; ++j){ // column
+            if(!std::isfinite(max_coeffs[j])){
                 throw std::logic_error("Unable to estimate binary correspondence.");
             }
-            params.final_stat_correspondence.emplace_back( std::make_pair(max_i, j) );
+            params.final_stat_correspondence.emplace_back( std::make_pair(max_is[j], j) );
         }
 
         return;
@@ -850,8 +1066,8 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
                 //
                 // Note: The 'gutter' term is intentionally omitted here.
                 Stats::Running_Sum<double> col_sum_rs;
-                for(long int j = 0; j < N_stat_points; ++j){ // column
-                    col_sum_rs.Digest( M(i,j) );
+                for(const auto &c : M[i]){ // column
+                    if(c.first < N_stat_points) col_sum_rs.Digest( c.second );
                 }
                 col_sum_inv = 1.0 / col_sum_rs.Current_Sum();
                 if(!std::isfinite(col_sum_inv)){
@@ -860,19 +1076,20 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
                     // TODO: Come up with better way to deal with perfect outliers.
                     col_sum_inv = std::sqrt( std::numeric_limits<double>::max() );
                 }
-                W(i,i) = col_sum_inv;
+                W(i) = col_sum_inv;
             }
 
             Stats::Running_Sum<double> c_x;
             Stats::Running_Sum<double> c_y;
             Stats::Running_Sum<double> c_z;
-            for(long int j = 0; j < N_stat_points; ++j){ // column
-                const auto P_stationary = stationary.points[j];
+            for(const auto &c : M[i]){ // column
+                if(N_stat_points <= c.first) continue;
+                const auto P_stationary = stationary.points[c.first];
 
                 double weight = std::numeric_limits<double>::quiet_NaN();
                 if(params.double_sided_outliers){
                     // 'Double-sided outlier handling' approach from Yang et al (2011).
-                    weight = M(i,j) * col_sum_inv;
+                    weight = c.second * col_sum_inv;
                     if( !std::isfinite(weight)
                     ||  !isininc(0.0, weight, 1.0) ){
                         throw std::runtime_error("Encountered invalid weight. Is the point cloud degenerate? Refusing to continue.");
@@ -882,7 +1099,7 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
 
                 }else{
                     // Original formulation from Chui and Rangaran.
-                    weight = M(i,j);
+                    weight = c.second;
                 }
 
                 const auto weighted_P = P_stationary * weight;
@@ -895,20 +1112,19 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             Y(i, 2) = c_z.Current_Sum();
         }
 
+        // Note: Yang et al. (2011) suggest scaling lambda by N_stat_points when using double-sided outlier handling,
+        // but this is not done here for reasons of parity; the scale of the lambda regularization parameter seems to
+        // remain more comparable with the original algorithm.
+        const bool regularize = (std::abs(L_1_start) != 0.0);
+
         // Use pseudo-inverse method.
         if(params.solution_method == AlignViaTPSRPMParams::SolutionMethod::PseudoInverse){
             // Update the L matrix inverse using current regularization lambda.
-            if(std::abs(L_1_start) != 0.0){
-                Eigen::MatrixXd R;
-                if(params.double_sided_outliers){
-                    R = L + W * lambda; // * static_cast<double>(N_stat_points);
-                    // Note: Yang et al. (2011) suggest scaling lambda by N_stat_points, but this is not done here for
-                    // reasons of parity; the scale of the lambda regularization parameter seems to remain more
-                    // comparable with the original algorithm.
-                }else{
-                    R = L + I_N4 * lambda;
+            if(regularize){
+                Eigen::MatrixXd R = L;
+                for(long int k = 0; k < N_ctrl_points; ++k){
+                    R(ctrl_idx[k], k) += W(ctrl_idx[k]) * lambda;
                 }
-
                 L_pinv = R.completeOrthogonalDecomposition().pseudoInverse();
             }
             
@@ -920,31 +1136,55 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
             // Update W_A.
             W_A = L_pinv * Y;
 
-        // Use LDLT method.
-        }else if(params.solution_method == AlignViaTPSRPMParams::SolutionMethod::LDLT){
+        // Use LDLT or conjugate gradient methods, which both solve the normal equations.
+        }else if( (params.solution_method == AlignViaTPSRPMParams::SolutionMethod::LDLT)
+              ||  (params.solution_method == AlignViaTPSRPMParams::SolutionMethod::ConjugateGradient) ){
+            Eigen::MatrixXd RHS = L.transpose() * Y;
             Eigen::MatrixXd LHS;
-            if(std::abs(L_1_start) != 0.0){
-                if(params.double_sided_outliers){
-                    LHS = L + W * lambda; // * static_cast<double>(N_stat_points);
-                    // Note: Yang et al. (2011) suggest scaling lambda by N_stat_points, but this is not done here for
-                    // reasons of parity; the scale of the lambda regularization parameter seems to remain more
-                    // comparable with the original algorithm.
-                }else{
-                    LHS = L + I_N4 * lambda; // Regularized version of L.
+            if(regularize){
+                LHS = LtL;
+                for(long int k = 0; k < N_ctrl_points; ++k){
+                    const auto i = ctrl_idx[k];
+                    const auto wl = W(i) * lambda;
+                    LHS.row(k) += L.row(i) * wl;
+                    LHS.col(k) += L.row(i).transpose() * wl;
+                    LHS(k, k) += wl * wl;
+                    RHS.row(k) += Y.row(i) * wl;
                 }
-            }else{
-                LHS = L;
             }
-            
-            Eigen::LDLT<Eigen::MatrixXd> LDLT;
-            LDLT.compute(LHS.transpose() * LHS);
-            if(LDLT.info() != Eigen::Success){
-                throw std::runtime_error("Unable to update transformation: LDLT decomposition failed.");
-            }
-            
-            W_A = LDLT.solve(LHS.transpose() * Y);
-            if(LDLT.info() != Eigen::Success){
-                throw std::runtime_error("Unable to update transformation: LDLT solve failed.");
+
+            if(params.solution_method == AlignViaTPSRPMParams::SolutionMethod::LDLT){
+                Eigen::LDLT<Eigen::MatrixXd> LDLT_regularized;
+                if(regularize){
+                    LDLT_regularized.compute(LHS);
+                    if(LDLT_regularized.info() != Eigen::Success){
+                        throw std::runtime_error("Unable to update transformation: LDLT decomposition failed.");
+                    }
+                }
+                auto &LDLT = (regularize) ? LDLT_regularized : LDLT_unregularized;
+                
+                W_A = LDLT.solve(RHS);
+                if(LDLT.info() != Eigen::Success){
+                    throw std::runtime_error("Unable to update transformation: LDLT solve failed.");
+                }
+
+            }else{
+                // The previous solution is used as the initial guess. Only the correspondence and regularization change
+                // between iterations, and they change gradually, so few iterations are typically needed.
+                Eigen::ConjugateGradient<Eigen::MatrixXd, Eigen::Lower|Eigen::Upper> CG;
+                CG.setMaxIterations( (0 < params.CG_max_iters) ? params.CG_max_iters : (N_ctrl_points + 4) );
+                CG.setTolerance(params.CG_tolerance);
+                CG.compute( (regularize) ? LHS : LtL );
+                if(CG.info() != Eigen::Success){
+                    throw std::runtime_error("Unable to update transformation: conjugate gradient initialization failed.");
+                }
+
+                const Eigen::MatrixXd W_A_guess = W_A;
+                W_A = CG.solveWithGuess(RHS, W_A_guess);
+                if(CG.info() == Eigen::NumericalIssue){
+                    throw std::runtime_error("Unable to update transformation: conjugate gradient solve failed.");
+                }
+                N_CG_iters += CG.iterations();
             }
         }else{
             throw std::logic_error("Solution method not understood. Cannot continue.");
@@ -965,8 +1205,25 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
         // These will approach a binary state (min=0 and max=1) when the temperature is low.
         // Whether these are binary or not fully depends on the temperature, so they can be used to tweak the annealing
         // schedule.
-        const auto mean_row_min_coeff = M.rowwise().minCoeff().sum() / static_cast<double>( M.rows() );
-        const auto mean_row_max_coeff = M.rowwise().maxCoeff().sum() / static_cast<double>( M.rows() );
+        Stats::Running_Sum<double> row_min_coeffs;
+        Stats::Running_Sum<double> row_max_coeffs;
+        for(const auto &row : M){
+            double min_coeff = std::numeric_limits<double>::infinity();
+            double max_coeff = -(std::numeric_limits<double>::infinity());
+            for(const auto &c : row){
+                min_coeff = std::min(min_coeff, c.second);
+                max_coeff = std::max(max_coeff, c.second);
+            }
+            if(static_cast<long int>(row.size()) < (N_stat_points + 1)){
+                // Coefficients that are not stored are zero.
+                min_coeff = std::min(min_coeff, 0.0);
+                max_coeff = std::max(max_coeff, 0.0);
+            }
+            row_min_coeffs.Digest(min_coeff);
+            row_max_coeffs.Digest(max_coeff);
+        }
+        const auto mean_row_min_coeff = row_min_coeffs.Current_Sum() / static_cast<double>( M.size() );
+        const auto mean_row_max_coeff = row_max_coeffs.Current_Sum() / static_cast<double>( M.size() );
 
         FUNCINFO("Optimizer state: T = " << std::setw(12) << T_now 
                    << ", mean min,max corr coeffs = " << std::setw(12) << mean_row_min_coeff
@@ -987,19 +1244,24 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
     };
     const auto estimate_bending_energies = [&]() -> bending_energies {
 
+        // The kernel matrix evaluated between control points.
+        Eigen::MatrixXd K(N_ctrl_points, N_ctrl_points);
+        for(long int k = 0; k < N_ctrl_points; ++k){
+            K.row(k) = L.block(ctrl_idx[k],0, 1,N_ctrl_points);
+        }
+
         // Compute (approximate) bending energy.
-        const auto E_x = (  W_A.block(0,0, N_move_points,1).transpose()
-                            * L.block(0,0, N_move_points,N_move_points) 
-                            * W_A.block(0,0, N_move_points,1) ).sum();
-        const auto E_y = (  W_A.block(0,1, N_move_points,1).transpose()
-                            * L.block(0,0, N_move_points,N_move_points) 
-                            * W_A.block(0,1, N_move_points,1) ).sum();
-        const auto E_z = (  W_A.block(0,2, N_move_points,1).transpose()
-                            * L.block(0,0, N_move_points,N_move_points) 
-                            * W_A.block(0,2, N_move_points,1) ).sum();
+        const auto E_x = (  W_A.block(0,0, N_ctrl_points,1).transpose()
+                            * K
+                            * W_A.block(0,0, N_ctrl_points,1) ).sum();
+        const auto E_y = (  W_A.block(0,1, N_ctrl_points,1).transpose()
+                            * K
+                            * W_A.block(0,1, N_ctrl_points,1) ).sum();
+        const auto E_z = (  W_A.block(0,2, N_ctrl_points,1).transpose()
+                            * K
+                            * W_A.block(0,2, N_ctrl_points,1) ).sum();
         return bending_energies{ E_x, E_y, E_z };
     };
-
 /*
     // Debugging routine....
     const auto write_to_xyz_file = [&](const std::string &base){
@@ -1047,6 +1309,9 @@ AlignViaTPSRPM(AlignViaTPSRPMParams & params,
 
     // Report final fit parameters to the user.
     {
+        if(params.solution_method == AlignViaTPSRPMParams::SolutionMethod::ConjugateGradient){
+            FUNCINFO("Conjugate gradient solver required " << N_CG_iters << " iterations in total");
+        }
         const auto E = estimate_bending_energies();
         const double E_sum = E.x + E.y + E.z;
         FUNCINFO("Final bending energy is propto " << E_sum << " with " << E.x << " from x, " << E.y << " from y, and " << E.z << " from z");
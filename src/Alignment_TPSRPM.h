@@ -107,6 +107,12 @@ struct AlignViaTPSRPMParams {
     // iterations, then the algorithm terminates due to failure.
     double Sinkhorn_tolerance = 0.01;
 
+    // Whether to warm-start the Sinkhorn procedure using the row and column scale factors from the previous
+    // correspondence update. The correspondence changes only gradually during annealing, so warm-starting can
+    // drastically reduce the number of Sinkhorn iterations needed. Note that the normalized correspondence will differ
+    // (by no more than the tolerance) from that of a cold start.
+    bool Sinkhorn_warm_start = false;
+
     // Regularization parameters.
     //
     // Controls the smoothness of the fitted thin plate spline function.
@@ -141,13 +147,39 @@ struct AlignViaTPSRPMParams {
     //
     // The method used to solve the system of linear equtions that defines the thin plate spline solution.
     // The pseudoinverse will likely be able to provide a solution when the system is degenerate, but it might not be
-    // reasonable.
+    // reasonable. The conjugate gradient method is iterative and is warm-started with the previous solution, which
+    // changes only slightly between iterations, so it is well suited to large systems.
     enum class SolutionMethod {
         PseudoInverse,
-        LDLT
+        LDLT,
+        ConjugateGradient
     };
     SolutionMethod solution_method = SolutionMethod::LDLT;
 
+    // Conjugate gradient solver parameters. The tolerance is relative to the norm of the right-hand side. The maximum
+    // number of iterations is per solve; if zero or negative, the system dimension is used.
+    long int CG_max_iters = 0;
+    double CG_tolerance = 1.0E-8;
+
+    // Scalability parameters.
+    //
+    // The number of moving points to use as TPS control points. If fewer than the number of moving points, a regularly
+    // spaced subset of the moving points is used and the spline is fitted to all moving points in a least-squares
+    // sense. This low-rank kernel approximation shrinks the system matrix from (N+4)x(N+4) to (N+4)x(C+4) and the
+    // linear solve from O(N^3) to O(N*C^2). If zero or negative, all moving points are used (i.e., the exact TPS).
+    //
+    // Note that the resulting transformation will only contain the control points.
+    long int N_control_points = 0;
+
+    // Truncation distance for the softassign correspondence, in units of sqrt(T). Correspondence coefficients decay
+    // like exp(-d^2/T), so pairs farther apart than this distance are negligible and are treated as exactly zero. The
+    // candidate pairs are located using a spatial index, and the correspondence is stored sparsely, which avoids
+    // O(N*M) work and storage once the temperature has cooled. A value of 3 discards coefficients below ~1E-4 of the
+    // largest possible coefficient. If zero or negative, the full (dense) correspondence is used.
+    //
+    // Note: every moving point retains at least its nearest stationary point as a candidate.
+    double softassign_cutoff = 0.0;
+
     // Algorithm-altering parameters.
     //
     // Seed the initial transformation with the result of a rigid centroid-to-centroid shift transformation. The default
@@ -52,6 +52,9 @@ int main(int argc, char* argv[]){
     drover_serial_func_name_mapping["txt"] = Common_Boost_Serialize_Drover_to_Simple_Text;
     drover_serial_func_name_mapping["xml"] = Common_Boost_Serialize_Drover_to_XML;
 
+    drover_serial_func_name_mapping["mapped"] = Common_Boost_Serialize_Drover_to_Mapped;
+    drover_serial_func_name_mapping["mapped-gzip"] = Common_Boost_Serialize_Drover_to_Mapped_Gzip;
+
     Drover DICOM_data;
 
     
@@ -75,7 +78,11 @@ int main(int argc, char* argv[]){
                        { "-i file.xml.gz -o file.bin -t 'binary'",
                          "Convert to a binary file." },
                        { "-i file.xml.gz -o file.bin.gz -t 'gzip-binary'",
-                         "Convert to a gzipped binary file." }
+                         "Convert to a gzipped binary file." },
+                       { "-i file.xml.gz -o file.dcma -t 'mapped'",
+                         "Convert to a memory-mapped archive with uncompressed pixel data, which loads quickly." },
+                       { "-i file.dcma -o file.xml.gz -t 'gzip-xml'",
+                         "Convert a memory-mapped archive to a portable gzipped text XML file." }
                      };
     arger.description = "A program for converting Boost.Serialization archives types which DICOMautomaton can read.";
 
@@ -105,7 +112,7 @@ int main(int argc, char* argv[]){
     );
 
     arger.push_back( ygor_arg_handlr_t(2, 't', "output-type", true, ConvertTo,
-      "The format to convert to. Supported: gzip-binary, gzip-txt, gzip-xml, binary, txt, xml.",
+      "The format to convert to. Supported: gzip-binary, gzip-txt, gzip-xml, binary, txt, xml, mapped, mapped-gzip.",
       [&](const std::string &optarg) -> void {
         ConvertTo = optarg;
         return;
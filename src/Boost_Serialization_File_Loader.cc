@@ -23,6 +23,9 @@ bool Load_From_Boost_Serialization_Files( Drover &DICOM_data,
     // Note: This routine returns false only iff a file is suspected of being suited for this loader, but could not be
     //       loaded (e.g., the file seems appropriate, but a parsing failure was encountered).
     //
+    // Note: Memory-mapped archives are also recognized. Their pixel data is read directly from the mapping, which is
+    //       considerably faster than parsing the other archive types.
+    //
     if(Filenames.empty()) return true;
 
     std::list<boost::filesystem::path> Filenames_Copy(Filenames);
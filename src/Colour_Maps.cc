@@ -1,7 +1,15 @@
 //Colour_Maps.cc - A part of DICOMautomaton 2017. Written by hal clark.
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
 #include <optional>
+#include <stdexcept>
+#include <type_traits>
 
 #include "Colour_Maps.h"
 #include "YgorMath.h"
@@ -16974,7 +16982,7 @@ ClampedColourRGB ColourMap_(double y){
 std::optional<ClampedColourRGB> Colour_from_name(const std::string& n){
     const auto cn = Canonicalize_String2(n, CANONICALIZE::TO_LOWER | CANONICALIZE::TRIM_ALL | CANONICALIZE::TO_AZ);
 
-    std::map<std::string, ClampedColourRGB> colours {
+    const static std::map<std::string, ClampedColourRGB> colours {
             // Basic colours.
             //{ "red",                           { 1.000, 0.000, 0.000 } },
             //{ "green",                         { 0.000, 1.000, 0.000 } },
@@ -17922,5 +17930,90 @@ std::optional<ClampedColourRGB> Colour_from_name(const std::string& n){
 }
 
 
+colour_map_lut::colour_map_lut(const std::function<ClampedColourRGB(double)> &colour_map){
+    const auto to_byte = [](double x) -> uint8_t {
+        const auto y = std::floor(x * 255.0);
+        return static_cast<uint8_t>( std::isfinite(y) ? std::clamp(y, 0.0, 255.0) : 0.0 );
+    };
+
+    this->rgba.resize(N_entries * 4);
+    for(long int i = 0; i < N_entries; ++i){
+        const auto c = colour_map( static_cast<double>(i) / static_cast<double>(N_entries - 1) );
+        this->rgba[i * 4 + 0] = to_byte(c.R);
+        this->rgba[i * 4 + 1] = to_byte(c.G);
+        this->rgba[i * 4 + 2] = to_byte(c.B);
+        this->rgba[i * 4 + 3] = 255;
+    }
+}
+
+void Colourize_Values(const float *vals,
+                      size_t N,
+                      size_t stride,
+                      double win_low,
+                      double win_high,
+                      const colour_map_lut &lut,
+                      const std::array<uint8_t, 4> &nan_colour,
+                      uint8_t *out,
+                      long int N_out_channels){
+    if( (N_out_channels != 3) && (N_out_channels != 4) ){
+        throw std::invalid_argument("Only RGB8 and RGBA8 outputs are supported.");
+    }
+    if(static_cast<long int>(lut.rgba.size()) != (colour_map_lut::N_entries * 4)){
+        throw std::invalid_argument("Colour map lookup table is not valid.");
+    }
+
+    // The window is converted to a scale so that the inner loop is simple branchless arithmetic. A degenerate window
+    // uses an effectively infinite scale, mapping values at or below the window to the lowest colour and values above
+    // the window to the highest colour.
+    const float top = static_cast<float>(colour_map_lut::N_entries - 1);
+    const float w_low = static_cast<float>(win_low);
+    const float scale = (win_low < win_high) ? static_cast<float>( static_cast<double>(top) / (win_high - win_low) )
+                                             : std::numeric_limits<float>::max();
+
+    // The NaN colour is appended to a copy of the table so that every value resolves to a table entry.
+    std::vector<uint8_t> table(lut.rgba);
+    table.insert(std::end(table), std::begin(nan_colour), std::end(nan_colour));
+    const uint8_t *entries = table.data();
+    const auto nan_entry = static_cast<int32_t>(colour_map_lut::N_entries);
 
+    // Values are processed in blocks. Table indices are computed first, which vectorizes well, and then colours are
+    // gathered from the table. The loops are instantiated separately for the common contiguous case and for each
+    // output format so that strides and copy sizes are known at compile time.
+    const auto colourize = [&](auto v_stride, auto n_out) -> void {
+        constexpr size_t block_size = 1024;
+        std::array<int32_t, block_size> ks;
+        for(size_t b = 0; b < N; b += block_size){
+            const size_t n_b = std::min(block_size, N - b);
+            const float *v_b = vals + b * v_stride;
+            for(size_t i = 0; i < n_b; ++i){
+                const float v = v_b[i * v_stride];
+                const float t = std::min(top, std::max(0.0f, (v - w_low) * scale + 0.5f)); // Note: maps NaN to zero.
+                const auto k = static_cast<int32_t>(t);
+                const auto is_finite = static_cast<int32_t>(std::abs(v) <= std::numeric_limits<float>::max());
+                ks[i] = k + (1 - is_finite) * (nan_entry - k);
+            }
+            uint8_t *o_b = out + b * n_out;
+            for(size_t i = 0; i < n_b; ++i){
+                std::memcpy(o_b + i * n_out, entries + static_cast<size_t>(ks[i]) * 4, n_out);
+            }
+        }
+    };
+    using rgb8 = std::integral_constant<size_t, 3>;
+    using rgba8 = std::integral_constant<size_t, 4>;
+    using contiguous = std::integral_constant<size_t, 1>;
+    if(stride == 1){
+        if(N_out_channels == 4){
+            colourize(contiguous(), rgba8());
+        }else{
+            colourize(contiguous(), rgb8());
+        }
+    }else{
+        if(N_out_channels == 4){
+            colourize(stride, rgba8());
+        }else{
+            colourize(stride, rgb8());
+        }
+    }
+    return;
+}
 
@@ -2,8 +2,13 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <optional>
 #include <string>
+#include <vector>
 
 
 struct ClampedColourRGB {
@@ -46,3 +51,32 @@ ClampedColourRGB ColourMap_Composite_50_90_100_107_110(double y);
 //This function takes a named colour and map it to a colour specified in terms of R,G,B all within [0,1].
 std::optional<ClampedColourRGB> Colour_from_name(const std::string& n);
 
+
+//This class tabulates a colour map at uniformly-spaced points spanning [0,1] so that many values can be colourized
+// without evaluating the colour map for each one. Colours are pre-quantized to 8 bits, so this is suitable for display
+// purposes only.
+class colour_map_lut {
+    public:
+        static constexpr long int N_entries = 4096;
+
+        std::vector<uint8_t> rgba; // Packed RGBA8 colours, N_entries * 4 bytes. Alpha is always opaque.
+
+        explicit colour_map_lut(const std::function<ClampedColourRGB(double)> &colour_map);
+};
+
+//This function colourizes N values, linearly mapping the window [win_low, win_high] onto the colour map. Values outside
+// the window are clamped to the window edges, and non-finite values are assigned nan_colour (RGBA8).
+//
+// Values are read with the given stride, so a single channel can be selected from interleaved multi-channel data.
+// Packed colours are written contiguously to 'out', which must have room for N * N_out_channels bytes. N_out_channels
+// must be 3 (RGB8) or 4 (RGBA8).
+void Colourize_Values(const float *vals,
+                      size_t N,
+                      size_t stride,
+                      double win_low,
+                      double win_high,
+                      const colour_map_lut &lut,
+                      const std::array<uint8_t, 4> &nan_colour,
+                      uint8_t *out,
+                      long int N_out_channels);
+
@@ -17,12 +17,26 @@
 //#include <boost/iostreams/filter/zlib.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/stream.hpp>
 #include <boost/math/special_functions/nonfinite_num_facets.hpp>
 #include <boost/serialization/nvp.hpp>
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <exception>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>    
 #include <utility>
+#include <vector>
 
 #include "Common_Boost_Serialization.h"
 //#include "YgorMathChebyshevIOBoostSerialization.h"
@@ -35,6 +49,8 @@
 
 #include "Structs.h"
 #include "StructsIOBoostSerialization.h"
+#include "Thread_Pool.h"
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 
 namespace boost {
 namespace iostreams {
@@ -43,6 +59,62 @@ struct output;
 }  // namespace boost
 
 
+// Memory-mapped archives.
+//
+// File layout (all integers are native-endian):
+//
+//   [ preamble, padded to a page ][ pixel block ]...[ pixel block ][ header ][ block table ]
+//
+// The preamble identifies the file and locates the header and block table. The header is a binary Boost.Serialization
+// archive of the Drover with all image pixel data removed. Every image (in the order images appear in the header)
+// has exactly one entry in the block table. Each pixel block begins on a page boundary so it can be read directly
+// from a memory mapping.
+
+namespace {
+
+const std::array<char, 8> mapped_archive_magic = {{ 'D', 'C', 'M', 'A', 'M', 'A', 'P', '1' }};
+constexpr uint64_t mapped_archive_page_size = 4096;
+
+struct mapped_archive_preamble {
+    std::array<char, 8> magic;
+    uint64_t header_offset;
+    uint64_t header_size;
+    uint64_t table_offset;
+    uint64_t block_count;
+};
+static_assert(sizeof(mapped_archive_preamble) == 40, "Unexpected padding in the archive preamble");
+
+enum class mapped_block_encoding : uint32_t {
+    raw  = 0,
+    gzip = 1,
+};
+
+struct mapped_block_entry {
+    uint64_t offset;
+    uint64_t stored_size;
+    uint64_t raw_size;
+    uint32_t encoding;
+    uint32_t reserved;
+};
+static_assert(sizeof(mapped_block_entry) == 32, "Unexpected padding in the archive block table");
+
+// Distinct image arrays in the order they are (first) encountered, which is the order Boost.Serialization emits them.
+std::vector<std::shared_ptr<Image_Array>>
+distinct_image_arrays(const Drover &d){
+    std::vector<std::shared_ptr<Image_Array>> out;
+    std::set<const Image_Array*> seen;
+    for(const auto &ia : d.image_data){
+        if( (ia != nullptr)
+        &&  seen.insert(ia.get()).second ){
+            out.emplace_back(ia);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+
 bool
 Common_Boost_Serialize_Drover(const Drover &in,
                               boost::filesystem::path Filename){
@@ -77,6 +149,8 @@ Common_Boost_Deserialize_Drover(Drover &out,
     // This routine will try opening the file multiple times until the correct combination (if any) 
     // is found. The most anticipated combinations are therefore first.
     //
+    // Memory-mapped archives are recognized by their leading magic string and are handled separately.
+    //
     // NOTE: By default, Boost.Serialize cannot deserialize NaN or +-Inf in text or xml. If you try, you get
     //       an unspecific invalid_input_stream exception with description: 'input stream error'. A 
     //       workaround is implemented here that uses Boost.Math locale facets to coax native reading and
@@ -93,6 +167,16 @@ Common_Boost_Deserialize_Drover(Drover &out,
         if(length == 0) return false;
     }
 
+    //Memory-mapped archive. These are identified by a leading magic string, so they can be detected cheaply.
+    {
+        std::ifstream fi(Filename.string(), std::ios::binary);
+        std::array<char, 8> magic {};
+        if( fi.read(magic.data(), magic.size())
+        &&  (magic == mapped_archive_magic) ){
+            return Common_Boost_Deserialize_Drover_from_Mapped(out, Filename);
+        }
+    }
+
     //XML, gzip compression.
     try{
         std::ifstream ifs(Filename.string(), std::ios::in | std::ios::binary);
@@ -315,6 +399,255 @@ Common_Boost_Serialize_Drover_to_XML(const Drover &in,
 }
 
 
+//------------------
+
+namespace {
+
+bool
+Serialize_Drover_to_Mapped(const Drover &in,
+                           const boost::filesystem::path& Filename,
+                           mapped_block_encoding encoding){
+
+    try{
+        //Assemble a header Drover. Everything is shared except image arrays, which are replaced with copies that lack
+        // pixel data. Sharing among image arrays is preserved.
+        Drover h;
+        h.contour_data = in.contour_data;
+        h.point_data   = in.point_data;
+        h.smesh_data   = in.smesh_data;
+        h.tplan_data   = in.tplan_data;
+        h.lsamp_data   = in.lsamp_data;
+        h.trans_data   = in.trans_data;
+
+        std::vector<const planar_image<float,double>*> payloads;
+        std::map<const Image_Array*, std::shared_ptr<Image_Array>> stripped;
+        for(const auto &ia : in.image_data){
+            if(ia == nullptr){
+                h.image_data.emplace_back();
+                continue;
+            }
+            auto &s = stripped[ia.get()];
+            if(s == nullptr){
+                s = std::make_shared<Image_Array>();
+                for(const auto &img : ia->imagecoll.images){
+                    s->imagecoll.images.emplace_back(img);
+                    std::vector<float>().swap(s->imagecoll.images.back().data);
+                    payloads.emplace_back(&img);
+                }
+            }
+            h.image_data.emplace_back(s);
+        }
+
+        std::ofstream ofs(Filename.string(), std::ios::trunc | std::ios::binary);
+        if(!ofs) return false;
+
+        const auto pad_to = [&](uint64_t boundary) -> uint64_t {
+            const auto pos = static_cast<uint64_t>(ofs.tellp());
+            const auto rem = pos % boundary;
+            if(rem != 0){
+                const std::string zeros(boundary - rem, '\0');
+                ofs.write(zeros.data(), zeros.size());
+            }
+            return static_cast<uint64_t>(ofs.tellp());
+        };
+
+        //Reserve space for the preamble; it is written last.
+        mapped_archive_preamble pre {};
+        pre.magic = mapped_archive_magic;
+        ofs.write(reinterpret_cast<const char*>(&pre), sizeof(pre));
+
+        //Pixel blocks.
+        std::vector<mapped_block_entry> table;
+        table.reserve(payloads.size());
+        for(const auto &img_ptr : payloads){
+            mapped_block_entry e {};
+            e.offset = pad_to(mapped_archive_page_size);
+            e.raw_size = static_cast<uint64_t>(img_ptr->data.size() * sizeof(float));
+            e.encoding = static_cast<uint32_t>(encoding);
+
+            const auto raw = reinterpret_cast<const char*>(img_ptr->data.data());
+            if(encoding == mapped_block_encoding::gzip){
+                std::string compressed;
+                {
+                    boost::iostreams::filtering_ostream os;
+                    boost::iostreams::gzip_params gzparams(boost::iostreams::gzip::best_speed);
+                    os.push(boost::iostreams::gzip_compressor(gzparams));
+                    os.push(boost::iostreams::back_inserter(compressed));
+                    os.write(raw, e.raw_size);
+                }
+                e.stored_size = static_cast<uint64_t>(compressed.size());
+                ofs.write(compressed.data(), compressed.size());
+            }else{
+                e.stored_size = e.raw_size;
+                ofs.write(raw, e.raw_size);
+            }
+            table.emplace_back(e);
+        }
+
+        //Header.
+        {
+            std::ostringstream ss(std::ios::out | std::ios::binary);
+            {
+                boost::archive::binary_oarchive ar(ss);
+                ar & boost::serialization::make_nvp("dicom_data", static_cast<const Drover &>(h));
+            }
+            const auto header = ss.str();
+            pre.header_offset = pad_to(8);
+            pre.header_size = static_cast<uint64_t>(header.size());
+            ofs.write(header.data(), header.size());
+        }
+
+        //Block table.
+        pre.table_offset = pad_to(8);
+        pre.block_count = static_cast<uint64_t>(table.size());
+        ofs.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(mapped_block_entry));
+
+        ofs.seekp(0);
+        ofs.write(reinterpret_cast<const char*>(&pre), sizeof(pre));
+        ofs.flush();
+        if(!ofs) return false;
+
+    }catch(const std::exception &e){
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+
+bool
+Common_Boost_Serialize_Drover_to_Mapped(const Drover &in,
+                                        const boost::filesystem::path& Filename){
+    return Serialize_Drover_to_Mapped(in, Filename, mapped_block_encoding::raw);
+}
+
+
+bool
+Common_Boost_Serialize_Drover_to_Mapped_Gzip(const Drover &in,
+                                             const boost::filesystem::path& Filename){
+    return Serialize_Drover_to_Mapped(in, Filename, mapped_block_encoding::gzip);
+}
+
+
+bool
+Common_Boost_Deserialize_Drover_from_Mapped(Drover &out,
+                                            const boost::filesystem::path& Filename){
+
+    //This routine attempts to deserialize a memory-mapped archive. It returns false if the file is not such an archive
+    // or if it is malformed. The header is parsed first, then pixel blocks are copied (or decompressed) directly from
+    // the mapping. Pages are only read from disk as they are needed.
+    try{
+        boost::iostreams::mapped_file_source m(Filename.string());
+        const auto N_bytes = static_cast<uint64_t>(m.size());
+        const char *base = m.data();
+
+        mapped_archive_preamble pre {};
+        if(N_bytes < sizeof(pre)) return false;
+        std::memcpy(&pre, base, sizeof(pre));
+        if(pre.magic != mapped_archive_magic) return false;
+
+        const auto in_bounds = [N_bytes](uint64_t offset, uint64_t size) -> bool {
+            return (offset <= N_bytes) && (size <= (N_bytes - offset));
+        };
+        if( !in_bounds(pre.header_offset, pre.header_size)
+        ||  (pre.block_count > (N_bytes / sizeof(mapped_block_entry)))
+        ||  !in_bounds(pre.table_offset, pre.block_count * sizeof(mapped_block_entry)) ){
+            FUNCWARN("Memory-mapped archive is truncated or corrupt");
+            return false;
+        }
+
+        Drover d;
+        {
+            boost::iostreams::stream<boost::iostreams::array_source> is(base + pre.header_offset, pre.header_size);
+            boost::archive::binary_iarchive ar(is);
+            ar & boost::serialization::make_nvp("dicom_data", d);
+        }
+
+        std::vector<mapped_block_entry> table(pre.block_count);
+        std::memcpy(reinterpret_cast<char*>(table.data()), base + pre.table_offset,
+                    table.size() * sizeof(mapped_block_entry));
+
+        //Pair every image with its pixel block.
+        std::vector<std::pair<planar_image<float,double>*, mapped_block_entry>> work;
+        work.reserve(table.size());
+        {
+            auto t_it = table.begin();
+            for(const auto &ia : distinct_image_arrays(d)){
+                for(auto &img : ia->imagecoll.images){
+                    if(t_it == table.end()){
+                        FUNCWARN("Memory-mapped archive is missing pixel blocks");
+                        return false;
+                    }
+                    const auto expected = static_cast<uint64_t>(img.rows * img.columns * img.channels) * sizeof(float);
+                    if( (img.rows < 0) || (img.columns < 0) || (img.channels < 0)
+                    ||  (t_it->raw_size != expected)
+                    ||  !in_bounds(t_it->offset, t_it->stored_size)
+                    ||  ( (t_it->encoding == static_cast<uint32_t>(mapped_block_encoding::raw))
+                          && (t_it->stored_size != t_it->raw_size) ) ){
+                        FUNCWARN("Memory-mapped archive pixel block does not match its image");
+                        return false;
+                    }
+                    work.emplace_back(&img, *t_it);
+                    ++t_it;
+                }
+            }
+            if(t_it != table.end()){
+                FUNCWARN("Memory-mapped archive contains unclaimed pixel blocks");
+                return false;
+            }
+        }
+
+        //Populate the pixel data concurrently. Each image is independent.
+        std::mutex failure_mutex;
+        std::string failure;
+        {
+            asio_thread_pool tp;
+            for(auto &w : work){
+                tp.submit_task([&,base]() -> void {
+                    try{
+                        auto &img = *(w.first);
+                        const auto &e = w.second;
+                        img.data.resize(e.raw_size / sizeof(float));
+                        auto dest = reinterpret_cast<char*>(img.data.data());
+
+                        if(e.encoding == static_cast<uint32_t>(mapped_block_encoding::raw)){
+                            std::memcpy(dest, base + e.offset, e.raw_size);
+
+                        }else if(e.encoding == static_cast<uint32_t>(mapped_block_encoding::gzip)){
+                            boost::iostreams::filtering_istream is;
+                            is.push(boost::iostreams::gzip_decompressor());
+                            is.push(boost::iostreams::array_source(base + e.offset, e.stored_size));
+                            is.read(dest, e.raw_size);
+                            if(static_cast<uint64_t>(is.gcount()) != e.raw_size){
+                                throw std::runtime_error("compressed pixel block is truncated");
+                            }
+
+                        }else{
+                            throw std::runtime_error("pixel block encoding not recognized");
+                        }
+                    }catch(const std::exception &e){
+                        std::lock_guard<std::mutex> lock(failure_mutex);
+                        failure = e.what();
+                    }
+                }); // thread pool task closure.
+            }
+        } // Wait until all threads are done.
+        if(!failure.empty()){
+            FUNCWARN("Unable to load memory-mapped archive pixel data: " << failure);
+            return false;
+        }
+
+        out = d;
+    }catch(const std::exception &){
+        return false;
+    }
+
+    return true;
+}
+
+
 //=====================================================================================================================
 
 #ifdef DCMA_USE_GNU_GSL
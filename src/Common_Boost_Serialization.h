@@ -49,6 +49,20 @@ Common_Boost_Serialize_Drover_to_Simple_Text(const Drover &in, const boost::file
 bool
 Common_Boost_Serialize_Drover_to_XML(const Drover &in, const boost::filesystem::path& Filename);
 
+// Memory-mapped archives.
+//
+// These archives store a binary header (holding everything except image pixel data) alongside page-aligned pixel
+// blocks, one per image, that are either stored verbatim or individually gzip-compressed. The file is memory-mapped
+// when read, so only the header is parsed and pixel blocks are copied (or decompressed) directly from the mapping,
+// concurrently. Like the binary archives, these archives are not portable across CPU architectures.
+bool
+Common_Boost_Serialize_Drover_to_Mapped(const Drover &in, const boost::filesystem::path& Filename);
+bool
+Common_Boost_Serialize_Drover_to_Mapped_Gzip(const Drover &in, const boost::filesystem::path& Filename);
+
+bool
+Common_Boost_Deserialize_Drover_from_Mapped(Drover &out, const boost::filesystem::path& Filename);
+
 
 
 #ifdef DCMA_USE_GNU_GSL
@@ -8,6 +8,10 @@
 #include <map>
 #include <cmath>
 #include <any>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
 
 #ifdef DCMA_USE_CGAL
 #else
@@ -24,9 +28,279 @@
 #include "YgorMisc.h"
 #include "YgorMath.h"
 
+#include "Thread_Pool.h"
 #include "Contour_Boolean_Operations.h"
 
 
+namespace {
+
+using Kernel = CGAL::Simple_cartesian<double>;
+using Point_2 = Kernel::Point_2;
+using Polygon_2 = CGAL::Polygon_2<Kernel>;
+using Polygon_with_holes_2 = CGAL::Polygon_with_holes_2<Kernel>;
+using Polygon_set_2 = CGAL::Polygon_set_2<Kernel>;
+
+// An orthonormal basis that spans a 2D plane, used to express contour vertices in (and recover them from) the plane.
+//
+// When a grid spacing is provided, in-plane coordinates are expressed in units of the grid spacing and rounded to the
+// nearest integer.
+struct planar_basis {
+    plane<double> p;
+    vec3<double> U_x;
+    vec3<double> U_y;
+    double snap = 0.0;
+
+    planar_basis(const plane<double> &p, double snap) : p(p), snap(snap) {
+        // Identify an orthonormal set that spans the 2D plane. Store them for later projection.
+        const auto pi = std::acos(-1.0);
+        const auto U_z = p.N_0.unit();
+        U_y = vec3<double>(1.0, 0.0, 0.0); //Candidate vector.
+        if(U_y.Dot(U_z) > 0.25){
+            U_y = U_z.rotate_around_x(pi * 0.5);
+        }
+        U_x = U_z.Cross(U_y);
+        if(!U_z.GramSchmidt_orthogonalize(U_y, U_x)){
+            throw std::runtime_error("Unable to find planar basis vectors.");
+        }
+        U_x = U_x.unit();  // U_x and U_y now form an in-plane basis.
+        U_y = U_y.unit();
+    }
+
+    // Express a vector in the plane's basis.
+    Point_2 to_plane(const vec3<double> &R) const {
+        // 'R' is a vector from the R^3 origin to a contour vertex.
+        // We want to express 'R' explicitly in terms of the R^2 plane's basis.
+
+        //Project onto the plane.
+        const auto proj = p.Project_Onto_Plane_Orthogonally(R);
+
+        //Now express the projected point in terms of the plane's basis.
+        const auto dR = (proj - p.R_0);  // in-plane vector from plane's pinning vector.
+        if(0.0 < snap){
+            return Point_2(std::round(dR.Dot(U_x) / snap), std::round(dR.Dot(U_y) / snap));
+        }
+        return Point_2(dR.Dot(U_x), dR.Dot(U_y));
+    }
+
+    // Convert from the plane's basis back to R^3 representation.
+    vec3<double> from_plane(const Point_2 &P) const {
+        // 'P' is a vector from the plane's origin (and R_0) to a contour vertex.
+        // We want to express 'P' explicitly in terms of the R^3 coordinate system the plane is described in.
+        // Note that we cannot un-project the vertices off the plane, so we assume they were already exactly coincident
+        // with the plane.
+        const auto scale = (0.0 < snap) ? snap : 1.0;
+        return p.R_0 + (U_x * (P.x() * scale)) + (U_y * (P.y() * scale));
+    }
+};
+
+// Convert a contour into CGAL style by projecting onto the plane and expressing in the plane's basis.
+//
+// When snapping, vertices that coincide after snapping are merged. Polygons that degenerate are returned empty.
+Polygon_2
+Project_Contour(const contour_of_points<double> &c, const planar_basis &basis){
+    Polygon_2 out;
+    for(const auto &v : c.points){
+        const auto P = basis.to_plane(v);
+        if( (0.0 < basis.snap)
+        &&  !out.is_empty()
+        &&  (*std::prev(out.vertices_end()) == P) ) continue;
+        out.push_back(P);
+    }
+    if(0.0 < basis.snap){
+        while( (1 < out.size()) && (*out.vertices_begin() == *std::prev(out.vertices_end())) ){
+            out.erase(std::prev(out.vertices_end()));
+        }
+        if( (out.size() < 3) || (out.area() == 0.0) ) return Polygon_2();
+    }
+
+    //Ensure that the contour is counter-clockwise (as per the CGAL requirement for outer-boundary polygons).
+    if(!out.is_empty() && out.is_clockwise_oriented()) out.reverse_orientation();
+    return out;
+}
+
+// Combine a polygon set with another polygon set or polygon.
+template <class T>
+void
+Apply_Boolean(Polygon_set_2 &A, ContourBooleanMethod op, const T &B){
+    if(op == ContourBooleanMethod::noop){
+        //Intentionally do nothing here.
+    }else if(op == ContourBooleanMethod::join){
+        A.join(B);
+    }else if(op == ContourBooleanMethod::intersection){
+        A.intersection(B);
+    }else if(op == ContourBooleanMethod::difference){
+        A.difference(B);
+    }else if(op == ContourBooleanMethod::symmetric_difference){
+        A.symmetric_difference(B);
+    }else{
+        throw std::logic_error("Requested Boolean operation is not supported.");
+    }
+    return;
+}
+
+// Build a polygon set from a collection of (counter-clockwise) polygons.
+Polygon_set_2
+Build_Polygon_Set(const std::vector<Polygon_2> &polys, ContourBooleanMethod construction_op){
+    Polygon_set_2 out;
+    bool first_contour = true;
+    for(const auto &poly : polys){
+        if(poly.is_empty()) continue;
+        if(first_contour){
+            first_contour = false;
+            out.join(poly);
+        }else if(construction_op == ContourBooleanMethod::noop){
+            throw std::logic_error("Requested Boolean operation is not supported.");
+        }else{
+            Apply_Boolean(out, construction_op, poly);
+        }
+    }
+    return out;
+}
+
+// Convert each polygon back to the DICOMautomaton coordinate system using the orthonormal basis.
+void
+Extract_Contours(const Polygon_set_2 &C_set,
+                 const planar_basis &basis,
+                 const std::map<std::string, std::string> &metadata,
+                 std::list<contour_of_points<double>> &out){
+    if(C_set.number_of_polygons_with_holes() == 0) return;
+
+    std::list<Polygon_with_holes_2> pwhl;
+    C_set.polygons_with_holes(std::back_inserter(pwhl));
+
+    for(auto &pwh : pwhl){
+        //If necessary, remove polygon holes by 'seaming' the contours.
+        // Otherwise there are no holes to seam.
+        //
+        // Note: The following connect_holes routine fails with CGAL 4.10-1 (Arch Linux)
+        //       when using CGAL::Exact_predicates_inexact_constructions_kernel. Beware if you switch kernels.
+        std::list<Point_2> p2l;
+        connect_holes(pwh,std::back_inserter(p2l));
+
+        if(p2l.empty()) continue;
+        out.emplace_back();
+        for(auto &p2 : p2l){
+            out.back().points.emplace_back(basis.from_plane(p2));
+        }
+        //The outer boundary of all CGAL contours with holes are oriented clockwise.
+        // Flip them around as per normal positive orientation in DICOMautomaton.
+        out.back().points.reverse();
+
+        //Attach the common metadata.
+        out.back().closed = true;
+        out.back().metadata = metadata;
+    }
+    return;
+}
+
+// Returns true if any bounding box in A overlaps (or touches) any bounding box in B.
+bool
+Any_Bbox_Overlap(const std::vector<CGAL::Bbox_2> &A, const std::vector<CGAL::Bbox_2> &B){
+    for(const auto &a : A){
+        for(const auto &b : B){
+            if(CGAL::do_overlap(a, b)) return true;
+        }
+    }
+    return false;
+}
+
+// Returns true if any pair of bounding boxes overlap (or touch).
+bool
+Any_Bbox_Overlap(const std::vector<CGAL::Bbox_2> &A){
+    for(auto a_it = std::begin(A); a_it != std::end(A); ++a_it){
+        for(auto b_it = std::next(a_it); b_it != std::end(A); ++b_it){
+            if(CGAL::do_overlap(*a_it, *b_it)) return true;
+        }
+    }
+    return false;
+}
+
+// Evaluate a multi-operand Boolean expression on a single plane.
+//
+// While the operands and the running result consist of polygons with mutually disjoint bounding boxes, many operations
+// can be evaluated without computing any intersections, e.g., the difference of disjoint polygons. The running result
+// is only converted to a CGAL polygon set when the operands actually interact.
+std::list<contour_of_points<double>>
+Evaluate_Plane_Expression(const planar_basis &basis,
+                          const std::vector<std::vector<std::reference_wrapper<contour_of_points<double>>>> &operand_contours,
+                          const std::vector<ContourBooleanOperand> &operands,
+                          ContourBooleanMethod construction_op){
+
+    // Extract the common metadata from all contours in all operands. Store it for later.
+    std::list<std::reference_wrapper<contour_of_points<double>>> all;
+    for(const auto &oc : operand_contours) all.insert(all.end(), oc.begin(), oc.end());
+    const auto common_metadata = contour_collection<double>().get_common_metadata( { }, { std::ref(all) } );
+
+    bool fast = true; // Whether the running result is still represented by 'R' rather than 'R_set'.
+    std::vector<Polygon_2> R;
+    std::vector<CGAL::Bbox_2> R_bboxes;
+    Polygon_set_2 R_set;
+
+    for(size_t k = 0; k < operands.size(); ++k){
+        const auto op = (k == 0) ? ContourBooleanMethod::join : operands[k].op;
+        if(op == ContourBooleanMethod::noop) continue;
+
+        std::vector<Polygon_2> S;
+        std::vector<CGAL::Bbox_2> S_bboxes;
+        for(const auto &c_ref : operand_contours[k]){
+            auto poly = Project_Contour(c_ref.get(), basis);
+            if(poly.is_empty()) continue;
+            S_bboxes.emplace_back(poly.bbox());
+            S.emplace_back(std::move(poly));
+        }
+
+        const bool S_disjoint = ( (S.size() <= 1) || (construction_op == ContourBooleanMethod::join) )
+                             && !Any_Bbox_Overlap(S_bboxes);
+        if( fast
+        &&  S_disjoint
+        &&  ( (k == 0) || !Any_Bbox_Overlap(R_bboxes, S_bboxes) ) ){
+            if( (op == ContourBooleanMethod::join)
+            ||  (op == ContourBooleanMethod::symmetric_difference) ){
+                R.insert(std::end(R), std::begin(S), std::end(S));
+                R_bboxes.insert(std::end(R_bboxes), std::begin(S_bboxes), std::end(S_bboxes));
+            }else if(op == ContourBooleanMethod::intersection){
+                R.clear();
+                R_bboxes.clear();
+            }else if(op == ContourBooleanMethod::difference){
+                //Intentionally do nothing here.
+            }else{
+                throw std::logic_error("Requested Boolean operation is not supported.");
+            }
+            continue;
+        }
+
+        if(fast){
+            fast = false;
+            R_set = Build_Polygon_Set(R, ContourBooleanMethod::join);
+            R.clear();
+            R_bboxes.clear();
+        }
+        if(k == 0){
+            R_set = Build_Polygon_Set(S, construction_op);
+        }else{
+            Apply_Boolean(R_set, op, Build_Polygon_Set(S, construction_op));
+        }
+    }
+
+    std::list<contour_of_points<double>> out;
+    if(fast){
+        for(const auto &poly : R){
+            out.emplace_back();
+            for(auto v_it = poly.vertices_begin(); v_it != poly.vertices_end(); ++v_it){
+                out.back().points.emplace_back(basis.from_plane(*v_it));
+            }
+            out.back().closed = true;
+            out.back().metadata = common_metadata;
+        }
+    }else{
+        Extract_Contours(R_set, basis, common_metadata, out);
+    }
+    return out;
+}
+
+} // namespace.
+
+
 // Because ROI contours are 2D planar contours embedded in R^3, an explicit projection plane must be provided. Contours
 // are projected on the plane, an orthonormal basis is created, the projected contours are expressed in the basis, and
 // the Boolean operations are performed. Note that the outgoing contours remain projected onto the provided plane.
@@ -55,45 +329,7 @@ ContourBoolean(plane<double> p,
                ContourBooleanMethod op,
                ContourBooleanMethod construction_op){
 
-    // Identify an orthonormal set that spans the 2D plane. Store them for later projection.
-    const auto pi = std::acos(-1.0);
-    const auto U_z = p.N_0.unit();
-    vec3<double> U_y = vec3<double>(1.0, 0.0, 0.0); //Candidate vector.
-    if(U_y.Dot(U_z) > 0.25){
-        U_y = U_z.rotate_around_x(pi * 0.5);
-    }
-    vec3<double> U_x = U_z.Cross(U_y);
-    if(!U_z.GramSchmidt_orthogonalize(U_y, U_x)){
-        throw std::runtime_error("Unable to find planar basis vectors.");
-    }
-    U_x = U_x.unit();  // U_x and U_y now form an in-plane basis.
-    U_y = U_y.unit();
-
-    // Closure for expressing vectors in the plane's basis.
-    const auto R3_v_to_R2_P_basis = [=](vec3<double> R) -> vec3<double> {
-        // 'R' is a vector from the R^3 origin to a contour vertex.
-        // We want to express 'R' explicitly in terms of the R^2 plane's basis.
-        // (Our convention in this representation will be to use a vec3 but enforce z=0 everywhere.)
-
-        //Project onto the plane.
-        const auto proj = p.Project_Onto_Plane_Orthogonally(R);
-
-        //Now express the projected point in terms of the plane's basis.
-        const auto dR = (proj - p.R_0);  // in-plane vector from plane's pinning vector.
-
-        return vec3<double>(dR.Dot(U_x), dR.Dot(U_y), 0.0);
-    };
-
-    // Closure for converting from the plane's basis back to R^3 representation.
-    const auto R2_P_basis_to_R3_v = [=](vec3<double> R) -> vec3<double> {
-        // 'R' is a vector from the plane's origin (and R_0) to a contour vertex.
-        // We want to express 'R' explicitly in terms of the R^3 coordinate system the plane is described in.
-        // Note that we cannot un-project the vertices off the plane, so we assume they were already exactly coincident
-        // with the plane.
-
-        vec3<double> actual = p.R_0 + (U_x * R.x) + (U_y * R.y);
-        return actual;
-    };
+    const planar_basis basis(p, /*snap=*/ 0.0);
 
     // Extract the common metadata from all contours in both A and B sets. Store it for later.
     std::list<std::reference_wrapper<contour_of_points<double>>> all;
@@ -101,136 +337,74 @@ ContourBoolean(plane<double> p,
     all.insert(all.end(), B.begin(), B.end());
     auto common_metadata = contour_collection<double>().get_common_metadata( { }, { std::ref(all) } );
 
+    // Convert the sets of contours into CGAL style by projecting onto the plane and expressing in the new basis.
+    std::vector<Polygon_2> A_polys;
+    for(auto &c_ref : A) A_polys.emplace_back(Project_Contour(c_ref.get(), basis));
+    std::vector<Polygon_2> B_polys;
+    for(auto &c_ref : B) B_polys.emplace_back(Project_Contour(c_ref.get(), basis));
 
-    using Kernel = CGAL::Simple_cartesian<double>;
-    using Point_2 = Kernel::Point_2;
-    using Polygon_2 = CGAL::Polygon_2<Kernel>;
-    using Polygon_with_holes_2 = CGAL::Polygon_with_holes_2<Kernel>;
-    using Polygon_set_2 = CGAL::Polygon_set_2<Kernel>;
+    const auto A_set = Build_Polygon_Set(A_polys, construction_op);
+    const auto B_set = Build_Polygon_Set(B_polys, construction_op);
 
-    bool first_contour;
+    // Perform the selected Boolean operation.
+    Polygon_set_2 C_set;
+    C_set.join(A_set);
+    Apply_Boolean(C_set, op, B_set);
 
-    // Convert the A set of contours into CGAL style by projecting onto the plane and expressing in the new basis.
-    Polygon_set_2 A_set;
-    first_contour = true;
-    for(auto &c_ref : A){
-        //Express in the planar basis (with z'=0 everywhere).
-        contour_of_points<double> projected;
-        projected.closed = true;
-        for(auto &v : c_ref.get().points){
-            projected.points.emplace_back(R3_v_to_R2_P_basis(v));
-        }
+    contour_collection<double> out;
+    Extract_Contours(C_set, basis, common_metadata, out.contours);
+    return out;
+}
 
-        //Ensure that the contour is counter-clockwise (as per the CGAL requirement for outer-boundary polygons).
-        if(!projected.Is_Counter_Clockwise()) projected.Reorient_Counter_Clockwise();
 
-        //Insert in the CGAL polygon set.
-        Polygon_2 A_cgal;
-        for(auto &v : projected.points){
-            A_cgal.push_back(Point_2(v.x,v.y));
-        }
-        if(first_contour){
-            first_contour = false;
-            A_set.join(A_cgal);
-        }else if(construction_op == ContourBooleanMethod::join){
-            A_set.join(A_cgal);
-        }else if(construction_op == ContourBooleanMethod::intersection){
-            A_set.intersection(A_cgal);
-        }else if(construction_op == ContourBooleanMethod::difference){
-            A_set.difference(A_cgal);
-        }else if(construction_op == ContourBooleanMethod::symmetric_difference){
-            A_set.symmetric_difference(A_cgal);
-        }else{
-            throw std::logic_error("Requested Boolean operation is not supported.");
+contour_collection<double>
+ContourBooleanExpression(const std::vector<plane<double>> &planes,
+                         double plane_thickness,
+                         const std::vector<ContourBooleanOperand> &operands,
+                         ContourBooleanMethod construction_op,
+                         double snap_spacing){
+
+    if(operands.empty()) return contour_collection<double>();
+
+    // Assign contours to every plane they are 'on' up front. We give planes a thickness to help determine coincidence.
+    const auto N_planes = planes.size();
+    const auto N_operands = operands.size();
+    std::vector<std::vector<std::vector<std::reference_wrapper<contour_of_points<double>>>>> plane_contours(
+        N_planes, std::vector<std::vector<std::reference_wrapper<contour_of_points<double>>>>(N_operands) );
+    for(size_t k = 0; k < N_operands; ++k){
+        for(const auto &c_ref : operands[k].contours){
+            if(c_ref.get().points.empty()) continue;
+            const auto &v = c_ref.get().points.front();
+            for(size_t i = 0; i < N_planes; ++i){
+                if(std::abs(planes[i].Get_Signed_Distance_To_Point(v)) <= plane_thickness){
+                    plane_contours[i][k].emplace_back(c_ref);
+                }
+            }
         }
     }
 
-    // Convert the B set of contours into CGAL style by projecting onto the plane and expressing in the new basis.
-    Polygon_set_2 B_set;
-    first_contour = true;
-    for(auto &c_ref : B){
-        //Express in the planar basis (with z'=0 everywhere).
-        contour_of_points<double> projected;
-        projected.closed = true;
-        for(auto &v : c_ref.get().points){
-            projected.points.emplace_back(R3_v_to_R2_P_basis(v));
-        }
-
-        //Ensure that the contour is counter-clockwise (as per the CGAL requirement for outer-boundary polygons).
-        if(!projected.Is_Counter_Clockwise()) projected.Reorient_Counter_Clockwise();
-
-        //Insert in the CGAL polygon set.
-        Polygon_2 B_cgal;
-        for(auto &v : projected.points){
-            B_cgal.push_back(Point_2(v.x,v.y));
-        }
-        if(first_contour){
-            first_contour = false;
-            B_set.join(B_cgal);
-        }else if(construction_op == ContourBooleanMethod::join){
-            B_set.join(B_cgal);
-        }else if(construction_op == ContourBooleanMethod::intersection){
-            B_set.intersection(B_cgal);
-        }else if(construction_op == ContourBooleanMethod::difference){
-            B_set.difference(B_cgal);
-        }else if(construction_op == ContourBooleanMethod::symmetric_difference){
-            B_set.symmetric_difference(B_cgal);
-        }else{
-            throw std::logic_error("Requested Boolean operation is not supported.");
+    // Evaluate each plane independently.
+    std::vector<std::list<contour_of_points<double>>> plane_results(N_planes);
+    std::vector<std::exception_ptr> plane_errors(N_planes);
+    {
+        asio_thread_pool tp;
+        for(size_t i = 0; i < N_planes; ++i){
+            tp.submit_task([&,i]() -> void {
+                try{
+                    const planar_basis basis(planes[i], snap_spacing);
+                    plane_results[i] = Evaluate_Plane_Expression(basis, plane_contours[i], operands, construction_op);
+                }catch(const std::exception &){
+                    plane_errors[i] = std::current_exception();
+                }
+            }); // thread pool task closure.
         }
-    }
-
-
-    // Perform the selected Boolean operation.
-    Polygon_set_2 C_set;
-    C_set.join(A_set);
-    if(op == ContourBooleanMethod::noop){
-        //Intentionally do nothing here.
-    }else if(op == ContourBooleanMethod::join){
-        C_set.join(B_set);
-    }else if(op == ContourBooleanMethod::intersection){
-        C_set.intersection(B_set);
-    }else if(op == ContourBooleanMethod::difference){
-        C_set.difference(B_set);
-    }else if(op == ContourBooleanMethod::symmetric_difference){
-        C_set.symmetric_difference(B_set);
-    }else{
-        throw std::logic_error("Requested Boolean operation is not supported.");
-    }
+    } // Wait until all threads are done.
 
-    // Convert each contour back to the DICOMautomaton coordinate system using the orthonormal basis.
     contour_collection<double> out;
-    if(C_set.number_of_polygons_with_holes() != 0){
-        std::list<Polygon_with_holes_2> pwhl;
-        C_set.polygons_with_holes(std::back_inserter(pwhl));
-
-        for(auto &pwh : pwhl){
-            //If necessary, remove polygon holes by 'seaming' the contours.
-            // Otherwise there are no holes to seam.
-            //
-            // Note: The following connect_holes routine fails with CGAL 4.10-1 (Arch Linux)
-            //       when using CGAL::Exact_predicates_inexact_constructions_kernel. Beware if you switch kernels.
-            std::list<Point_2> p2l;
-            connect_holes(pwh,std::back_inserter(p2l));
-
-            if(p2l.empty()) continue;
-            out.contours.emplace_back();
-            for(auto &p2 : p2l){
-                const vec3<double> proj(p2.x(), p2.y(), 0.0);
-                const auto v = R2_P_basis_to_R3_v(proj);
-                out.contours.back().points.emplace_back(v);
-            }
-            //The outer boundary of all CGAL contours with holes are oriented clockwise.
-            // Flip them around as per normal positive orientation in DICOMautomaton.
-            out.contours.back().points.reverse();
-
-            //Attach the common metadata.
-            out.contours.back().closed = true;
-            out.contours.back().metadata = common_metadata;
-        }
+    for(size_t i = 0; i < N_planes; ++i){
+        if(plane_errors[i]) std::rethrow_exception(plane_errors[i]);
+        out.contours.splice(out.contours.end(), plane_results[i]);
     }
-
     return out;
-}               
-
+}
 
@@ -6,6 +6,7 @@
 
 #include <list>
 #include <functional>
+#include <vector>
 
 #include "YgorMath.h"
 
@@ -54,3 +55,36 @@ ContourBoolean(plane<double> p,
                ContourBooleanMethod construction_op = ContourBooleanMethod::join);
 
 
+// One operand of a multi-operand Boolean expression.
+struct ContourBooleanOperand {
+    // How this operand is combined with the result of all preceding operands. Ignored for the first operand.
+    ContourBooleanMethod op = ContourBooleanMethod::join;
+
+    std::list<std::reference_wrapper<contour_of_points<double>>> contours;
+};
+
+// Evaluates a multi-operand Boolean expression, e.g., (A ∪ B) - C, on every provided plane in a single pass. Operands
+// are combined left-to-right. Contours are assigned to all planes within the provided thickness, and planes are
+// evaluated concurrently. The outgoing contours are ordered by plane.
+//
+// If a positive snap spacing (in DICOM units) is provided, in-plane coordinates are rounded to a grid with that spacing
+// before any Boolean operations are performed, and vertices that coincide after rounding are merged. Snapping is
+// disabled by default, in which case vertices are used exactly as ContourBoolean() would use them. Note that snapping
+// does not make the operations exact; the polygon sets use a floating-point kernel, so constructed intersections are
+// subject to round-off either way.
+//
+// Operations whose result can be determined from bounding boxes alone (e.g., the difference of non-overlapping
+// polygons) are evaluated directly; all others are evaluated using the same polygon sets as ContourBoolean(). There is
+// no dedicated polygon clipper, so operands that actually overlap are no cheaper to evaluate than with
+// ContourBoolean(); the speedup for such inputs comes only from evaluating planes concurrently.
+//
+// Note: The same caveats as for ContourBoolean() apply, and the outgoing contours carry only the metadata common to all
+//       operand contours on each plane.
+//
+contour_collection<double>
+ContourBooleanExpression(const std::vector<plane<double>> &planes,
+                         double plane_thickness,
+                         const std::vector<ContourBooleanOperand> &operands,
+                         ContourBooleanMethod construction_op = ContourBooleanMethod::join,
+                         double snap_spacing = 0.0);
+
@@ -8,7 +8,10 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>    
+#include <vector>
 //#include <cfenv>              //Needed for std::feclearexcept(FE_ALL_EXCEPT).
 
 #include <boost/algorithm/string/predicate.hpp>
@@ -19,6 +22,7 @@
 #include "Explicator.h"       //Needed for Explicator class.
 #include "Imebra_Shim.h"      //Wrapper for Imebra library. Black-boxed to speed up compilation.
 #include "Structs.h"
+#include "Thread_Pool.h"
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -35,8 +39,60 @@ Concatenate_Contour_Data(std::unique_ptr<Contour_Data> A,
 }
 
 
+//Everything that can be extracted from a single file without consulting any other file.
+struct Loaded_DICOM_File {
+    std::string Modality;
+
+    std::unique_ptr<TPlan_Config> tplan;
+    std::unique_ptr<Contour_Data> contour_data;
+    std::unique_ptr<Image_Array> img_arr;
+
+    std::exception_ptr error; // Set iff a file was recognized but could not be loaded.
+};
+
+static
+Loaded_DICOM_File
+Load_DICOM_File(const std::string &Filename){
+    //The file is parsed exactly once. All subsequent queries (modality, metadata, pixel data, etc.) reuse the parsed
+    // data set. This routine does not touch any shared state and can be called concurrently.
+    Loaded_DICOM_File out;
+
+    std::shared_ptr<Parsed_DICOM_File> pdf;
+    try{
+        pdf = Parse_DICOM_File(Filename);
+        out.Modality = get_modality(*pdf);
+    }catch(const std::exception &){
+        out.Modality = "";
+        return out;
+    };
+
+    try{
+        if(boost::iequals(out.Modality,"RTPLAN")){
+            out.tplan = Load_TPlan_Config(*pdf);
+
+        }else if(boost::iequals(out.Modality,"RTSTRUCT")){
+            out.contour_data = get_Contour_Data(*pdf);
+
+        }else if(boost::iequals(out.Modality,"RTDOSE")){
+            out.img_arr = Load_Dose_Array(*pdf);
+
+        }else if(  boost::iequals(out.Modality,"CT")
+                || boost::iequals(out.Modality,"OT")
+                || boost::iequals(out.Modality,"US")
+                || boost::iequals(out.Modality,"MR")
+                || boost::iequals(out.Modality,"RTIMAGE")
+                || boost::iequals(out.Modality,"PT") ){
+            out.img_arr = Load_Image_Array(*pdf);
+        }
+    }catch(const std::exception &){
+        out.error = std::current_exception();
+    }
+    return out;
+}
+
+
 bool Load_From_DICOM_Files( Drover &DICOM_data,
-                            std::map<std::string,std::string> & /* InvocationMetadata */,
+                            std::map<std::string,std::string> &InvocationMetadata,
                             const std::string &FilenameLex,
                             std::list<boost::filesystem::path> &Filenames ){
 
@@ -46,34 +102,77 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
     // Note: This routine returns false only iff a file is suspected of being suited for this loader, but could not be
     //       loaded (e.g., the file seems appropriate, but a parsing failure was encountered).
     //
+    // Note: Files are parsed and decoded independently, and optionally concurrently. The number of worker threads can
+    //       be controlled via the 'DICOMLoaderThreads' invocation metadata key (e.g., '-m DICOMLoaderThreads=8'). The
+    //       default is a single thread; zero selects the number of available cores. Regardless of the number of
+    //       threads, files are collated in the order they were provided so results are deterministic.
+    //
     if(Filenames.empty()) return true;
 
     using loaded_imgs_storage_t = decltype(DICOM_data.image_data);
     std::list<loaded_imgs_storage_t> loaded_imgs_storage;
     using loaded_dose_storage_t = decltype(DICOM_data.image_data);
     std::list<loaded_dose_storage_t> loaded_dose_storage;
-    std::shared_ptr<Contour_Data> loaded_contour_data_storage = std::make_shared<Contour_Data>();
+    std::unique_ptr<Contour_Data> loaded_contour_data_storage = std::make_unique<Contour_Data>();
 
     //This routine currently assumes ALL image files are part of the same image set. Same for dose files.
     // (To change this behaviour, it will suffice to emplace_back() the storage lists as needed.)
     loaded_imgs_storage.emplace_back();
     loaded_dose_storage.emplace_back();
 
-    size_t i = 0;
     const size_t N = Filenames.size();
 
+    long int thread_count = 1;
+    if(InvocationMetadata.count("DICOMLoaderThreads") != 0){
+        try{
+            thread_count = std::stol( InvocationMetadata["DICOMLoaderThreads"] );
+        }catch(const std::exception &){
+            FUNCWARN("Unable to parse 'DICOMLoaderThreads' invocation metadata. Ignoring it");
+        }
+    }
+    if(thread_count < 0) thread_count = 1;
+
+    // ------------------------------------------ Parsing and decoding -----------------------------------------------
+    //Each file is parsed once and all facets are extracted into an independent slot, so no coordination is needed
+    // between workers. Only a bounded number of parsed files are held in memory at any one time.
+    std::vector<Loaded_DICOM_File> loaded_files(N);
+    {
+        std::vector<std::string> l_filenames;
+        l_filenames.reserve(N);
+        for(const auto &p : Filenames) l_filenames.emplace_back(p.string());
+
+        std::mutex printer; // Who gets to print to the console and iterate the counter.
+        size_t completed = 0;
+        auto load_slot = [&](size_t i) -> void {
+            loaded_files[i] = Load_DICOM_File(l_filenames[i]);
+
+            std::lock_guard<std::mutex> lock(printer);
+            ++completed;
+            FUNCINFO("Parsed file #" << completed << "/" << N << " = " << 100*completed/N << "% \t" << l_filenames[i]);
+        };
+
+        if(thread_count == 1){
+            for(size_t i = 0; i < N; ++i) load_slot(i);
+        }else{
+            asio_thread_pool tp(static_cast<size_t>(thread_count));
+            for(size_t i = 0; i < N; ++i){
+                tp.submit_task([&,i]() -> void {
+                    load_slot(i);
+                }); // thread pool task closure.
+            }
+        } // Wait until all threads are done.
+    }
+
+    // ----------------------------------------------- Collation -----------------------------------------------------
+    //Collation is performed serially in the order files were provided.
+    size_t i = 0;
     auto bfit = Filenames.begin();
     while(bfit != Filenames.end()){
-        FUNCINFO("Parsing file #" << i+1 << "/" << N << " = " << 100*(i+1)/N << "% \t" << *bfit);
+        auto &lf = loaded_files[i];
         ++i;
 
         const auto Filename = bfit->string();
-        std::string Modality;
-        try{
-            Modality = get_modality(Filename);
-        }catch(const std::exception &){
-            Modality = "";
-        };
+        const auto &Modality = lf.Modality;
 
         if(boost::iequals(Modality,"RTRECORD")){
             FUNCWARN("RTRECORD file encountered. "
@@ -92,17 +191,19 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
         }else if(boost::iequals(Modality,"RTPLAN")){
             FUNCWARN("RTPLAN file support is experimental");
 
-            auto tplan = Load_TPlan_Config(Filename);
-            DICOM_data.tplan_data.emplace_back( std::move(tplan) );
+            if(lf.error) std::rethrow_exception(lf.error);
+            DICOM_data.tplan_data.emplace_back( std::move(lf.tplan) );
 
             bfit = Filenames.erase( bfit ); 
 
         }else if(boost::iequals(Modality,"RTSTRUCT")){
             const auto preloadcount = loaded_contour_data_storage->ccs.size();
             try{
-                auto combined = Concatenate_Contour_Data( loaded_contour_data_storage->Duplicate(),
-                                                          get_Contour_Data(Filename));
-                loaded_contour_data_storage = std::move(combined);
+                if(lf.error) std::rethrow_exception(lf.error);
+                if(lf.contour_data == nullptr) throw std::runtime_error("No contour data was extracted");
+                //Contours are moved (not copied) so loading many files remains linear in the number of contours.
+                loaded_contour_data_storage = Concatenate_Contour_Data( std::move(loaded_contour_data_storage),
+                                                                        std::move(lf.contour_data) );
 
             }catch(const std::exception &e){
                 FUNCWARN("Difficulty encountered during contour data loading: '" << e.what() << "'. Ignoring file and continuing");
@@ -124,7 +225,8 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
 
         }else if(boost::iequals(Modality,"RTDOSE")){
             try{
-                loaded_dose_storage.back().push_back( Load_Dose_Array(Filename));
+                if(lf.error) std::rethrow_exception(lf.error);
+                loaded_dose_storage.back().push_back( std::move(lf.img_arr) );
             }catch(const std::exception &e){
                 FUNCWARN("Difficulty encountered during dose array loading: '" << e.what() << "'. Ignoring file and continuing");
                 //loaded_dose_storage.back().pop_back();
@@ -142,7 +244,8 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
                 || boost::iequals(Modality,"PT") ){
 
             try{
-                loaded_imgs_storage.back().push_back( Load_Image_Array(Filename));
+                if(lf.error) std::rethrow_exception(lf.error);
+                loaded_imgs_storage.back().push_back( std::move(lf.img_arr) );
             }catch(const std::exception &e){
                 FUNCWARN("Difficulty encountered during image array loading: '" << e.what() << "'. Ignoring file and continuing");
                 //loaded_imgs_storage.back().pop_back();
@@ -181,22 +284,36 @@ bool Load_From_DICOM_Files( Drover &DICOM_data,
     // ----------------------------------------------- Post-processing -----------------------------------------------
 
     //Attempt contour name normalization using the selected lexicon.
+    //
+    // Lexicon lookups are memoized since ROIs often consist of hundreds of contours that share a single name.
     {
         Explicator X(FilenameLex);
+        std::map<std::string, std::string> normalized_names;
         for(auto & cc : loaded_contour_data_storage->ccs){
              for(auto & c : cc.contours){
-                 const auto NormalizedROIName = X(c.metadata["ROIName"]); //Could be cached, externally or internally.
-                 c.metadata["NormalizedROIName"] = NormalizedROIName;
+                 const auto &ROIName = c.metadata["ROIName"];
+                 auto n_it = normalized_names.find(ROIName);
+                 if(n_it == normalized_names.end()){
+                     n_it = normalized_names.emplace(ROIName, X(ROIName)).first;
+                 }
+                 c.metadata["NormalizedROIName"] = n_it->second;
              }
         }
     }
 
     //Concatenate contour data into the Drover instance.
     {
-        if(DICOM_data.contour_data == nullptr) DICOM_data.contour_data = std::make_shared<Contour_Data>();
-        auto combined = Concatenate_Contour_Data( DICOM_data.contour_data->Duplicate(),
-                                                  loaded_contour_data_storage->Duplicate());
-        DICOM_data.contour_data = std::move(combined);
+        const bool contours_loaded = !loaded_contour_data_storage->ccs.empty();
+        if(DICOM_data.contour_data == nullptr){
+            DICOM_data.contour_data = std::move(loaded_contour_data_storage);
+        }else if(contours_loaded){
+            //Existing contour data may be shared with other Drover instances, so it is replaced rather than altered.
+            DICOM_data.contour_data = Concatenate_Contour_Data( DICOM_data.contour_data->Duplicate(),
+                                                                std::move(loaded_contour_data_storage) );
+        }
+
+        //Build the per-ROI bounding boxes and plane indices now so later consumers need not.
+        if(contours_loaded) DICOM_data.contour_data->get_roi_index();
     }
 
     //Collate each group of images into a single set, if possible. Also stuff the correct contour data in the same set.
@@ -21,6 +21,7 @@
 #include <Wt/WProgressBar.h>
 #include <Wt/WPushButton.h>
 #include <Wt/WSelectionBox.h>
+#include <Wt/WServer.h>
 #include <Wt/WSignal.h>
 #include <Wt/WString.h>
 #include <Wt/WTable.h>
@@ -34,6 +35,7 @@
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <atomic>
 //#include <cfenv>              //Needed for std::feclearexcept(FE_ALL_EXCEPT).
 #include <chrono>
 #include <cstdint>
@@ -49,6 +51,7 @@
 #include <set> 
 #include <stdexcept>
 #include <string>    
+#include <thread>
 #include <type_traits>
 #include <utility>            //Needed for std::pair.
 #include <vector>
@@ -61,6 +64,7 @@
 #include "Operation_Dispatcher.h"
 #include "Structs.h"
 #include "Regex_Selectors.h"
+#include "Thread_Pool.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
 #include "YgorMath.h"         //Needed for vec3 class.
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -178,10 +182,136 @@ std::string HumanToCamel(std::string in){
     return in;
 }
 
+
+// ------------------------------------------- Job scheduling ----------------------------------------------
+
+// A unit of long-running work (e.g., file loading or an operation) submitted by a session.
+//
+// Jobs run on a worker pool shared by all sessions, so neither the session nor a Wt request thread is tied up while
+// the work proceeds. Progress and log lines are posted back to the owning session and pushed to the client using Wt
+// server push. Cancellation is cooperative: the work must poll cancel_requested() between steps.
+class webserver_job {
+  public:
+    enum class outcome {
+        Succeeded,
+        Failed,
+        Cancelled,
+    };
+
+  private:
+    std::string session_id;
+    std::atomic<bool> cancel_flag;
+
+  public:
+    // Sinks for job events. They are invoked within the owning session (i.e., with the session lock held) and can thus
+    // manipulate widgets. They must be set before the job is submitted.
+    std::function<void(const std::string &)> on_log;
+    std::function<void(double)> on_progress; // Fraction in [0:1].
+    std::function<void(outcome, const std::string &)> on_finish;
+
+    explicit webserver_job(std::string session_id) : session_id(std::move(session_id)), cancel_flag(false) {}
+
+    void request_cancel(){
+        this->cancel_flag.store(true);
+        return;
+    }
+
+    bool cancel_requested() const {
+        return this->cancel_flag.load();
+    }
+
+    // Schedules a callback to run within the owning session and pushes the resulting changes to the client. The
+    // callback is silently dropped if the session has since terminated.
+    void post(std::function<void()> f) const {
+        auto server = Wt::WServer::instance();
+        if(server == nullptr) return;
+        server->post(this->session_id, [f]() -> void {
+            f();
+            if(auto app = Wt::WApplication::instance()) app->triggerUpdate();
+            return;
+        });
+        return;
+    }
+
+    void log(const std::string &msg) const {
+        FUNCINFO(msg);
+        if(this->on_log){
+            auto f = this->on_log;
+            this->post([f,msg]() -> void { f(msg); });
+        }
+        return;
+    }
+
+    void progress(double frac) const {
+        if(this->on_progress){
+            auto f = this->on_progress;
+            this->post([f,frac]() -> void { f(frac); });
+        }
+        return;
+    }
+};
+
+
+// A bounded worker pool shared by all sessions.
+class webserver_job_scheduler {
+  private:
+    std::atomic<long int> outstanding; // Jobs that are queued or running.
+    asio_thread_pool pool;
+
+  public:
+    explicit webserver_job_scheduler(size_t num_workers) : outstanding(0), pool(num_workers) {}
+
+    // Queues the work and returns the number of jobs (from all sessions) that were already queued or running.
+    //
+    // Exceptions thrown by the work are reported as failures. The job's on_finish sink is always invoked exactly once,
+    // unless the session terminates first.
+    long int submit(const std::shared_ptr<webserver_job> &job,
+                    std::function<void(webserver_job &)> work){
+        const auto ahead = this->outstanding.fetch_add(1);
+        this->pool.submit_task([this,job,work]() -> void {
+            auto res = webserver_job::outcome::Succeeded;
+            std::string msg;
+            if(job->cancel_requested()){
+                res = webserver_job::outcome::Cancelled;
+                msg = "Job cancelled before it started.";
+            }else{
+                try{
+                    job->log("Job started.");
+                    work(*job);
+                    if(job->cancel_requested()){
+                        res = webserver_job::outcome::Cancelled;
+                        msg = "Job cancelled.";
+                    }
+                }catch(const std::exception &e){
+                    res = webserver_job::outcome::Failed;
+                    msg = e.what();
+                }
+            }
+            --(this->outstanding);
+
+            if(job->on_finish){
+                auto f = job->on_finish;
+                job->post([f,res,msg]() -> void { f(res, msg); });
+            }
+            return;
+        }); // thread pool task closure.
+        return ahead;
+    }
+};
+
+static
+webserver_job_scheduler & Job_Scheduler(){
+    // Operations and loaders often spawn their own threads, so only a fraction of the available cores are used here.
+    // Jobs beyond this limit are queued.
+    static webserver_job_scheduler scheduler( std::max<size_t>(1, std::thread::hardware_concurrency() / 2) );
+    return scheduler;
+}
+
 // This class is instanced for each client. It holds all state for a single session.
 class BaseWebServerApplication : public Wt::WApplication {
   public:
     BaseWebServerApplication(const Wt::WEnvironment& env);
+    ~BaseWebServerApplication() override;
 
   private:
 
@@ -202,7 +332,11 @@ class BaseWebServerApplication : public Wt::WApplication {
 
     //A working space specific to this instance. Not truly private: can be read by others.
     std::string InstancePrivateDirectory;
-    
+
+    //The job currently running on behalf of this session, if any. The DICOM_data member must not be accessed while a
+    // job is active because the job works on (a shallow copy of) it.
+    std::shared_ptr<webserver_job> ActiveJob;
+
 
     //Regex for operation parameters.
     std::regex trueregex    = Compile_Regex("^tr?u?e?$");
@@ -220,6 +354,16 @@ class BaseWebServerApplication : public Wt::WApplication {
     void createOperationParamSelectorGB();
     void appendOperationParamsColumn();
     void createComputeGB();
+    void corralComputeOutputs(Wt::WGroupBox *gb,
+                              Wt::WBreak *sep_break,
+                              const std::map<std::string,std::shared_ptr<Wt::WFileResource>> &OutputFiles,
+                              const std::map<std::string,std::string> &OutputMimetype);
+
+    //Creates widgets in the provided container for monitoring and cancelling a job, and submits the job to the shared
+    // worker pool. The on_finish functor is invoked within this session when the job completes.
+    void submitJob(Wt::WContainerWidget *cont,
+                   std::function<void(webserver_job &)> work,
+                   std::function<void(webserver_job::outcome, const std::string &)> on_finish);
 
 };
 
@@ -244,6 +388,9 @@ BaseWebServerApplication::BaseWebServerApplication(const Wt::WEnvironment &env)
         FUNCINFO("Using file '" << FilenameLex << "' as lexicon");
     }
 
+    //Long-running work is performed on a shared worker pool and the results are pushed to the client.
+    this->enableUpdates(true);
+
     // -----------------------------------------------------------------------------------
     // Static widgets and whole-page styling.
     // -----------------------------------------------------------------------------------
@@ -269,6 +416,68 @@ BaseWebServerApplication::BaseWebServerApplication(const Wt::WEnvironment &env)
     this->createFileUploadGB();
 }
 
+BaseWebServerApplication::~BaseWebServerApplication(){
+    //Do not waste workers on a session that no longer exists.
+    if(this->ActiveJob != nullptr) this->ActiveJob->request_cancel();
+}
+
+
+void BaseWebServerApplication::submitJob(Wt::WContainerWidget *cont,
+                                         std::function<void(webserver_job &)> work,
+                                         std::function<void(webserver_job::outcome, const std::string &)> on_finish){
+    if(this->ActiveJob != nullptr) throw std::logic_error("A job is already active for this session. Refusing to submit another.");
+
+    auto pb = cont->addWidget(std::make_unique<Wt::WProgressBar>());
+    pb->setWidth(Wt::WLength("100%"));
+    pb->setRange(0.0, 1.0);
+    pb->setValue(0.0);
+
+    auto logarea = cont->addWidget(std::make_unique<Wt::WTextArea>());
+    logarea->addStyleClass("JobLog");
+    logarea->setWidth(Wt::WLength("100%"));
+    logarea->setRows(6);
+    logarea->setReadOnly(true);
+
+    (void*) cont->addWidget(std::make_unique<Wt::WBreak>());
+
+    auto cancelbutton = cont->addWidget(std::make_unique<Wt::WPushButton>("Cancel"));
+
+    auto append_log = [=](const std::string &msg) -> void {
+        logarea->setText( logarea->text() + Wt::WString::fromUTF8(msg + "\n") );
+        return;
+    };
+
+    auto job = std::make_shared<webserver_job>(this->sessionId());
+    job->on_log = append_log;
+    job->on_progress = [=](double frac) -> void {
+        pb->setValue(frac);
+        return;
+    };
+    job->on_finish = [=](webserver_job::outcome res, const std::string &msg) -> void {
+        this->ActiveJob.reset();
+        cancelbutton->disable();
+        cancelbutton->hide();
+        if(res == webserver_job::outcome::Succeeded) pb->setValue(1.0);
+        if(!msg.empty()) append_log(msg);
+        on_finish(res, msg);
+        return;
+    };
+
+    cancelbutton->clicked().connect(std::bind([=](){
+        cancelbutton->disable();
+        job->request_cancel();
+        append_log("Cancellation requested. The job will stop at the next opportunity.");
+        return;
+    }));
+
+    this->ActiveJob = job;
+    const auto ahead = Job_Scheduler().submit(job, std::move(work));
+    if(0 < ahead){
+        append_log(std::to_string(ahead) + " other job(s) are queued or running. This job may have to wait.");
+    }
+    return;
+}
+
 
 void BaseWebServerApplication::createFileUploadGB(){
     // This routine creates a file upload box.
@@ -357,12 +566,25 @@ void BaseWebServerApplication::filesUploaded(){
     // This routine gets called after all files have been uploaded.
     //
     // It must corral, validate, load them into the DICOM_data member, and initiate the next interactive widget(s).
+    // Loading is performed on the shared worker pool so that large uploads do not tie up the session.
     //
 
     auto fileup = reinterpret_cast<Wt::WFileUpload *>( root()->find("file_upload_gb_file_picker") );
     if(fileup == nullptr) throw std::logic_error("Cannot find file uploader widget in DOM tree. Cannot continue.");
 
-    std::list<boost::filesystem::path> UploadedFilesDirsReachable;
+    //Everything the loaders need, decoupled from the session so the session can terminate while loading proceeds.
+    struct load_state_t {
+        Drover DICOM_data;
+        std::map<std::string,std::string> InvocationMetadata;
+        std::string FilenameLex;
+        std::list<boost::filesystem::path> UploadedFilesDirsReachable;
+        std::list<std::pair<std::string,std::string>> ArchiveCopies; // (source, destination).
+    };
+    auto state = std::make_shared<load_state_t>();
+    state->DICOM_data = this->DICOM_data;
+    state->InvocationMetadata = this->InvocationMetadata;
+    state->FilenameLex = this->FilenameLex;
+
     const auto files_vec = fileup->uploadedFiles(); //const std::vector< Http::UploadedFile > &
     for(const auto &afile : files_vec){
         // Assume ownership of the files so they do not disappear when the connection terminates.
@@ -370,16 +592,10 @@ void BaseWebServerApplication::filesUploaded(){
         // NOTE: You'll have to garbage-collect files that you steal. Perhaps by moving them to some infinite storage
         //       location or consuming when loaded into memory?
         //afile.stealSpoolFile();
-        UploadedFilesDirsReachable.emplace_back(afile.spoolFileName());
+        state->UploadedFilesDirsReachable.emplace_back(afile.spoolFileName());
 
         //Copy the file to the working directory. (Useful for debugging.)
-        if(!CopyFile(afile.spoolFileName(), 
-                     this->InstancePrivateDirectory + afile.clientFileName())
-        && !CopyFile(afile.spoolFileName(), 
-                     this->InstancePrivateDirectory + afile.spoolFileName()) ){
-            FUNCWARN("Unable to copy uploaded file '" << afile.clientFileName() << "'"
-                     << " aka '" << afile.spoolFileName() << "' to archive directory. Continuing");
-        }
+        state->ArchiveCopies.emplace_back(afile.spoolFileName(), afile.clientFileName());
     }
     fileup->disable();
 
@@ -398,91 +614,108 @@ void BaseWebServerApplication::filesUploaded(){
     }
     feedback->setText(ss.str());
     feedback->setToolTip(ss.str());
-    this->processEvents();
 
 
     // ======================= Load the files ========================
-    {
-        (void*) root()->addWidget(std::make_unique<Wt::WBreak>());
-
-        auto gb = root()->addWidget(std::make_unique<Wt::WGroupBox>("File Loading"));
-        gb->setObjectName("file_loading_gb");
-        gb->addStyleClass("DataEntryGroupBlock");
-        gb->hide();
- 
-        auto feedback = gb->addWidget(std::make_unique<Wt::WText>());
-        feedback->setObjectName("file_loading_gb_feedback");
-        feedback->addStyleClass("FeedbackText");
-        feedback->setText("<p>Loading files now...</p>");
-
-        auto sep_break = root()->addWidget(std::make_unique<Wt::WBreak>());
-        sep_break->setCanReceiveFocus(true);
-
-        gb->show();
-        sep_break->setFocus(true);
-        gb->setCanReceiveFocus(true);
-        gb->setFocus(true);
-        gb->setFocus(false);
-        this->processEvents();
+    (void*) root()->addWidget(std::make_unique<Wt::WBreak>());
 
-        //Uploaded file loading: Boost.Serialization archives.
-        if(!UploadedFilesDirsReachable.empty()
-        && !Load_From_Boost_Serialization_Files( this->DICOM_data,
-                                                 this->InvocationMetadata,
-                                                 this->FilenameLex,
-                                                 UploadedFilesDirsReachable )){
-            feedback->setText("<p>Failed to load client-provided Boost.Serialization archive. Instance terminated.</p>");
-            return;
-        }
+    auto gb = root()->addWidget(std::make_unique<Wt::WGroupBox>("File Loading"));
+    gb->setObjectName("file_loading_gb");
+    gb->addStyleClass("DataEntryGroupBlock");
+    gb->hide();
 
-        //Uploaded file loading: DICOM files.
-        if(!UploadedFilesDirsReachable.empty()
-        && !Load_From_DICOM_Files( this->DICOM_data,
-                                   this->InvocationMetadata,
-                                   this->FilenameLex,
-                                   UploadedFilesDirsReachable )){
-            feedback->setText("<p>Failed to load client-provided DICOM file. Instance terminated.</p>");
-            return;
-        }
+    auto loading_feedback = gb->addWidget(std::make_unique<Wt::WText>());
+    loading_feedback->setObjectName("file_loading_gb_feedback");
+    loading_feedback->addStyleClass("FeedbackText");
+    loading_feedback->setText("<p>Loading files now...</p>");
 
-        //Uploaded file loading: FITS files.
-        if(!UploadedFilesDirsReachable.empty()
-        && !Load_From_FITS_Files( this->DICOM_data, 
-                                  this->InvocationMetadata, 
-                                  this->FilenameLex,
-                                  UploadedFilesDirsReachable )){
-            feedback->setText("<p>Failed to load client-provided FITS file. Instance terminated.</p>");
-            return;
+    auto sep_break = root()->addWidget(std::make_unique<Wt::WBreak>());
+    sep_break->setCanReceiveFocus(true);
+
+    const auto PrivateDirectory = this->InstancePrivateDirectory;
+    auto work = [state,PrivateDirectory](webserver_job &job) -> void {
+        for(const auto &p : state->ArchiveCopies){
+            if(!CopyFile(p.first, PrivateDirectory + p.second)
+            && !CopyFile(p.first, PrivateDirectory + p.first) ){
+                FUNCWARN("Unable to copy uploaded file '" << p.second << "'"
+                         << " aka '" << p.first << "' to archive directory. Continuing");
+            }
         }
 
-        //Uploaded file loading: XYZ files.
-        if(!UploadedFilesDirsReachable.empty()
-        && !Load_From_XYZ_Files( this->DICOM_data, 
-                                  this->InvocationMetadata, 
-                                  this->FilenameLex,
-                                  UploadedFilesDirsReachable )){
-            feedback->setText("<p>Failed to load client-provided XYZ file. Instance terminated.</p>");
-            return;
+        //Files are parsed concurrently by the DICOM loader. Other loaders ignore this key.
+        const bool set_loader_threads = (state->InvocationMetadata.count("DICOMLoaderThreads") == 0);
+        if(set_loader_threads) state->InvocationMetadata["DICOMLoaderThreads"] = "0";
+
+        using loader_t = std::function<bool(Drover &,
+                                            std::map<std::string,std::string> &,
+                                            const std::string &,
+                                            std::list<boost::filesystem::path> &)>;
+        const std::list<std::pair<std::string,loader_t>> loaders = {
+            { "Boost.Serialization archive", Load_From_Boost_Serialization_Files },
+            { "DICOM file",                  Load_From_DICOM_Files },
+            { "FITS file",                   Load_From_FITS_Files },
+            { "XYZ file",                    Load_From_XYZ_Files },
+        };
+
+        auto &Paths = state->UploadedFilesDirsReachable;
+        const auto N_files = Paths.size();
+        for(const auto &l : loaders){
+            if(job.cancel_requested()) break;
+            if(Paths.empty()) break;
+
+            const auto N_before = Paths.size();
+            if(!l.second( state->DICOM_data,
+                          state->InvocationMetadata,
+                          state->FilenameLex,
+                          Paths )){
+                throw std::runtime_error("Failed to load client-provided "_s + l.first + ". Instance terminated.");
+            }
+            const auto N_loaded = N_before - Paths.size();
+            if(N_loaded != 0){
+                job.log("Loaded " + std::to_string(N_loaded) + " " + l.first + "(s).");
+            }
+
+            job.progress( static_cast<double>(N_files - Paths.size()) / static_cast<double>(N_files) );
         }
+        if(set_loader_threads) state->InvocationMetadata.erase("DICOMLoaderThreads");
 
         //Other loaders.
         // ...
 
-
         //If any standalone files remain, they cannot be loaded.
-        if(!UploadedFilesDirsReachable.empty()){
-            std::stringstream es;
-            feedback->setText("<p>Failed to load client-provided file. Instance terminated.</p>");
+        if(!job.cancel_requested() && !Paths.empty()){
+            throw std::runtime_error("Failed to load client-provided file. Instance terminated.");
+        }
+        return;
+    };
+
+    auto on_finish = [=](webserver_job::outcome res, const std::string &msg) -> void {
+        if(res == webserver_job::outcome::Failed){
+            loading_feedback->setText("<p>"_s + msg + "</p>");
+            return;
+        }
+        if(res == webserver_job::outcome::Cancelled){
+            loading_feedback->setText("<p>File loading was cancelled. Instance terminated.</p>");
             return;
         }
 
-        feedback->setText("<p>Loaded all files successfully. </p>");
-        this->processEvents();
-    }
+        this->DICOM_data = state->DICOM_data;
+        this->InvocationMetadata = state->InvocationMetadata;
+        loading_feedback->setText("<p>Loaded all files successfully. </p>");
 
-    //Create the next widgets for the user to interact with.
-    //this->createInvocationMetadataGB();
-    this->createOperationSelectorGB();
+        //Create the next widgets for the user to interact with.
+        //this->createInvocationMetadataGB();
+        this->createOperationSelectorGB();
+        return;
+    };
+
+    this->submitJob(gb, work, on_finish);
+
+    gb->show();
+    sep_break->setFocus(true);
+    gb->setCanReceiveFocus(true);
+    gb->setFocus(true);
+    gb->setFocus(false);
     return;
 }
 
@@ -1012,7 +1245,6 @@ void BaseWebServerApplication::createComputeGB(){
     gb->setCanReceiveFocus(true);
     gb->setFocus(true);
     gb->setFocus(false);
-    this->processEvents();
 
     // Gather the operation and parameters specified.
     auto selector = reinterpret_cast<Wt::WSelectionBox *>( root()->find("op_select_gb_selector") );
@@ -1027,7 +1259,7 @@ void BaseWebServerApplication::createComputeGB(){
     std::map<std::string,std::string> OutputMimetype;
     const auto rows = table->rowCount(); 
     const auto cols = table->columnCount(); 
-    bool AllSuccessful = true;
+    std::list<OperationArgPkg> Runs; // One for each column of parameters.
     for(auto col = 1; col < cols; ++col){
         auto op_doc_l = (Known_Operations()[selected_op].first)(); // Documentation parameter list.
         OperationArgPkg op_args(selected_op); // The list of parameters passed to the operation.
@@ -1172,33 +1404,83 @@ void BaseWebServerApplication::createComputeGB(){
             }
         }
 
-        // ---
+        Runs.push_back(op_args);
+    }
+
+    // ---
 
-        //Perform the operation.
-        std::list<OperationArgPkg> PackedOperation = { op_args };
-        try{
-            if(!Operation_Dispatcher( this->DICOM_data, 
-                                      this->InvocationMetadata, 
-                                      this->FilenameLex,
-                                      PackedOperation )){
-                throw std::runtime_error("Return value non-zero (non-descript error condition)");
+    //Perform the operations on the shared worker pool. Each column is performed as a separate run.
+    struct compute_state_t {
+        Drover DICOM_data;
+        std::map<std::string,std::string> InvocationMetadata;
+        std::string FilenameLex;
+        std::list<OperationArgPkg> Runs;
+        std::string LastError;
+    };
+    auto state = std::make_shared<compute_state_t>();
+    state->DICOM_data = this->DICOM_data;
+    state->InvocationMetadata = this->InvocationMetadata;
+    state->FilenameLex = this->FilenameLex;
+    state->Runs = std::move(Runs);
+
+    auto work = [state,selected_op](webserver_job &job) -> void {
+        const auto N_runs = state->Runs.size();
+        size_t i = 0;
+        for(const auto &op_args : state->Runs){
+            // Note: operations cannot be interrupted, so cancellation takes effect between runs.
+            if(job.cancel_requested()) break;
+            ++i;
+            job.log("Run " + std::to_string(i) + "/" + std::to_string(N_runs) + ": performing operation '" + selected_op + "'.");
+
+            std::list<OperationArgPkg> PackedOperation = { op_args };
+            try{
+                if(!Operation_Dispatcher( state->DICOM_data, 
+                                          state->InvocationMetadata, 
+                                          state->FilenameLex,
+                                          PackedOperation )){
+                    throw std::runtime_error("Return value non-zero (non-descript error condition)");
+                }
+                job.log("Run " + std::to_string(i) + "/" + std::to_string(N_runs) + ": completed.");
+            }catch(const std::exception &e){
+                state->LastError = e.what();
+                job.log("Run " + std::to_string(i) + "/" + std::to_string(N_runs) + ": failed: " + state->LastError + ".");
             }
-        }catch(const std::exception &e){
-            feedback->setText("<p>Operation failed: "_s + e.what() + ".</p>");
-            AllSuccessful = false;
-            //return;
+            job.progress( static_cast<double>(i) / static_cast<double>(N_runs) );
         }
-    }
-    if(AllSuccessful){
-        feedback->setText("<p>Operation successful.</p>");
-    }
+        return;
+    };
 
+    auto on_finish = [=](webserver_job::outcome res, const std::string &msg) -> void {
+        //Operations modify data in-place, so the outcome of completed runs is retained even if later runs fail or the
+        // job is cancelled.
+        this->DICOM_data = state->DICOM_data;
+
+        if(res == webserver_job::outcome::Failed){
+            feedback->setText("<p>Operation failed: "_s + msg + ".</p>");
+        }else if(res == webserver_job::outcome::Cancelled){
+            feedback->setText("<p>Operation cancelled.</p>");
+        }else if(!state->LastError.empty()){
+            feedback->setText("<p>Operation failed: "_s + state->LastError + ".</p>");
+        }else{
+            feedback->setText("<p>Operation successful.</p>");
+        }
+        this->corralComputeOutputs(gb, sep_break, OutputFiles, OutputMimetype);
+        return;
+    };
+
+    this->submitJob(gb, work, on_finish);
+    return;
+}
+
+void BaseWebServerApplication::corralComputeOutputs(Wt::WGroupBox *gb,
+                                                    Wt::WBreak *sep_break,
+                                                    const std::map<std::string,std::shared_ptr<Wt::WFileResource>> &OutputFiles,
+                                                    const std::map<std::string,std::string> &OutputMimetype){
     gb->show();
     sep_break->setFocus(true);
     gb->setCanReceiveFocus(true);
     gb->setFocus(true);
     gb->setFocus(false);
-    this->processEvents();
 
     // ---
 
@@ -1231,7 +1513,7 @@ void BaseWebServerApplication::createComputeGB(){
 
 
         // If the file is tabular, create a table to display the info.
-        if(OutputMimetype[param_name] == "text/csv"){
+        if(OutputMimetype.at(param_name) == "text/csv"){
             auto table = gb->addWidget(std::make_unique<Wt::WTable>());
             table->setHeaderCount(1);
             table->setWidth(Wt::WLength("100%"));
@@ -1275,7 +1557,7 @@ void BaseWebServerApplication::createComputeGB(){
         }
 
         // If the file is an image, display it.
-        if(OutputMimetype[param_name] == "image/png"){
+        if(OutputMimetype.at(param_name) == "image/png"){
             auto img = gb->addWidget(std::make_unique<Wt::WImage>(Wt::WLink(fr)));
             img->setAlternateText("Generated image.");
             img->hide();
@@ -1286,7 +1568,6 @@ void BaseWebServerApplication::createComputeGB(){
             overlay->addStyleClass("ImageHoverOverlay");
         }
     }
-    this->processEvents();
 
     // ---
 
@@ -1342,8 +1623,6 @@ void BaseWebServerApplication::createComputeGB(){
     sep_break->setFocus(true);
     gobutton->setCanReceiveFocus(true);
     gobutton->setFocus(true);
-    this->processEvents();
-
     return;
 }
 
@@ -24,6 +24,7 @@
 #include "Regex_Selectors.h"
 
 #include "Dose_Meld.h"
+#include "Rectilinear_Volume.h"
 
 #include "YgorImages.h"
 #include "YgorMisc.h"
@@ -242,36 +243,51 @@ std::unique_ptr<Image_Array> Meld_Unequal_Geom_Image_Data(std::shared_ptr<Image_
     *out = *larger; //Make a deep copy of the data.
 
     //Now cycle through the voxel data, collecting the dose contributions from either A or B. 
-    auto i0_it = out->imagecoll.images.begin();
-    auto i1_it = A->imagecoll.images.begin();
-    auto i2_it = B->imagecoll.images.begin();
-    for(   ;    (i0_it != out->imagecoll.images.end())
-             && (i1_it !=   A->imagecoll.images.end())
-             && (i2_it !=   B->imagecoll.images.end()); ++i0_it, ++i1_it, ++i2_it){
+    //
+    // The images in A and B which overlap each output voxel are found using volume indices, so images need not be
+    // paired up in order (or even be equal in number). The contributing images are located for every voxel because
+    // the smaller array need not cover the whole of an output image (e.g., its centre).
+    const auto A_index = A->get_volume_index();
+    const auto B_index = B->get_volume_index();
+
+    // Returns the image containing the point, checking the most recently found image first since adjacent voxels
+    // nearly always fall within the same image.
+    const auto locate = [](const image_volume_index &index,
+                           planar_image<float,double> *&last,
+                           const vec3<double> &pos) -> planar_image<float,double>* {
+        if( (last != nullptr) && (last->index(pos, 0) != -1) ) return last;
+        auto *img_ptr = index.image_encompassing(pos);
+        if(img_ptr != nullptr) last = img_ptr;
+        return img_ptr;
+    };
+
+    for(auto i0_it = out->imagecoll.images.begin(); i0_it != out->imagecoll.images.end(); ++i0_it){
+        planar_image<float,double> *i1_last = nullptr;
+        planar_image<float,double> *i2_last = nullptr;
 
         const auto rows     = i0_it->rows;
         const auto columns  = i0_it->columns;
         const auto channels = i0_it->channels;
         for(long int r = 0; r < rows; ++r){
             for(long int c = 0; c < columns; ++c){
-                for(long int l = 0; l < channels; ++l){
-                    //Clear the value in the channel.
-                    const auto zero = static_cast<decltype(i0_it->value(r,c,l))>(0);
-                    i0_it->reference(r,c,l) = zero;
+                const auto pos = i0_it->position(r,c);
+                const auto i1_ptr = locate(*A_index, i1_last, pos);
+                const auto i2_ptr = locate(*B_index, i2_last, pos);
 
+                for(long int l = 0; l < channels; ++l){
                     //Get the (floating-point) dose from each image. If out of bounds, we will 
                     // get a safe zero. 
-                    const auto pos = i0_it->position(r,c);
+                    const auto zero = static_cast<decltype(i0_it->value(r,c,l))>(0);
                     auto dose_sum = zero;
 
-                    const auto indexA = i1_it->index(pos,l);
+                    const auto indexA = (i1_ptr == nullptr) ? -1 : i1_ptr->index(pos,l);
                     if(indexA != -1){
-                        dose_sum += i1_it->value(indexA);
+                        dose_sum += i1_ptr->value(indexA);
                     }
 
-                    const auto indexB = i2_it->index(pos,l);
+                    const auto indexB = (i2_ptr == nullptr) ? -1 : i2_ptr->index(pos,l);
                     if(indexB != -1){
-                        dose_sum += i2_it->value(indexB);
+                        dose_sum += i2_ptr->value(indexB);
                     }
 
                     //Set the new value.
@@ -0,0 +1,272 @@
+//Dose_Volume_Histogram.cc - A part of DICOMautomaton 2021. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for samples_1D class.
+
+#include "Dose_Volume_Histogram.h"
+
+
+// Fixed-width histograms refuse to grow beyond this number of bins (approx 8 GB for the bins alone).
+static const int64_t dvh_fixed_width_bin_limit = 1'000'000'000;
+
+// Division rounding toward negative infinity.
+static int64_t floor_div(int64_t a, int64_t b){
+    return (a / b) - (((a % b) != 0) && ((a < 0) != (b < 0)));
+}
+
+
+dose_volume_histogram::dose_volume_histogram(double bin_width, double origin, int64_t max_bins)
+    : binning((max_bins == 0) ? binning_method::fixed_width : binning_method::adaptive),
+      origin(origin),
+      bin_width(bin_width),
+      max_bins((max_bins == 0) ? dvh_fixed_width_bin_limit : max_bins) {
+    if(!std::isfinite(bin_width) || (bin_width <= 0.0)){
+        throw std::invalid_argument("Histogram bin width must be finite and positive.");
+    }
+    if(!std::isfinite(origin)){
+        throw std::invalid_argument("Histogram origin must be finite.");
+    }
+    if(max_bins < 0){
+        throw std::invalid_argument("Histogram bin limit must be non-negative.");
+    }
+    if((this->binning == binning_method::adaptive) && (max_bins < 2)){
+        throw std::invalid_argument("Adaptive histograms require at least two bins.");
+    }
+}
+
+int64_t dose_volume_histogram::bin_index(double dose) const {
+    const auto k = std::floor((dose - this->origin) / this->bin_width);
+    if(!(std::abs(k) < 9.0E18)){
+        throw std::runtime_error("Voxel value cannot be represented with the current histogram bin width.");
+    }
+    return static_cast<int64_t>(k);
+}
+
+void dose_volume_histogram::coarsen(){
+    // Merge adjacent bins pairwise. Because bins are aligned to the origin, bins 2K and 2K+1 become bin K.
+    const auto new_first = floor_div(this->first_bin, 2);
+    const auto N_bins = static_cast<int64_t>(this->bins.size());
+    std::vector<double> merged( static_cast<size_t>(floor_div(this->first_bin + N_bins - 1, 2) - new_first + 1), 0.0 );
+    for(int64_t i = 0; i < N_bins; ++i){
+        merged[ static_cast<size_t>(floor_div(this->first_bin + i, 2) - new_first) ] += this->bins[i];
+    }
+    this->bins.swap(merged);
+    this->first_bin = new_first;
+    this->bin_width *= 2.0;
+    return;
+}
+
+void dose_volume_histogram::add_to_bin(double dose, double weight){
+    auto k = this->bin_index(dose);
+    if(this->bins.empty()){
+        this->first_bin = k;
+        this->bins.assign(1, weight);
+        return;
+    }
+
+    auto last_bin = this->first_bin + static_cast<int64_t>(this->bins.size()) - 1;
+    if((k < this->first_bin) || (last_bin < k)){
+        auto span = std::max(last_bin, k) - std::min(this->first_bin, k) + 1;
+        if(this->binning == binning_method::adaptive){
+            while(this->max_bins < span){
+                this->coarsen();
+                k = this->bin_index(dose);
+                last_bin = this->first_bin + static_cast<int64_t>(this->bins.size()) - 1;
+                span = std::max(last_bin, k) - std::min(this->first_bin, k) + 1;
+            }
+        }else if(this->max_bins < span){
+            throw std::runtime_error("Excessive number of histogram bins required. Increase the bin width.");
+        }
+
+        if(k < this->first_bin){
+            this->bins.insert(this->bins.begin(), static_cast<size_t>(this->first_bin - k), 0.0);
+            this->first_bin = k;
+        }else if(last_bin < k){
+            this->bins.resize(static_cast<size_t>(k - this->first_bin + 1), 0.0);
+        }
+    }
+    this->bins[ static_cast<size_t>(k - this->first_bin) ] += weight;
+    return;
+}
+
+void dose_volume_histogram::digest(double dose, double weight){
+    if( !std::isfinite(dose)
+    ||  !std::isfinite(weight)
+    ||  (weight <= 0.0) ) return;
+
+    this->add_to_bin(dose, weight);
+
+    // Weighted incremental mean and variance (West, 1979).
+    ++(this->N);
+    this->W += weight;
+    const auto delta = dose - this->mean_dose;
+    this->mean_dose += delta * (weight / this->W);
+    this->M2 += weight * delta * (dose - this->mean_dose);
+
+    if(dose < this->min_dose) this->min_dose = dose;
+    if(this->max_dose < dose) this->max_dose = dose;
+    return;
+}
+
+void dose_volume_histogram::merge(const dose_volume_histogram &other){
+    if(other.empty()) return;
+    if(this->origin != other.origin){
+        throw std::invalid_argument("Unable to merge histograms with differing origins.");
+    }
+
+    // Coarsen this histogram until it is at least as coarse as the other. Bins of the other histogram then nest
+    // within bins of this histogram, so they can be added by their centres.
+    const auto rel_eps = 1.0E-9;
+    while(this->bin_width < other.bin_width * (1.0 - rel_eps)){
+        if(this->binning != binning_method::adaptive){
+            throw std::invalid_argument("Unable to merge histograms with differing bin widths.");
+        }
+        this->coarsen();
+    }
+    const auto ratio = this->bin_width / other.bin_width;
+    const auto log2_ratio = std::log2(ratio);
+    if(std::abs(log2_ratio - std::round(log2_ratio)) > rel_eps){
+        throw std::invalid_argument("Unable to merge histograms with incommensurate bin widths.");
+    }
+
+    const auto N_bins = static_cast<int64_t>(other.bins.size());
+    for(int64_t i = 0; i < N_bins; ++i){
+        const auto w = other.bins[i];
+        if(w <= 0.0) continue;
+        const auto centre = other.origin + other.bin_width * (static_cast<double>(other.first_bin + i) + 0.5);
+        this->add_to_bin(centre, w);
+    }
+
+    // Combine the moments (Chan et al., 1979).
+    const auto W_total = this->W + other.W;
+    const auto delta = other.mean_dose - this->mean_dose;
+    this->mean_dose += delta * (other.W / W_total);
+    this->M2 += other.M2 + delta * delta * (this->W * other.W / W_total);
+    this->W = W_total;
+    this->N += other.N;
+
+    this->min_dose = std::min(this->min_dose, other.min_dose);
+    this->max_dose = std::max(this->max_dose, other.max_dose);
+    return;
+}
+
+void dose_volume_histogram::clear(){
+    this->first_bin = 0;
+    this->bins.clear();
+    this->N = 0;
+    this->W = 0.0;
+    this->mean_dose = 0.0;
+    this->M2 = 0.0;
+    this->min_dose = std::numeric_limits<double>::infinity();
+    this->max_dose = -std::numeric_limits<double>::infinity();
+    return;
+}
+
+bool dose_volume_histogram::empty() const {
+    return (this->N == 0);
+}
+
+dose_volume_histogram::binning_method dose_volume_histogram::get_binning_method() const {
+    return this->binning;
+}
+
+double dose_volume_histogram::get_bin_width() const {
+    return this->bin_width;
+}
+
+int64_t dose_volume_histogram::count() const {
+    return this->N;
+}
+
+double dose_volume_histogram::volume() const {
+    return this->W;
+}
+
+double dose_volume_histogram::min() const {
+    return (this->empty()) ? std::numeric_limits<double>::quiet_NaN() : this->min_dose;
+}
+
+double dose_volume_histogram::max() const {
+    return (this->empty()) ? std::numeric_limits<double>::quiet_NaN() : this->max_dose;
+}
+
+double dose_volume_histogram::mean() const {
+    return (this->empty()) ? std::numeric_limits<double>::quiet_NaN() : this->mean_dose;
+}
+
+double dose_volume_histogram::variance() const {
+    return (this->empty()) ? std::numeric_limits<double>::quiet_NaN() : (this->M2 / this->W);
+}
+
+double dose_volume_histogram::volume_above(double dose) const {
+    if(this->empty() || (this->max_dose < dose)) return 0.0;
+    if(dose <= this->min_dose) return this->W;
+
+    const auto k = this->bin_index(dose);
+    const auto N_bins = static_cast<int64_t>(this->bins.size());
+    const auto i = k - this->first_bin;
+
+    double V = 0.0;
+    for(int64_t j = N_bins - 1; i < j; --j) V += this->bins[j];
+
+    // Assume the voxels within the bin are uniformly distributed.
+    const auto upper_edge = this->origin + this->bin_width * static_cast<double>(k + 1);
+    const auto frac = std::clamp((upper_edge - dose) / this->bin_width, 0.0, 1.0);
+    V += this->bins[i] * frac;
+    return V;
+}
+
+double dose_volume_histogram::dose_covering(double volume_fraction) const {
+    if(this->empty()) return std::numeric_limits<double>::quiet_NaN();
+    if(volume_fraction <= 0.0) return this->max_dose;
+    if(1.0 <= volume_fraction) return this->min_dose;
+
+    // Walk down from the hottest bin until the requested volume is covered.
+    const auto V_target = volume_fraction * this->W;
+    const auto N_bins = static_cast<int64_t>(this->bins.size());
+    double V = 0.0;
+    for(int64_t j = N_bins - 1; 0 <= j; --j){
+        const auto w = this->bins[j];
+        if((0.0 < w) && (V_target <= (V + w))){
+            const auto upper_edge = this->origin + this->bin_width * static_cast<double>(this->first_bin + j + 1);
+            const auto D = upper_edge - this->bin_width * ((V_target - V) / w);
+            return std::clamp(D, this->min_dose, this->max_dose);
+        }
+        V += w;
+    }
+    return this->min_dose;
+}
+
+samples_1D<double> dose_volume_histogram::differential() const {
+    samples_1D<double> out;
+    const auto N_bins = static_cast<int64_t>(this->bins.size());
+    out.samples.reserve(static_cast<size_t>(N_bins));
+    for(int64_t i = 0; i < N_bins; ++i){
+        const auto centre = this->origin + this->bin_width * (static_cast<double>(this->first_bin + i) + 0.5);
+        out.samples.push_back( {centre, 0.0, this->bins[i], 0.0} );
+    }
+    return out;
+}
+
+samples_1D<double> dose_volume_histogram::cumulative() const {
+    samples_1D<double> out;
+    const auto N_bins = static_cast<int64_t>(this->bins.size());
+    if(N_bins == 0) return out;
+
+    out.samples.resize(static_cast<size_t>(N_bins + 1));
+    double V = 0.0;
+    for(int64_t i = N_bins; 0 <= i; --i){
+        const auto lower_edge = this->origin + this->bin_width * static_cast<double>(this->first_bin + i);
+        out.samples[i] = {lower_edge, 0.0, V, 0.0};
+        if(0 < i) V += this->bins[i - 1];
+    }
+    return out;
+}
+
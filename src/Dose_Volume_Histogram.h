@@ -0,0 +1,98 @@
+//Dose_Volume_Histogram.h - A part of DICOMautomaton 2021. Written by hal clark.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for samples_1D class.
+
+
+// A single-pass dose-volume histogram.
+//
+// Voxel doses (or any other voxel intensities) are binned as they are visited, so the distribution itself never needs
+// to be stored or rescanned. Each voxel can carry a weight, e.g., its volume or its volume scaled by the fraction of
+// the voxel that lies within an ROI (i.e., partial-volume weighting).
+//
+// Bins are aligned to the origin, i.e., bin k spans [origin + k*bin_width, origin + (k+1)*bin_width). Two binning
+// methods are available:
+//
+//   - Fixed-width histograms keep the requested bin width and grow to accommodate any voxel value.
+//
+//   - Adaptive histograms cap the number of bins. When a voxel would require more bins, adjacent bins are merged
+//     pairwise (doubling the bin width) until it fits. Memory use is therefore bounded regardless of the range of
+//     voxel values, and the bin width adapts to the distribution.
+//
+// Histograms can be accumulated independently (e.g., in separate threads) and merged afterward, provided they share an
+// origin and their bin widths differ by a power of two.
+//
+// Extrema, the (weighted) mean, and the (weighted) variance are tracked exactly. Quantities that depend on the
+// distribution (cumulative volumes and dose-at-volume metrics) assume voxel values are uniformly distributed within
+// each bin, so they are exact only at bin edges.
+class dose_volume_histogram {
+    public:
+        enum class binning_method {
+            fixed_width,
+            adaptive,
+        };
+
+    private:
+        binning_method binning;
+        double origin;
+        double bin_width;
+        int64_t max_bins;
+
+        int64_t first_bin = 0;       // The index of bins.front(), relative to the origin.
+        std::vector<double> bins;    // The accumulated weight in each bin.
+
+        int64_t N = 0;               // Number of digested voxels.
+        double W = 0.0;              // Total digested weight.
+        double mean_dose = 0.0;      // Weighted mean, updated incrementally.
+        double M2 = 0.0;             // Weighted sum of squared deviations from the mean.
+        double min_dose = std::numeric_limits<double>::infinity();
+        double max_dose = -std::numeric_limits<double>::infinity();
+
+        int64_t bin_index(double dose) const;
+        void coarsen();
+        void add_to_bin(double dose, double weight);
+
+    public:
+        // Fixed-width binning is used when max_bins is zero. Otherwise binning is adaptive; bins start with the given
+        // width and are merged as needed to respect max_bins.
+        explicit dose_volume_histogram(double bin_width, double origin = 0.0, int64_t max_bins = 0);
+
+        // Bins a single voxel. Non-finite doses and non-positive weights are ignored.
+        void digest(double dose, double weight = 1.0);
+
+        // Adds the contents of another histogram. Adaptive histograms will coarsen to match, if necessary.
+        void merge(const dose_volume_histogram &other);
+
+        // Discards all digested voxels, but retains the binning configuration (including any adaptive coarsening).
+        void clear();
+
+        bool empty() const;
+        binning_method get_binning_method() const;
+        double get_bin_width() const;
+
+        int64_t count() const;    // Number of voxels digested.
+        double volume() const;    // Total weight digested.
+        double min() const;
+        double max() const;
+        double mean() const;
+        double variance() const;  // Weighted population variance.
+
+        // The volume receiving a dose greater than or equal to the given dose, i.e., V_{D}.
+        double volume_above(double dose) const;
+
+        // The minimum dose received by the hottest fraction of the volume, i.e., D_{x%} with x = 100*volume_fraction.
+        // For example, 0.5 gives the median dose and 0.02 gives D_{2%}.
+        double dose_covering(double volume_fraction) const;
+
+        // Volume per bin vs bin centre, spanning the occupied bins.
+        samples_1D<double> differential() const;
+
+        // Volume receiving at least the given dose vs dose, sampled at the occupied bins' edges.
+        samples_1D<double> cumulative() const;
+};
+
@@ -0,0 +1,169 @@
+//Image_Signature.cc - A part of DICOMautomaton 2021. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
+#include "Image_Signature.h"
+
+
+// Scrambles the bits of a 64-bit word (the SplitMix64 finalizer).
+static uint64_t mix_bits(uint64_t x){
+    x ^= (x >> 30);
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= (x >> 27);
+    x *= 0x94d049bb133111ebULL;
+    x ^= (x >> 31);
+    return x;
+}
+
+static uint64_t hash_combine(uint64_t h, uint64_t x){
+    return (h ^ mix_bits(x)) * 0x100000001b3ULL;
+}
+
+static uint64_t hash_combine(uint64_t h, double x){
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return hash_combine(h, bits);
+}
+
+static uint64_t hash_combine(uint64_t h, const vec3<double> &v){
+    return hash_combine(hash_combine(hash_combine(h, v.x), v.y), v.z);
+}
+
+static uint64_t hash_combine(uint64_t h, float x){
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return hash_combine(h, static_cast<uint64_t>(bits));
+}
+
+static uint64_t image_geometry_hash(const planar_image<float,double> &img){
+    uint64_t h = 0xcbf29ce484222325ULL;
+    h = hash_combine(h, static_cast<uint64_t>(img.rows));
+    h = hash_combine(h, static_cast<uint64_t>(img.columns));
+    h = hash_combine(h, static_cast<uint64_t>(img.channels));
+    h = hash_combine(h, img.pxl_dx);
+    h = hash_combine(h, img.pxl_dy);
+    h = hash_combine(h, img.pxl_dz);
+    h = hash_combine(h, img.anchor);
+    h = hash_combine(h, img.offset);
+    h = hash_combine(h, img.row_unit);
+    h = hash_combine(h, img.col_unit);
+    return h;
+}
+
+static uint64_t image_content_hash(const planar_image<float,double> &img){
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for(const auto &val : img.data){
+        h = hash_combine(h, val);
+    }
+    return h;
+}
+
+
+image_array_signature::image_array_signature(const planar_image_collection<float,double> &imagecoll){
+    const auto inf = std::numeric_limits<double>::infinity();
+    this->histogram.fill(0);
+    this->bbox_min = vec3<double>( inf,  inf,  inf);
+    this->bbox_max = vec3<double>(-inf, -inf, -inf);
+
+    if(!imagecoll.images.empty()){
+        this->centre = imagecoll.center();
+        this->volume = imagecoll.volume();
+    }
+
+    uint64_t g_hash = 0xcbf29ce484222325ULL;
+    uint64_t c_hash = 0xcbf29ce484222325ULL;
+    double min = inf;
+    double max = -inf;
+    double sum = 0.0;
+    int64_t N = 0;
+    for(const auto &img : imagecoll.images){
+        const auto img_g_hash = image_geometry_hash(img);
+        g_hash = hash_combine(g_hash, img_g_hash);
+        const auto img_c_hash = image_content_hash(img);
+        c_hash = hash_combine(c_hash, img_c_hash);
+        this->fingerprints.push_back( { &img, img.data.data(), img.data.size(), img_g_hash, img_c_hash } );
+
+        // Extend the bounding box using the outer corners of the corner voxels.
+        if( (0 < img.rows) && (0 < img.columns) ){
+            const auto normal = img.row_unit.Cross(img.col_unit).unit();
+            const auto dR = img.row_unit * (img.pxl_dx * 0.5);
+            const auto dC = img.col_unit * (img.pxl_dy * 0.5);
+            const auto dN = normal * (img.pxl_dz * 0.5);
+            for(const auto r : { 0L, img.rows - 1L }){
+                for(const auto c : { 0L, img.columns - 1L }){
+                    const auto pos = img.position(r, c);
+                    for(const auto sR : { -1.0, 1.0 }){
+                        for(const auto sC : { -1.0, 1.0 }){
+                            for(const auto sN : { -1.0, 1.0 }){
+                                const auto P = pos + dR * sR + dC * sC + dN * sN;
+                                this->bbox_min.x = std::min(this->bbox_min.x, P.x);
+                                this->bbox_min.y = std::min(this->bbox_min.y, P.y);
+                                this->bbox_min.z = std::min(this->bbox_min.z, P.z);
+                                this->bbox_max.x = std::max(this->bbox_max.x, P.x);
+                                this->bbox_max.y = std::max(this->bbox_max.y, P.y);
+                                this->bbox_max.z = std::max(this->bbox_max.z, P.z);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        for(const auto &val : img.data){
+            if(!std::isfinite(val)) continue;
+            const auto v = static_cast<double>(val);
+            if(v < min) min = v;
+            if(max < v) max = v;
+            sum += v;
+            ++N;
+        }
+    }
+    this->geometry_hash = g_hash;
+    this->content_hash = c_hash;
+
+    this->N_voxels = N;
+    if(0 < N){
+        this->min = min;
+        this->max = max;
+        this->mean = sum / static_cast<double>(N);
+
+        const auto width = (max - min) / static_cast<double>(N_hist_bins);
+        for(const auto &img : imagecoll.images){
+            for(const auto &val : img.data){
+                if(!std::isfinite(val)) continue;
+                auto k = (0.0 < width) ? static_cast<long int>((static_cast<double>(val) - min) / width) : 0L;
+                k = std::clamp(k, 0L, N_hist_bins - 1L);
+                ++(this->histogram[k]);
+            }
+        }
+    }
+}
+
+bool image_array_signature::is_current(const planar_image_collection<float,double> &imagecoll) const {
+    if(imagecoll.images.size() != this->fingerprints.size()) return false;
+
+    auto f_it = std::begin(this->fingerprints);
+    for(const auto &img : imagecoll.images){
+        const auto &f = *f_it;
+        if( (f.img != &img)
+        ||  (f.data != img.data.data())
+        ||  (f.N_data != img.data.size())
+        ||  (f.geometry_hash != image_geometry_hash(img))
+        ||  (f.content_hash != image_content_hash(img)) ){
+            return false;
+        }
+        ++f_it;
+    }
+    return true;
+}
+
@@ -0,0 +1,56 @@
+//Image_Signature.h - A part of DICOMautomaton 2021. Written by hal clark.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
+
+// A compact summary of an image collection's geometry and voxel intensities.
+//
+// Signatures are meant to be cached (see Image_Array::get_signature()) so that image collections can be compared or
+// bucketed without rescanning voxel data.
+class image_array_signature {
+    public:
+        // Number of bins in the coarse intensity histogram.
+        static constexpr long int N_hist_bins = 32;
+
+        // Geometry.
+        uint64_t geometry_hash = 0;   // Hash of every image's dimensions, spacing, position, and orientation.
+        vec3<double> bbox_min;        // Axis-aligned bounding box enclosing all voxels (not just voxel centres).
+        vec3<double> bbox_max;
+        vec3<double> centre;          // As per planar_image_collection::center().
+        double volume = 0.0;          // As per planar_image_collection::volume().
+
+        // Voxel intensities, considering all channels. Non-finite intensities are excluded from the statistics, but
+        // not from the content hash.
+        int64_t N_voxels = 0;
+        double min = 0.0;
+        double max = 0.0;
+        double mean = 0.0;
+        std::array<int64_t, N_hist_bins> histogram; // Equal-width bins spanning [min, max].
+        uint64_t content_hash = 0;    // Hash of every voxel intensity, image-by-image.
+
+        explicit image_array_signature(const planar_image_collection<float,double> &imagecoll);
+
+        // Returns true iff the collection appears unaltered since the signature was computed.
+        //
+        // Geometry is compared exactly. Voxel intensities are compared using a hash of every voxel, so this requires a
+        // full pass over the voxel data, but it is still considerably cheaper than recomputing the signature.
+        bool is_current(const planar_image_collection<float,double> &imagecoll) const;
+
+    private:
+        struct image_fingerprint {
+            const planar_image<float,double> *img;
+            const float *data;
+            size_t N_data;
+            uint64_t geometry_hash;
+            uint64_t content_hash;
+        };
+        std::vector<image_fingerprint> fingerprints;
+};
+
@@ -585,6 +585,41 @@ FUNCINFO("    This node is a leaf node. Creating a leaf tag");
 
 
 
+//----------------- Parsed files ------------------
+//The parsed top-level data set is held here so the Imebra types do not leak into the header.
+class Parsed_DICOM_File {
+  public:
+    std::string filename;
+    puntoexe::ptr<puntoexe::imebra::dataSet> tds;
+};
+
+//Parse a file once so that multiple facets can be extracted without re-reading it.
+//
+//NOTE: Throws on error.
+std::shared_ptr<Parsed_DICOM_File> Parse_DICOM_File(const std::string &filename){
+    using namespace puntoexe;
+    ptr<puntoexe::stream> readStream(new puntoexe::stream);
+    readStream->openFile(filename.c_str(), std::ios::in);
+    if(readStream == nullptr){
+        throw std::runtime_error("Unable to open file '"_s + filename + "'");
+    }
+
+    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
+
+    auto out = std::make_shared<Parsed_DICOM_File>();
+    out->filename = filename;
+    out->tds = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    if(out->tds == nullptr){
+        throw std::runtime_error("Unable to parse file '"_s + filename + "'. Is it valid DICOM?");
+    }
+    return out;
+}
+
+const std::string & get_filename(const Parsed_DICOM_File &pdf){
+    return pdf.filename;
+}
+
+
 //------------------ General ----------------------
 //This is used to grab the contents of a single DICOM tag. It can be used for whatever. Some routines
 // use it to grab specific things. Each invocation involves disk access and file parsing.
@@ -602,11 +637,19 @@ std::string get_tag_as_string(const std::string &filename, size_t U, size_t L){
     return TopDataSet->getString(U, 0, L, 0);
 }
 
+std::string get_tag_as_string(const Parsed_DICOM_File &pdf, size_t U, size_t L){
+    return pdf.tds->getString(U, 0, L, 0);
+}
+
 std::string get_modality(const std::string &filename){
     //Should exist in each DICOM file.
     return get_tag_as_string(filename,0x0008,0x0060);
 }
 
+std::string get_modality(const Parsed_DICOM_File &pdf){
+    return get_tag_as_string(pdf,0x0008,0x0060);
+}
+
 std::string get_patient_ID(const std::string &filename){
     //Should exist in each DICOM file.
     return get_tag_as_string(filename,0x0010,0x0020);
@@ -616,21 +659,23 @@ std::string get_patient_ID(const std::string &filename){
 //
 //NOTE: May not be complete. Add additional tags as needed!
 std::map<std::string,std::string> get_metadata_top_level_tags(const std::string &filename){
-    std::map<std::string,std::string> out;
-    const auto ctrim = CANONICALIZE::TRIM_ENDS;
-
-    //Attempt to parse the DICOM file and harvest the elements of interest. We are only interested in
-    // top-level elements specifying metadata (i.e., not pixel data) and will not need to recurse into 
-    // any DICOM sequences.
-    puntoexe::ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(filename.c_str(), std::ios::in);
-    if(readStream == nullptr){
+    std::shared_ptr<Parsed_DICOM_File> pdf;
+    try{
+        pdf = Parse_DICOM_File(filename);
+    }catch(const std::exception &){
         FUNCWARN("Could not parse file '" << filename << "'. Is it valid DICOM? Cannot continue");
-        return out;
+        return std::map<std::string,std::string>();
     }
+    return get_metadata_top_level_tags(*pdf);
+}
+
+std::map<std::string,std::string> get_metadata_top_level_tags(const Parsed_DICOM_File &pdf){
+    std::map<std::string,std::string> out;
+    const auto ctrim = CANONICALIZE::TRIM_ENDS;
 
-    puntoexe::ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    puntoexe::ptr<puntoexe::imebra::dataSet> tds = puntoexe::imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    //Harvest the elements of interest from the parsed DICOM file. We are only interested in top-level elements
+    // specifying metadata (i.e., not pixel data) and will not need to recurse into any DICOM sequences.
+    puntoexe::ptr<puntoexe::imebra::dataSet> tds = pdf.tds;
 
     //We pull out all the data we need as strings. For single element strings, the SQL engine can directly perform
     // the type casting. The benefit of this is twofold: (1) the SQL engine hides the checking code, simplifying
@@ -1125,12 +1170,12 @@ std::map<std::string,std::string> get_metadata_top_level_tags(const std::string
 //Returns a bimap with the (raw) ROI tags and their corresponding ROI numbers. The ROI numbers are
 // arbitrary identifiers used within the DICOM file to identify contours more conveniently.
 bimap<std::string,long int> get_ROI_tags_and_numbers(const std::string &FilenameIn){
-    using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(FilenameIn.c_str(), std::ios::in);
+    return get_ROI_tags_and_numbers(*Parse_DICOM_File(FilenameIn));
+}
 
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+bimap<std::string,long int> get_ROI_tags_and_numbers(const Parsed_DICOM_File &pdf){
+    using namespace puntoexe;
+    ptr<imebra::dataSet> TopDataSet = pdf.tds;
     ptr<imebra::dataSet> SecondDataSet;
 
     size_t i=0, j;
@@ -1165,16 +1210,17 @@ bimap<std::string,long int> get_ROI_tags_and_numbers(const std::string &Filename
 
 //Returns contour data from a DICOM RTSTRUCT file sorted into ROI-specific collections.
 std::unique_ptr<Contour_Data> get_Contour_Data(const std::string &filename){
+    return get_Contour_Data(*Parse_DICOM_File(filename));
+}
+
+std::unique_ptr<Contour_Data> get_Contour_Data(const Parsed_DICOM_File &pdf){
     auto output = std::make_unique<Contour_Data>();
-    bimap<std::string,long int> tags_names_and_numbers = get_ROI_tags_and_numbers(filename);
+    bimap<std::string,long int> tags_names_and_numbers = get_ROI_tags_and_numbers(pdf);
 
-    auto FileMetadata = get_metadata_top_level_tags(filename);
+    auto FileMetadata = get_metadata_top_level_tags(pdf);
 
     using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(filename.c_str(), std::ios::in);
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    ptr<imebra::dataSet> TopDataSet = pdf.tds;
     ptr<imebra::dataSet> SecondDataSet, ThirdDataSet;
 
     //Collect the data into a container of contours with meta info. It may be unordered (within the file).
@@ -1260,14 +1306,14 @@ std::unique_ptr<Contour_Data> get_Contour_Data(const std::string &filename){
 //       handles multi-frame images (and thus might be adaptable for other non-RTDOSE multi-frame 
 //       images).
 std::unique_ptr<Image_Array> Load_Image_Array(const std::string &FilenameIn){
+    return Load_Image_Array(*Parse_DICOM_File(FilenameIn));
+}
+
+std::unique_ptr<Image_Array> Load_Image_Array(const Parsed_DICOM_File &pdf){
     auto out = std::make_unique<Image_Array>();
 
     using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(FilenameIn.c_str(), std::ios::in);
-
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    ptr<imebra::dataSet> TopDataSet = pdf.tds;
 
     //Helper routines that do not create tags when they are missing.
     //
@@ -1575,7 +1621,7 @@ std::unique_ptr<Image_Array> Load_Image_Array(const std::string &FilenameIn){
             // a 'row'. Perhaps I've got many things backward...
         }
 
-        out->imagecoll.images.back().metadata = get_metadata_top_level_tags(FilenameIn);
+        out->imagecoll.images.back().metadata = get_metadata_top_level_tags(pdf);
         out->imagecoll.images.back().init_orientation(image_orien_r,image_orien_c);
 
         const auto img_chnls = static_cast<long int>(channelsNumber);
@@ -1654,17 +1700,18 @@ std::unique_ptr<Image_Array> Collate_Image_Arrays(std::list<std::shared_ptr<Imag
 //--------------------- Dose -----------------------
 //This routine reads a single DICOM dose file.
 std::unique_ptr<Image_Array>  Load_Dose_Array(const std::string &FilenameIn){
-    auto metadata = get_metadata_top_level_tags(FilenameIn);
+    return Load_Dose_Array(*Parse_DICOM_File(FilenameIn));
+}
+
+std::unique_ptr<Image_Array>  Load_Dose_Array(const Parsed_DICOM_File &pdf){
+    const auto &FilenameIn = pdf.filename;
+    auto metadata = get_metadata_top_level_tags(pdf);
     metadata["Modality"] = "RTDOSE";
 
     auto out = std::make_unique<Image_Array>();
 
     using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(FilenameIn.c_str(), std::ios::in);
-
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> TopDataSet = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    ptr<imebra::dataSet> TopDataSet = pdf.tds;
 
     //These should exist in all files. They appear to be the same for CT and DS files of the same set. Not sure
     // if this is *always* the case.
@@ -1831,14 +1878,15 @@ std::list<std::shared_ptr<Image_Array>>  Load_Dose_Arrays(const std::list<std::s
 
 std::unique_ptr<TPlan_Config> 
 Load_TPlan_Config(const std::string &FilenameIn){
+    return Load_TPlan_Config(*Parse_DICOM_File(FilenameIn));
+}
+
+std::unique_ptr<TPlan_Config> 
+Load_TPlan_Config(const Parsed_DICOM_File &pdf){
     std::unique_ptr<TPlan_Config> out(new TPlan_Config());
 
     using namespace puntoexe;
-    ptr<puntoexe::stream> readStream(new puntoexe::stream);
-    readStream->openFile(FilenameIn.c_str(), std::ios::in);
-
-    ptr<puntoexe::streamReader> reader(new puntoexe::streamReader(readStream));
-    ptr<imebra::dataSet> base_node_ptr = imebra::codecs::codecFactory::getCodecFactory()->load(reader);
+    ptr<imebra::dataSet> base_node_ptr = pdf.tds;
 
 
     const auto convert_first_to_string = [](const std::vector<std::string> &in) -> std::optional<std::string> {
@@ -1911,7 +1959,7 @@ Load_TPlan_Config(const std::string &FilenameIn){
 
 
     // ------------------------------------------- General --------------------------------------------------
-    out->metadata = get_metadata_top_level_tags(FilenameIn);
+    out->metadata = get_metadata_top_level_tags(pdf);
     out->metadata["Modality"] = "RTPLAN";
 
     // DoseReferenceSequence
@@ -17,6 +17,20 @@ class Contour_Data;
 class Image_Array;
 
 
+//----------------- Parsed files ------------------
+//Parsing dominates the cost of loading a file, so routines which need several facets of the same file (e.g., the
+// modality, top-level metadata, and pixel data) should parse it once and pass around the resultant handle.
+//
+// Note: handles are opaque to keep Imebra black-boxed. Distinct handles can be used concurrently from distinct
+//       threads, but a single handle should only be used by one thread at a time.
+class Parsed_DICOM_File;
+
+//Throws if the file cannot be parsed.
+std::shared_ptr<Parsed_DICOM_File> Parse_DICOM_File(const std::string &filename);
+
+const std::string & get_filename(const Parsed_DICOM_File &pdf);
+
+
 //------------------ General ----------------------
 //Generic helper functions.
 std::string Generate_Random_UID(long int len);
@@ -25,8 +39,10 @@ std::string Generate_Random_Int_Str(long int low, long int high);
 
 //One-offs.
 std::string get_tag_as_string(const std::string &filename, size_t U, size_t L);
+std::string get_tag_as_string(const Parsed_DICOM_File &pdf, size_t U, size_t L);
 
 std::string get_modality(const std::string &filename);
+std::string get_modality(const Parsed_DICOM_File &pdf);
 
 std::string get_patient_ID(const std::string &filename);
 
@@ -34,17 +50,21 @@ std::string get_patient_ID(const std::string &filename);
 //
 //NOTE: May not be complete. Add additional tags as needed!
 std::map<std::string,std::string> get_metadata_top_level_tags(const std::string &filename);
+std::map<std::string,std::string> get_metadata_top_level_tags(const Parsed_DICOM_File &pdf);
 
 
 //------------------ Contours ---------------------
 bimap<std::string,long int> get_ROI_tags_and_numbers(const std::string &filename);
+bimap<std::string,long int> get_ROI_tags_and_numbers(const Parsed_DICOM_File &pdf);
 
 std::unique_ptr<Contour_Data>  get_Contour_Data(const std::string &filename);
+std::unique_ptr<Contour_Data>  get_Contour_Data(const Parsed_DICOM_File &pdf);
 
 
 //-------------------- Images ----------------------
 //This routine will often result in an array with only a single image. So collate output as needed.
 std::unique_ptr<Image_Array> Load_Image_Array(const std::string &filename);
+std::unique_ptr<Image_Array> Load_Image_Array(const Parsed_DICOM_File &pdf);
 
 //These pointers will actually be unique. This just aims to convert from unique_ptr to shared_ptr for you.
 std::list<std::shared_ptr<Image_Array>>  Load_Image_Arrays(const std::list<std::string> &filenames);
@@ -55,12 +75,14 @@ std::unique_ptr<Image_Array> Collate_Image_Arrays(std::list<std::shared_ptr<Imag
 
 //--------------------- Dose -----------------------
 std::unique_ptr<Image_Array> Load_Dose_Array(const std::string &filename);
+std::unique_ptr<Image_Array> Load_Dose_Array(const Parsed_DICOM_File &pdf);
 
 //These pointers will actually be unique. This just aims to convert from unique_ptr to shared_ptr for you.
 std::list<std::shared_ptr<Image_Array>>  Load_Dose_Arrays(const std::list<std::string> &filenames);
 
 //-------------------- Plans ------------------------
 std::unique_ptr<TPlan_Config> Load_TPlan_Config(const std::string &filename);
+std::unique_ptr<TPlan_Config> Load_TPlan_Config(const Parsed_DICOM_File &pdf);
 
 //-------------------- Export -----------------------
 //Writes an Image_Array as if it were a dose matrix.
@@ -134,6 +134,7 @@
 #include "Operations/RankPixels.h"
 #include "Operations/ReduceNeighbourhood.h"
 #include "Operations/Repeat.h"
+#include "Operations/ResampleImages.h"
 #include "Operations/ScalePixels.h"
 #include "Operations/SelectSlicesIntersectingROI.h"
 #include "Operations/SimplifyContours.h"
@@ -321,6 +322,7 @@ std::map<std::string, op_packet_t> Known_Operations(){
     out["RankPixels"] = std::make_pair(OpArgDocRankPixels, RankPixels);
     out["ReduceNeighbourhood"] = std::make_pair(OpArgDocReduceNeighbourhood, ReduceNeighbourhood);
     out["Repeat"] = std::make_pair(OpArgDocReduceNeighbourhood, Repeat);
+    out["ResampleImages"] = std::make_pair(OpArgDocResampleImages, ResampleImages);
     out["ScalePixels"] = std::make_pair(OpArgDocScalePixels, ScalePixels);
     out["SelectSlicesIntersectingROI"] = std::make_pair(OpArgDocSelectSlicesIntersectingROI, SelectSlicesIntersectingROI);
     out["SimplifyContours"] = std::make_pair(OpArgDocSimplifyContours, SimplifyContours);
@@ -1,6 +1,8 @@
 //BoostSerializeDrover.cc - A part of DICOMautomaton 2016. Written by hal clark.
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem.hpp>
+#include <functional>
 #include <optional>
 #include <list>
 #include <map>
@@ -25,8 +27,7 @@ OperationDoc OpArgDocBoost_Serialize_Drover(){
 
     out.args.emplace_back();
     out.args.back().name = "Filename";
-    out.args.back().desc = "The filename (or full path name) to which the serialized data should be written."
-                           " The file format is gzipped XML, which should be portable across most CPUs.";
+    out.args.back().desc = "The filename (or full path name) to which the serialized data should be written.";
     out.args.back().default_val = "/tmp/boost_serialized_drover.xml.gz";
     out.args.back().expected = true;
     out.args.back().examples = { "/tmp/out.xml.gz", 
@@ -35,6 +36,25 @@ OperationDoc OpArgDocBoost_Serialize_Drover(){
     out.args.back().mimetype = "application/octet-stream";
 
 
+    out.args.emplace_back();
+    out.args.back().name = "Format";
+    out.args.back().desc = "The archive format to write."
+                           " 'gzip-xml' is the default and should be portable across most CPUs."
+                           " 'mapped' writes a native archive with uncompressed, page-aligned pixel blocks that are"
+                           " read directly from a memory mapping when loaded. It loads far faster than the other formats,"
+                           " but the file is not compressed. 'mapped-gzip' compresses each pixel block individually,"
+                           " which reduces the file size but requires decompression (performed concurrently) when loading."
+                           " Memory-mapped and binary archives are not portable across CPU architectures."
+                           " Other supported formats are 'gzip-binary', 'gzip-txt', 'binary', 'txt', and 'xml'.";
+    out.args.back().default_val = "gzip-xml";
+    out.args.back().expected = true;
+    out.args.back().examples = { "gzip-xml",
+                                 "mapped",
+                                 "mapped-gzip",
+                                 "gzip-binary",
+                                 "binary" };
+
+
     out.args.emplace_back();
     out.args.back().name = "Components";
     out.args.back().desc = "Which components to include in the output."
@@ -61,6 +81,7 @@ Drover Boost_Serialize_Drover(const Drover& DICOM_data,
     //---------------------------------------------- User Parameters --------------------------------------------------
     auto FilenameStr = OptArgs.getValueStr("Filename").value();
     auto ComponentsStr = OptArgs.getValueStr("Components").value();
+    const auto FormatStr = OptArgs.getValueStr("Format").value();
 
     //-----------------------------------------------------------------------------------------------------------------
 
@@ -78,6 +99,25 @@ Drover Boost_Serialize_Drover(const Drover& DICOM_data,
 
     const boost::filesystem::path apath(FilenameStr);
 
+    using drover_serial_func_t = std::function<bool (const Drover &, const boost::filesystem::path &)>;
+    const std::map<std::string, drover_serial_func_t> drover_serial_funcs = {
+        { "gzip-binary", Common_Boost_Serialize_Drover_to_Gzip_Binary },
+        { "gzip-txt",    Common_Boost_Serialize_Drover_to_Gzip_Simple_Text },
+        { "gzip-xml",    Common_Boost_Serialize_Drover_to_Gzip_XML },
+        { "binary",      Common_Boost_Serialize_Drover_to_Binary },
+        { "txt",         Common_Boost_Serialize_Drover_to_Simple_Text },
+        { "xml",         Common_Boost_Serialize_Drover_to_XML },
+        { "mapped",      Common_Boost_Serialize_Drover_to_Mapped },
+        { "mapped-gzip", Common_Boost_Serialize_Drover_to_Mapped_Gzip } };
+
+    drover_serial_func_t serialize;
+    for(const auto &f : drover_serial_funcs){
+        if(boost::iequals(f.first, FormatStr)) serialize = f.second;
+    }
+    if(!serialize){
+        throw std::invalid_argument("Archive format '" + FormatStr + "' not understood. Cannot continue.");
+    }
+
     // Figure out what needs to be serialized.
     //
     // Note: The Drover class holds everything as shared_ptrs or containers of shared_ptrs, so these copies are
@@ -99,7 +139,7 @@ Drover Boost_Serialize_Drover(const Drover& DICOM_data,
         d.tplan_data = DICOM_data.tplan_data;
     }
 
-    const auto res = Common_Boost_Serialize_Drover(d, apath);
+    const auto res = serialize(d, apath);
     if(res){
         FUNCINFO("Dumped serialization to file " << apath);
     }else{
@@ -254,6 +254,25 @@ OperationDoc OpArgDocComparePixels(){
                                  "NNN" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
+    out.args.emplace_back();
+    out.args.back().name = "DTAEngine";
+    out.args.back().desc = "Parameter for all comparisons involving a distance-to-agreement (DTA) search."
+                           " Controls how the search is carried out. Both options produce identical results."
+                           " The 'wavefront' engine expands a search shell around every voxel until agreement is"
+                           " found or the search is abandoned."
+                           " The 'indexed' engine first surveys all searches, then sorts them into value bands and"
+                           " computes distance transforms of the reference images for each band. Searches that"
+                           " provably cannot find agreement within the search cut-off are resolved without"
+                           " exploring the neighbourhood, and voxel neighbourhoods that cannot straddle the target"
+                           " value are skipped during interpolation. The indexed engine requires additional memory"
+                           " (a few copies of the reference image volume) but can be considerably faster when many"
+                           " voxels fail, when large DTA cut-offs are used, or when interpolation is enabled.";
+    out.args.back().default_val = "wavefront";
+    out.args.back().expected = true;
+    out.args.back().examples = { "wavefront",
+                                 "indexed" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     out.args.emplace_back();
     out.args.back().name = "GammaDTAThreshold";
     out.args.back().desc = "Parameter for gamma-index comparisons."
@@ -325,6 +344,7 @@ Drover ComparePixels(Drover DICOM_data,
     const auto DTAVoxValEqRelDiff = std::stod( OptArgs.getValueStr("DTAVoxValEqRelDiff").value() );
     const auto DTAMax = std::stod( OptArgs.getValueStr("DTAMax").value() );
     const auto DTAInterpolationMethodStr = OptArgs.getValueStr("DTAInterpolationMethod").value();
+    const auto DTAEngineStr = OptArgs.getValueStr("DTAEngine").value();
 
     const auto GammaDTAThreshold = std::stod( OptArgs.getValueStr("GammaDTAThreshold").value() );
     const auto GammaDiscThreshold = std::stod( OptArgs.getValueStr("GammaDiscThreshold").value() );
@@ -341,6 +361,9 @@ Drover ComparePixels(Drover DICOM_data,
     const auto interp_nn   = Compile_Regex("^nn$");
     const auto interp_nnn  = Compile_Regex("^nnn$");
 
+    const auto engine_wave = Compile_Regex("^wa?v?e?f?r?o?n?t?$");
+    const auto engine_idx  = Compile_Regex("^in?d?e?x?e?d?$");
+
     const auto disctype_rel = Compile_Regex("^re?l?a?t?i?v?e?$");
     const auto disctype_dif = Compile_Regex("^di?f?f?e?r?e?n?c?e?$");
     const auto disctype_pin = Compile_Regex("^pi?n?n?e?d?-?t?o?-?m?a?x?$");
@@ -410,6 +433,16 @@ Drover ComparePixels(Drover DICOM_data,
             throw std::invalid_argument("Interpolation method not understood. Cannot continue.");
         }
 
+        if(std::regex_match(DTAEngineStr, engine_wave)){
+            ud.search_engine = ComputeCompareImagesUserData::SearchEngine::Wavefront;
+
+        }else if(std::regex_match(DTAEngineStr, engine_idx)){
+            ud.search_engine = ComputeCompareImagesUserData::SearchEngine::Indexed;
+
+        }else{
+            throw std::invalid_argument("DTA engine not understood. Cannot continue.");
+        }
+
         ud.channel = Channel;
 
         ud.inc_lower_threshold = TestImgLowerThreshold;
@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "../Dose_Meld.h"
+#include "../Rectilinear_Volume.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "ContourBasedRayCastDoseAccumulate.h"
@@ -381,6 +382,17 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data,
     DetectImg.init_orientation(GridX, GridY);
     DetectImg.fill_pixels(0.0);
 
+    //Index the dose array so dose lookups do not need to search all images.
+    const auto dose_index = img_arr_ptr->get_volume_index();
+    const auto accumulate_dose = [&](const vec3<double> &midpoint) -> double {
+        double doselength = 0.0;
+        dose_index->for_each_image_encompassing(midpoint, [&](planar_image<float,double> *enc_img) -> void {
+            const auto pix_val = enc_img->value(midpoint, 0);
+            doselength += RaydL * pix_val;
+        });
+        return doselength;
+    };
+
     //Now ready to ray cast. Loop over integer pixel coordinates. Start and finish are image pixels.
     // The top image can be the length image.
     const auto sq_radius = std::pow(CylinderRadius, 2.0);
@@ -409,11 +421,7 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data,
                         accumulated_length += RaydL;
 
                         //Find the dose at the half-way point.
-                        auto encompass_imgs = img_arr_ptr->imagecoll.get_images_which_encompass_point( midpoint );
-                        for(const auto &enc_img : encompass_imgs){
-                            const auto pix_val = enc_img->value(midpoint, 0);
-                            accumulated_doselength += RaydL * pix_val;
-                        }
+                        accumulated_doselength += accumulate_dose(midpoint);
                         skip = true;
                         break;
                     }
@@ -425,11 +433,7 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data,
                             accumulated_length += RaydL;
 
                             //Find the dose at the half-way point.
-                            auto encompass_imgs = img_arr_ptr->imagecoll.get_images_which_encompass_point( midpoint );
-                            for(const auto &enc_img : encompass_imgs){
-                                const auto pix_val = enc_img->value(midpoint, 0);
-                                accumulated_doselength += RaydL * pix_val;
-                            }
+                            accumulated_doselength += accumulate_dose(midpoint);
                             break;
                         }
                     }
@@ -12,6 +12,7 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <vector>
 
 #include "../Contour_Boolean_Operations.h"
 #include "../Structs.h"
@@ -53,6 +54,15 @@ OperationDoc OpArgDocContourBooleanOperations(){
     out.notes.emplace_back(
         "Only the common metadata between contours is propagated to the product contours."
     );
+
+    out.notes.emplace_back(
+        "An optional third set of contour polygons 'C' can be provided, in which case the expression g(f(A,B),C) is"
+        " evaluated in a single pass, where g is another Boolean operation. For example, 'A ∪ B - C'."
+    );
+
+    out.notes.emplace_back(
+        "All planes are processed concurrently."
+    );
         
 
     out.args.emplace_back();
@@ -112,6 +122,40 @@ OperationDoc OpArgDocContourBooleanOperations(){
     out.args.back().examples = { "intersection", "join", "difference", "symmetric_difference" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
+    out.args.emplace_back();
+    out.args.back().name = "ROILabelRegexC";
+    out.args.back().desc = "A regex matching ROI labels/names that comprise the (optional) set of contour polygons 'C'"
+                      " as in g(f(A,B),C) where f and g are Boolean operations."
+                      " This set is only used if OperationC is not 'none'.";
+    out.args.back().default_val = ".*";
+    out.args.back().expected = true;
+    out.args.back().examples = { ".*", ".*[cC]ord.*", "body", "Gross_Liver",
+                            R"***(.*left.*parotid.*|.*right.*parotid.*|.*eyes.*)***",
+                            R"***(left_parotid|right_parotid)***" };
+
+    out.args.emplace_back();
+    out.args.back().name = "NormalizedROILabelRegexC";
+    out.args.back().desc = "A regex matching ROI labels/names that comprise the (optional) set of contour polygons 'C'"
+                      " as in g(f(A,B),C) where f and g are Boolean operations."
+                      " The regex is applied to normalized ROI labels/names, which are translated using"
+                      " a user-provided lexicon (i.e., a dictionary that supports fuzzy matching)."
+                      " This set is only used if OperationC is not 'none'.";
+    out.args.back().default_val = ".*";
+    out.args.back().expected = true;
+    out.args.back().examples = { ".*", ".*Cord.*", "Body", "Gross_Liver",
+                            R"***(.*Left.*Parotid.*|.*Right.*Parotid.*|.*Eye.*)***",
+                            R"***(Left Parotid|Right Parotid)***" };
+
+    out.args.emplace_back();
+    out.args.back().name = "OperationC";
+    out.args.back().desc = "The Boolean operation (e.g., the function 'g') used to combine the result of f(A,B)"
+                      " with the set of contour polygons 'C'. If 'none', 'C' is ignored and only f(A,B) is"
+                      " evaluated.";
+    out.args.back().default_val = "none";
+    out.args.back().expected = true;
+    out.args.back().examples = { "none", "intersection", "join", "difference", "symmetric_difference" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     out.args.emplace_back();
     out.args.back().name = "OutputROILabel";
     out.args.back().desc = "The label to attach to the ROI contour product of f(A,B).";
@@ -135,7 +179,11 @@ Drover ContourBooleanOperations(const Drover& DICOM_data,
     const auto NormalizedROILabelRegexA = OptArgs.getValueStr("NormalizedROILabelRegexA").value();
     const auto NormalizedROILabelRegexB = OptArgs.getValueStr("NormalizedROILabelRegexB").value();
 
+    const auto ROILabelRegexC = OptArgs.getValueStr("ROILabelRegexC").value();
+    const auto NormalizedROILabelRegexC = OptArgs.getValueStr("NormalizedROILabelRegexC").value();
+
     const auto Operation_str = OptArgs.getValueStr("Operation").value();
+    const auto OperationC_str = OptArgs.getValueStr("OperationC").value();
     const auto OutputROILabel = OptArgs.getValueStr("OutputROILabel").value();
 
     //-----------------------------------------------------------------------------------------------------------------
@@ -145,24 +193,31 @@ Drover ContourBooleanOperations(const Drover& DICOM_data,
     const auto roinormalizedregexA = Compile_Regex(NormalizedROILabelRegexA);
     const auto roinormalizedregexB = Compile_Regex(NormalizedROILabelRegexB);
 
+    const auto roiregexC = Compile_Regex(ROILabelRegexC);
+    const auto roinormalizedregexC = Compile_Regex(NormalizedROILabelRegexC);
+
+    const auto regex_none = Compile_Regex("^no?n?e?$");
     const auto regex_join = Compile_Regex("^jo?i?n?$");
     const auto regex_intersection = Compile_Regex("^inte?r?s?e?c?t?i?o?n?$");
     const auto regex_difference = Compile_Regex("^diffe?r?e?n?c?e?$");
     const auto regex_symmdiff = Compile_Regex("^symme?t?r?i?c?_?d?i?f?f?e?r?e?n?c?e?$");
 
-    //Figure out which operation is desired.
-    ContourBooleanMethod op = ContourBooleanMethod::join;
-    if(std::regex_match(Operation_str,regex_join)){
-        op = ContourBooleanMethod::join;
-    }else if(std::regex_match(Operation_str,regex_intersection)){
-        op = ContourBooleanMethod::intersection;
-    }else if(std::regex_match(Operation_str,regex_difference)){
-        op = ContourBooleanMethod::difference;
-    }else if(std::regex_match(Operation_str,regex_symmdiff)){
-        op = ContourBooleanMethod::symmetric_difference;
-    }else{
+    //Figure out which operations are desired.
+    const auto parse_op = [&](const std::string &s) -> ContourBooleanMethod {
+        if(std::regex_match(s,regex_join)){
+            return ContourBooleanMethod::join;
+        }else if(std::regex_match(s,regex_intersection)){
+            return ContourBooleanMethod::intersection;
+        }else if(std::regex_match(s,regex_difference)){
+            return ContourBooleanMethod::difference;
+        }else if(std::regex_match(s,regex_symmdiff)){
+            return ContourBooleanMethod::symmetric_difference;
+        }
         throw std::logic_error("Unanticipated Boolean operation request.");
-    }
+    };
+    const ContourBooleanMethod op = parse_op(Operation_str);
+    const ContourBooleanMethod opC = std::regex_match(OperationC_str,regex_none) ? ContourBooleanMethod::noop
+                                                                                 : parse_op(OperationC_str);
 
     Explicator X(FilenameLex);
 
@@ -200,10 +255,26 @@ Drover ContourBooleanOperations(const Drover& DICOM_data,
                    return !(std::regex_match(ROIName,roinormalizedregexB));
     });
 
+    std::list<std::reference_wrapper<contour_collection<double>>> cc_C;
+    if(opC != ContourBooleanMethod::noop){
+        cc_C = cc_all;
+        cc_C.remove_if([=](std::reference_wrapper<contour_collection<double>> cc) -> bool {
+                       const auto ROINameOpt = cc.get().contours.front().GetMetadataValueAs<std::string>("ROIName");
+                       const auto ROIName = ROINameOpt.value_or("");
+                       return !(std::regex_match(ROIName,roiregexC));
+        });
+        cc_C.remove_if([=](std::reference_wrapper<contour_collection<double>> cc) -> bool {
+                       const auto ROINameOpt = cc.get().contours.front().GetMetadataValueAs<std::string>("NormalizedROIName");
+                       const auto ROIName = ROINameOpt.value_or("");
+                       return !(std::regex_match(ROIName,roinormalizedregexC));
+        });
+    }
+
     //Make a copy of all contours for assessing some information later.
     std::list<std::reference_wrapper<contour_collection<double>>> cc_A_B;
     cc_A_B.insert(cc_A_B.end(), cc_A.begin(), cc_A.end());
     cc_A_B.insert(cc_A_B.end(), cc_B.begin(), cc_B.end());
+    cc_A_B.insert(cc_A_B.end(), cc_C.begin(), cc_C.end());
     if(cc_A_B.empty()){
         throw std::invalid_argument("No contours were selected. Cannot continue.");
         // Note that while zero contours may technically be valid input for some operations (e.g., joins), it will most
@@ -226,46 +297,27 @@ Drover ContourBooleanOperations(const Drover& DICOM_data,
         return ( vA.sq_dist(vB) < std::pow(0.01,2.0) );
     };
 
-    // For each plane, pack the shuttles with (only) the relevant contours.
-    contour_collection<double> cc_new;
-    for(const auto &aplane : ucp){
-        std::list<std::reference_wrapper<contour_of_points<double>>> A;
-        std::list<std::reference_wrapper<contour_of_points<double>>> B;
-
-        for(auto &cc : cc_A){
+    // Pack the operands with the (cleaned) contours. Contours are assigned to planes when the expression is evaluated.
+    std::vector<ContourBooleanOperand> operands(3);
+    operands[1].op = op;
+    operands[2].op = opC;
+    const std::vector<std::reference_wrapper<std::list<std::reference_wrapper<contour_collection<double>>>>> ccs_operands
+        = { std::ref(cc_A), std::ref(cc_B), std::ref(cc_C) };
+    for(size_t k = 0; k < operands.size(); ++k){
+        for(auto &cc : ccs_operands[k].get()){
             for(auto &cop : cc.get().contours){
-                //Ignore contours that are not 'on' the specified plane.
-                // We give planes a thickness to help determine coincidence.
                 cop.Remove_Sequential_Duplicate_Points(verts_equal_F);
                 cop.Remove_Needles(verts_equal_F);
                 if(cop.points.empty()) continue;
-                const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
-                if(dist_to_plane > est_cont_thickness) continue;
-
-                //Pack the contour into the shuttle.
-                A.emplace_back(std::ref(cop));
+                operands[k].contours.emplace_back(std::ref(cop));
             }
         }
-        for(auto &cc : cc_B){
-            for(auto &cop : cc.get().contours){
-                cop.Remove_Sequential_Duplicate_Points(verts_equal_F);
-                cop.Remove_Needles(verts_equal_F);
-                if(cop.points.empty()) continue;
-                const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
-                if(dist_to_plane > est_cont_thickness) continue;
-
-                B.emplace_back(std::ref(cop));
-            }
-        }
-
-        //Perform the operation.
-        //FUNCINFO("About to perform boolean operation. A and B have " << A.size() << " and " << B.size() << " elements, respectively");
-        auto cc = ContourBoolean(aplane, A, B, op);
-
-        //Insert any contours created into a holding contour_collection.
-        cc_new.contours.splice(cc_new.contours.end(), std::move(cc.contours));
     }
 
+    //Perform the operation on all planes.
+    const std::vector<plane<double>> planes(std::begin(ucp), std::end(ucp));
+    auto cc_new = ContourBooleanExpression(planes, est_cont_thickness, operands);
+
     //Attach the requested metadata.
     cc_new.Insert_Metadata("ROIName", OutputROILabel);
     cc_new.Insert_Metadata("NormalizedROIName", X(OutputROILabel));
@@ -9,14 +9,13 @@
 #include <memory>
 #include <regex>
 #include <stdexcept>
-#include <numeric>        //Needed for std::inner_product().
 #include <string>    
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
-#include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
+#include "../Rectilinear_Convolution.h"
 
 #include "YgorImages.h"
 #include "YgorString.h"       //Needed for GetFirstRegex(...)
@@ -50,6 +49,15 @@ OperationDoc OpArgDocConvolveImages(){
          " the average voxel intensity. However, for pattern matching the kernel need not"
          " be normalized (though it may make interpretting partial matches easier.)"
     );
+    out.notes.emplace_back(
+        "Voxels are only modified if they are bounded by one or more of the selected ROIs. Voxels whose neighbourhood"
+        " extends beyond the image array, or contains non-finite intensities, are assigned NaN."
+    );
+    out.notes.emplace_back(
+        "Large kernels are applied in the frequency domain using FFTs and overlap-save tiling, which is much faster"
+        " than direct summation. Pattern-matching is then performed by expanding the sum of squared differences into"
+        " correlations, so nearly-perfect matches are subject to some floating-point cancellation error."
+    );
     
     out.args.emplace_back();
     out.args.back() = IAWhitelistOpArgDoc();
@@ -111,6 +119,21 @@ OperationDoc OpArgDocConvolveImages(){
                                  "pattern-match" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "Controls how the kernel is applied."
+                           " 'Direct' sums over the kernel for every voxel, which is efficient for small kernels."
+                           " 'FFT' uses fast Fourier transforms, which are efficient for large kernels."
+                           " 'Auto' will select the method with the lowest estimated cost."
+                           " All methods produce the same result, apart from floating-point rounding.";
+    out.args.back().default_val = "auto";
+    out.args.back().expected = true;
+    out.args.back().examples = { "auto",
+                                 "direct",
+                                 "fft" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -129,6 +152,7 @@ Drover ConvolveImages(Drover DICOM_data,
 
     const auto Channel = std::stol( OptArgs.getValueStr("Channel").value() );
     const auto OperationStr = OptArgs.getValueStr("Operation").value();
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_conv = Compile_Regex("^conv?o?l?u?t?i?o?n?$");
@@ -138,6 +162,32 @@ Drover ConvolveImages(Drover DICOM_data,
     const bool op_is_conv = std::regex_match(OperationStr, regex_conv);
     const bool op_is_corr = std::regex_match(OperationStr, regex_corr);
     const bool op_is_mtch = std::regex_match(OperationStr, regex_mtch);
+
+    const auto regex_auto = Compile_Regex("^au?t?o?m?a?t?i?c?$");
+    const auto regex_drct = Compile_Regex("^di?r?e?c?t?$");
+    const auto regex_fft  = Compile_Regex("^ff?t?$");
+
+    kernel_method method;
+    if(std::regex_match(MethodStr, regex_auto)){
+        method = kernel_method::automatic;
+    }else if(std::regex_match(MethodStr, regex_drct)){
+        method = kernel_method::direct;
+    }else if(std::regex_match(MethodStr, regex_fft)){
+        method = kernel_method::fft;
+    }else{
+        throw std::invalid_argument("Method not understood. Cannot continue.");
+    }
+
+    kernel_operation operation;
+    if(op_is_conv){
+        operation = kernel_operation::convolution;
+    }else if(op_is_corr){
+        operation = kernel_operation::correlation;
+    }else if(op_is_mtch){
+        operation = kernel_operation::pattern_match;
+    }else{
+        throw std::invalid_argument("Requested operation is not understood. Cannot continue.");
+    }
     //-----------------------------------------------------------------------------------------------------------------
 
     // Identify the contours to use.
@@ -177,98 +227,94 @@ Drover ConvolveImages(Drover DICOM_data,
             throw std::invalid_argument("Reference image array (kernel) contained no images. Cannot continue.");
         }
 
-        auto IAs = Whitelist( IAs_all, ImageSelectionStr );
-        for(auto & iap_it : IAs){
-
-            ComputeVolumetricNeighbourhoodSamplerUserData ud;
-            ud.channel = Channel;
-            ud.description = "Image Convolved";
-            ud.maximum_distance = std::numeric_limits<double>::quiet_NaN();
-            ud.neighbourhood = ComputeVolumetricNeighbourhoodSamplerUserData::Neighbourhood::Selection;
-
-            // Convert the kernel into a list of voxel triplets and voxel values.
-            //
-            // Note: The following vectors will be kept synchronized. This will obviate the need to perform any
-            // correspondence look-ups later.
-            std::vector<std::array<long int, 3>> triplets;
-            std::vector<float> k_values;
-
-            const auto first_img_num = 0L;
-            const auto first_img_refw = img_adj.index_to_image(first_img_num);
-            const long int k_rows = first_img_refw.get().rows;
-            const long int k_columns = first_img_refw.get().columns;
-            const auto k_imgs = static_cast<long int>(img_adj.int_to_img.size());
-            //std::map<long int, img_ptr_t> int_to_img;
-
-            const auto d_r = k_rows / 2;   // Offsets to (approximately) centre the kernel.
-            const auto d_c = k_columns / 2;
-            const auto d_i = k_imgs / 2;
-
-            for(long int r = 0; r < k_rows; ++r){
-                for(long int c = 0; c < k_columns; ++c){
-                    for(long int i = 0; i < k_imgs; ++i){
-                        std::array<long int, 3> t = { r - d_r,
-                                                      c - d_c,
-                                                      i - d_i };
-                        triplets.emplace_back( t );
-
-                        const auto i_num = i + first_img_num;
-                        const auto l_img_refw = img_adj.index_to_image(i_num);
-                        const auto val = l_img_refw.get().value(r, c, Channel);
-                        k_values.emplace_back( static_cast<float>(val) );
+        // Extract the kernel voxels, ordering images along the contour normal.
+        const auto first_img_refw = img_adj.index_to_image(0L);
+        const long int k_rows = first_img_refw.get().rows;
+        const long int k_columns = first_img_refw.get().columns;
+        const auto k_imgs = static_cast<long int>(img_adj.int_to_img.size());
+        const auto extract_kernel = [&](long int chnl) -> dense_volume {
+            dense_volume kernel(k_rows, k_columns, k_imgs);
+            for(long int i = 0; i < k_imgs; ++i){
+                const auto l_img_refw = img_adj.index_to_image(i);
+                for(long int r = 0; r < k_rows; ++r){
+                    for(long int c = 0; c < k_columns; ++c){
+                        kernel.at(r, c, i) = l_img_refw.get().value(r, c, chnl);
                     }
                 }
             }
-            
-            // Perform any necessary post-processing.
-            if(op_is_conv){
-                // Spatially flip the kernel. This can be accomplished by negating since the kernel is (approximately)
-                // centred.
-                for(auto &t : triplets){
-                    t[0] *= -1L;
-                    t[1] *= -1L;
-                    t[2] *= -1L;
-                }
+            return kernel;
+        };
 
-            }else if( op_is_corr
-                  ||  op_is_mtch ){
-                // No-op...
+        auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+        for(auto & iap_it : IAs){
+            {
+                std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+                for(auto &img : (*iap_it)->imagecoll.images){
+                    selected_imgs.push_back( std::ref(img) );
+                }
 
-            }else{
-                throw std::logic_error("Requested operation is not understood. Cannot continue.");
+                if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+                    throw std::invalid_argument("Images do not form a rectilinear grid. Cannot continue");
+                }
             }
-            ud.voxel_triplets = triplets;
-
-            if( op_is_conv
-                  ||  op_is_corr ){
-                ud.f_reduce = [=](float v, std::vector<float> &shtl, vec3<double>) -> float {
-                                  // Multiply the kernel and image samples together and sum them up.
-                                  const auto val = std::inner_product( std::begin(k_values), std::end(k_values),
-                                                                       std::begin(shtl), static_cast<double>(0.0) );
-                                  return val;
-                              };
-
-            }else if(op_is_mtch){
-                ud.f_reduce = [=](float v, std::vector<float> &shtl, vec3<double>) -> float {
-                                  // Compute the Euclidean distance between the kernel and image voxel intensities.
-                                  float val = 0.0;
-                                  for(size_t i = 0; i < shtl.size(); ++i){
-                                      val += std::pow(shtl[i] - k_values[i], 2.0);
-                                  }
-                                  return std::sqrt(val);
-                              };
-
-            }else{
-                throw std::logic_error("Requested operation is not understood. Cannot continue.");
+
+            planar_image_adjacency<float,double> adj( {}, { { std::ref((*iap_it)->imagecoll) } }, orientation_normal );
+            if(adj.int_to_img.empty()){
+                continue;
             }
+            const auto first_refw = adj.index_to_image(0L);
+            const long int N_rows = first_refw.get().rows;
+            const long int N_columns = first_refw.get().columns;
+            const long int N_channels = first_refw.get().channels;
+            const auto N_imgs = static_cast<long int>(adj.int_to_img.size());
 
-            if(!ud.voxel_triplets.empty()){
-                FUNCINFO("Neighbourhood comprises " << ud.voxel_triplets.size() << " neighbours");
+            // Apply the kernel to the whole image array, one channel at a time.
+            //
+            // Note: when all channels are operated on, each channel is paired with the same channel of the kernel.
+            std::map<long int, dense_volume> outgoing;
+            for(long int chnl = 0; chnl < N_channels; ++chnl){
+                if( (0 <= Channel) && (chnl != Channel) ) continue;
+
+                dense_volume vol(N_rows, N_columns, N_imgs);
+                for(long int i = 0; i < N_imgs; ++i){
+                    const auto l_img_refw = adj.index_to_image(i);
+                    for(long int r = 0; r < N_rows; ++r){
+                        for(long int c = 0; c < N_columns; ++c){
+                            vol.at(r, c, i) = l_img_refw.get().value(r, c, chnl);
+                        }
+                    }
+                }
+                outgoing[chnl] = Apply_Kernel(vol, extract_kernel(chnl), operation, method);
             }
 
-            if(!(*iap_it)->imagecoll.Compute_Images( ComputeVolumetricNeighbourhoodSampler, 
-                                                     {}, cc_ROIs, &ud )){
-                throw std::runtime_error("Unable to convolve images.");
+            // Update the voxels bounded by the ROIs.
+            Mutate_Voxels_Opts mv_opts;
+            mv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
+            mv_opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
+            mv_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+            mv_opts.aggregate      = Mutate_Voxels_Opts::Aggregate::First;
+            mv_opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+            mv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
+
+            for(auto &img : (*iap_it)->imagecoll.images){
+                std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
+                const auto img_num = adj.image_to_index( img_refw );
+
+                auto f_bounded = [&](long int E_row, long int E_col, long int channel, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
+                    auto o_it = outgoing.find(channel);
+                    if(o_it == std::end(outgoing)) return;
+                    voxel_val = static_cast<float>( o_it->second.at(E_row, E_col, img_num) );
+                    return;
+                };
+
+                Mutate_Voxels<float,double>( img_refw,
+                                             { img_refw },
+                                             cc_ROIs, 
+                                             mv_opts, 
+                                             f_bounded );
+
+                UpdateImageDescription( img_refw, "Image Convolved" );
+                UpdateImageWindowCentreWidth( img_refw );
             }
         }
     }
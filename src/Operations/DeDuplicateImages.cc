@@ -1,5 +1,6 @@
 //DeDuplicateImages.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
+#include <algorithm>
 #include <deque>
 #include <optional>
 #include <iterator>
@@ -9,11 +10,15 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <numeric>
+#include <vector>
 
 #include "YgorMisc.h"
 #include "YgorStats.h"
 
 #include "../Structs.h"
+#include "../Image_Signature.h"
+#include "../Thread_Pool.h"
 #include "../Regex_Selectors.h"
 
 #include "DeDuplicateImages.h"
@@ -51,61 +56,70 @@ Drover DeDuplicateImages(Drover DICOM_data,
     const auto vox_range_overlap_dice_threshold = 0.99; // the minimum acceptable dice similarity of the voxel intensity range.
     //-----------------------------------------------------------------------------------------------------------------
 
-    const auto voxel_intensity_min_max = [](std::shared_ptr<Image_Array> ia){
-        Stats::Running_MinMax<float> rmm;
-        const auto tally_mm = [&rmm](long int, long int, long int, float val) -> void {
-            rmm.Digest(val);
-            return;
-        };
-        ia->imagecoll.apply_to_pixels(tally_mm);
-        return rmm;
-    };
-
     // Gather a list of images to work on.
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr ); // std::list<std::list<std::shared_ptr<Image_Array>>::iterator>
+    std::vector< std::list<std::shared_ptr<Image_Array>>::iterator > IA_its( std::begin(IAs), std::end(IAs) );
+    const auto N_IAs = IA_its.size();
+
+    // Summarize each image array once. Signatures are cached, so they will only be computed if needed.
+    std::vector< std::shared_ptr<const image_array_signature> > sigs(N_IAs);
+    {
+        asio_thread_pool tp;
+        for(size_t i = 0; i < N_IAs; ++i){
+            tp.submit_task([&,i]() -> void {
+                sigs[i] = (*(IA_its[i]))->get_signature();
+            }); // thread pool task closure.
+        }
+    } // Wait until all threads are done.
+
+    // Bucket the image arrays by position so that only nearby image arrays need to be compared.
+    std::vector<size_t> by_x(N_IAs);
+    std::iota(std::begin(by_x), std::end(by_x), static_cast<size_t>(0));
+    std::sort(std::begin(by_x), std::end(by_x), [&](size_t a, size_t b){
+        return (sigs[a]->centre.x < sigs[b]->centre.x);
+    });
 
-    //std::list<std::shared_ptr<Image_Array>> IA_duplicates;
     std::list< std::list<std::shared_ptr<Image_Array>>::iterator > IA_duplicates;
+    std::vector<bool> is_duplicate(N_IAs, false);
+
+    // Score each relevant metric for each image array. Earlier image arrays are retained in favour of later ones.
+    for(size_t a = 0; a < N_IAs; ++a){
+        if(is_duplicate[a]) continue;
+        const auto &sig_A = *(sigs[a]);
+
+        const auto x_lo = std::lower_bound(std::begin(by_x), std::end(by_x), sig_A.centre.x - d_center_threshold,
+                                           [&](size_t i, double x){ return (sigs[i]->centre.x < x); });
+        const auto x_hi = std::upper_bound(std::begin(by_x), std::end(by_x), sig_A.centre.x + d_center_threshold,
+                                           [&](double x, size_t i){ return (x < sigs[i]->centre.x); });
+        for(auto b_it = x_lo; b_it != x_hi; ++b_it){
+            const auto b = *b_it;
+            if( (b <= a) || is_duplicate[b] ) continue;
+            const auto &sig_B = *(sigs[b]);
 
-    // Score each relevant metric for each image array.
-    for(auto iapA_it_it = std::begin(IAs); iapA_it_it != std::end(IAs); ++iapA_it_it){
-        const auto center_A = (*(*iapA_it_it))->imagecoll.center();
-        const auto volume_A = (*(*iapA_it_it))->imagecoll.volume();
-        const auto rmm_A = voxel_intensity_min_max( (*(*iapA_it_it)) );
+            // Score the similarity by considering position, spatial extent, and voxel distribution.
+            const auto d_center = (sig_A.centre - sig_B.centre).length();
+            const auto d_volume = std::abs(sig_A.volume - sig_B.volume);
 
-        for(auto iapB_it_it = std::next(iapA_it_it); iapB_it_it != std::end(IAs);  ){
-            const auto center_B = (*(*iapB_it_it))->imagecoll.center();
-            const auto volume_B = (*(*iapB_it_it))->imagecoll.volume();
-            const auto rmm_B = voxel_intensity_min_max( (*(*iapB_it_it)) );
+            const auto vox_highest_min = std::max(sig_A.min, sig_B.min);
+            const auto vox_lowest_max  = std::min(sig_A.max, sig_B.max);
+            const auto vox_range_dice_numer = 2.0 * std::max(0.0, vox_lowest_max - vox_highest_min);
+            const auto vox_range_dice_denom = (sig_A.max - sig_A.min) + (sig_B.max - sig_B.min);
+            const auto vox_range_dice = (0.0 < vox_range_dice_denom) ? (vox_range_dice_numer / vox_range_dice_denom)
+                                      : ( (sig_A.min == sig_B.min) ? 1.0 : 0.0 );
 
-            // Score the similarity by considering position, spatial extent, and voxel distribution.
-            const auto d_center = (center_A - center_B).length();
-            const auto d_volume = std::abs(volume_A - volume_B);
-
-            const auto vox_lowest_min  = std::min(rmm_A.Current_Min(), rmm_B.Current_Min());
-            const auto vox_highest_min = std::max(rmm_A.Current_Min(), rmm_B.Current_Min());
-            const auto vox_lowest_max  = std::min(rmm_A.Current_Max(), rmm_B.Current_Max());
-            const auto vox_highest_max = std::max(rmm_A.Current_Max(), rmm_B.Current_Max());
-            const auto vox_range_dice_numer = 2.0 * std::abs(vox_lowest_max - vox_highest_min);
-            const auto vox_range_dice_denom = std::abs(rmm_A.Current_Max() - rmm_A.Current_Min()) 
-                                            + std::abs(rmm_B.Current_Max() - rmm_B.Current_Min());
-            const auto vox_range_dice = vox_range_dice_numer + vox_range_dice_denom;
-
-FUNCINFO("About to compare image arrays: "
-      << " d_center = " << d_center
-      << " d_volume = " << d_volume
-      << " vox_range_dice = " << vox_range_dice );
+            FUNCINFO("About to compare image arrays: "
+                  << " d_center = " << d_center
+                  << " d_volume = " << d_volume
+                  << " vox_range_dice = " << vox_range_dice );
 
             // Check if the pair are duplicates. If so, erase the latter.
             if( (d_center <= d_center_threshold)
             &&  (d_volume <= d_volume_threshold)
             &&  (vox_range_overlap_dice_threshold <= vox_range_dice) ){
                 FUNCINFO("Duplicate image array identified");
-                IA_duplicates.push_back( *iapB_it_it );
-                iapB_it_it = IAs.erase( iapB_it_it );
-            }else{
-                ++iapB_it_it;
+                IA_duplicates.push_back( IA_its[b] );
+                is_duplicate[b] = true;
             }
         }
     }
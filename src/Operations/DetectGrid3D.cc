@@ -1,6 +1,7 @@
 //DetectGrid3D.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
 #include <any>
+#include <atomic>
 #include <optional>
 #include <functional>
 #include <iterator>
@@ -12,9 +13,9 @@
 #include <random>
 #include <stdexcept>
 #include <string>    
+#include <thread>
 #include <algorithm>    
 
-/*
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/point.hpp>
 #include <boost/geometry/geometries/box.hpp>
@@ -22,9 +23,6 @@
 #include <boost/geometry/index/parameters.hpp>
 #include <boost/geometry/index/rtree.hpp>
 
-#include <boost/geometry/algorithms/within.hpp>
-*/
-
 #ifdef DCMA_USE_EIGEN    
 #else
     #error "Attempting to compile this operation without Eigen, which is required."
@@ -44,6 +42,7 @@
 #include "../Regex_Selectors.h"
 #include "../Insert_Contours.h"
 #include "../Write_File.h"
+#include "../Thread_Pool.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Compute/Volumetric_Neighbourhood_Sampler.h"
@@ -86,9 +85,10 @@ struct ICP_Context {
     // Point cloud points participating in a single RANSAC phase.
     //
     // This list is regenerated for each round of RANSAC. Only some point cloud points within a fixed distance from
-    // some randomly-selected point will be retained. The points are not altered, just copied for ease-of-use.
+    // some randomly-selected point will be retained. The points are not altered. They are not owned by the context,
+    // so contexts can share them read-only.
     using pcp_c_t = decltype(Point_Cloud().pset.points); // Point_Cloud point container type.
-    pcp_c_t cohort;
+    const pcp_c_t *cohort = nullptr;
 
     // Cohort points projected into a single volumetric proto cell.
     pcp_c_t p_cell;
@@ -338,7 +338,7 @@ Project_Into_Proto_Cube( Grid_Context &GC,
                         ICP_Context &ICPC ){
     // Using the current grid axes directions and anchor point, project all points into the proto cell.
     auto p_cell_it = std::begin(ICPC.p_cell);
-    for(const auto &P : ICPC.cohort){
+    for(const auto &P : *(ICPC.cohort)){
 
         // Vector rel. to grid anchor.
         const auto R = (P - GC.current_grid_anchor);
@@ -413,7 +413,7 @@ Translate_Grid_Optimally( Grid_Context &GC,
     dist_z.reserve(ICPC.p_cell.size());
     {
         auto p_cell_it = std::begin(ICPC.p_cell);
-        for(const auto &pp : ICPC.cohort){
+        for(const auto &pp : *(ICPC.cohort)){
             const auto C = (*p_cell_it) - GC.current_grid_anchor;
 
             const auto proj_x = GC.current_grid_x.Dot(C);
@@ -453,7 +453,7 @@ Find_Corresponding_Points( Grid_Context &GC,
     // Note: There is likely a faster way to do the following using the same approach as the optimal translation routine.
     // This way is easy to debug and reason about.
 
-    if(ICPC.p_corr.size() != ICPC.cohort.size() ){
+    if(ICPC.p_corr.size() != ICPC.cohort->size() ){
         throw std::logic_error("Insufficient working space allocated. Cannot continue.");
     }
 
@@ -588,7 +588,7 @@ Rotate_Grid_Optimally( Grid_Context &GC,
     Eigen::MatrixXf A(N_rows, N_cols);
     Eigen::MatrixXf B(N_rows, N_cols);
 
-    auto o_it = std::begin(ICPC.cohort);
+    auto o_it = std::begin(*(ICPC.cohort));
     auto c_it = std::begin(ICPC.p_corr);
     auto p_it = std::begin(ICPC.p_cell);
     size_t col = 0;
@@ -776,8 +776,8 @@ return;
         Write_PLY(filename_base + "ransac_point.ply", points);
     }
 
-    Write_XYZ(filename_base + "original_points.xyz", ICPC.cohort);
-    Write_PLY(filename_base + "original_points.ply", ICPC.cohort);
+    Write_XYZ(filename_base + "original_points.xyz", *(ICPC.cohort));
+    Write_PLY(filename_base + "original_points.ply", *(ICPC.cohort));
 
     Write_XYZ(filename_base + "cube_proj_points.xyz", ICPC.p_cell);
     Write_PLY(filename_base + "cube_proj_points.ply", ICPC.p_cell);
@@ -800,8 +800,8 @@ return;
     {
         // Determine where the average original point is.
         vec3<double> avg(0.0, 0.0, 0.0);
-        for(const auto &vp : ICPC.cohort) avg += vp;
-        avg *= (1.0 / (1.0 * ICPC.cohort.size()));
+        for(const auto &vp : *(ICPC.cohort)) avg += vp;
+        avg *= (1.0 / (1.0 * ICPC.cohort->size()));
 
         const auto proto_mid = GC.current_grid_anchor
                              + GC.current_grid_x * GC.grid_sep * 0.5
@@ -868,7 +868,7 @@ return;
         lines.emplace_back( c_H, c_E );
 
 
-        for(const auto &P : ICPC.cohort){
+        for(const auto &P : *(ICPC.cohort)){
 
             double closest_dist = std::numeric_limits<double>::quiet_NaN();
             vec3<double> closest_proj = NaN_vec3;
@@ -920,7 +920,7 @@ ICP_Fit_Grid( std::mt19937 re,
 
     Grid_Context best_GC = GC;
 
-static int icp_invoke = 0;
+static std::atomic<int> icp_invoke(0);
 
     for(long int loop = 1; loop <= icp_max_loops; ++loop){
 //        std::cout << "====================================== " << "Loop: " << loop << std::endl;
@@ -930,29 +930,29 @@ static int icp_invoke = 0;
         // Note: This *might* be wasteful, but it will also help protect against picking an irrelevant point and being
         // stuck with it for the entire ICP procedure. TODO: try commenting out this code to always use the ransac point
         // as the rotation centre.
-        std::uniform_int_distribution<long int> rd(0, ICPC.cohort.size());
+        std::uniform_int_distribution<long int> rd(0, static_cast<long int>(ICPC.cohort->size()) - 1L);
         const auto N_select = rd(re);
-        ICPC.rot_centre = (*std::next( std::begin(ICPC.cohort), N_select ));
+        ICPC.rot_centre = (*std::next( std::begin(*(ICPC.cohort)), N_select ));
 
-Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke) + "_icp" + std::to_string(loop) + "_01loopbegins_", GC, ICPC);
+Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke.load()) + "_icp" + std::to_string(loop) + "_01loopbegins_", GC, ICPC);
         Project_Into_Proto_Cube(GC, ICPC);
-Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke) + "_icp" + std::to_string(loop) + "_02projected_", GC, ICPC);
+Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke.load()) + "_icp" + std::to_string(loop) + "_02projected_", GC, ICPC);
         Translate_Grid_Optimally(GC, ICPC);
-Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke) + "_icp" + std::to_string(loop) + "_03translated_", GC, ICPC);
+Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke.load()) + "_icp" + std::to_string(loop) + "_03translated_", GC, ICPC);
 
         // TODO: Does this invalidate the optimal translation we just found? If so, can anything be done?
         Project_Into_Proto_Cube(GC, ICPC);
-Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke) + "_icp" + std::to_string(loop) + "_04projected_", GC, ICPC);
+Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke.load()) + "_icp" + std::to_string(loop) + "_04projected_", GC, ICPC);
         Find_Corresponding_Points(GC, ICPC);
-Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke) + "_icp" + std::to_string(loop) + "_05corresfound_", GC, ICPC);
+Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke.load()) + "_icp" + std::to_string(loop) + "_05corresfound_", GC, ICPC);
         Rotate_Grid_Optimally(GC, ICPC);
-Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke) + "_icp" + std::to_string(loop) + "_06rotated_", GC, ICPC);
+Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke.load()) + "_icp" + std::to_string(loop) + "_06rotated_", GC, ICPC);
 
         // Evaluate over the entire point cloud, retaining the global best.
         Project_Into_Proto_Cube(GC, ICPC);
-Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke) + "_icp" + std::to_string(loop) + "_07projected_", GC, ICPC);
+Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke.load()) + "_icp" + std::to_string(loop) + "_07projected_", GC, ICPC);
         Find_Corresponding_Points(GC, ICPC);
-Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke) + "_icp" + std::to_string(loop) + "_08corresfound_", GC, ICPC);
+Write_Everything("/tmp/ransac"_s + std::to_string(icp_invoke.load()) + "_icp" + std::to_string(loop) + "_08corresfound_", GC, ICPC);
 
         GC.score = Score_Fit(ICPC);
         if(!std::isfinite(best_GC.score) || (GC.score < best_GC.score)){
@@ -1030,6 +1030,11 @@ OperationDoc OpArgDocDetectGrid3D(){
         " Given the complicated interplay between parameters and stages, it is always best"
         " to tune using a representative sample of the point cloud you need to fit!"
     );
+    out.notes.emplace_back(
+        "RANSAC loops are independent and are performed concurrently. Each loop begins with the same initial grid"
+        " estimate and uses a random number stream derived from the RandomSeed parameter and the loop number, so"
+        " results are reproducible for a given seed regardless of the number of threads available."
+    );
 
     out.args.emplace_back();
     out.args.back() = PCWhitelistOpArgDoc();
@@ -1207,8 +1212,6 @@ Drover DetectGrid3D(Drover DICOM_data,
         return ResultsSummaryFileName;
     };
 
-    std::mt19937 re( RandomSeed );
-
 FUNCINFO("Loading point clouds");
 
     auto PCs_all = All_PCs( DICOM_data );
@@ -1238,18 +1241,29 @@ if(false){
 
         Grid_Context best_GC; // The current best estimate of the grid position.
 
-        Grid_Context GC; // A working estimate of the grid position.
-        GC.grid_sep = GridSeparation;
-        GC.grid_sampling = GridSampling;
-
-        ICP_Context ICPC; // Working ICP context.
-
         ICP_Context whole_ICPC; // Whole (i.e., entire point cloud) context.
-        whole_ICPC.cohort = (*pcp_it)->pset.points;
-        whole_ICPC.p_cell = whole_ICPC.cohort; // Prime the container with dummy info.
-        whole_ICPC.p_corr = whole_ICPC.cohort; // Prime the container with dummy info.
-        //whole_ICPC.p_corr.resize(whole_ICPC.cohort.size());
-        //whole_ICPC.rot_centre = whole_ICPC.ransac_centre;
+        whole_ICPC.cohort = &((*pcp_it)->pset.points);
+        whole_ICPC.p_cell = *(whole_ICPC.cohort); // Prime the container with dummy info.
+        whole_ICPC.p_corr = *(whole_ICPC.cohort); // Prime the container with dummy info.
+
+        // Index the point cloud so the vicinity of a RANSAC point can be found without scanning the whole cloud.
+        const auto &points = (*pcp_it)->pset.points;
+        const auto N_points = static_cast<long int>(points.size());
+
+        using pc_point_t = boost::geometry::model::point<double, 3, boost::geometry::cs::cartesian>;
+        using pc_box_t = boost::geometry::model::box<pc_point_t>;
+        using pc_value_t = std::pair<pc_point_t, long int>;
+        using pc_rtree_t = boost::geometry::index::rtree<pc_value_t, boost::geometry::index::rstar<16>>;
+        pc_rtree_t pc_rtree;
+        {
+            std::vector<pc_value_t> pc_values;
+            pc_values.reserve(points.size());
+            long int i = 0;
+            for(const auto &p : points){
+                pc_values.emplace_back( pc_point_t(p.x, p.y, p.z), i++ );
+            }
+            pc_rtree = pc_rtree_t(pc_values.begin(), pc_values.end()); // Bulk-loaded (packed), and read-only hereafter.
+        }
 
         // Some RANSAC failures are expected due to outliers and noisy data, so a fairly number of failures will be
         // tolerated. However, RANSAC must eventually terminate if too many errors are encountered. It is tricky to
@@ -1257,98 +1271,145 @@ if(false){
         // *most* points to be randomly sampled. This might result in an excessive amount of tries for large data sets,
         // but it will also minimize the likelihood that valid cases will erroneously be rejected.
         //
-        // The routine below can be called only a certain number of times before throwing.
-        long int RANSACFails = 0;
+        // Failures are tallied across all RANSAC rounds. Once too many are encountered, all rounds are abandoned.
+        std::atomic<long int> RANSACFails(0);
+        std::atomic<bool> RANSACAborted(false);
         const long int PermittedRANSACFails = std::max(100L, static_cast<long int>((*pcp_it)->pset.points.size() * 2));
         auto Handle_RANSAC_Failure = [&]() -> void {
-            ++RANSACFails;
-            if(RANSACFails > PermittedRANSACFails){
-                std::stringstream ss;
-                ss << "Encountered too many RANSAC failures."
-                   << " Confirm GridSeparation and RANSACDist are valid and appropriate for the point cloud density.";
-                throw std::runtime_error(ss.str());
+            if(PermittedRANSACFails < ++RANSACFails){
+                RANSACAborted = true;
             }
             return;
         };
 
         // Perform a RANSAC analysis by only analyzing the vicinity of a randomly selected point.
-        long int ransac_loop = 0;
+        //
+        // Every RANSAC round begins from the same initial grid estimate and draws from a dedicated random number stream
+        // derived from the seed and the round number. Rounds are therefore independent and can be performed
+        // concurrently, and the results do not depend on how rounds are scheduled.
+        std::vector<Grid_Context> round_GCs(static_cast<size_t>(std::max(0L, RANSACMaxLoops)));
+        std::atomic<long int> next_round(0);
+        long int completed_rounds = 0;
         std::mutex saver_printer;
-        while(ransac_loop < RANSACMaxLoops){
-            // Randomly select a point from the cloud.
-            std::uniform_int_distribution<long int> rd(0, (*pcp_it)->pset.points.size());
-            const auto N = rd(re);
-            ICPC.ransac_centre = (* std::next( std::begin((*pcp_it)->pset.points), N ));
-
-            // Retain only the points within a small distance of the RANSAC centre.
-            using pcp_t = decltype((*pcp_it)->pset.points.front());
-            ICPC.cohort = (*pcp_it)->pset.points;
-            ICPC.cohort.erase(
-                std::remove_if(std::begin(ICPC.cohort), 
-                               std::end(ICPC.cohort),
-                               [&](pcp_t &pcp) -> bool {
-                                   return (pcp.distance(ICPC.ransac_centre) > RANSACDist);
-                               }),
-                std::end(ICPC.cohort) );
-
-            if(ICPC.cohort.size() < 3){
-                // If there are too few points to meaningfully continue, then the only thing we can assume is that the
-                // selected point is in a region with a low density of points. So re-do the loop. However, if multiple
-                // failures occur then we can probably conclude that the grid parameters are inappropriate. For example,
-                // if the GridSeparation is too small then all points will appear to be in regions of low density.
-                FUNCWARN("Too few adjacent points (" << ICPC.cohort.size() << "), rebooting RANSAC loop.");
-                Handle_RANSAC_Failure(); // Will throw if too many failures encountered.
-                continue;
-            }
-
-            // Allocate storage for ICP loops.
-            ICPC.p_cell = ICPC.cohort;
-            ICPC.p_corr = ICPC.cohort;
-            //ICPC.p_corr.resize(ICPC.cohort.size());
-            //ICPC.rot_centre = ICPC.ransac_centre;
-
-            // Perform ICP on the sub-set cohort.
-            try{
-                ICP_Fit_Grid(re, CoarseICPMaxLoops, GC, ICPC);
-            }catch(const std::exception &e){
-                FUNCWARN("Error encountered during coarse ICP (" << e.what() << "), rebooting RANSAC loop.");
-                Handle_RANSAC_Failure(); // Will throw if too many failures encountered.
-                continue;
-            }
-
-            // Invalidate the coarse fit score since it is not applicable to the whole point cloud.
-            GC.score = std::numeric_limits<double>::quiet_NaN();
-
-            // Using the subset cohort fit, perform an ICP using the whole point cloud.
-            //Grid_Context whole_GC = GC; // Needed?
-            //whole_GC.grid_sep = GridSeparation;
-            whole_ICPC.ransac_centre = ICPC.ransac_centre;
+        {
+            const auto N_workers = std::max(1L, std::min(RANSACMaxLoops, static_cast<long int>(std::thread::hardware_concurrency())));
+            asio_thread_pool tp;
+            for(long int w = 0; w < N_workers; ++w){
+                tp.submit_task([&]() -> void {
+                    // Working space is allocated once per worker and reused for every round.
+                    //
+                    // The whole point cloud is shared read-only, so only the projection buffers are duplicated.
+                    ICP_Context::pcp_c_t cohort;
+                    ICP_Context ICPC; // Working ICP context.
+                    ICPC.cohort = &cohort;
+                    ICP_Context l_whole_ICPC = whole_ICPC;
+                    std::vector<pc_value_t> nearby;
+
+                    for(long int ransac_loop = next_round++; ransac_loop < RANSACMaxLoops; ransac_loop = next_round++){
+                        std::seed_seq seq{ static_cast<long int>(RandomSeed), ransac_loop };
+                        std::mt19937 re(seq);
+
+                        Grid_Context GC; // A working estimate of the grid position.
+                        GC.grid_sep = GridSeparation;
+                        GC.grid_sampling = GridSampling;
+
+                        bool fitted = false;
+                        while(!fitted){
+                            if(RANSACAborted) return;
+
+                            // Randomly select a point from the cloud.
+                            std::uniform_int_distribution<long int> rd(0, N_points - 1L);
+                            const auto N = rd(re);
+                            ICPC.ransac_centre = (* std::next( std::begin(points), N ));
+
+                            // Retain only the points within a small distance of the RANSAC centre. The cohort retains
+                            // the point cloud ordering.
+                            const auto &C = ICPC.ransac_centre;
+                            const pc_box_t bbox( pc_point_t(C.x - RANSACDist, C.y - RANSACDist, C.z - RANSACDist),
+                                                 pc_point_t(C.x + RANSACDist, C.y + RANSACDist, C.z + RANSACDist) );
+                            nearby.clear();
+                            pc_rtree.query( boost::geometry::index::intersects(bbox), std::back_inserter(nearby) );
+                            std::sort( std::begin(nearby), std::end(nearby),
+                                       [](const pc_value_t &L, const pc_value_t &R){ return (L.second < R.second); } );
+
+                            cohort.clear();
+                            for(const auto &v : nearby){
+                                const auto &P = (* std::next( std::begin(points), v.second ));
+                                if(P.distance(C) <= RANSACDist) cohort.emplace_back(P);
+                            }
+
+                            if(cohort.size() < 3){
+                                // If there are too few points to meaningfully continue, then the only thing we can assume is that the
+                                // selected point is in a region with a low density of points. So re-do the loop. However, if multiple
+                                // failures occur then we can probably conclude that the grid parameters are inappropriate. For example,
+                                // if the GridSeparation is too small then all points will appear to be in regions of low density.
+                                FUNCWARN("Too few adjacent points (" << cohort.size() << "), rebooting RANSAC loop.");
+                                Handle_RANSAC_Failure();
+                                continue;
+                            }
+
+                            // Allocate storage for ICP loops.
+                            ICPC.p_cell = cohort;
+                            ICPC.p_corr = cohort;
+
+                            // Perform ICP on the sub-set cohort.
+                            try{
+                                ICP_Fit_Grid(re, CoarseICPMaxLoops, GC, ICPC);
+                            }catch(const std::exception &e){
+                                FUNCWARN("Error encountered during coarse ICP (" << e.what() << "), rebooting RANSAC loop.");
+                                Handle_RANSAC_Failure();
+                                continue;
+                            }
+
+                            // Invalidate the coarse fit score since it is not applicable to the whole point cloud.
+                            GC.score = std::numeric_limits<double>::quiet_NaN();
+
+                            // Using the subset cohort fit, perform an ICP using the whole point cloud.
+                            l_whole_ICPC.ransac_centre = ICPC.ransac_centre;
+
+                            try{
+                                ICP_Fit_Grid(re, FineICPMaxLoops, GC, l_whole_ICPC);
+                            }catch(const std::exception &e){
+                                FUNCWARN("Error encountered during fine ICP (" << e.what() << "), rebooting RANSAC loop.");
+                                Handle_RANSAC_Failure();
+                                continue;
+                            }
+
+                            // Evaluate over the entire point cloud.
+                            GC.score = Score_Fit(l_whole_ICPC);
+                            fitted = true;
+                        }
+                        round_GCs[ransac_loop] = GC;
 
-            try{
-                ICP_Fit_Grid(re, FineICPMaxLoops, GC, whole_ICPC);
-            }catch(const std::exception &e){
-                FUNCWARN("Error encountered during fine ICP (" << e.what() << "), rebooting RANSAC loop.");
-                Handle_RANSAC_Failure(); // Will throw if too many failures encountered.
-                continue;
-            }
+                        {
+                            std::lock_guard<std::mutex> lock(saver_printer);
+                            ++completed_rounds;
+                            std::stringstream ss;
 
-            // Evaluate over the entire point cloud, retaining the global best.
-            GC.score = Score_Fit(whole_ICPC);
-            if(!std::isfinite(best_GC.score) || (GC.score < best_GC.score)){
-                best_GC = GC;
+                            ss << "Completed RANSAC loop " << ransac_loop << " (" << completed_rounds << " of " << RANSACMaxLoops
+                               << " --> " << static_cast<int>(1000.0*(completed_rounds)/RANSACMaxLoops)/10.0 << "%)."
+                               << " Current score is " << GC.score;
+                            FUNCINFO(ss.str());
+                        }
+                    }
+                }); // thread pool task closure.
             }
+        } // Wait until all threads are done.
 
-            {
-                std::lock_guard<std::mutex> lock(saver_printer);
-                std::stringstream ss;
+        if(RANSACAborted){
+            std::stringstream ss;
+            ss << "Encountered too many RANSAC failures."
+               << " Confirm GridSeparation and RANSACDist are valid and appropriate for the point cloud density.";
+            throw std::runtime_error(ss.str());
+        }
 
-                ss << "Completed RANSAC loop " << ransac_loop << " of " << RANSACMaxLoops
-                   << " --> " << static_cast<int>(1000.0*(ransac_loop)/RANSACMaxLoops)/10.0 << "%."
-                   << " Best and current scores are " << best_GC.score << " and " << GC.score;
-                FUNCINFO(ss.str());
+        // Retain the global best. Ties are resolved in favour of the earliest round so the result is reproducible.
+        for(const auto &GC : round_GCs){
+            if(std::isfinite(GC.score) && (!std::isfinite(best_GC.score) || (GC.score < best_GC.score))){
+                best_GC = GC;
             }
-            ++ransac_loop;
-        } // RANSAC loop.
+        }
+        FUNCINFO("Best score after RANSAC is " << best_GC.score);
 
         // Do something with the results.
         if(true){
@@ -1382,7 +1443,7 @@ if(false){
             // Write the grid for inspection.
             Insert_Grid_Contours(DICOM_data,
                            "best_grid",
-                           whole_ICPC.cohort,
+                           *(whole_ICPC.cohort),
                            best_GC.current_grid_anchor,
                            best_GC.current_grid_x * best_GC.grid_sep,
                            best_GC.current_grid_y * best_GC.grid_sep,
@@ -1403,7 +1464,7 @@ if(false){
                 const double proj_eps = 1.0E-4; // The amount of numerical uncertainty in the planar projection.
                 const bool inhibit_sort = true;
 
-                auto o_it = std::begin(whole_ICPC.cohort);
+                auto o_it = std::begin(*(whole_ICPC.cohort));
                 auto c_it = std::begin(whole_ICPC.p_corr);
                 for(const auto &P : whole_ICPC.p_cell){
                     const auto C = (*c_it);
@@ -1487,7 +1548,7 @@ if(false){
                                              std::numeric_limits<double>::quiet_NaN(),
                                              std::numeric_limits<double>::quiet_NaN() );
 
-                auto o_it = std::begin(whole_ICPC.cohort);
+                auto o_it = std::begin(*(whole_ICPC.cohort));
                 auto c_it = std::begin(whole_ICPC.p_corr);
                 for(const auto &P : whole_ICPC.p_cell){
                     const auto C = (*c_it);  // Corresponding point (in the proto cell).
@@ -1615,7 +1676,7 @@ for(const auto &apair : partitioned){
 
         // Imbue the fitted point cloud with metadata for visualization.
         {
-            std::vector<double> displacement(whole_ICPC.cohort.size(), std::numeric_limits<double>::quiet_NaN());
+            std::vector<double> displacement(whole_ICPC.cohort->size(), std::numeric_limits<double>::quiet_NaN());
 
             auto d_it = std::begin(displacement);
             auto c_it = std::begin(whole_ICPC.p_corr);
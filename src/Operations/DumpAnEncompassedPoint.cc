@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>    
 
+#include "../Rectilinear_Volume.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "DumpAnEncompassedPoint.h"
@@ -29,7 +30,7 @@ Drover DumpAnEncompassedPoint(Drover DICOM_data,
                               const std::map<std::string, std::string>& /*InvocationMetadata*/,
                               const std::string& /*FilenameLex*/){
     const auto apoint = DICOM_data.image_data.front()->imagecoll.images.front().center();
-    auto encompassing_images = DICOM_data.image_data.front()->imagecoll.get_images_which_encompass_point(apoint);
+    auto encompassing_images = DICOM_data.image_data.front()->get_volume_index()->images_encompassing(apoint);
 
     FUNCINFO("Found " << encompassing_images.size() << " images which encompass the point " << apoint);
 
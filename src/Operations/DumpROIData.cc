@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "../Structs.h"
+#include "../Dose_Volume_Histogram.h"
 #include "DumpROIData.h"
 #include "Explicator.h"       //Needed for Explicator class.
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -25,6 +26,10 @@ OperationDoc OpArgDocDumpROIData(){
 
     out.desc = "This operation dumps ROI contour information for debugging and quick inspection purposes.";
 
+    out.notes.emplace_back(
+        "If RTDOSE images are present, a summary of each ROI's dose-volume histogram is also reported."
+    );
+
     return out;
 }
 
@@ -163,6 +168,58 @@ Drover DumpROIData(const Drover& DICOM_data,
 
 
 
+    //If dose is available, summarize each ROI's dose-volume histogram. All ROIs are binned in a single sweep.
+    const auto is_dose = [](const std::shared_ptr<Image_Array> &ia) -> bool {
+        if((ia == nullptr) || ia->imagecoll.images.empty()) return false;
+        const auto &m = ia->imagecoll.images.front().metadata;
+        const auto m_it = m.find("Modality");
+        return (m_it != m.end()) && (m_it->second == "RTDOSE");
+    };
+    if( DICOM_data.Has_Contour_Data()
+    &&  std::any_of(DICOM_data.image_data.begin(), DICOM_data.image_data.end(), is_dose) ){
+        auto dvhs = drover_bnded_dose_dvh_map_factory();
+        for(auto cc_it = DICOM_data.contour_data->ccs.begin(); cc_it != DICOM_data.contour_data->ccs.end(); ++cc_it){
+            if(cc_it->contours.empty()) continue;
+            dvhs.emplace(cc_it, dose_volume_histogram(0.01));
+        }
+        DICOM_data.Bounded_Dose_General(nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,&dvhs);
+
+        std::map<key_t,dose_volume_histogram> ROIDVHs;
+        for(const auto &dvh : dvhs){
+            const auto &c = dvh.first->contours.front();
+            const key_t key = std::make_tuple(c.GetMetadataValueAs<std::string>("PatientID").value_or(""),
+                                              c.GetMetadataValueAs<std::string>("ROIName").value_or(""),
+                                              c.GetMetadataValueAs<std::string>("NormalizedROIName").value_or(""));
+            auto r_it = ROIDVHs.find(key);
+            if(r_it == ROIDVHs.end()){
+                ROIDVHs.emplace(key, dvh.second);
+            }else{
+                r_it->second.merge(dvh.second);
+            }
+        }
+
+        std::cout << "==== Dose-volume summary ====" << std::endl;
+        for(const auto &ROIDVH : ROIDVHs){
+            const auto thekey = ROIDVH.first;
+            const auto &dvh = ROIDVH.second;
+            std::cout << "DumpROIData:\t"
+                      << "PatientID='" << std::get<0>(thekey) << "'\t"
+                      << "ROIName='" << std::get<1>(thekey) << "'\t"
+                      << "NormalizedROIName='" << std::get<2>(thekey) << "'\t"
+                      << "DoseVolume=" << dvh.volume() << "\t"
+                      << "DoseMin=" << dvh.min() << "\t"
+                      << "DoseMean=" << dvh.mean() << "\t"
+                      << "DoseMax=" << dvh.max() << "\t"
+                      << "D02=" << dvh.dose_covering(0.02) << "\t"
+                      << "D50=" << dvh.dose_covering(0.50) << "\t"
+                      << "D98=" << dvh.dose_covering(0.98) << "\t"
+                      << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+
+
     std::cout << "==== Explictor best-guesses ====" << std::endl;
     Explicator X(FilenameLex);
     for(auto & ContourCount : ContourCounts){
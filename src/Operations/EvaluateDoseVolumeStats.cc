@@ -10,6 +10,7 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
@@ -20,6 +21,7 @@
 #include <vector>
 
 #include "../Structs.h"
+#include "../Dose_Volume_Histogram.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
 #include "EvaluateDoseVolumeStats.h"
@@ -52,6 +54,12 @@ OperationDoc OpArgDocEvaluateDoseVolumeStats(){
         "This routine will combine spatially-overlapping images by summing voxel intensities. It will not"
         " combine separate image_arrays though. If needed, you'll have to perform a meld on them beforehand."
     );
+    out.notes.emplace_back(
+        "Statistics are derived from dose-volume histograms that are accumulated in a single pass over the voxels."
+        " The minimum, mean, maximum, and standard deviation are exact. Dose percentiles (e.g., D_{2%} and the"
+        " median) are interpolated within histogram bins, so they are accurate to within the bin width."
+        " Bins are aligned so that 95% of the prescription dose falls on a bin edge."
+    );
 
 
 
@@ -72,6 +80,13 @@ OperationDoc OpArgDocEvaluateDoseVolumeStats(){
     out.args.back().expected = true;
     out.args.back().examples = { "50", "66", "70", "82.5" };
 
+    out.args.emplace_back();
+    out.args.back().name = "dDose";
+    out.args.back().desc = "The width of the dose-volume histogram bins used to derive dose statistics (in Gy).";
+    out.args.back().default_val = "0.01";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.001", "0.01", "0.1" };
+
     out.args.emplace_back();
     out.args.back() = RCWhitelistOpArgDoc();
     out.args.back().name = "PTVROILabelRegex";
@@ -120,6 +135,7 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data,
     const auto BodyNormalizedROILabelRegex = OptArgs.getValueStr("BodyNormalizedROILabelRegex").value();
 
     const auto PTVPrescriptionDose = std::stod( OptArgs.getValueStr("PTVPrescriptionDose").value());
+    const auto dDose = std::stod( OptArgs.getValueStr("dDose").value());
 
     const auto UserComment = OptArgs.getValueStr("UserComment");
 
@@ -196,62 +212,50 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data,
     }
 
     //Accumulate the voxel intensity distributions.
+    //
+    // Only voxels receiving strictly more than 95% of the prescription dose are counted. Bins are aligned to the
+    // smallest dose that exceeds it, so cumulative volumes at that edge are exact and exclude voxels at exactly 95%.
+    const auto Dpres95 = 0.95 * PTVPrescriptionDose;
+    const auto D_over_pres95 = std::nextafter(Dpres95, std::numeric_limits<double>::infinity());
+    const dose_volume_histogram prototype(dDose, D_over_pres95);
+
     AccumulatePixelDistributionsUserData ud_PTV;
+    ud_PTV.histogram_prototype = prototype;
     if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
                                                cc_PTV_ROIs, &ud_PTV )){
         throw std::runtime_error("Unable to accumulate PTV pixel distributions.");
     }
     AccumulatePixelDistributionsUserData ud_Body;
+    ud_Body.histogram_prototype = prototype;
     if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
                                                cc_Body_ROIs, &ud_Body )){
         throw std::runtime_error("Unable to accumulate Body pixel distributions.");
     }
 
 
-    const auto Dpres95 = 0.95 * PTVPrescriptionDose;
-    long int N_Body_over_Dpres95 = 0; //We assume all body ROIs are part of a single object.
-
     //Evalute the models.
-    {
-        for(auto &av : ud_Body.accumulated_voxels){
-            for(const auto &D_voxel : av.second){
-                if(D_voxel > Dpres95) ++N_Body_over_Dpres95;
-            }
-            av.second.clear(); // Reduce memory pressure.
-        }
+    //
+    // Note: voxels have unit weight, so histogram volumes are voxel counts.
+    double N_Body_over_Dpres95 = 0.0; //We assume all body ROIs are part of a single object.
+    for(const auto &h : ud_Body.histograms){
+        N_Body_over_Dpres95 += h.second.volume_above(D_over_pres95);
     }
 
     std::map<std::string, double> HI; // Heterogeneity index.
     std::map<std::string, double> CN; // Conformity number.
-
-    std::map<std::string, long int> N_PTV_over_Dpres95; //We assume all PTV ROIs are distinct.
-    {
-        for(const auto &av : ud_PTV.accumulated_voxels){
-            const auto lROIname = av.first;
-
-            const auto D_02 = Stats::Percentile(av.second, 0.98); // D_02 == 98% dose percentile.
-            const auto D_50 = Stats::Percentile(av.second, 0.50);
-            const auto D_98 = Stats::Percentile(av.second, 0.02); // D_98 == 2% dose percentile.
-
-            HI[lROIname] = (D_02 - D_98)/D_50;
-
-            long int N_over_Dpres95 = 0;
-            for(const auto &D_voxel : av.second){
-                if(D_voxel > Dpres95) ++N_over_Dpres95;
-            }
-            N_PTV_over_Dpres95[lROIname] += N_over_Dpres95;
-        }
-        for(const auto &av : ud_PTV.accumulated_voxels){
-            const auto lROIname = av.first;
-            const auto N = av.second.size();
-            //const long double V_frac = static_cast<long double>(1) / N; // Fractional volume of a single voxel compared to whole ROI.
-
-            const auto N_T = static_cast<double>(N);
-            const auto N_T_pres = static_cast<double>(N_PTV_over_Dpres95[lROIname]);
-            const auto N_pres = static_cast<double>(N_Body_over_Dpres95);
-
-            CN[lROIname] = (N_T_pres * N_T_pres) / (N_T * N_pres);
-        }
+    for(const auto &h : ud_PTV.histograms){
+        const auto lROIname = h.first;
+        const auto &dvh = h.second;
+
+        const auto D_02 = dvh.dose_covering(0.02); // D_02 == 98% dose percentile.
+        const auto D_50 = dvh.dose_covering(0.50);
+        const auto D_98 = dvh.dose_covering(0.98); // D_98 == 2% dose percentile.
+        HI[lROIname] = (D_02 - D_98)/D_50;
+
+        const auto N_T = dvh.volume();
+        const auto N_T_pres = dvh.volume_above(D_over_pres95); //We assume all PTV ROIs are distinct.
+        const auto N_pres = N_Body_over_Dpres95;
+        CN[lROIname] = (N_T_pres * N_T_pres) / (N_T * N_pres);
     }
 
 
@@ -288,13 +292,15 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data,
                    << "VoxelCount"
                    << std::endl;
         }
-        for(const auto &av : ud_PTV.accumulated_voxels){
-            const auto lROIname = av.first;
-            const auto DoseMin = Stats::Min( av.second );
-            const auto DoseMean = Stats::Mean( av.second );
-            const auto DoseMedian = Stats::Median( av.second );
-            const auto DoseMax = Stats::Max( av.second );
-            const auto DoseStdDev = std::sqrt(Stats::Unbiased_Var_Est( av.second ));
+        for(const auto &h : ud_PTV.histograms){
+            const auto lROIname = h.first;
+            const auto &dvh = h.second;
+            const auto N = static_cast<double>(dvh.count());
+            const auto DoseMin = dvh.min();
+            const auto DoseMean = dvh.mean();
+            const auto DoseMedian = dvh.dose_covering(0.50);
+            const auto DoseMax = dvh.max();
+            const auto DoseStdDev = std::sqrt(dvh.variance() * N / (N - 1.0)); // Unbiased estimate.
             const auto HeterogeneityIndex = HI[lROIname];
             const auto ConformityNumber = CN[lROIname];
 
@@ -309,7 +315,7 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data,
                     << DoseMedian         << ","
                     << DoseMax            << ","
                     << DoseStdDev         << ","
-                    << av.second.size()
+                    << dvh.count()
                     << std::endl;
         }
         FO_tcp.flush();
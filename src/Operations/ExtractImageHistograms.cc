@@ -49,6 +49,10 @@ OperationDoc OpArgDocExtractImageHistograms(){
         " HU or Gy), unscaled ordinates are reported in volumetric DICOM units (mm^3^), and normalized"
         " ordinates are reported as a fraction of the given ROI's total volume."
     );
+    out.notes.emplace_back(
+        "Cumulative histograms are sampled at bin edges and report the volume receiving a dose greater than or"
+        " equal to the abscissa."
+    );
     out.notes.emplace_back(
         "Non-finite voxels are excluded from analysis and do not contribute to the volume."
         " If exact volume is required, ensure all voxels are finite prior to invoking this routine."
@@ -179,15 +183,42 @@ OperationDoc OpArgDocExtractImageHistograms(){
 
     out.args.emplace_back();
     out.args.back().name = "dDose";
-    out.args.back().desc = "The (fixed) bin width, in units of dose (DICOM units; nominally Gy)."
-                           " Note that this is the *maximum* bin width, in practice bins may be"
-                           " smaller to account for slop (i.e., excess caused by the extrema being"
-                           " separated by a non-integer number of bins of width $dDose$).";
+    out.args.back().desc = "The bin width, in units of dose (DICOM units; nominally Gy)."
+                           " Bins are aligned to zero, so bin edges are integer multiples of $dDose$."
+                           " If 'MaxBins' is non-zero, this is the *initial* bin width and bins may be widened.";
     out.args.back().default_val = "0.1";
     out.args.back().expected = true;
     out.args.back().examples = { "0.0001", "0.001", "0.01", "5.0", "10", "50" };
 
 
+    out.args.emplace_back();
+    out.args.back().name = "MaxBins";
+    out.args.back().desc = "Controls whether histogram bins adapt to the distribution."
+                           " If zero, bins have fixed width $dDose$ and as many bins are used as needed to span the"
+                           " voxel values. Otherwise, adjacent bins are merged (doubling the bin width) whenever"
+                           " more than this many bins would be needed. Adaptive binning bounds memory usage when the"
+                           " range of voxel values is not known in advance.";
+    out.args.back().default_val = "0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0", "100", "1000", "10000" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "PartialVolumeSamples";
+    out.args.back().desc = "Controls partial-volume weighting."
+                           " If zero, every voxel deemed interior (according to the 'Inclusivity' parameter)"
+                           " contributes its whole volume. Otherwise, voxels straddling the ROI boundary contribute"
+                           " only the fraction of their volume within the ROI. The fraction is estimated by dividing"
+                           " each row of voxels into N sub-rows, where N is the value of this parameter, and computing"
+                           " the exact coverage along each sub-row."
+                           " When enabled, the 'Inclusivity' parameter is ignored."
+                           " Note that partial-volume weighting is not compatible with the"
+                           " 'honour_opposite_orientations' contour overlap option.";
+    out.args.back().default_val = "0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0", "3", "5", "10" };
+
+
     out.args.emplace_back();
     out.args.back().name = "UserComment";
     out.args.back().desc = "A string that will be inserted into the output file which will simplify merging output"
@@ -223,6 +254,8 @@ Drover ExtractImageHistograms(Drover DICOM_data,
     const auto Lower = std::stod(OptArgs.getValueStr("Lower").value());
     const auto Upper = std::stod(OptArgs.getValueStr("Upper").value());
     const auto dDose = std::stod(OptArgs.getValueStr("dDose").value());
+    const auto MaxBins = std::stol(OptArgs.getValueStr("MaxBins").value());
+    const auto PartialVolumeSamples = std::stol(OptArgs.getValueStr("PartialVolumeSamples").value());
 
     const auto UserComment = OptArgs.getValueStr("UserComment");
 
@@ -275,6 +308,8 @@ Drover ExtractImageHistograms(Drover DICOM_data,
         ComputeExtractHistogramsUserData ud;
 
         ud.dDose = dDose;
+        ud.max_bins = MaxBins;
+        ud.partial_volume_samples = PartialVolumeSamples;
         ud.channel = Channel;
         ud.lower_threshold = Lower;
         ud.upper_threshold = Upper;
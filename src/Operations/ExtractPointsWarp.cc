@@ -123,9 +123,9 @@ OperationDoc OpArgDocExtractPointsWarp(){
                            " correspondence estimate. 'ICP' stands for 'iterative closest point.'"
                            " Each iteration uses the previous transformation *only* to estimate correspondence;"
                            " a least-squares optimal linear transform is estimated afresh each iteration."
-                           " The 'exhaustive_icp' method is most suitable when both point clouds consist of"
-                           " approximately 50k points or less. Beyond this, ICP will still work but runtime"
-                           " scales badly."
+                           " Correspondence is estimated using a spatial index of the stationary points, so"
+                           " large point clouds are tolerated; runtime can be reduced further by subsampling the"
+                           " moving points and by using a coarse-to-fine resolution schedule."
                            " ICP is susceptible to outliers and will not scale a point cloud."
                            " It can be used for 2D and 1D degenerate problems, but is not guaranteed to find the"
                            " 'correct' orientation of degenerate or symmetrical point clouds."
@@ -362,6 +362,54 @@ OperationDoc OpArgDocExtractPointsWarp(){
     out.args.back().examples = { "1E-4", "0.001", "0.01" };
 #endif
 
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "TPSRPMSinkhornWarmStart";
+    out.args.back().desc = "Whether to warm-start the Sinkhorn procedure using the normalization from the previous"
+                           " correspondence update. The correspondence changes gradually during annealing, so"
+                           " warm-starting can greatly reduce the number of Sinkhorn iterations needed."
+                           " The resulting correspondence will differ slightly (i.e., within the Sinkhorn tolerance)"
+                           " from a cold start."
+                           " Note that this parameter is used with the TPS-RPM method, but *not* in the TPS method.";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
+#endif
+
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "TPSRPMControlPoints";
+    out.args.back().desc = "The number of moving points to use as thin plate spline control points."
+                           " If fewer than the number of moving points, a regularly spaced subset of the moving points"
+                           " is used and the spline is fitted to all moving points in a least-squares sense."
+                           " This low-rank approximation makes the linear solve scale linearly, rather than cubically,"
+                           " with the number of moving points, but the spline will not be able to represent"
+                           " deformations finer than the control point spacing."
+                           " Set to zero or a negative number to use all moving points."
+                           " Note that this parameter is used with the TPS-RPM method, but *not* in the TPS method.";
+    out.args.back().default_val = "-1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "-1", "200", "500", "2000" };
+#endif
+
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "TPSRPMSoftassignCutoff";
+    out.args.back().desc = "The distance beyond which softassign correspondence coefficients are truncated to zero,"
+                           " in units of the square root of the annealing temperature."
+                           " Correspondence coefficients decay exponentially with square distance, so distant pairs"
+                           " contribute negligibly. Truncation permits the correspondence to be stored sparsely and"
+                           " located using a spatial index, which greatly reduces the cost for large point clouds"
+                           " once the temperature has cooled."
+                           " A value of 3 discards coefficients smaller than about 1E-4 of the largest possible"
+                           " coefficient."
+                           " Set to zero or a negative number to disable truncation."
+                           " Note that this parameter is used with the TPS-RPM method, but *not* in the TPS method.";
+    out.args.back().default_val = "0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0", "3", "5" };
+#endif
+
 #ifdef DCMA_USE_EIGEN
     out.args.emplace_back();
     out.args.back().name = "TPSRPMSeedWithCentroidShift";
@@ -383,11 +431,12 @@ OperationDoc OpArgDocExtractPointsWarp(){
     out.args.back().desc = "The method used to solve the system of linear equtions that defines the thin plate spline"
                            " solution. The pseudoinverse will likely be able to provide a solution when the system is"
                            " degenerate, but it might not be reasonable or even sensible. The LDLT method scales"
-                           " better."
+                           " better. The conjugate gradient method is iterative and is warm-started with the previous"
+                           " solution, so it is best suited to large systems (e.g., when many control points are used)."
                            " Note that this parameter is used with the TPS-RPM method, but *not* in the TPS method.";
     out.args.back().default_val = "LDLT";
     out.args.back().expected = true;
-    out.args.back().examples = { "LDLT", "PseudoInverse", };
+    out.args.back().examples = { "LDLT", "PseudoInverse", "ConjugateGradient" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 #endif
 
@@ -448,6 +497,30 @@ OperationDoc OpArgDocExtractPointsWarp(){
     out.args.back().examples = { "true", "false" };
 #endif
 
+#ifdef DCMA_USE_EIGEN
+    out.args.emplace_back();
+    out.args.back().name = "ICPMaxMovingPoints";
+    out.args.back().desc = "The maximum number of moving points to use with the 'exhaustive_icp' method."
+                           " If the moving point cloud has more points, it is subsampled uniformly."
+                           " Subsampling can dramatically reduce runtime for dense point clouds, but may reduce"
+                           " precision if too few points are retained."
+                           " Set to zero or a negative number to use all points.";
+    out.args.back().default_val = "-1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "-1", "10000", "50000", "200000" };
+
+    out.args.emplace_back();
+    out.args.back().name = "ICPResolutionLevels";
+    out.args.back().desc = "The number of resolution levels to use with the 'exhaustive_icp' method."
+                           " Alignment is first performed with a coarse subsample of the moving points,"
+                           " and then refined using progressively more points (4x more per level)."
+                           " Coarse levels are cheap and help the finest level to converge in fewer iterations."
+                           " Set to 1 to perform alignment only at the finest level.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "2", "3", "4" };
+#endif
+
     out.args.emplace_back();
     out.args.back().name = "MaxIterations";
     out.args.back().desc = "If the method is iterative, only permit this many iterations to occur."
@@ -511,10 +584,17 @@ Drover ExtractPointsWarp(Drover DICOM_data,
     const auto TPSRPMStepsPerT = std::stol( OptArgs.getValueStr("TPSRPMStepsPerT").value() );
     const auto TPSRPMSinkhornMaxSteps = std::stol( OptArgs.getValueStr("TPSRPMSinkhornMaxSteps").value() );
     const auto TPSRPMSinkhornTolerance = std::stod( OptArgs.getValueStr("TPSRPMSinkhornTolerance").value() );
+    const auto TPSRPMSinkhornWarmStartStr = OptArgs.getValueStr("TPSRPMSinkhornWarmStart").value();
+    const auto TPSRPMControlPoints = std::stol( OptArgs.getValueStr("TPSRPMControlPoints").value() );
+    const auto TPSRPMSoftassignCutoff = std::stod( OptArgs.getValueStr("TPSRPMSoftassignCutoff").value() );
     const auto TPSRPMSeedWithCentroidShiftStr = OptArgs.getValueStr("TPSRPMSeedWithCentroidShift").value();
     const auto TPSRPMHardContraintsStr = OptArgs.getValueStr("TPSRPMHardConstraints").value();
     const auto TPSRPMPermitMovingOutliersStr = OptArgs.getValueStr("TPSRPMPermitMovingOutliers").value();
     const auto TPSRPMPermitStationaryOutliersStr = OptArgs.getValueStr("TPSRPMPermitStationaryOutliers").value();
+
+    // ICP params.
+    const auto ICPMaxMovingPoints = std::stol( OptArgs.getValueStr("ICPMaxMovingPoints").value() );
+    const auto ICPResolutionLevels = std::stol( OptArgs.getValueStr("ICPResolutionLevels").value() );
 #endif // DCMA_USE_EIGEN
 
     const auto MaxIters = std::stol( OptArgs.getValueStr("MaxIterations").value() );
@@ -531,9 +611,11 @@ Drover ExtractPointsWarp(Drover DICOM_data,
 
     const auto regex_ldlt = Compile_Regex("^LD?L?T?$");
     const auto regex_pinv = Compile_Regex("^ps?e?u?d?o?[-_]?i?n?v?e?r?s?e?$");
+    const auto regex_cg   = Compile_Regex("^co?n?j?u?g?a?t?e?[-_]?g?r?a?d?i?e?n?t?$");
 
     const auto TPSRPMSeedWithCentroidShift = std::regex_match(TPSRPMSeedWithCentroidShiftStr, regex_true);
     const auto TPSRPMDoubleSidedOutliers = std::regex_match(TPSRPMDoubleSidedOutliersStr, regex_true);
+    const auto TPSRPMSinkhornWarmStart = std::regex_match(TPSRPMSinkhornWarmStartStr, regex_true);
     const auto TPSRPMPermitMovingOutliers = std::regex_match(TPSRPMPermitMovingOutliersStr, regex_true);
     const auto TPSRPMPermitStationaryOutliers = std::regex_match(TPSRPMPermitStationaryOutliersStr, regex_true);
 
@@ -607,7 +689,9 @@ Drover ExtractPointsWarp(Drover DICOM_data,
             auto t_opt = AlignViaExhaustiveICP( (*pcp_it)->pset,
                                                 (*ref_PCs.front())->pset,
                                                 MaxIters,
-                                                RelativeTol );
+                                                RelativeTol,
+                                                ICPMaxMovingPoints,
+                                                ICPResolutionLevels );
             if(t_opt){
                 FUNCINFO("Successfully found warp using exhaustive ICP");
                 DICOM_data.trans_data.emplace_back( std::make_shared<Transform3>( ) );
@@ -657,6 +741,9 @@ Drover ExtractPointsWarp(Drover DICOM_data,
             params.N_iters_at_fixed_T       = TPSRPMStepsPerT;
             params.N_Sinkhorn_iters         = TPSRPMSinkhornMaxSteps;
             params.Sinkhorn_tolerance       = TPSRPMSinkhornTolerance;
+            params.Sinkhorn_warm_start      = TPSRPMSinkhornWarmStart;
+            params.N_control_points         = TPSRPMControlPoints;
+            params.softassign_cutoff        = TPSRPMSoftassignCutoff;
             params.seed_with_centroid_shift = TPSRPMSeedWithCentroidShift;
             params.forced_correspondence    = TPSRPMHardContraints;
             params.permit_move_outliers     = TPSRPMPermitMovingOutliers;
@@ -670,6 +757,8 @@ params.report_final_correspondence = true;
                 params.solution_method = AlignViaTPSRPMParams::SolutionMethod::LDLT;
             }else if( std::regex_match(TPSRPMSolverStr, regex_pinv) ){
                 params.solution_method = AlignViaTPSRPMParams::SolutionMethod::PseudoInverse;
+            }else if( std::regex_match(TPSRPMSolverStr, regex_cg) ){
+                params.solution_method = AlignViaTPSRPMParams::SolutionMethod::ConjugateGradient;
             }else{
                 throw std::runtime_error("Solver not understood. Unable to continue.");
             }
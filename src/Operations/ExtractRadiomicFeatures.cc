@@ -39,11 +39,65 @@
 #include "../Write_File.h"
 #include "../Thread_Pool.h"
 #include "../Surface_Meshes.h"
+#include "../Texture_Matrices.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
 
 #include "ExtractRadiomicFeatures.h"
 
+
+namespace {
+
+// Accumulates voxel intensities and their central moments (up to fourth order) in a single pass.
+//
+// Accumulators for disjoint sets of voxels can be merged exactly (Pebay, 2008), so images can be processed
+// independently.
+struct first_order_accumulator {
+    std::vector<double> vals;
+    double N = 0.0;
+    double mean = 0.0;
+    double M2 = 0.0;
+    double M3 = 0.0;
+    double M4 = 0.0;
+    double energy = 0.0; // Sum of squared intensities.
+
+    void merge(double n_b, double mean_b, double M2_b, double M3_b, double M4_b, double energy_b){
+        const auto n_a = this->N;
+        const auto n = n_a + n_b;
+        if(n_b <= 0.0) return;
+
+        const auto delta = mean_b - this->mean;
+        const auto delta2 = delta * delta;
+        const auto M2_a = this->M2;
+        const auto M3_a = this->M3;
+        this->M4 += M4_b + delta2 * delta2 * n_a * n_b * (n_a * n_a - n_a * n_b + n_b * n_b) / (n * n * n)
+                  + 6.0 * delta2 * (n_a * n_a * M2_b + n_b * n_b * M2_a) / (n * n)
+                  + 4.0 * delta * (n_a * M3_b - n_b * M3_a) / n;
+        this->M3 += M3_b + delta * delta2 * n_a * n_b * (n_a - n_b) / (n * n)
+                  + 3.0 * delta * (n_a * M2_b - n_b * M2_a) / n;
+        this->M2 += M2_b + delta2 * n_a * n_b / n;
+        this->mean += delta * n_b / n;
+        this->N = n;
+        this->energy += energy_b;
+        return;
+    }
+
+    void digest(double I){
+        this->vals.push_back(I);
+        this->merge(1.0, I, 0.0, 0.0, 0.0, I * I);
+        return;
+    }
+
+    void merge(const first_order_accumulator &other){
+        this->vals.insert(std::end(this->vals), std::begin(other.vals), std::end(other.vals));
+        this->merge(other.N, other.mean, other.M2, other.M3, other.M4, other.energy);
+        return;
+    }
+};
+
+} // namespace.
+
+
 OperationDoc OpArgDocExtractRadiomicFeatures(){
     OperationDoc out;
     out.name = "ExtractRadiomicFeatures";
@@ -61,6 +115,17 @@ OperationDoc OpArgDocExtractRadiomicFeatures(){
         " Often removing the highest-frequency components of the contour will help, such as edges that conform"
         " tightly to individual voxels."
     );
+    out.notes.emplace_back(
+        "Convex hull features (i.e., the maximum 3D diameter, hull volume, hull surface area, and solidity) are derived"
+        " from the convex hull of the ROI contour vertices, not the estimated surface mesh."
+    );
+    out.notes.emplace_back(
+        "Texture features are derived from grey level co-occurrence (GLCM), run length (GLRLM), and size zone (GLSZM)"
+        " matrices. Voxel intensities within the ROI(s) are quantized into a fixed number of equal-width grey levels."
+        " GLCM and GLRLM features are computed for each of the 13 unique 3D directions and averaged."
+        " Only the first channel is considered. Images must form a rectilinear grid, otherwise texture features are"
+        " reported as NaN."
+    );
 
 
     out.args.emplace_back();
@@ -101,6 +166,16 @@ OperationDoc OpArgDocExtractRadiomicFeatures(){
     out.args.back().default_val = ".*";
 
 
+    out.args.emplace_back();
+    out.args.back().name = "TextureGreyLevels";
+    out.args.back().desc = "The number of grey levels that voxel intensities are quantized into prior to computing"
+                           " texture features. Quantization spans the range of voxel intensities within the ROI(s)."
+                           " Fewer levels are more robust to noise, but may obscure fine textural detail.";
+    out.args.back().default_val = "32";
+    out.args.back().expected = true;
+    out.args.back().examples = { "8", "16", "32", "64" };
+
+
     return out;
 }
 
@@ -121,7 +196,12 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
 
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
 
+    const auto TextureGreyLevels = std::stol( OptArgs.getValueStr("TextureGreyLevels").value() );
+
     //-----------------------------------------------------------------------------------------------------------------
+    if(TextureGreyLevels < 1){
+        throw std::invalid_argument("At least one texture grey level is required. Cannot continue.");
+    }
 
     //Stuff references to all contours into a list. Remember that you can still address specific contours through
     // the original holding containers (which are not modified here).
@@ -168,18 +248,13 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
         contours_header << ",LongestPerimeter";
         contours_report << "," << LongestPerimeter;
 
+        // The longest distance between any two vertices is the diameter of their convex hull, so only the hull
+        // vertices need to be compared.
         double LongestVertVertDistance = -1.0;
         for(const auto &cc_refw : cc_ROIs){
-            for(const auto &cA : cc_refw.get().contours){
-                for(const auto &vA : cA.points){
-                    for(const auto &cB : cc_refw.get().contours){
-                        for(const auto &vB : cB.points){
-                            const auto dist = vB.distance( vA );
-                            if(dist > LongestVertVertDistance) LongestVertVertDistance = dist;
-                        }
-                    }
-                }
-            }
+            const auto hull = polyhedron_processing::Convex_Hull( { cc_refw } );
+            const auto dist = polyhedron_processing::Diameter(hull);
+            if(dist > LongestVertVertDistance) LongestVertVertDistance = dist;
         }
         contours_header << ",LongestVertexVertexDistance";
         contours_report << "," << LongestVertVertDistance;
@@ -225,6 +300,27 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
         const auto C = V/std::sqrt( pi * std::pow(A, 3.0) );
         smesh_header << ",MeshCompactness";
         smesh_report << "," << C;
+
+        // Convex hull features. Note that the hull is computed from the contour vertices, not the estimated mesh.
+        const auto hull = polyhedron_processing::Convex_Hull( cc_ROIs );
+
+        const auto D_max = polyhedron_processing::Diameter(hull);
+        smesh_header << ",Maximum3DDiameter";
+        smesh_report << "," << D_max;
+
+        const auto V_hull = polyhedron_processing::Volume(hull);
+        smesh_header << ",ConvexHullVolume";
+        smesh_report << "," << V_hull;
+
+        const auto A_hull = polyhedron_processing::SurfaceArea(hull);
+        smesh_header << ",ConvexHullSurfaceArea";
+        smesh_report << "," << A_hull;
+
+        // Also known as 'volume density' w.r.t. the convex hull. Undefined when the hull is degenerate (e.g., flat).
+        const auto Solidity = ( std::isfinite(V_hull) && (0.0 < V_hull) ) ? V/V_hull
+                                                                            : std::numeric_limits<double>::quiet_NaN();
+        smesh_header << ",Solidity";
+        smesh_report << "," << Solidity;
     }
 
 
@@ -252,7 +348,22 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
                             });
         }
 
-        std::vector<double> voxel_vals;
+        // Harvest the voxels and their moments in a single pass, processing images in parallel. Each image has a
+        // dedicated accumulator, so no synchronization is needed.
+        //
+        // The bounded voxels are also recorded for texture features. Only bounded voxels are stored, since the ROI
+        // typically covers a small portion of each image.
+        struct bounded_voxel {
+            long int row;
+            long int col;
+            float val;
+        };
+        std::map<const planar_image<float,double>*, first_order_accumulator> img_accs;
+        std::map<const planar_image<float,double>*, std::vector<bounded_voxel>> img_bounded;
+        for(const auto &img : (*iap_it)->imagecoll.images){
+            img_accs[ &img ];
+            img_bounded[ &img ];
+        }
 
         PartitionedImageVoxelVisitorMutatorUserData ud;
         ud.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
@@ -272,25 +383,41 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
         std::function<void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &)> f_noop;
         ud.f_unbounded = f_noop;
         ud.f_visitor = f_noop;
-        ud.f_bounded = [&](long int /*row*/, 
-                           long int /*col*/, 
-                           long int /*chan*/, 
-                           std::reference_wrapper<planar_image<float,double>> /*img_refw*/, 
+        ud.f_bounded = [&](long int row, 
+                           long int col, 
+                           long int chan, 
+                           std::reference_wrapper<planar_image<float,double>> img_refw, 
                            float &voxel_val) {
             // Append the value to the voxel store.
-            voxel_vals.emplace_back(voxel_val);
+            img_accs.at( &(img_refw.get()) ).digest(voxel_val);
+
+            if(chan == 0){
+                img_bounded.at( &(img_refw.get()) ).push_back( { row, col, voxel_val } );
+            }
 
             // Append the value rounded to the nearest integer to the voxel store.
-            //voxel_vals.emplace_back( static_cast<long int>( std::round(voxel_val) ) );
+            //img_accs.at( &(img_refw.get()) ).digest( static_cast<long int>( std::round(voxel_val) ) );
             return;
         };
 
-        if(!(*iap_it)->imagecoll.Process_Images( GroupIndividualImages,
-                                                 PartitionedImageVoxelVisitorMutator,
-                                                 {}, cc_ROIs, &ud )){
+        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
+                                                          PartitionedImageVoxelVisitorMutator,
+                                                          {}, cc_ROIs, &ud )){
             throw std::runtime_error("Unable to harvest voxels within the specified ROI(s).");
         }
 
+        first_order_accumulator acc;
+        {
+            size_t N_total = 0;
+            for(const auto &p : img_accs) N_total += p.second.vals.size();
+            acc.vals.reserve(N_total);
+        }
+        for(auto &p : img_accs){
+            acc.merge(p.second);
+            p.second = first_order_accumulator(); // Release memory early.
+        }
+        const auto &voxel_vals = acc.vals;
+
         // Process the voxel data.
         if(voxel_vals.empty()){
             throw std::domain_error("No voxels identified interior to the selected ROI(s). Cannot continue.");
@@ -318,7 +445,7 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
         const auto N_I    = static_cast<double>(voxel_vals.size());
         const auto I_min  = Stats::Min(voxel_vals);
         const auto I_max  = Stats::Max(voxel_vals);
-        const auto I_mean = Stats::Mean(voxel_vals);
+        const auto I_mean = acc.mean;
         const auto I_02   = Stats::Percentile(voxel_vals, 0.02);
         const auto I_05   = Stats::Percentile(voxel_vals, 0.05);
         const auto I_10   = Stats::Percentile(voxel_vals, 0.10);
@@ -395,12 +522,7 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
 
         // Deviations.
         {
-            const auto Var = std::accumulate(
-                               std::begin(voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + (I - I_mean) * (I - I_mean);
-                               }) / N_I;
+            const auto Var = acc.M2 / N_I;
                                 
             header << ",Variance";
             report << "," << Var;
@@ -411,19 +533,8 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
             report << "," << StdDev;
 
 
-            const auto CM3 = std::accumulate(
-                               std::begin(voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + (I - I_mean) * (I - I_mean) * (I - I_mean);
-                               }) / N_I;
-                                
-            const auto CM4 = std::accumulate(
-                               std::begin(voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + (I - I_mean) * (I - I_mean) * (I - I_mean) * (I - I_mean);
-                               }) / N_I;
+            const auto CM3 = acc.M3 / N_I;
+            const auto CM4 = acc.M4 / N_I;
                                 
             const auto CV = StdDev / I_mean;
 
@@ -483,12 +594,7 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
         // Pixel intensity 'image energy.' Also a shifted energy with voxel intensities translated so the smallest voxel
         // intensity contributes zero energy.
         {
-            const auto E = std::accumulate(std::begin(
-                               voxel_vals), std::end(voxel_vals),
-                               static_cast<double>(0),
-                               [&](double run, double I) -> double {
-                                   return run + I*I;
-                               });
+            const auto E = acc.energy;
                                 
             header << ",IntensityEnergy";
             report << "," << E;
@@ -513,6 +619,89 @@ Drover ExtractRadiomicFeatures(Drover DICOM_data,
         }
 
 
+        // Texture features.
+        {
+            // Placeholders (i.e., NaNs) are reported if the features cannot be computed so the columns remain consistent.
+            auto glcm_features = GLCM_Features( {} );
+            auto glrlm_features = GLRLM_Features( {}, 0L );
+            auto glszm_features = GLSZM_Features( texture_matrix(), 0L );
+            try{
+                std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+                for(auto &img : (*iap_it)->imagecoll.images){
+                    selected_imgs.push_back( std::ref(img) );
+                }
+                if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+                    throw std::invalid_argument("Images do not form a rectilinear grid");
+                }
+
+                // Order the masked voxels into a volume, stacking images along the contour normal.
+                const auto orientation_normal = Average_Contour_Normals(cc_ROIs);
+                planar_image_adjacency<float,double> adj( {}, { { std::ref((*iap_it)->imagecoll) } }, orientation_normal );
+                const auto N_adj_imgs = static_cast<long int>(adj.int_to_img.size());
+                const long int N_adj_rows = adj.index_to_image(0L).get().rows;
+                const long int N_adj_cols = adj.index_to_image(0L).get().columns;
+
+                // Crop the volume to the bounding box of the masked voxels, padded by one voxel. Voxels outside the ROI
+                // do not contribute to any texture matrix, so this only reduces the work and memory needed.
+                long int r_lo = N_adj_rows, r_hi = -1;
+                long int c_lo = N_adj_cols, c_hi = -1;
+                long int i_lo = N_adj_imgs, i_hi = -1;
+                for(long int i = 0; i < N_adj_imgs; ++i){
+                    const auto &bounded = img_bounded.at( &(adj.index_to_image(i).get()) );
+                    if(bounded.empty()) continue;
+                    i_lo = std::min(i_lo, i);
+                    i_hi = std::max(i_hi, i);
+                    for(const auto &v : bounded){
+                        r_lo = std::min(r_lo, v.row);
+                        r_hi = std::max(r_hi, v.row);
+                        c_lo = std::min(c_lo, v.col);
+                        c_hi = std::max(c_hi, v.col);
+                    }
+                }
+                if(i_hi < 0){
+                    throw std::invalid_argument("No voxels are bounded by the ROI(s)");
+                }
+                r_lo = std::max(0L, r_lo - 1L);
+                c_lo = std::max(0L, c_lo - 1L);
+                i_lo = std::max(0L, i_lo - 1L);
+                r_hi = std::min(N_adj_rows - 1L, r_hi + 1L);
+                c_hi = std::min(N_adj_cols - 1L, c_hi + 1L);
+                i_hi = std::min(N_adj_imgs - 1L, i_hi + 1L);
+                const auto N_rows = r_hi - r_lo + 1L;
+                const auto N_cols = c_hi - c_lo + 1L;
+                const auto N_imgs = i_hi - i_lo + 1L;
+
+                std::vector<float> intensities( static_cast<size_t>(N_rows * N_cols * N_imgs),
+                                                std::numeric_limits<float>::quiet_NaN() );
+                for(long int i = i_lo; i <= i_hi; ++i){
+                    for(const auto &v : img_bounded.at( &(adj.index_to_image(i).get()) )){
+                        const auto k = ((i - i_lo) * N_rows + (v.row - r_lo)) * N_cols + (v.col - c_lo);
+                        intensities.at( static_cast<size_t>(k) ) = v.val;
+                    }
+                }
+                img_bounded.clear();
+
+                const auto vol = Quantize_Intensities(N_rows, N_cols, N_imgs, intensities, TextureGreyLevels);
+                const auto N_masked = static_cast<long int>( std::count_if(std::begin(vol.levels), std::end(vol.levels),
+                                                                           [](int32_t l){ return (0 <= l); }) );
+
+                glcm_features = GLCM_Features( Compute_GLCMs(vol) );
+                glrlm_features = GLRLM_Features( Compute_GLRLMs(vol), N_masked );
+                glszm_features = GLSZM_Features( Compute_GLSZM(vol), N_masked );
+
+            }catch(const std::exception &e){
+                FUNCWARN("Unable to compute texture features: '" << e.what() << "'");
+            }
+
+            for(const auto &features : { glcm_features, glrlm_features, glszm_features }){
+                for(const auto &f : features){
+                    header << "," << f.first;
+                    report << "," << f.second;
+                }
+            }
+        }
+
+
         // Add the contour- and surface-mesh-based features.
         header << contours_header.str();
         report << contours_report.str();
@@ -2,6 +2,8 @@
 
 #include <asio.hpp>
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <optional>
 #include <fstream>
 #include <iterator>
@@ -12,7 +14,9 @@
 #include <regex>
 #include <set> 
 #include <stdexcept>
+#include <sstream>
 #include <string>    
+#include <thread>
 #include <utility>            //Needed for std::pair.
 #include <list>
 #include <memory>
@@ -109,10 +113,25 @@ OperationDoc OpArgDocForEachDistinct() {
         "If this operation has no children, this operation will evaluate to a no-op."
     );
     out.notes.emplace_back(
-        "Each invocation is performed sequentially, and all side-effects are carried forward for each iteration."
+        "By default, each invocation is performed sequentially, and all side-effects are carried forward for each iteration."
         " However, partitions are generated before any child operations are invoked, so newly-added elements (e.g.,"
         " new Image_Arrays) created by one invocation will not participate in subsequent invocations."
-        " The final order of the partitions is arbitrary."
+        " The final order of the partitions is arbitrary, but it does not depend on whether partitions are"
+        " processed concurrently."
+    );
+    out.notes.emplace_back(
+        "Partitions can optionally be processed concurrently. Partitions are disjoint, so child operations that only"
+        " access the data in their partition are safe to run concurrently. If any partition fails, partitions that"
+        " have not yet started are skipped, running partitions stop before their next child operation, and this"
+        " operation fails."
+    );
+    out.notes.emplace_back(
+        "Not all child operations are safe to run concurrently. Interactive operations (e.g., SDL_Viewer,"
+        " SFML_Viewer, BuildLexiconInteractively) must not be used. Operations that generate unique filenames"
+        " (e.g., in /tmp) check for existing files before writing, so concurrent invocations can select the same"
+        " filename; explicit, distinct filenames should be provided instead. Operations that append to shared"
+        " files guarded by a named mutex (e.g., DumpPlanSummary, ContourSimilarity, EvaluateDoseVolumeStats,"
+        " AnalyzeHistograms) remain correct, but are serialized across partitions."
     );
     out.notes.emplace_back(
         " This operation will most often be used to process data group-wise rather than as a whole."
@@ -132,6 +151,15 @@ OperationDoc OpArgDocForEachDistinct() {
                                  "SeriesInstanceUID", 
                                  "StationName" };
 
+    out.args.emplace_back();
+    out.args.back().name = "MaxWorkers";
+    out.args.back().desc = "The maximum number of partitions to process concurrently."
+                           " A value of 1 processes partitions sequentially."
+                           " A value of 0 uses the number of available hardware threads.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0", "1", "2", "4", "8" };
+
     return out;
 }
 
@@ -141,9 +169,14 @@ Drover ForEachDistinct(Drover DICOM_data,
               const std::string& FilenameLex){
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto KeysCommonStr = OptArgs.getValueStr("KeysCommon").value();
+    const auto MaxWorkers = std::stol( OptArgs.getValueStr("MaxWorkers").value() );
 
     //-----------------------------------------------------------------------------------------------------------------
 
+    if(MaxWorkers < 0){
+        throw std::invalid_argument("MaxWorkers must be non-negative. Cannot continue.");
+    }
+
     // Parse the chain of metadata keys.
     std::list<std::string> KeysCommon;
     for(auto a : SplitStringToVector(KeysCommonStr, ';', 'd')){
@@ -212,11 +245,73 @@ Drover ForEachDistinct(Drover DICOM_data,
         }
 
         // Invoke children operations over each valid partition.
-        FUNCINFO("Performing children operations over " << partitions.size() << " partitions (+1 'N/A' partition)");
-        for(auto & p : partitions){
-            if(!Operation_Dispatcher(p.second, InvocationMetadata, FilenameLex, OptArgs.getChildren())){
-                throw std::runtime_error("Child analysis failed. Cannot continue");
+        //
+        // Child operations are dispatched one at a time so that a failure in one partition can halt the others
+        // between operations. Messages are prefixed with the partition's key-values to help untangle concurrent logs.
+        const auto children = OptArgs.getChildren();
+        const auto N_partitions = partitions.size();
+        std::atomic<bool> failed(false);
+        std::mutex failure_lock;
+        std::string failed_partition;
+
+        auto process_partition = [&](size_t n, const std::list<std::string> &value_signature, Drover &d) -> void {
+            std::stringstream ss;
+            ss << "Partition " << (n + 1) << "/" << N_partitions << " (";
+            auto key_it = std::begin(KeysCommon);
+            for(auto val_it = std::begin(value_signature); val_it != std::end(value_signature); ++val_it, ++key_it){
+                ss << ((val_it == std::begin(value_signature)) ? "" : ", ") << *key_it << "=" << *val_it;
             }
+            ss << ")";
+            const auto prefix = ss.str();
+
+            try{
+                long int i = 0;
+                for(const auto &child : children){
+                    if(failed){
+                        FUNCINFO(prefix << ": cancelled because another partition failed");
+                        return;
+                    }
+                    FUNCINFO(prefix << ": performing child operation " << ++i << "/" << children.size()
+                                    << " '" << child.getName() << "'");
+                    if(!Operation_Dispatcher(d, InvocationMetadata, FilenameLex, { child })){
+                        throw std::runtime_error("Child analysis failed");
+                    }
+                }
+                FUNCINFO(prefix << ": completed");
+            }catch(const std::exception &e){
+                FUNCWARN(prefix << ": failed: '" << e.what() << "'");
+                std::lock_guard<std::mutex> lock(failure_lock);
+                if(!failed) failed_partition = prefix;
+                failed = true;
+            }
+            return;
+        };
+
+        const auto N_workers = (MaxWorkers == 0) ? static_cast<long int>(std::thread::hardware_concurrency())
+                                                 : MaxWorkers;
+        FUNCINFO("Performing children operations over " << N_partitions << " partitions (+1 'N/A' partition)"
+                 << " using up to " << std::max(1L, N_workers) << " concurrent worker(s)");
+        if( (N_workers <= 1) || (N_partitions <= 1) ){
+            size_t n = 0;
+            for(auto & p : partitions){
+                process_partition(n++, p.first, p.second);
+                if(failed) break;
+            }
+        }else{
+            asio_thread_pool tp(static_cast<size_t>( std::min<long int>(N_workers, N_partitions) ));
+            size_t n = 0;
+            for(auto & p : partitions){
+                auto *p_ptr = &p;
+                tp.submit_task([&,n,p_ptr]() -> void {
+                    if(failed) return;
+                    process_partition(n, p_ptr->first, p_ptr->second);
+                }); // thread pool task closure.
+                ++n;
+            }
+        } // Wait until all threads are done.
+
+        if(failed){
+            throw std::runtime_error("Child analysis failed in " + failed_partition + ". Cannot continue");
         }
 
         // Combine all partitions back into a single Drover object to capture all additions/removals/modifications.
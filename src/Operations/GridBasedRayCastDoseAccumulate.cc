@@ -17,6 +17,7 @@
 #include <string>    
 
 #include "../Dose_Meld.h"
+#include "../Rectilinear_Volume.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
@@ -112,10 +113,9 @@ OperationDoc OpArgDocGridBasedRayCastDoseAccumulate(){
     
     out.args.emplace_back();
     out.args.back().name = "RaydL";
-    out.args.back().desc = "The distance to move a ray each iteration. Should be << img_thickness and << cylinder_radius."
-                      " Making too large will invalidate results, causing rays to pass through the surface without"
-                      " registering any dose accumulation. Making too small will cause the run-time to grow and may"
-                      " eventually lead to truncation or round-off errors. Quantity is in the DICOM coordinate system.";
+    out.args.back().desc = "The distance to move a ray each iteration. Note that this parameter is no longer used;"
+                      " rays are traversed voxel-by-voxel through the surface mask grid, and the exact length of"
+                      " the ray within each voxel is used. This parameter is retained for compatibility only.";
     out.args.back().default_val = "0.1";
     out.args.back().expected = true;
     out.args.back().examples = { "0.1", "0.05", "0.01", "0.005" };
@@ -181,7 +181,6 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
     const auto ReferenceROILabelRegex = OptArgs.getValueStr("ReferenceROILabelRegex").value();
     const auto NormalizedReferenceROILabelRegex = OptArgs.getValueStr("NormalizedReferenceROILabelRegex").value();
     const auto SmallestFeature = std::stod(OptArgs.getValueStr("SmallestFeature").value());
-    const auto RaydL = std::stod(OptArgs.getValueStr("RaydL").value());
     const auto GridRows = std::stol(OptArgs.getValueStr("GridRows").value());
     const auto GridColumns = std::stol(OptArgs.getValueStr("GridColumns").value());
     const auto SourceDetectorRows = std::stol(OptArgs.getValueStr("SourceDetectorRows").value());
@@ -449,6 +448,16 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
 
     //Now ready to ray cast. Loop over integer pixel coordinates. Start and finish are image pixels.
     // The top image can be the length image.
+    //
+    // Rays are traversed voxel-by-voxel through the surface mask grid, which is rectilinear by construction. Dose
+    // lookups use the dose array's volume index rather than a search over all images.
+    const auto mask_vol_index = grid_arr_ptr->get_volume_index();
+    if(!mask_vol_index->rectilinear){
+        throw std::logic_error("Surface mask grid is not rectilinear. Cannot continue.");
+    }
+    const auto &mask_index = mask_vol_index->rectilinear.value();
+    const auto dose_index = img_arr_ptr->get_volume_index();
+
     {
         asio_thread_pool tp;
         std::mutex printer; // Who gets to print to the console and iterate the counter.
@@ -461,35 +470,28 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data,
                 for(long int col = 0; col < SourceDetectorColumns; ++col){
                     double accumulated_length = 0.0;      //Length of ray travel within the 'surface'.
                     double accumulated_doselength = 0.0;
-                    vec3<double> ray_pos = SourceImg->position(row, col);
+                    const vec3<double> ray_source = SourceImg->position(row, col);
                     const vec3<double> terminus = DetectImg->position(row, col);
-                    const vec3<double> ray_dir = (terminus - ray_pos).unit();
-
-                    ray_pos += ray_dir * cleaved_gap_dist; // Skip the gap which has been cleaved out.
-
-                    //Go until we get within certain distance or overshoot and the ray wants to backtrack.
-                    while(    (ray_dir.Dot( (terminus - ray_pos).unit() ) > 0.8 ) // Ray orientation is still downward-facing.
-                           && (ray_pos.distance(terminus) > std::max(RaydL, SmallestFeature)) ){ // Still far away from detector.
-
-                        ray_pos += ray_dir * RaydL;
-                        const auto midpoint = ray_pos - (ray_dir * RaydL * 0.5);
-
-                        //Check if it was in the surface at the midpoint.
-                        auto rel_img = grid_arr_ptr->imagecoll.get_images_which_encompass_point(midpoint);
-                        if(rel_img.empty()) continue;
-                        const auto mask_val = rel_img.front()->value(midpoint, 0);
-                        const auto is_in_surface = (mask_val == surface_mask_val);
-                        if(is_in_surface){
-                            accumulated_length += RaydL;
-
-                            //Find the dose at the half-way point.
-                            auto encompass_imgs = img_arr_ptr->imagecoll.get_images_which_encompass_point( midpoint );
-                            for(const auto &enc_img : encompass_imgs){
-                                const auto pix_val = enc_img->value(midpoint, 0);
-                                accumulated_doselength += RaydL * pix_val;
-                            }
-                        }
-                    }
+                    const vec3<double> ray_dir = (terminus - ray_source).unit();
+
+                    const auto ray_start = ray_source + ray_dir * cleaved_gap_dist; // Skip the gap which has been cleaved out.
+                    const auto ray_end = terminus - ray_dir * SmallestFeature; // Stop short of the detector.
+
+                    //Visit each mask voxel the ray crosses.
+                    mask_index.traverse(ray_start, ray_end,
+                        [&](long int m_row, long int m_col, long int m_img, double dL, const vec3<double> &midpoint) -> void {
+
+                        //Check if it was in the surface.
+                        const auto mask_val = mask_index.imgs[m_img]->value(m_row, m_col, 0);
+                        if(mask_val != surface_mask_val) return;
+                        accumulated_length += dL;
+
+                        //Find the dose at the half-way point.
+                        dose_index->for_each_image_encompassing(midpoint, [&](planar_image<float,double> *enc_img) -> void {
+                            const auto pix_val = enc_img->value(midpoint, 0);
+                            accumulated_doselength += dL * pix_val;
+                        });
+                    });
 
                     //Deposit the dose in the images.
                     SourceImg->reference(row, col, 0) = static_cast<float>(accumulated_length);
@@ -0,0 +1,381 @@
+//ResampleImages.cc - A part of DICOMautomaton 2021. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>            //Needed for std::pair.
+#include <variant>
+#include <vector>
+
+#include "../Structs.h"
+#include "../Alignment_TPSRPM.h"
+#include "../Regex_Selectors.h"
+#include "../YgorImages_Functors/Compute/Resample_Images.h"
+#include "ResampleImages.h"
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorString.h"       //Needed for GetFirstRegex(...)
+
+
+
+OperationDoc OpArgDocResampleImages(){
+    OperationDoc out;
+    out.name = "ResampleImages";
+    out.desc =
+        "This operation resamples image arrays onto a new voxel grid, which can be the geometry of a reference"
+        " image array or an explicitly specified grid."
+        " The new grid can have any position, orientation, and voxel dimensions."
+        " This operation is meant to prepare image arrays to be compared or operated on in a per-voxel manner, e.g.,"
+        " by resampling a dose array onto a CT image array.";
+
+    out.notes.emplace_back(
+        "No images are overwritten by this operation."
+        " The outgoing images will inherit (interpolated) voxel values and metadata from the selected images and"
+        " image geometry from the reference images or explicit grid."
+    );
+    out.notes.emplace_back(
+        "The selected images must form a rectilinear grid, though slices need not be evenly spaced."
+        " Each selected image array should represent a single volume, so time series should be separated first."
+    );
+    out.notes.emplace_back(
+        "Outgoing voxels that are within half a voxel of the selected image array are treated as if they were on"
+        " the boundary. Voxels further away are assigned the out-of-bounds value."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "ImageSelection";
+    out.args.back().default_val = "last";
+    out.args.back().desc = "The image arrays that will be resampled. "_s
+                         + out.args.back().desc;
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "ReferenceImageSelection";
+    out.args.back().default_val = "none";
+    out.args.back().desc = "The image array whose geometry will be used for the outgoing images."
+                           " If none are selected, an explicit grid is generated using the GridSpacing,"
+                           " GridRowUnit, and GridColumnUnit parameters. The explicit grid encloses the selected"
+                           " images. "_s
+                         + out.args.back().desc;
+
+    out.args.emplace_back();
+    out.args.back().name = "GridSpacing";
+    out.args.back().desc = "The voxel dimensions (in DICOM units, i.e., mm) of the explicit grid."
+                           " Either a single value can be provided, which is used along all directions, or three"
+                           " comma-separated values can be provided, which are used along the row, column,"
+                           " and image-normal directions respectively."
+                           " If 'source', the voxel dimensions of the selected images are used."
+                           " This parameter is ignored if a reference image array is selected.";
+    out.args.back().default_val = "source";
+    out.args.back().expected = true;
+    out.args.back().examples = { "source",
+                                 "1.0",
+                                 "2.0,2.0,2.5" };
+
+    out.args.emplace_back();
+    out.args.back().name = "GridRowUnit";
+    out.args.back().desc = "The direction (a comma-separated 3-vector) along which row numbers increase in the"
+                           " explicit grid."
+                           " If 'source', the orientation of the selected images is used."
+                           " This parameter is ignored if a reference image array is selected.";
+    out.args.back().default_val = "source";
+    out.args.back().expected = true;
+    out.args.back().examples = { "source",
+                                 "0.0,1.0,0.0",
+                                 "0.0,0.7071,0.7071" };
+
+    out.args.emplace_back();
+    out.args.back().name = "GridColumnUnit";
+    out.args.back().desc = "The direction (a comma-separated 3-vector) along which column numbers increase in the"
+                           " explicit grid. It will be orthogonalized against GridRowUnit."
+                           " If 'source', the orientation of the selected images is used."
+                           " This parameter is ignored if a reference image array is selected.";
+    out.args.back().default_val = "source";
+    out.args.back().expected = true;
+    out.args.back().examples = { "source",
+                                 "1.0,0.0,0.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Kernel";
+    out.args.back().desc = "The interpolation kernel to use."
+                           " 'Nearest' copies the value of the nearest voxel, which is appropriate for masks and"
+                           " labels."
+                           " 'Trilinear' linearly interpolates the eight nearest voxels, ignoring non-finite voxels."
+                           " 'Cubic-B-spline' is smoother and more accurate for smooth images, but can overshoot"
+                           " near sharp edges. It reverts to trilinear interpolation near non-finite voxels.";
+    out.args.back().default_val = "trilinear";
+    out.args.back().expected = true;
+    out.args.back().examples = { "nearest",
+                                 "trilinear",
+                                 "cubic-b-spline" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
+    out.args.emplace_back();
+    out.args.back() = T3WhitelistOpArgDoc();
+    out.args.back().name = "TransformSelection";
+    out.args.back().default_val = "none";
+    out.args.back().desc = "An optional transformation that maps outgoing voxel positions to the positions where"
+                           " the selected images are sampled (i.e., the transformation is applied in the"
+                           " 'pull' direction). Affine transformations are applied incrementally, so are"
+                           " inexpensive. Deformable transformations are evaluated for every voxel. "_s
+                         + out.args.back().desc;
+
+    out.args.emplace_back();
+    out.args.back().name = "Channel";
+    out.args.back().desc = "The channel to resample (zero-based)."
+                           " A negative value will result in all channels being resampled, otherwise"
+                           " the outgoing images will contain only the selected channel.";
+    out.args.back().default_val = "-1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "-1",
+                                 "0",
+                                 "1",
+                                 "2" };
+
+    out.args.emplace_back();
+    out.args.back().name = "OutOfBoundsValue";
+    out.args.back().desc = "The value assigned to outgoing voxels that do not overlap the selected images.";
+    out.args.back().default_val = "nan";
+    out.args.back().expected = true;
+    out.args.back().examples = { "nan",
+                                 "0.0",
+                                 "-1000.0" };
+
+    return out;
+}
+
+
+
+Drover ResampleImages(Drover DICOM_data,
+                      const OperationArgPkg& OptArgs,
+                      const std::map<std::string, std::string>& /*InvocationMetadata*/,
+                      const std::string& /*FilenameLex*/){
+
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+    const auto ReferenceImageSelectionStr = OptArgs.getValueStr("ReferenceImageSelection").value();
+
+    const auto GridSpacingStr = OptArgs.getValueStr("GridSpacing").value();
+    const auto GridRowUnitStr = OptArgs.getValueStr("GridRowUnit").value();
+    const auto GridColumnUnitStr = OptArgs.getValueStr("GridColumnUnit").value();
+
+    const auto KernelStr = OptArgs.getValueStr("Kernel").value();
+    const auto TFormSelectionStr = OptArgs.getValueStr("TransformSelection").value();
+
+    const auto Channel = std::stol( OptArgs.getValueStr("Channel").value() );
+    const auto OutOfBoundsValue = std::stof( OptArgs.getValueStr("OutOfBoundsValue").value() );
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_nearest = Compile_Regex("^ne?a?r?e?s?t?$");
+    const auto regex_trilin  = Compile_Regex("^tr?i?l?i?n?e?a?r?$");
+    const auto regex_bspline = Compile_Regex("^cu?b?i?c?[-_]?b?[-_]?s?p?l?i?n?e?$");
+    const auto regex_source  = Compile_Regex("^so?u?r?c?e?$");
+
+    ComputeResampleImagesUserData ud;
+    ud.channel = Channel;
+    ud.out_of_bounds_value = OutOfBoundsValue;
+    if(std::regex_match(KernelStr, regex_nearest)){
+        ud.kernel = ComputeResampleImagesUserData::Kernel::Nearest;
+        ud.description = "Resampled (nearest)";
+    }else if(std::regex_match(KernelStr, regex_trilin)){
+        ud.kernel = ComputeResampleImagesUserData::Kernel::Trilinear;
+        ud.description = "Resampled (trilinear)";
+    }else if(std::regex_match(KernelStr, regex_bspline)){
+        ud.kernel = ComputeResampleImagesUserData::Kernel::CubicBSpline;
+        ud.description = "Resampled (cubic B-spline)";
+    }else{
+        throw std::invalid_argument("Kernel argument '"_s + KernelStr + "' is not valid");
+    }
+
+    // Parses either 'source' or a list of comma-separated numbers.
+    const auto parse_numbers = [&](const std::string &in, size_t N_expected) -> std::optional<std::vector<double>> {
+        if(std::regex_match(in, regex_source)) return std::nullopt;
+        std::vector<double> out;
+        for(const auto &s : SplitStringToVector(in, ',', 'd')) out.push_back( std::stod(s) );
+        if( (N_expected == 3) && (out.size() == 1) ) out.resize(3, out.front());
+        if(out.size() != N_expected){
+            throw std::invalid_argument("Unable to parse '"_s + in + "'. Cannot continue.");
+        }
+        return out;
+    };
+    const auto GridSpacing = parse_numbers(GridSpacingStr, 3);
+    const auto GridRowUnit = parse_numbers(GridRowUnitStr, 3);
+    const auto GridColumnUnit = parse_numbers(GridColumnUnitStr, 3);
+    if(GridSpacing && ( !(0.0 < (*GridSpacing)[0]) || !(0.0 < (*GridSpacing)[1]) || !(0.0 < (*GridSpacing)[2]) )){
+        throw std::invalid_argument("Grid spacing must be positive. Cannot continue.");
+    }
+    if(static_cast<bool>(GridRowUnit) != static_cast<bool>(GridColumnUnit)){
+        throw std::invalid_argument("Both or neither of the grid row and column units must be provided. Cannot continue.");
+    }
+
+    // Transformation.
+    auto T3s_all = All_T3s( DICOM_data );
+    auto T3s = Whitelist( T3s_all, TFormSelectionStr );
+    if(1 < T3s.size()){
+        throw std::invalid_argument("Only a single transformation can be selected. Cannot continue.");
+    }
+    if(!T3s.empty()){
+        std::visit([&](auto && t){
+            using V = std::decay_t<decltype(t)>;
+            if constexpr (std::is_same_v<V, std::monostate>){
+                throw std::invalid_argument("Transformation is invalid. Unable to continue.");
+
+            // Affine transformations.
+            }else if constexpr (std::is_same_v<V, affine_transform<double>>){
+                FUNCINFO("Sampling via affine transformation");
+                ud.affine = t;
+
+            // Thin plate spline transformations.
+            }else if constexpr (std::is_same_v<V, thin_plate_spline>){
+                FUNCINFO("Sampling via thin plate spline transformation");
+                ud.warp = [&t](const vec3<double> &v) -> vec3<double> { return t.transform(v); };
+
+            }else{
+                static_assert(std::is_same_v<V,void>, "Transformation not understood.");
+            }
+            return;
+        }, (*( T3s.front() ))->transform);
+    }
+
+    auto RIAs_all = All_IAs( DICOM_data );
+    auto RIAs = Whitelist( RIAs_all, ReferenceImageSelectionStr );
+    if(1 < RIAs.size()){
+        throw std::invalid_argument("Only one reference image collection can be specified.");
+    }
+
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+    for(auto & iap_it : IAs){
+        if((*iap_it)->imagecoll.images.empty()){
+            FUNCWARN("Skipping empty image array");
+            continue;
+        }
+        const auto common_metadata = (*iap_it)->imagecoll.get_common_metadata({});
+        const auto &src_first = (*iap_it)->imagecoll.images.front();
+        const auto N_chnls = (Channel < 0) ? src_first.channels : 1L;
+
+        // Prepare the outgoing image geometry.
+        planar_image_collection<float,double> edit_imagecoll;
+        if(!RIAs.empty()){
+            edit_imagecoll = (*( RIAs.front() ))->imagecoll;
+            for(auto &img : edit_imagecoll.images){
+                img.init_buffer(img.rows, img.columns, N_chnls);
+            }
+
+        }else{
+            vec3<double> row_unit = src_first.row_unit.unit();
+            vec3<double> col_unit = src_first.col_unit.unit();
+            if(GridRowUnit){
+                row_unit = vec3<double>( (*GridRowUnit)[0], (*GridRowUnit)[1], (*GridRowUnit)[2] ).unit();
+                col_unit = vec3<double>( (*GridColumnUnit)[0], (*GridColumnUnit)[1], (*GridColumnUnit)[2] );
+                col_unit = (col_unit - row_unit * row_unit.Dot(col_unit)).unit();
+            }
+            const auto ortho_unit = row_unit.Cross(col_unit).unit();
+            if( !row_unit.isfinite() || !col_unit.isfinite() || !ortho_unit.isfinite() ){
+                throw std::invalid_argument("Grid orientation is degenerate. Cannot continue.");
+            }
+            const auto dR = GridSpacing ? (*GridSpacing)[0] : src_first.pxl_dx;
+            const auto dC = GridSpacing ? (*GridSpacing)[1] : src_first.pxl_dy;
+            const auto dN = GridSpacing ? (*GridSpacing)[2] : src_first.pxl_dz;
+            if( !(0.0 < dR) || !(0.0 < dC) || !(0.0 < dN) ){
+                throw std::invalid_argument("Grid spacing must be positive. Cannot continue.");
+            }
+
+            // Find the extent of the selected images along the grid axes, using the outer corners of the corner voxels.
+            const auto inf = std::numeric_limits<double>::infinity();
+            std::array<double, 3> lo = {{  inf,  inf,  inf }};
+            std::array<double, 3> hi = {{ -inf, -inf, -inf }};
+            for(const auto &img : (*iap_it)->imagecoll.images){
+                const auto normal = img.row_unit.Cross(img.col_unit).unit();
+                const auto hR = img.row_unit * (img.pxl_dx * 0.5);
+                const auto hC = img.col_unit * (img.pxl_dy * 0.5);
+                const auto hN = normal * (img.pxl_dz * 0.5);
+                for(const auto r : { 0L, img.rows - 1L }){
+                    for(const auto c : { 0L, img.columns - 1L }){
+                        const auto pos = img.position(r, c);
+                        for(const auto sR : { -1.0, 1.0 }){
+                            for(const auto sC : { -1.0, 1.0 }){
+                                for(const auto sN : { -1.0, 1.0 }){
+                                    const auto P = pos + hR * sR + hC * sC + hN * sN;
+                                    const std::array<double, 3> proj = {{ row_unit.Dot(P), col_unit.Dot(P), ortho_unit.Dot(P) }};
+                                    for(size_t a = 0; a < 3; ++a){
+                                        lo[a] = std::min(lo[a], proj[a]);
+                                        hi[a] = std::max(hi[a], proj[a]);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Note: a small tolerance avoids adding a sliver of voxels due to round-off.
+            const std::array<double, 3> d = {{ dR, dC, dN }};
+            std::array<long int, 3> N;
+            for(size_t a = 0; a < 3; ++a){
+                N[a] = std::max(1L, static_cast<long int>(std::ceil((hi[a] - lo[a]) / d[a] - 1E-6)));
+            }
+            FUNCINFO("Generating a grid with " << N[0] << " rows, " << N[1] << " columns, and " << N[2] << " images");
+
+            for(long int k = 0; k < N[2]; ++k){
+                edit_imagecoll.images.emplace_back();
+                auto &img = edit_imagecoll.images.back();
+                const auto offset = row_unit * (lo[0] + 0.5 * dR)
+                                  + col_unit * (lo[1] + 0.5 * dC)
+                                  + ortho_unit * (lo[2] + (0.5 + static_cast<double>(k)) * dN);
+                img.init_orientation(row_unit, col_unit);
+                img.init_buffer(N[0], N[1], N_chnls);
+                img.init_spatial(dR, dC, dN, vec3<double>(0.0, 0.0, 0.0), offset);
+            }
+        }
+
+        // Carry over the common metadata, but describe the outgoing geometry rather than the source geometry.
+        for(auto &img : edit_imagecoll.images){
+            img.metadata = common_metadata;
+            img.metadata.erase("SpacingBetweenSlices");
+            img.metadata.erase("SliceLocation");
+
+            const auto pos = img.position(0, 0);
+            img.metadata["Rows"] = std::to_string(img.rows);
+            img.metadata["Columns"] = std::to_string(img.columns);
+            img.metadata["SliceThickness"] = std::to_string(img.pxl_dz);
+            img.metadata["ImagePositionPatient"] = std::to_string(pos.x) + "\\"
+                                                 + std::to_string(pos.y) + "\\"
+                                                 + std::to_string(pos.z);
+            img.metadata["ImageOrientationPatient"] = std::to_string(img.row_unit.x) + "\\"
+                                                    + std::to_string(img.row_unit.y) + "\\"
+                                                    + std::to_string(img.row_unit.z) + "\\"
+                                                    + std::to_string(img.col_unit.x) + "\\"
+                                                    + std::to_string(img.col_unit.y) + "\\"
+                                                    + std::to_string(img.col_unit.z);
+            img.metadata["PixelSpacing"] = std::to_string(img.pxl_dx) + "\\" + std::to_string(img.pxl_dy);
+        }
+
+        std::list<std::reference_wrapper<planar_image_collection<float, double>>> IARL = { std::ref( (*iap_it)->imagecoll ) };
+        if(!edit_imagecoll.Compute_Images( ComputeResampleImages,
+                                           IARL, {}, &ud )){
+            throw std::runtime_error("Unable to resample images.");
+        }
+
+        DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>() );
+        DICOM_data.image_data.back()->imagecoll.images.splice(
+            DICOM_data.image_data.back()->imagecoll.images.end(),
+            edit_imagecoll.images );
+    }
+
+    return DICOM_data;
+}
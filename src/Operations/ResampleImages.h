@@ -0,0 +1,16 @@
+// ResampleImages.h.
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "../Structs.h"
+
+
+OperationDoc OpArgDocResampleImages();
+
+Drover ResampleImages(Drover DICOM_data,
+                      const OperationArgPkg& /*OptArgs*/,
+                      const std::map<std::string, std::string>& /*InvocationMetadata*/,
+                      const std::string& /*FilenameLex*/);
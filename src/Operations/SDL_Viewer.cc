@@ -148,6 +148,10 @@ Drover SDL_Viewer(Drover DICOM_data,
     };
     size_t colour_map = 0;
 
+    // Colour maps are tabulated when first used so that textures can be colourized without evaluating the colour map
+    // for every pixel.
+    std::map<size_t, colour_map_lut> colour_map_luts;
+
     const auto nan_colour = std::array<std::byte, 3>{ std::byte{60}, std::byte{0}, std::byte{0} }; // 8-bit colour.
 
     //Toggle whether existing contours should be displayed.
@@ -278,6 +282,7 @@ Drover SDL_Viewer(Drover DICOM_data,
                                       &custom_width,
                                       &colour_maps,
                                       &colour_map,
+                                      &colour_map_luts,
                                       &nan_colour]( const planar_image<float,double>& img ) -> opengl_texture_handle_t {
             const auto img_cols = img.columns;
             const auto img_rows = img.rows;
@@ -286,8 +291,16 @@ Drover SDL_Viewer(Drover DICOM_data,
                 FUNCERR("Image dimensions are not reasonable. Is this a mistake? Refusing to continue");
             }
 
-            std::vector<std::byte> animage;
-            animage.reserve(img_cols * img_rows * 3);
+            auto lut_it = colour_map_luts.find(colour_map);
+            if(lut_it == std::end(colour_map_luts)){
+                lut_it = colour_map_luts.emplace(colour_map, colour_map_lut(colour_maps[colour_map].second)).first;
+            }
+            const std::array<uint8_t, 4> nan_rgba{ std::to_integer<uint8_t>(nan_colour[0]),
+                                                   std::to_integer<uint8_t>(nan_colour[1]),
+                                                   std::to_integer<uint8_t>(nan_colour[2]),
+                                                   255 };
+
+            std::vector<uint8_t> animage(img_cols * img_rows * 3);
 
             //------------------------------------------------------------------------------------------------
             //Apply a window to the data if it seems like the WindowCenter or WindowWidth specified in the image metadata
@@ -306,58 +319,16 @@ Drover SDL_Viewer(Drover DICOM_data,
                                                 : (  img_win_valid && img_desc && img_win_c 
                                                   && img_win_fw && (img_win_valid.value() == img_desc.value()));
 
+            double win_low;
+            double win_high;
             if( UseCustomWL || UseImgWL ){
-                //Window/linear scaling transformation parameters.
-                //const auto win_r = 0.5*(win_fw.value() - 1.0); //The 'radius' of the range, or half width omitting the centre point.
-
                 //The 'radius' of the range, or half width omitting the centre point.
                 const auto win_r  = (UseCustomWL) ? 0.5*custom_win_fw.value()
                                                   : 0.5*img_win_fw.value();
                 const auto win_c  = (UseCustomWL) ? custom_win_c.value()
                                                   : img_win_c.value();
-                const auto win_fw = (UseCustomWL) ? custom_win_fw.value()
-                                                  : img_win_fw.value();
-
-                //The output range we are targeting. In this case, a commodity 8 bit (2^8 = 256 intensities) display.
-                const auto destmin = static_cast<double>( 0 );
-                const auto destmax = static_cast<double>( std::numeric_limits<uint8_t>::max() );
-
-                for(auto j = 0; j < img_rows; ++j){
-                    for(auto i = 0; i < img_cols; ++i){
-                        const auto val = static_cast<double>( img.value(j,i,0) ); //The first (R or gray) channel.
-                        if(!std::isfinite(val)){
-                            animage.push_back( nan_colour[0] );
-                            animage.push_back( nan_colour[1] );
-                            animage.push_back( nan_colour[2] );
-                        }else{
-                            double x; // range = [0,1].
-                            if(val <= (win_c - win_r)){
-                                x = 0.0;
-                            }else if(val >= (win_c + win_r)){
-                                x = 1.0;
-                            }else{
-                                x = (val - (win_c - win_r)) / win_fw;
-                            }
-
-                            const auto res = colour_maps[colour_map].second(x);
-                            const double x_R = res.R;
-                            const double x_G = res.G;
-                            const double x_B = res.B;
-
-                            const double out_R = x_R * (destmax - destmin) + destmin;
-                            const double out_B = x_B * (destmax - destmin) + destmin;
-                            const double out_G = x_G * (destmax - destmin) + destmin;
-
-                            const auto scaled_R = static_cast<uint8_t>( std::floor(out_R) );
-                            const auto scaled_G = static_cast<uint8_t>( std::floor(out_G) );
-                            const auto scaled_B = static_cast<uint8_t>( std::floor(out_B) );
-
-                            animage.push_back( std::byte{scaled_R} );
-                            animage.push_back( std::byte{scaled_G} );
-                            animage.push_back( std::byte{scaled_B} );
-                        }
-                    }
-                }
+                win_low  = win_c - win_r;
+                win_high = win_c + win_r;
 
             //------------------------------------------------------------------------------------------------
             //Scale pixels to fill the maximum range. None will be clipped or truncated.
@@ -366,57 +337,19 @@ Drover SDL_Viewer(Drover DICOM_data,
                 // If you don't want to window you need to anticipate and ignore the gigantic numbers being 
                 // you might encounter. This is not the place to do this! If you need to do it here, write a
                 // filter routine and *call* it from here.
-                //
-                // NOTE: This routine could definitely use a re-working, especially to make it safe for all
-                //       arithmetical types (i.e., handling negatives, ensuring there is no overflow or wrap-
-                //       around, ensuring there is minimal precision loss).
-                using pixel_value_t = decltype(img.value(0, 0, 0));
                 const auto pixel_minmax_allchnls = img.minmax();
-                const auto lowest = std::get<0>(pixel_minmax_allchnls);
-                const auto highest = std::get<1>(pixel_minmax_allchnls);
-
-                //const auto lowest = Stats::Percentile(img.data, 0.01);
-                //const auto highest = Stats::Percentile(img.data, 0.99);
-
-                const auto pixel_type_max = static_cast<double>(std::numeric_limits<pixel_value_t>::max());
-                const auto pixel_type_min = static_cast<double>(std::numeric_limits<pixel_value_t>::min());
-                const auto dest_type_max = static_cast<double>(std::numeric_limits<uint8_t>::max()); //Min is implicitly 0.
-
-                const double clamped_low  = static_cast<double>(lowest )/pixel_type_max;
-                const double clamped_high = static_cast<double>(highest)/pixel_type_max;
-
-                for(auto j = 0; j < img_rows; ++j){ 
-                    for(auto i = 0; i < img_cols; ++i){ 
-                        const auto val = img.value(j,i,0);
-                        if(!std::isfinite(val)){
-                            animage.push_back( nan_colour[0] );
-                            animage.push_back( nan_colour[1] );
-                            animage.push_back( nan_colour[2] );
-                        }else{
-                            const double clamped_value = (static_cast<double>(val) - pixel_type_min)/(pixel_type_max - pixel_type_min);
-                            auto rescaled_value = (clamped_value - clamped_low)/(clamped_high - clamped_low);
-                            if( rescaled_value < 0.0 ){
-                                rescaled_value = 0.0;
-                            }else if( rescaled_value > 1.0 ){
-                                rescaled_value = 1.0;
-                            }
-
-                            const auto res = colour_maps[colour_map].second(rescaled_value);
-                            const double x_R = res.R;
-                            const double x_G = res.G;
-                            const double x_B = res.B;
-                            
-                            const auto scaled_R = static_cast<uint8_t>(x_R * dest_type_max);
-                            const auto scaled_G = static_cast<uint8_t>(x_G * dest_type_max);
-                            const auto scaled_B = static_cast<uint8_t>(x_B * dest_type_max);
-
-                            animage.push_back( std::byte{scaled_R} );
-                            animage.push_back( std::byte{scaled_G} );
-                            animage.push_back( std::byte{scaled_B} );
-                        }
-                    }
-                }
+                win_low  = static_cast<double>(std::get<0>(pixel_minmax_allchnls));
+                win_high = static_cast<double>(std::get<1>(pixel_minmax_allchnls));
             }
+
+            // Colourize the first (R or gray) channel.
+            Colourize_Values( img.data.data(),
+                              static_cast<size_t>(img_rows * img_cols),
+                              static_cast<size_t>(img.channels),
+                              win_low, win_high,
+                              lut_it->second,
+                              nan_rgba,
+                              animage.data(), 3 );
         
 
             opengl_texture_handle_t out;
@@ -58,10 +58,27 @@ Drover SelectSlicesIntersectingROI(Drover DICOM_data,
                                         { "NormalizedROIName", NormalizedROILabelRegex } } );
 
 
+    //Use the per-ROI index to skip ROIs that lie entirely above or below an image, since none of their contours can be
+    // encompassed by the image. The index is cached, so it is usually already available from loading.
+    std::shared_ptr<const contour_roi_index> roi_index;
+    if(DICOM_data.contour_data != nullptr) roi_index = DICOM_data.contour_data->get_roi_index();
+
     //Generate a closure that discards images not encompassing any ROI contours.
-    const auto retain_encompassing_imgs = [&cc_ROIs](const planar_image<float, double> &animg) -> bool {
+    const auto retain_encompassing_imgs = [&cc_ROIs,&roi_index](const planar_image<float, double> &animg) -> bool {
+                const auto ortho_unit = animg.row_unit.Cross(animg.col_unit).unit();
+                const auto img_offset = animg.position(0, 0).Dot(ortho_unit);
+                const auto img_halfwidth = animg.pxl_dz * 0.5 * (1.0 + 1E-3); // Slightly inflated for round-off.
+
                 //Retain the image IFF it intersects one of the contours.
                 for(const auto &cc_ref : cc_ROIs){
+                    const auto *roi = (roi_index == nullptr) ? nullptr : roi_index->get( &(cc_ref.get()) );
+                    if(roi != nullptr){
+                        if(roi->N_vertices == 0) continue;
+                        const auto extent = roi->extent_along(ortho_unit);
+                        if( (extent.second < (img_offset - img_halfwidth))
+                        ||  ((img_offset + img_halfwidth) < extent.first) ) continue;
+                    }
+
                     for(const auto &acontour : cc_ref.get().contours){
                         if(animg.encompasses_contour_of_points(acontour)) return true;
                     }
@@ -46,6 +46,7 @@
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "../Dose_Meld.h"
+#include "../Rectilinear_Volume.h"
 
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 
@@ -64,8 +65,8 @@ OperationDoc OpArgDocSimulateRadiograph(){
         " rays.";
 
     out.notes.emplace_back(
-        "Images must be regular."
-        // Note: while this operation could be implemented without requiring regularity, it is much faster to
+        "Images must form a rectilinear grid, but slice thickness may vary."
+        // Note: while this operation could be implemented without requiring rectilinearity, it is much faster to
         // require it. If this functionality is required then modify this operation.
     );
     out.notes.emplace_back(
@@ -258,38 +259,13 @@ Drover SimulateRadiograph(Drover DICOM_data,
     }
 
 
-    // Ensure the image array is regular. (This will allow us to use a faster postion-to-image lookup.)
-    {
-        std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
-        for(auto &img : img_arr_ptr->imagecoll.images){
-            selected_imgs.push_back( std::ref(img) );
-        }
-
-        if(!Images_Form_Regular_Grid(selected_imgs)){
-            throw std::invalid_argument("Images do not form a rectilinear grid. Cannot continue");
-        }
-    }
-
-    const auto row_unit = img_arr_ptr->imagecoll.images.front().row_unit.unit();
-    const auto col_unit = img_arr_ptr->imagecoll.images.front().col_unit.unit();
-    const auto img_unit = col_unit.Cross(row_unit).unit();
-
-    planar_image_adjacency<float,double> img_adj( {}, { { std::ref(img_arr_ptr->imagecoll) } }, img_unit );
-    if(img_adj.int_to_img.empty()){
-        throw std::logic_error("Image array contained no images. Cannot continue.");
+    // Index the image volume so rays can be traversed voxel-by-voxel without searching for images.
+    const auto img_vol_index = img_arr_ptr->get_volume_index();
+    if(!img_vol_index->rectilinear){
+        throw std::invalid_argument("Images do not form a rectilinear grid. Cannot continue");
     }
-
-    const auto pxl_dx = img_arr_ptr->imagecoll.images.front().pxl_dx;
-    const auto pxl_dy = img_arr_ptr->imagecoll.images.front().pxl_dy;
-    const auto pxl_dz = img_arr_ptr->imagecoll.images.front().pxl_dz;
-    const auto pxl_diagonal_sq_length = (pxl_dx*pxl_dx + pxl_dy*pxl_dy + pxl_dz*pxl_dz);
-
-    const auto grid_zero = img_adj.index_to_image(0).get().position(0,0); // Centre of the (0,0,0) voxel.
-    const auto img_bps = img_adj.bounding_volume_planes;
-
-    const auto N_rows = static_cast<long int>(img_arr_ptr->imagecoll.images.front().rows);
-    const auto N_cols = static_cast<long int>(img_arr_ptr->imagecoll.images.front().columns);
-    const auto N_imgs = static_cast<long int>(img_adj.int_to_img.size());
+    const auto &vol_index = img_vol_index->rectilinear.value();
+    const auto img_unit = vol_index.img_unit;
 
     // Determine an appropriate radiograph orientation.
     const auto img_centre = img_arr_ptr->imagecoll.center(); // TODO: For TBI, should be at the t0 point (i.e., at the level of the lung).
@@ -323,27 +299,6 @@ Drover SimulateRadiograph(Drover DICOM_data,
     FUNCINFO("Proceeding with image centre at: " << img_centre);
     FUNCINFO("Proceeding with ray source - image centre line: " << source_centre_line);
 
-    // Confirm the bounding planes are all correctly oriented.
-    for(const auto & img_bp : img_bps){
-        if(!img_bp.Is_Point_Above_Plane(img_centre)){
-            throw std::logic_error("Bounding planes are not inward oriented. Refusing to continue.");
-            // Note: could just re-orient them here...
-        }
-    }
-    if(img_bps.size() != 6){
-        throw std::logic_error("Incorrect number of bounding planes provided. Cannot continue.");
-    }
-
-    // Pre-compute whether the ray source position is bounded within the image volume.
-    bool ray_source_is_within_image_volume = false;
-    {
-        long int N_bounds = 0;
-        for(const auto & img_bp : img_bps){
-            N_bounds += (img_bp.Is_Point_Above_Plane(ray_source)) ? 1L : 0L;
-        }
-        ray_source_is_within_image_volume = (N_bounds == 6);
-    }
-
     // Encode the image geometry as contours for volumetric bounds determination.
     contour_collection<double> cc;
     for(const auto &animg : img_arr_ptr->imagecoll.images){
@@ -397,9 +352,6 @@ Drover SimulateRadiograph(Drover DICOM_data,
     DetectImg->metadata["Description"] = "Virtual radiograph detector";
     OrthoSrcImg->metadata["Description"] = "(unused)";
 
-    const auto detector_plane = DetectImg->image_plane();
-    const auto orthosrc_plane = OrthoSrcImg->image_plane();
-
     //------------------------
     // March rays through the image data.
     {
@@ -413,164 +365,31 @@ Drover SimulateRadiograph(Drover DICOM_data,
 
                     // Construct a line segment between the source and detector. 
                     const auto ray_terminus = DetectImg->position(RadiographRow, RadiographCol);
-                    const auto ray_line = line<double>(ray_source, ray_terminus);
-
-                    // Find the intersection of the ray with the detector bounding planes.
-                    vec3<double> detector_panel_bp_intersection;
-                    if(!detector_plane.Intersects_With_Line_Once(ray_line, detector_panel_bp_intersection)){
-                        throw std::logic_error("Ray line does not intersect far image array bounding plane. Cannot continue.");
-                    }
-                    const auto ray_ls = line_segment<double>(ray_source, detector_panel_bp_intersection);
-
-                    // Find the intersections of the ray and the bounding box containing the images.
-                    std::vector<vec3<double>> bp_intersections;
-                    for(const auto & img_bp : img_bps){
-                        vec3<double> P;
-                        //if(img_bp.Intersects_With_Line_Once(ray_line, P)){
-                        if(img_bp.Intersects_With_Line_Segment_Once(ray_ls, P)){
-
-                            // Determine if the intersection point is on a face of the cube.
-                            const auto bp_centre = img_bp.Project_Onto_Plane_Orthogonally(img_centre);
-                            const auto dP = (P - bp_centre);
-                            const auto dP_row = std::abs(dP.Dot(row_unit));
-                            const auto dP_col = std::abs(dP.Dot(col_unit));
-                            const auto dP_img = std::abs(dP.Dot(img_unit));
-
-                            const auto max_row = (static_cast<double>(N_rows) * pxl_dx * 0.5);
-                            const auto max_col = (static_cast<double>(N_cols) * pxl_dy * 0.5);
-                            const auto max_img = (static_cast<double>(N_imgs) * pxl_dz * 0.5);
-
-                            if( (dP_row <= max_row)
-                            &&  (dP_col <= max_col)
-                            &&  (dP_img <= max_img) ){
-                                bp_intersections.emplace_back(P);
-                            }
-                        }
-                    }
-
-                    // Explicitly add the ray source point if it is bounded within the image volume.
-                    if(ray_source_is_within_image_volume){
-                        bp_intersections.emplace_back(ray_source);
-                    }
-
-                    // Skip rays that do not intersect the image volume twice.
-                    if(bp_intersections.size() != 2){
-                        continue;
-                    }
-
-                    // Explicitly state the ray start and end positions using identified bounding-box intersection points.
-                    const vec3<double> ray_start = bp_intersections[0];
-                    const vec3<double> ray_end = bp_intersections[1];
-                    const auto ray_direction = (ray_end - ray_start).unit();
-                    const auto ray_total_sq_dist = ray_end.sq_dist(ray_start);
-
-                    // Determine whether moving from tail to head along the ray will increase or decrease the
-                    // row/col/img coordinates. Note that the direction will never change.
-                    const long int incr_row = (row_unit.Dot(ray_direction) < 0.0) ? -1L : 1L;
-                    const long int incr_col = (col_unit.Dot(ray_direction) < 0.0) ? -1L : 1L;
-                    const long int incr_img = (img_unit.Dot(ray_direction) < 0.0) ? -1L : 1L;
-
-                    // Determine the amount the ray will traverse due to incrementing i, j, or k individually.
-                    const auto true_ray_pos_dR_incr_row = ray_direction * (std::abs(row_unit.Dot(ray_direction)) * pxl_dx);
-                    const auto true_ray_pos_dR_incr_col = ray_direction * (std::abs(col_unit.Dot(ray_direction)) * pxl_dy);
-                    const auto true_ray_pos_dR_incr_img = ray_direction * (std::abs(img_unit.Dot(ray_direction)) * pxl_dz);
-
-                    const auto true_ray_pos_dR_incr_row_length = true_ray_pos_dR_incr_row.length();
-                    const auto true_ray_pos_dR_incr_col_length = true_ray_pos_dR_incr_col.length();
-                    const auto true_ray_pos_dR_incr_img_length = true_ray_pos_dR_incr_img.length();
-
-                    const auto blocky_ray_pos_dR_incr_row = row_unit * (pxl_dx * static_cast<double>(incr_row));
-                    const auto blocky_ray_pos_dR_incr_col = col_unit * (pxl_dy * static_cast<double>(incr_col));
-                    const auto blocky_ray_pos_dR_incr_img = img_unit * (pxl_dz * static_cast<double>(incr_img));
-
-                    // Determine the pseudo integer coordinates for the starting point.
-                    //
-                    // Note that these coordinates will not necessarily intersect any real voxels. They are defined only
-                    // by the (infinite) regular grid that coincides with the real voxels.
-                    const auto ray_start_grid_offset = ray_start - grid_zero;
-                    const auto ray_start_row_index = static_cast<long int>( std::round( ray_start_grid_offset.Dot(row_unit)/pxl_dx ) );
-                    const auto ray_start_col_index = static_cast<long int>( std::round( ray_start_grid_offset.Dot(col_unit)/pxl_dy ) );
-                    const auto ray_start_img_index = static_cast<long int>( std::round( ray_start_grid_offset.Dot(img_unit)/pxl_dz ) );
-
-                    long int ray_i = ray_start_row_index;
-                    long int ray_j = ray_start_col_index;
-                    long int ray_k = ray_start_img_index;
-
-                    vec3<double> true_ray_pos = ray_start;
-                    vec3<double> blocky_ray_pos = grid_zero + row_unit * (static_cast<double>(ray_i) * pxl_dx)
-                                                            + col_unit * (static_cast<double>(ray_j) * pxl_dy)
-                                                            + img_unit * (static_cast<double>(ray_k) * pxl_dz);
-
-                    const auto ray_start_side_of_terminus_plane = detector_plane.Is_Point_Above_Plane(ray_start);
-
-                    // Each time the ray samples the CT number, the ray is simulated to have interacted with the medium
-                    // for the length of the ray advancement.
+
+                    // Each time the ray crosses a voxel, the ray is simulated to have interacted with the medium
+                    // for the length of the ray within the voxel.
                     //
                     // For purposes of simulating a radiograph, the remaining fractional ray intensity could be
                     // immediately reduced by multiplying by a factor of exp(-attenuation_coeff*dL). However, it is
                     // easier to sum all the attenuation_coeff*dL contributions and apply the reduction factor once at
                     // the end.
                     double accumulated_attenuation_length_product = 0.0;
-                    double last_move_dist = 0.0;
-
-                    while(true){
-                        // Test which single increment (either i, j, or k) remaing the closest to the ray line.
-                        const auto cand_pos_i = blocky_ray_pos + blocky_ray_pos_dR_incr_row;
-                        const auto cand_pos_j = blocky_ray_pos + blocky_ray_pos_dR_incr_col;
-                        const auto cand_pos_k = blocky_ray_pos + blocky_ray_pos_dR_incr_img;
-
-                        const auto cand_sq_dist_i = ray_line.Sq_Distance_To_Point( cand_pos_i );
-                        const auto cand_sq_dist_j = ray_line.Sq_Distance_To_Point( cand_pos_j );
-                        const auto cand_sq_dist_k = ray_line.Sq_Distance_To_Point( cand_pos_k );
-
-                        if( (cand_sq_dist_i <= cand_sq_dist_j) && (cand_sq_dist_i <= cand_sq_dist_k) ){
-                            blocky_ray_pos = cand_pos_i;
-                            true_ray_pos += true_ray_pos_dR_incr_row;
-                            last_move_dist = true_ray_pos_dR_incr_row_length;
-                            ray_i += incr_row;
-                        }else if( cand_sq_dist_j <= cand_sq_dist_k ){
-                            blocky_ray_pos = cand_pos_j;
-                            true_ray_pos += true_ray_pos_dR_incr_col;
-                            last_move_dist = true_ray_pos_dR_incr_col_length;
-                            ray_j += incr_col;
-                        }else{
-                            blocky_ray_pos = cand_pos_k;
-                            true_ray_pos += true_ray_pos_dR_incr_img;
-                            last_move_dist = true_ray_pos_dR_incr_img_length;
-                            ray_k += incr_img;
-                        }
-
-                        // Terminate if the geometry is invalid.
-                        if( pxl_diagonal_sq_length < true_ray_pos.sq_dist(blocky_ray_pos) ){
-                            throw std::runtime_error("Real ray position and blocky ray position differ by more than a voxel diagonal");
-                        }
-
-                        // Process the voxel.
-                        if( ( 0 <= ray_i ) && (ray_i < N_rows)
-                        &&  ( 0 <= ray_j ) && (ray_j < N_cols)
-                        &&  ( 0 <= ray_k ) && (ray_k < N_imgs) ){
-                            const auto intersecting_img_refw = img_adj.index_to_image(ray_k);
-                            const auto voxel_val = intersecting_img_refw.get().value(ray_i, ray_j, Channel);
-
-                            // Ficticious mass density encountered by the ray.
-                            const auto intensity = (voxel_val < -1000.0f) ? -1000.0f : voxel_val; // Enforce physicality.
-                            const auto attenuation_coeff = 1.0f + (intensity / 1000.0f); 
-
-                            accumulated_attenuation_length_product += attenuation_coeff * last_move_dist;
-                            
-                            // Could alternately invoke a more generic user function using (i,j,k) and the various ray
-                            // positions/distances here.
 
-                            //  ... TODO ...
+                    vol_index.traverse(ray_source, ray_terminus,
+                        [&](long int ray_i, long int ray_j, long int ray_k, double dL, const vec3<double> &) -> void {
+                        const auto voxel_val = vol_index.imgs[ray_k]->value(ray_i, ray_j, Channel);
+
+                        // Ficticious mass density encountered by the ray.
+                        const auto intensity = (voxel_val < -1000.0f) ? -1000.0f : voxel_val; // Enforce physicality.
+                        const auto attenuation_coeff = 1.0f + (intensity / 1000.0f); 
 
-                        }
+                        accumulated_attenuation_length_product += attenuation_coeff * dL;
+                            
+                        // Could alternately invoke a more generic user function using (i,j,k) and the various ray
+                        // positions/distances here.
 
-                        // Terminate if the ray has traveled far enough.
-                        const auto ray_traveled_sq_dist = ray_start.sq_dist(true_ray_pos);
-                        if(ray_total_sq_dist <= ray_traveled_sq_dist){
-                            break;
-                        }
-                    }
+                        //  ... TODO ...
+                    });
 
                     //Record the result in the image.
                     DetectImg->reference(RadiographRow, RadiographCol, 0) = static_cast<float>(accumulated_attenuation_length_product);
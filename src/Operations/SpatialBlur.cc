@@ -52,9 +52,10 @@ OperationDoc OpArgDocSpatialBlur(){
     out.args.emplace_back();
     out.args.back().name = "GaussianOpenSigma";
     out.args.back().desc = "Controls the number of neighbours to consider (only) when using the gaussian_open estimator."
-                      " The number of pixels is computed automatically to accommodate the specified sigma"
-                      " (currently ignored pixels have 3*sigma or less weighting). Be aware this operation can take"
-                      " an enormous amount of time, since the pixel neighbourhoods quickly grow large.";
+                      " The blur is implemented with a recursive filter, so the computational cost does not depend"
+                      " on sigma. Pixels beyond the image boundary and non-finite pixels are treated as missing,"
+                      " and the blur is renormalized using the remaining pixels."
+                      " Sigma is specified in the units given by the GaussianOpenSigmaUnits parameter.";
     out.args.back().default_val = "1.5";
     out.args.back().expected = true;
     out.args.back().examples = { "0.5",
@@ -63,6 +64,18 @@ OperationDoc OpArgDocSpatialBlur(){
                             "2.5",
                             "5.0" };
 
+    out.args.emplace_back();
+    out.args.back().name = "GaussianOpenSigmaUnits";
+    out.args.back().desc = "Controls how GaussianOpenSigma is interpreted."
+                      " If 'pixel', sigma is a number of pixels (along both rows and columns)."
+                      " If 'dicom', sigma is in DICOM units (i.e., mm) and is converted to a number of pixels"
+                      " separately along rows and columns, so non-square pixels are blurred isotropically.";
+    out.args.back().default_val = "pixel";
+    out.args.back().expected = true;
+    out.args.back().examples = { "pixel",
+                                 "dicom" };
+    out.args.back().samples = OpArgSamples::Exhaustive;
+
     return out;
 }
 
@@ -75,6 +88,7 @@ Drover SpatialBlur(Drover DICOM_data,
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
     const auto EstimatorStr = OptArgs.getValueStr("Estimator").value();
     const auto GaussianOpenSigma = std::stod( OptArgs.getValueStr("GaussianOpenSigma").value() );
+    const auto GaussianOpenSigmaUnitsStr = OptArgs.getValueStr("GaussianOpenSigmaUnits").value();
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_box3x3 = Compile_Regex("^bo?x?_?3x?3?$");
@@ -83,12 +97,25 @@ Drover SpatialBlur(Drover DICOM_data,
     const auto regex_gau5x5 = Compile_Regex("^ga?u?s?s?i?a?n?_?5x?5?$");
     const auto regex_gauopn = Compile_Regex("^ga?u?s?s?i?a?n?_?op?e?n?$");
 
+    const auto regex_pixel = Compile_Regex("^pi?x?e?l?s?$");
+    const auto regex_dicom = Compile_Regex("^di?c?o?m?$");
+
+    bool sigma_in_dicom_units = false;
+    if( std::regex_match(GaussianOpenSigmaUnitsStr, regex_pixel) ){
+        sigma_in_dicom_units = false;
+    }else if( std::regex_match(GaussianOpenSigmaUnitsStr, regex_dicom) ){
+        sigma_in_dicom_units = true;
+    }else{
+        throw std::invalid_argument("GaussianOpenSigmaUnits argument '"_s + GaussianOpenSigmaUnitsStr + "' is not valid");
+    }
+
 
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
     for(auto & iap_it : IAs){
         InPlaneImageBlurUserData ud;
         ud.gaussian_sigma = GaussianOpenSigma;
+        ud.gaussian_sigma_in_dicom_units = sigma_in_dicom_units;
 
         if( std::regex_match(EstimatorStr, regex_box3x3) ){
             ud.estimator = BlurEstimator::box_3x3;
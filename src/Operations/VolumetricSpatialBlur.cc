@@ -1,6 +1,7 @@
 //VolumetricSpatialBlur.cc - A part of DICOMautomaton 2019. Written by hal clark.
 
 #include <any>
+#include <array>
 #include <optional>
 #include <functional>
 #include <iterator>
@@ -69,12 +70,31 @@ OperationDoc OpArgDocVolumetricSpatialBlur(){
                            " Gaussian blur that extends for 3*sigma thus providing a 7x7x7 window."
                            " Note that applying this kernel N times will approximate a Gaussian with sigma=N."
                            " Also note that boundary voxels will cause accessible voxels within the same window to be more"
-                           " heavily weighted. Try avoid boundaries or add extra margins if possible.";
+                           " heavily weighted. Try avoid boundaries or add extra margins if possible."
+                           " 'Gaussian_Open' refers to a Gaussian blur with an arbitrary sigma (in DICOM units)"
+                           " controlled by the GaussianOpenSigma parameter. It is implemented with a recursive filter,"
+                           " so the computational cost does not depend on sigma. Boundary voxels are handled in the"
+                           " same way as for the fixed Gaussian.";
     out.args.back().default_val = "Gaussian";
     out.args.back().expected = true;
-    out.args.back().examples = { "Gaussian" };
+    out.args.back().examples = { "Gaussian", "Gaussian_Open" };
     out.args.back().samples = OpArgSamples::Exhaustive;
 
+
+    out.args.emplace_back();
+    out.args.back().name = "GaussianOpenSigma";
+    out.args.back().desc = "The sigma (in DICOM units, i.e., mm) used by the Gaussian_Open estimator."
+                           " Either a single value can be provided, which is used along all directions, or three"
+                           " comma-separated values can be provided, which are used along the row, column,"
+                           " and image-normal directions respectively. A sigma of zero disables blurring along that"
+                           " direction. Voxel dimensions are taken into account, so anisotropic voxels are supported.";
+    out.args.back().default_val = "1.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1.0",
+                                 "5.0",
+                                 "2.5,2.5,5.0",
+                                 "10.0,10.0,0.0" };
+
     return out;
 }
 
@@ -94,8 +114,23 @@ Drover VolumetricSpatialBlur(Drover DICOM_data,
 
     const auto EstimatorStr = OptArgs.getValueStr("Estimator").value();
 
+    const auto GaussianOpenSigmaStr = OptArgs.getValueStr("GaussianOpenSigma").value();
+
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_gauss = Compile_Regex("^ga?u?s?s?i?a?n?$");
+    const auto regex_gauopn = Compile_Regex("^ga?u?s?s?i?a?n?_?op?e?n?$");
+
+    std::array<double, 3> GaussianOpenSigma;
+    {
+        const auto sigma_strs = SplitStringToVector(GaussianOpenSigmaStr, ',', 'd');
+        if(sigma_strs.size() == 1){
+            GaussianOpenSigma.fill( std::stod(sigma_strs.front()) );
+        }else if(sigma_strs.size() == 3){
+            for(size_t a = 0; a < 3; ++a) GaussianOpenSigma[a] = std::stod(sigma_strs[a]);
+        }else{
+            throw std::invalid_argument("GaussianOpenSigma should contain either one or three values. Cannot continue.");
+        }
+    }
 
     auto cc_all = All_CCs( DICOM_data );
     auto cc_ROIs = Whitelist( cc_all, { { "ROIName", ROILabelRegex },
@@ -111,8 +146,11 @@ Drover VolumetricSpatialBlur(Drover DICOM_data,
         // Planar derivatives.
         ComputeVolumetricSpatialBlurUserData ud;
         ud.channel = Channel;
+        ud.gaussian_sigma = GaussianOpenSigma;
         if(std::regex_match(EstimatorStr, regex_gauss)){
             ud.estimator = VolumetricSpatialBlurEstimator::Gaussian;
+        }else if(std::regex_match(EstimatorStr, regex_gauopn)){
+            ud.estimator = VolumetricSpatialBlurEstimator::Gaussian_Open;
         }else{
             throw std::invalid_argument("Estimator not understood. Refusing to continue.");
         }
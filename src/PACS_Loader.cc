@@ -61,7 +61,7 @@ bool Load_From_PACS_DB( Drover &DICOM_data,
     std::list<loaded_imgs_storage_t> loaded_imgs_storage;
     using loaded_dose_storage_t = decltype(DICOM_data.image_data);
     std::list<loaded_dose_storage_t> loaded_dose_storage;
-    std::shared_ptr<Contour_Data> loaded_contour_data_storage = std::make_shared<Contour_Data>();
+    std::unique_ptr<Contour_Data> loaded_contour_data_storage = std::make_unique<Contour_Data>();
 
     try{
         //Loop over each group of filter query files.
@@ -115,9 +115,10 @@ bool Load_From_PACS_DB( Drover &DICOM_data,
                 if(boost::iequals(Modality,"RTSTRUCT")){
                     const auto preloadcount = loaded_contour_data_storage->ccs.size();
                     try{
-                        auto combined = Concatenate_Contour_Data( loaded_contour_data_storage->Duplicate(),
-                                                                  get_Contour_Data(StoreFullPathName));
-                        loaded_contour_data_storage = std::move(combined);
+                        //Contours are moved (not copied) so loading many files remains linear in the number of contours.
+                        auto contour_data = get_Contour_Data(StoreFullPathName);
+                        loaded_contour_data_storage = Concatenate_Contour_Data( std::move(loaded_contour_data_storage),
+                                                                                std::move(contour_data) );
                     }catch(const std::exception &e){
                         FUNCWARN("Difficulty encountered during contour data loading: '" << e.what() <<
                                  "'. Ignoring file and continuing");
@@ -275,22 +276,36 @@ bool Load_From_PACS_DB( Drover &DICOM_data,
     //-----------------------------------------------------------------------------------------------------------------
 
     //Attempt contour name normalization using the selected lexicon.
+    //
+    // Lexicon lookups are memoized since ROIs often consist of hundreds of contours that share a single name.
     {
         Explicator X(FilenameLex);
+        std::map<std::string, std::string> normalized_names;
         for(auto & cc : loaded_contour_data_storage->ccs){
              for(auto & c : cc.contours){
-                 const auto NormalizedROIName = X(c.metadata["ROIName"]); //Could be cached, externally or internally.
-                 c.metadata["NormalizedROIName"] = NormalizedROIName;
+                 const auto &ROIName = c.metadata["ROIName"];
+                 auto n_it = normalized_names.find(ROIName);
+                 if(n_it == normalized_names.end()){
+                     n_it = normalized_names.emplace(ROIName, X(ROIName)).first;
+                 }
+                 c.metadata["NormalizedROIName"] = n_it->second;
              }
         }   
     }
 
     //Concatenate contour data into the Drover instance.
     {
-        if(DICOM_data.contour_data == nullptr) DICOM_data.contour_data = std::make_shared<Contour_Data>();
-        auto combined = Concatenate_Contour_Data( DICOM_data.contour_data->Duplicate(),
-                                                  loaded_contour_data_storage->Duplicate());
-        DICOM_data.contour_data = std::move(combined);
+        const bool contours_loaded = !loaded_contour_data_storage->ccs.empty();
+        if(DICOM_data.contour_data == nullptr){
+            DICOM_data.contour_data = std::move(loaded_contour_data_storage);
+        }else if(contours_loaded){
+            //Existing contour data may be shared with other Drover instances, so it is replaced rather than altered.
+            DICOM_data.contour_data = Concatenate_Contour_Data( DICOM_data.contour_data->Duplicate(),
+                                                                std::move(loaded_contour_data_storage) );
+        }
+
+        //Build the per-ROI bounding boxes and plane indices now so later consumers need not.
+        if(contours_loaded) DICOM_data.contour_data->get_roi_index();
     }
 
     //Collate each group of images into a single set, if possible. Also stuff the correct contour data in the same set.
@@ -0,0 +1,732 @@
+//Rectilinear_Convolution.cc - A part of DICOMautomaton 2021. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Thread_Pool.h"
+#include "Rectilinear_Convolution.h"
+
+
+dense_volume::dense_volume(long int N_rows, long int N_cols, long int N_imgs, double fill)
+    : N_rows(N_rows),
+      N_cols(N_cols),
+      N_imgs(N_imgs) {
+    if((N_rows < 0) || (N_cols < 0) || (N_imgs < 0)){
+        throw std::invalid_argument("Volume dimensions must be non-negative.");
+    }
+    this->voxels.assign(static_cast<size_t>(N_rows * N_cols * N_imgs), fill);
+}
+
+size_t dense_volume::index(long int row, long int col, long int img) const {
+    return static_cast<size_t>((img * this->N_rows + row) * this->N_cols + col);
+}
+
+double & dense_volume::at(long int row, long int col, long int img){
+    return this->voxels[ this->index(row, col, img) ];
+}
+
+const double & dense_volume::at(long int row, long int col, long int img) const {
+    return this->voxels[ this->index(row, col, img) ];
+}
+
+
+namespace {
+
+using axes_t = std::array<long int, 3>; // Ordered like (row, column, image).
+
+// Tiles (i.e., FFTs) are limited to this many voxels, so each thread requires at most 32 MB of scratch space.
+const long int max_tile_voxels = (1L << 21);
+
+// Describes the pairing of outgoing voxels with the neighbourhood voxels.
+//
+// Every operation is expressed as a correlation: outgoing voxel x (along each axis) is paired with the incoming voxels
+// [x - d, x - d + K), which are weighted by kernel voxels [0, K).
+struct kernel_geometry {
+    dense_volume kernel;
+    axes_t K;   // Kernel extent.
+    axes_t d;   // Kernel offset.
+    axes_t N;   // Volume extent.
+    axes_t lo;  // The first outgoing voxel with a complete neighbourhood.
+    axes_t hi;  // One past the last outgoing voxel with a complete neighbourhood.
+};
+
+axes_t extents(const dense_volume &v){
+    return {{ v.N_rows, v.N_cols, v.N_imgs }};
+}
+
+long int next_pow2(long int x){
+    long int p = 1;
+    while(p < x) p *= 2;
+    return p;
+}
+
+// Invokes f(start, stride, length) for every line of voxels along the given axis.
+template <class Functor>
+void for_each_line(const axes_t &N, size_t axis, Functor &&f){
+    const std::array<long int, 3> strides = {{ N[1], 1L, N[0] * N[1] }};
+    const axes_t ext = {{ (axis == 0) ? 1L : N[0],
+                          (axis == 1) ? 1L : N[1],
+                          (axis == 2) ? 1L : N[2] }};
+    for(long int i = 0; i < ext[2]; ++i){
+        for(long int r = 0; r < ext[0]; ++r){
+            for(long int c = 0; c < ext[1]; ++c){
+                const auto start = (i * N[0] + r) * N[1] + c;
+                f(static_cast<size_t>(start), static_cast<size_t>(strides[axis]), N[axis]);
+            }
+        }
+    }
+    return;
+}
+
+// Sums the neighbourhood of each outgoing voxel, i.e., correlates with a kernel of ones.
+//
+// The box is separable, so it is evaluated as a running sum along each axis in turn. Only outgoing voxels with a
+// complete neighbourhood are meaningful; others are zero.
+dense_volume box_sum(const dense_volume &vol, const kernel_geometry &g){
+    dense_volume a = vol;
+    dense_volume b(g.N[0], g.N[1], g.N[2], 0.0);
+    std::vector<double> P;
+    for(size_t axis = 0; axis < 3; ++axis){
+        std::fill(std::begin(b.voxels), std::end(b.voxels), 0.0);
+        for_each_line(g.N, axis, [&](size_t start, size_t stride, long int len) -> void {
+            P.assign(static_cast<size_t>(len + 1), 0.0);
+            for(long int x = 0; x < len; ++x){
+                P[x + 1] = P[x] + a.voxels[start + stride * x];
+            }
+            for(long int x = g.lo[axis]; x < g.hi[axis]; ++x){
+                b.voxels[start + stride * x] = P[x - g.d[axis] + g.K[axis]] - P[x - g.d[axis]];
+            }
+        });
+        std::swap(a, b);
+    }
+    return a;
+}
+
+// Directly accumulates the correlation (or the sum of squared differences) for outgoing voxels with a complete
+// neighbourhood.
+void direct_kernel(const dense_volume &vol, const kernel_geometry &g, bool ssd, dense_volume &out){
+    const auto N_c = g.hi[1] - g.lo[1];
+
+    asio_thread_pool tp;
+    for(long int z = g.lo[2]; z < g.hi[2]; ++z){
+        tp.submit_task([&,z]() -> void {
+            for(long int ji = 0; ji < g.K[2]; ++ji){
+                for(long int jr = 0; jr < g.K[0]; ++jr){
+                    for(long int jc = 0; jc < g.K[1]; ++jc){
+                        const auto k = g.kernel.at(jr, jc, ji);
+                        if(!ssd && (k == 0.0)) continue;
+
+                        for(long int r = g.lo[0]; r < g.hi[0]; ++r){
+                            double *o = &out.at(r, g.lo[1], z);
+                            const double *in = &vol.at(r - g.d[0] + jr, g.lo[1] - g.d[1] + jc, z - g.d[2] + ji);
+                            if(ssd){
+                                for(long int c = 0; c < N_c; ++c){
+                                    const auto diff = in[c] - k;
+                                    o[c] += diff * diff;
+                                }
+                            }else{
+                                for(long int c = 0; c < N_c; ++c){
+                                    o[c] += k * in[c];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }); // thread pool task closure.
+    }
+    return;
+}
+
+// Iterative radix-2 FFT for a fixed power-of-two length.
+class fft_plan {
+    private:
+        size_t n;
+        std::vector<size_t> rev;                      // Bit-reversal permutation.
+        std::vector<std::complex<double>> twiddles;   // exp(-2*pi*i*k/n) for k in [0, n/2).
+
+    public:
+        explicit fft_plan(size_t n) : n(n) {
+            size_t bits = 0;
+            while((static_cast<size_t>(1) << bits) < n) ++bits;
+            this->rev.resize(n);
+            for(size_t i = 0; i < n; ++i){
+                size_t r = 0;
+                for(size_t b = 0; b < bits; ++b){
+                    if(i & (static_cast<size_t>(1) << b)) r |= (static_cast<size_t>(1) << (bits - 1 - b));
+                }
+                this->rev[i] = r;
+            }
+            this->twiddles.resize(n / 2);
+            for(size_t k = 0; k < (n / 2); ++k){
+                const auto angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(n);
+                this->twiddles[k] = std::polar(1.0, angle);
+            }
+        }
+
+        // Unnormalized, in-place transform of n contiguous values.
+        void transform(std::complex<double> *x, bool inverse) const {
+            for(size_t i = 0; i < this->n; ++i){
+                if(i < this->rev[i]) std::swap(x[i], x[this->rev[i]]);
+            }
+            for(size_t len = 2; len <= this->n; len *= 2){
+                const auto half = len / 2;
+                const auto step = this->n / len;
+                for(size_t i = 0; i < this->n; i += len){
+                    for(size_t k = 0; k < half; ++k){
+                        const auto w = (inverse) ? std::conj(this->twiddles[k * step]) : this->twiddles[k * step];
+                        const auto u = x[i + k];
+                        const auto v = x[i + k + half] * w;
+                        x[i + k] = u + v;
+                        x[i + k + half] = u - v;
+                    }
+                }
+            }
+            return;
+        }
+};
+
+// Unnormalized, in-place 3D transform of a tile with the same layout as dense_volume.
+void fft_3d(std::vector<std::complex<double>> &buf,
+            const axes_t &P,
+            const std::vector<fft_plan> &plans,
+            bool inverse,
+            std::vector<std::complex<double>> &line){
+    for(size_t axis = 0; axis < 3; ++axis){
+        if(P[axis] <= 1) continue;
+        for_each_line(P, axis, [&](size_t start, size_t stride, long int len) -> void {
+            if(stride == 1){
+                plans[axis].transform(&buf[start], inverse);
+                return;
+            }
+            for(long int x = 0; x < len; ++x) line[x] = buf[start + stride * x];
+            plans[axis].transform(line.data(), inverse);
+            for(long int x = 0; x < len; ++x) buf[start + stride * x] = line[x];
+        });
+    }
+    return;
+}
+
+struct tiling {
+    axes_t P;     // Tile extent, i.e., the FFT size along each axis.
+    axes_t L;     // Number of outgoing voxels per tile along each axis, i.e., P - K + 1.
+    long int N_tiles;
+    double cost;  // Approximate number of floating-point operations.
+};
+
+// Selects the tile extents with the lowest estimated cost.
+//
+// Larger tiles waste less of each FFT on the overlap, but each FFT costs more per voxel. Tiles are processed in pairs
+// (one in the real component and one in the imaginary component), so each pair costs a forward and an inverse FFT.
+tiling choose_tiling(const kernel_geometry &g){
+    std::array<std::vector<long int>, 3> candidates;
+    for(size_t a = 0; a < 3; ++a){
+        const auto V_a = g.hi[a] - g.lo[a];
+        const auto p_max = next_pow2(V_a + g.K[a] - 1);
+        for(auto p = next_pow2(g.K[a]); p <= p_max; p *= 2) candidates[a].push_back(p);
+    }
+
+    std::optional<tiling> best;
+    for(const auto Pr : candidates[0]){
+        for(const auto Pc : candidates[1]){
+            for(const auto Pi : candidates[2]){
+                const axes_t P = {{ Pr, Pc, Pi }};
+                const auto N_P = Pr * Pc * Pi;
+                const bool smallest = (Pr == candidates[0].front())
+                                   && (Pc == candidates[1].front())
+                                   && (Pi == candidates[2].front());
+                if(!smallest && (max_tile_voxels < N_P)) continue;
+
+                tiling t;
+                t.P = P;
+                t.N_tiles = 1;
+                for(size_t a = 0; a < 3; ++a){
+                    t.L[a] = P[a] - g.K[a] + 1;
+                    const auto V_a = g.hi[a] - g.lo[a];
+                    t.N_tiles *= (V_a + t.L[a] - 1) / t.L[a];
+                }
+                const auto N_pairs = static_cast<double>((t.N_tiles + 1) / 2);
+                const auto fft_cost = 5.0 * static_cast<double>(N_P) * std::log2(static_cast<double>(N_P));
+                t.cost = N_pairs * (2.0 * fft_cost + 8.0 * static_cast<double>(N_P));
+                if(!best || (t.cost < best->cost)) best = t;
+            }
+        }
+    }
+    return best.value();
+}
+
+// Correlates using FFTs and overlap-save tiling for outgoing voxels with a complete neighbourhood.
+void fft_correlate(const dense_volume &vol, const kernel_geometry &g, const tiling &t, dense_volume &out){
+    const auto &P = t.P;
+    const auto N_P = static_cast<size_t>(P[0] * P[1] * P[2]);
+    std::vector<fft_plan> plans;
+    for(size_t a = 0; a < 3; ++a) plans.emplace_back( static_cast<size_t>(P[a]) );
+    const auto P_max = static_cast<size_t>( *std::max_element(std::begin(P), std::end(P)) );
+
+    // The kernel spectrum is conjugated so that products with a tile spectrum yield correlations. The normalization of
+    // the inverse transform is also folded in.
+    std::vector<std::complex<double>> K_hat(N_P);
+    {
+        std::vector<std::complex<double>> line(P_max);
+        for(long int ji = 0; ji < g.K[2]; ++ji){
+            for(long int jr = 0; jr < g.K[0]; ++jr){
+                for(long int jc = 0; jc < g.K[1]; ++jc){
+                    K_hat[ static_cast<size_t>((ji * P[0] + jr) * P[1] + jc) ] = g.kernel.at(jr, jc, ji);
+                }
+            }
+        }
+        fft_3d(K_hat, P, plans, false, line);
+        for(auto &k : K_hat) k = std::conj(k) / static_cast<double>(N_P);
+    }
+
+    // Tiles are identified by their first outgoing voxel.
+    std::vector<axes_t> tiles;
+    for(long int z = g.lo[2]; z < g.hi[2]; z += t.L[2]){
+        for(long int r = g.lo[0]; r < g.hi[0]; r += t.L[0]){
+            for(long int c = g.lo[1]; c < g.hi[1]; c += t.L[1]){
+                tiles.push_back( {{ r, c, z }} );
+            }
+        }
+    }
+
+    asio_thread_pool tp;
+    for(size_t n = 0; n < tiles.size(); n += 2){
+        tp.submit_task([&,n]() -> void {
+            std::vector<std::complex<double>> buf(N_P);
+            std::vector<std::complex<double>> line(P_max);
+            const size_t N_here = std::min<size_t>(2, tiles.size() - n);
+
+            // Load the incoming voxels. Voxels beyond the volume only affect outgoing voxels that are discarded.
+            for(size_t m = 0; m < N_here; ++m){
+                const auto &x0 = tiles[n + m];
+                for(long int ti = 0; ti < P[2]; ++ti){
+                    const auto i = x0[2] - g.d[2] + ti;
+                    if((i < 0) || (g.N[2] <= i)) continue;
+                    for(long int tr = 0; tr < P[0]; ++tr){
+                        const auto r = x0[0] - g.d[0] + tr;
+                        if((r < 0) || (g.N[0] <= r)) continue;
+                        for(long int tc = 0; tc < P[1]; ++tc){
+                            const auto c = x0[1] - g.d[1] + tc;
+                            if((c < 0) || (g.N[1] <= c)) continue;
+                            auto &v = buf[ static_cast<size_t>((ti * P[0] + tr) * P[1] + tc) ];
+                            const auto val = vol.at(r, c, i);
+                            v = (m == 0) ? std::complex<double>(val, v.imag())
+                                         : std::complex<double>(v.real(), val);
+                        }
+                    }
+                }
+            }
+
+            fft_3d(buf, P, plans, false, line);
+            for(size_t k = 0; k < N_P; ++k) buf[k] *= K_hat[k];
+            fft_3d(buf, P, plans, true, line);
+
+            // Store the outgoing voxels. Tiles do not overlap, so no synchronization is needed.
+            for(size_t m = 0; m < N_here; ++m){
+                const auto &x0 = tiles[n + m];
+                const auto n_i = std::min(t.L[2], g.hi[2] - x0[2]);
+                const auto n_r = std::min(t.L[0], g.hi[0] - x0[0]);
+                const auto n_c = std::min(t.L[1], g.hi[1] - x0[1]);
+                for(long int ti = 0; ti < n_i; ++ti){
+                    for(long int tr = 0; tr < n_r; ++tr){
+                        for(long int tc = 0; tc < n_c; ++tc){
+                            const auto &v = buf[ static_cast<size_t>((ti * P[0] + tr) * P[1] + tc) ];
+                            out.at(x0[0] + tr, x0[1] + tc, x0[2] + ti) = (m == 0) ? v.real() : v.imag();
+                        }
+                    }
+                }
+            }
+        }); // thread pool task closure.
+    }
+    return;
+}
+
+} // namespace.
+
+
+dense_volume
+Apply_Kernel(const dense_volume &vol,
+             const dense_volume &kernel,
+             kernel_operation op,
+             kernel_method method){
+
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+    for(const auto *v : { &vol, &kernel }){
+        if( (v->N_rows < 0) || (v->N_cols < 0) || (v->N_imgs < 0)
+        ||  (v->voxels.size() != static_cast<size_t>(v->N_rows * v->N_cols * v->N_imgs)) ){
+            throw std::invalid_argument("Volume dimensions are inconsistent with the number of voxels.");
+        }
+    }
+    if(kernel.voxels.empty()){
+        throw std::invalid_argument("Kernel contains no voxels.");
+    }
+
+    // Express the operation as a correlation.
+    kernel_geometry g;
+    g.K = extents(kernel);
+    g.N = extents(vol);
+    if(op == kernel_operation::convolution){
+        g.kernel = dense_volume(g.K[0], g.K[1], g.K[2]);
+        for(long int i = 0; i < g.K[2]; ++i){
+            for(long int r = 0; r < g.K[0]; ++r){
+                for(long int c = 0; c < g.K[1]; ++c){
+                    g.kernel.at(r, c, i) = kernel.at(g.K[0] - 1 - r, g.K[1] - 1 - c, g.K[2] - 1 - i);
+                }
+            }
+        }
+        for(size_t a = 0; a < 3; ++a) g.d[a] = g.K[a] - 1 - g.K[a] / 2;
+
+    }else if( (op == kernel_operation::correlation)
+          ||  (op == kernel_operation::pattern_match) ){
+        g.kernel = kernel;
+        for(size_t a = 0; a < 3; ++a) g.d[a] = g.K[a] / 2;
+
+    }else{
+        throw std::invalid_argument("Kernel operation not understood.");
+    }
+
+    bool any_valid = true;
+    for(size_t a = 0; a < 3; ++a){
+        g.lo[a] = g.d[a];
+        g.hi[a] = std::max(g.lo[a], g.N[a] - g.K[a] + g.d[a] + 1);
+        if(g.hi[a] <= g.lo[a]) any_valid = false;
+    }
+
+    const bool kernel_finite = std::all_of(std::begin(kernel.voxels), std::end(kernel.voxels),
+                                           [](double x){ return std::isfinite(x); });
+    if(!kernel_finite || !any_valid){
+        return dense_volume(g.N[0], g.N[1], g.N[2], nan);
+    }
+
+    // Non-finite voxels are replaced so they do not contaminate neighbouring tiles. Outgoing voxels with non-finite
+    // neighbours are identified afterward.
+    dense_volume clean = vol;
+    dense_volume nonfinite;
+    for(size_t k = 0; k < clean.voxels.size(); ++k){
+        if(!std::isfinite(clean.voxels[k])){
+            if(nonfinite.voxels.empty()) nonfinite = dense_volume(g.N[0], g.N[1], g.N[2], 0.0);
+            nonfinite.voxels[k] = 1.0;
+            clean.voxels[k] = 0.0;
+        }
+    }
+
+    // Select the method.
+    double V_valid = 1.0;
+    double K_count = 1.0;
+    for(size_t a = 0; a < 3; ++a){
+        V_valid *= static_cast<double>(g.hi[a] - g.lo[a]);
+        K_count *= static_cast<double>(g.K[a]);
+    }
+    const auto direct_cost = 2.0 * V_valid * K_count;
+    const auto t = choose_tiling(g);
+    const bool use_fft = (method == kernel_method::fft)
+                      || ((method == kernel_method::automatic) && (t.cost < direct_cost));
+    const bool ssd = (op == kernel_operation::pattern_match);
+
+    dense_volume out(g.N[0], g.N[1], g.N[2], 0.0);
+    if(use_fft){
+        FUNCINFO("Applying kernel using " << t.N_tiles << " FFT tiles of extent "
+                 << t.P[0] << "x" << t.P[1] << "x" << t.P[2]);
+        fft_correlate(clean, g, t, out);
+
+        if(ssd){
+            // Expand the sum of squared differences: sum(I^2) - 2*sum(I*k) + sum(k^2).
+            dense_volume squares = clean;
+            for(auto &x : squares.voxels) x *= x;
+            const auto sum_sq = box_sum(squares, g);
+            double k_sq = 0.0;
+            for(const auto &k : g.kernel.voxels) k_sq += k * k;
+            for(size_t k = 0; k < out.voxels.size(); ++k){
+                out.voxels[k] = sum_sq.voxels[k] - 2.0 * out.voxels[k] + k_sq;
+            }
+        }
+    }else{
+        FUNCINFO("Applying kernel directly");
+        direct_kernel(clean, g, ssd, out);
+    }
+
+    // Finalize outgoing voxels, invalidating those with an incomplete or non-finite neighbourhood.
+    const auto N_nonfinite = (nonfinite.voxels.empty()) ? dense_volume() : box_sum(nonfinite, g);
+    for(long int i = 0; i < g.N[2]; ++i){
+        for(long int r = 0; r < g.N[0]; ++r){
+            for(long int c = 0; c < g.N[1]; ++c){
+                auto &v = out.at(r, c, i);
+                const bool complete = (g.lo[0] <= r) && (r < g.hi[0])
+                                   && (g.lo[1] <= c) && (c < g.hi[1])
+                                   && (g.lo[2] <= i) && (i < g.hi[2]);
+                if( !complete
+                ||  (!N_nonfinite.voxels.empty() && (0.5 < N_nonfinite.at(r, c, i))) ){
+                    v = nan;
+                }else if(ssd){
+                    v = std::sqrt(std::max(0.0, v));
+                }
+            }
+        }
+    }
+    return out;
+}
+
+
+namespace {
+
+// A 1D Gaussian filter, implemented either recursively or with a sampled kernel.
+struct gaussian_filter_1d {
+    bool recursive = false;
+
+    // Recursive filter coefficients, normalized so that y[n] = B*x[n] + b1*y[n-1] + b2*y[n-2] + b3*y[n-3].
+    double B = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double b3 = 0.0;
+    long int tail = 0; // Zero padding needed for the impulse response to decay before the reverse pass.
+
+    // Sampled kernel weights, centred on the middle element.
+    std::vector<double> weights;
+};
+
+gaussian_filter_1d make_gaussian_filter(double sigma){
+    gaussian_filter_1d f;
+    if(sigma < 3.0){
+        const auto R = static_cast<long int>(std::ceil(4.0 * sigma));
+        double sum = 0.0;
+        for(long int k = -R; k <= R; ++k){
+            const auto x = static_cast<double>(k) / sigma;
+            f.weights.push_back(std::exp(-0.5 * x * x));
+            sum += f.weights.back();
+        }
+        for(auto &w : f.weights) w /= sum;
+        return f;
+    }
+
+    // Coefficients from I.T. Young and L.J. van Vliet, Signal Processing 44 (1995) 139-151.
+    const auto q = 0.98711 * sigma - 0.96330;
+    const auto q2 = q * q;
+    const auto q3 = q2 * q;
+    const auto b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+    f.recursive = true;
+    f.b1 = (2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0;
+    f.b2 = -(1.4281 * q2 + 1.26661 * q3) / b0;
+    f.b3 = (0.422205 * q3) / b0;
+    f.B = 1.0 - (f.b1 + f.b2 + f.b3);
+    f.tail = static_cast<long int>(std::ceil(4.0 * sigma)) + 3L;
+    return f;
+}
+
+// Filters N_lanes interleaved lines of length N in place. Element n of lane l is located at data[n * stride + l].
+//
+// The lanes are processed in lockstep, so the innermost loops run over contiguous memory and can be vectorized.
+void filter_lanes(double *data,
+                  long int N,
+                  size_t stride,
+                  long int N_lanes,
+                  const gaussian_filter_1d &f,
+                  std::vector<double> &buf){
+    const auto L = static_cast<size_t>(N_lanes);
+
+    if(!f.recursive){
+        const auto R = static_cast<long int>(f.weights.size() / 2);
+        buf.assign(static_cast<size_t>(N) * L, 0.0);
+        for(long int n = 0; n < N; ++n){
+            double *o = &buf[static_cast<size_t>(n) * L];
+            const auto k_lo = std::max(-R, -n);
+            const auto k_hi = std::min(R, N - 1L - n);
+            for(long int k = k_lo; k <= k_hi; ++k){
+                const auto w = f.weights[static_cast<size_t>(k + R)];
+                const double *in = &data[static_cast<size_t>(n + k) * stride];
+                for(size_t l = 0; l < L; ++l) o[l] += w * in[l];
+            }
+        }
+        for(long int n = 0; n < N; ++n){
+            std::copy_n(&buf[static_cast<size_t>(n) * L], L, &data[static_cast<size_t>(n) * stride]);
+        }
+        return;
+    }
+
+    // Three leading rows of zeros provide the initial state of the causal pass, and the trailing rows provide the
+    // zero padding (and initial state) for the anti-causal pass.
+    const auto M = static_cast<size_t>(N + f.tail);
+    buf.assign((M + 6) * L, 0.0);
+    double *w = &buf[3 * L];
+    for(size_t n = 0; n < M; ++n){
+        double *o = &w[n * L];
+        const double *o1 = o - L;
+        const double *o2 = o1 - L;
+        const double *o3 = o2 - L;
+        if(n < static_cast<size_t>(N)){
+            const double *in = &data[n * stride];
+            for(size_t l = 0; l < L; ++l){
+                o[l] = f.B * in[l] + f.b1 * o1[l] + f.b2 * o2[l] + f.b3 * o3[l];
+            }
+        }else{
+            for(size_t l = 0; l < L; ++l){
+                o[l] = f.b1 * o1[l] + f.b2 * o2[l] + f.b3 * o3[l];
+            }
+        }
+    }
+    for(size_t n = M; n-- > 0; ){
+        double *o = &w[n * L];
+        const double *o1 = o + L;
+        const double *o2 = o1 + L;
+        const double *o3 = o2 + L;
+        for(size_t l = 0; l < L; ++l){
+            o[l] = f.B * o[l] + f.b1 * o1[l] + f.b2 * o2[l] + f.b3 * o3[l];
+        }
+    }
+    for(long int n = 0; n < N; ++n){
+        std::copy_n(&w[static_cast<size_t>(n) * L], L, &data[static_cast<size_t>(n) * stride]);
+    }
+    return;
+}
+
+// Invokes f(i) for i in [0, N), concurrently if there is more than one task.
+template <class Functor>
+void parallel_for(long int N, Functor &&f){
+    if(N <= 1){
+        for(long int i = 0; i < N; ++i) f(i);
+        return;
+    }
+    asio_thread_pool tp;
+    for(long int i = 0; i < N; ++i){
+        tp.submit_task([&,i]() -> void {
+            f(i);
+        }); // thread pool task closure.
+    }
+    return;
+}
+
+// Estimates a derivative along the given axis using centred finite differences, in place.
+void differentiate(dense_volume &vol, size_t axis, long int order){
+    if(order == 0) return;
+    const auto N = extents(vol);
+    const auto len = N[axis];
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> line;
+    for_each_line(N, axis, [&](size_t start, size_t stride, long int) -> void {
+        line.resize(static_cast<size_t>(len));
+        for(long int x = 0; x < len; ++x) line[x] = vol.voxels[start + stride * x];
+        for(long int x = 0; x < len; ++x){
+            double d = nan;
+            if(order == 1){
+                if(2 <= len){
+                    const auto x_m = std::max(0L, x - 1L);
+                    const auto x_p = std::min(len - 1L, x + 1L);
+                    d = (line[x_p] - line[x_m]) / static_cast<double>(x_p - x_m);
+                }
+            }else if(order == 2){
+                if(3 <= len){
+                    const auto x_c = std::clamp(x, 1L, len - 2L);
+                    d = line[x_c + 1] - 2.0 * line[x_c] + line[x_c - 1];
+                }
+            }else{
+                throw std::invalid_argument("Derivative order not supported.");
+            }
+            vol.voxels[start + stride * x] = d;
+        }
+    });
+    return;
+}
+
+} // namespace.
+
+
+dense_volume
+Gaussian_Filter(const dense_volume &vol,
+                const std::array<double, 3> &sigma,
+                const std::array<long int, 3> &derivative){
+    for(size_t a = 0; a < 3; ++a){
+        if( !std::isfinite(sigma[a]) || (sigma[a] < 0.0) ){
+            throw std::invalid_argument("Gaussian sigma must be finite and non-negative.");
+        }
+        if( (derivative[a] < 0) || (2 < derivative[a]) ){
+            throw std::invalid_argument("Derivative order not supported.");
+        }
+    }
+    const auto N = extents(vol);
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+    // Normalized convolution: filter the (zeroed) voxel intensities and their availability alongside one another.
+    //
+    // When all voxels are finite the availability is separable, so it is filtered once per axis rather than per voxel.
+    dense_volume num = vol;
+    dense_volume den;
+    for(size_t k = 0; k < num.voxels.size(); ++k){
+        if(!std::isfinite(num.voxels[k])){
+            if(den.voxels.empty()) den = dense_volume(N[0], N[1], N[2], 1.0);
+            num.voxels[k] = 0.0;
+            den.voxels[k] = 0.0;
+        }
+    }
+    std::vector<dense_volume *> targets = { &num };
+    if(!den.voxels.empty()) targets.push_back( &den );
+    std::array<std::vector<double>, 3> den_axes;
+
+    const auto N_slice = N[0] * N[1];
+    for(size_t axis = 0; axis < 3; ++axis){
+        den_axes[axis].assign(static_cast<size_t>(N[axis]), 1.0);
+        if( (sigma[axis] == 0.0) || (N[axis] <= 1) || (N_slice == 0) ) continue;
+        const auto f = make_gaussian_filter(sigma[axis]);
+        {
+            std::vector<double> buf;
+            filter_lanes(den_axes[axis].data(), N[axis], 1, 1, f, buf);
+        }
+
+        if(axis == 0){
+            // Filter along rows. Each image is an independent task, and every column is a lane.
+            parallel_for(N[2], [&](long int i) -> void {
+                std::vector<double> buf;
+                for(auto *v : targets){
+                    filter_lanes(&v->at(0, 0, i), N[0], static_cast<size_t>(N[1]), N[1], f, buf);
+                }
+            });
+
+        }else if(axis == 1){
+            // Filter along columns. Each image is an independent task, and rows are filtered one at a time.
+            parallel_for(N[2], [&](long int i) -> void {
+                std::vector<double> buf;
+                for(auto *v : targets){
+                    for(long int r = 0; r < N[0]; ++r){
+                        filter_lanes(&v->at(r, 0, i), N[1], 1, 1, f, buf);
+                    }
+                }
+            });
+
+        }else{
+            // Filter across images. Each block of (row, column) positions is an independent task and a set of lanes.
+            const long int block = 1024;
+            const auto N_blocks = (N_slice + block - 1) / block;
+            parallel_for(N_blocks, [&](long int b) -> void {
+                std::vector<double> buf;
+                const auto first = b * block;
+                const auto lanes = std::min(block, N_slice - first);
+                for(auto *v : targets){
+                    filter_lanes(&v->voxels[static_cast<size_t>(first)], N[2], static_cast<size_t>(N_slice), lanes, f, buf);
+                }
+            });
+        }
+    }
+
+    for(long int i = 0; i < N[2]; ++i){
+        for(long int r = 0; r < N[0]; ++r){
+            for(long int c = 0; c < N[1]; ++c){
+                const auto k = num.index(r, c, i);
+                const auto d = (den.voxels.empty()) ? den_axes[0][r] * den_axes[1][c] * den_axes[2][i]
+                                                    : den.voxels[k];
+                num.voxels[k] = (d < 1E-3) ? nan : num.voxels[k] / d;
+            }
+        }
+    }
+
+    for(size_t axis = 0; axis < 3; ++axis){
+        differentiate(num, axis, derivative[axis]);
+    }
+    return num;
+}
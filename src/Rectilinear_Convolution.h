@@ -0,0 +1,77 @@
+//Rectilinear_Convolution.h - A part of DICOMautomaton 2021. Written by hal clark.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+
+// A dense 3D array of scalar voxel intensities in voxel number space.
+//
+// Voxels are stored with the column number varying fastest, then the row number, then the image number.
+struct dense_volume {
+    long int N_rows = 0;
+    long int N_cols = 0;
+    long int N_imgs = 0;
+    std::vector<double> voxels;
+
+    dense_volume() = default;
+    dense_volume(long int N_rows, long int N_cols, long int N_imgs, double fill = 0.0);
+
+    size_t index(long int row, long int col, long int img) const;
+    double & at(long int row, long int col, long int img);
+    const double & at(long int row, long int col, long int img) const;
+};
+
+
+enum class kernel_operation {
+    convolution,   // Sum of the products of kernel and (spatially inverted) neighbourhood intensities.
+    correlation,   // Sum of the products of kernel and neighbourhood intensities.
+    pattern_match, // Euclidean distance (i.e., 2-norm of the difference) between kernel and neighbourhood intensities.
+};
+
+enum class kernel_method {
+    automatic,     // Selects the method with the lower estimated cost.
+    direct,        // Directly sums over the kernel. Cost scales like (number of voxels)*(number of kernel voxels).
+    fft,           // Uses FFTs with overlap-save tiling. Cost scales like (number of voxels)*log(tile size).
+};
+
+
+// Applies a kernel to every voxel of a volume.
+//
+// The kernel is (approximately) centred on each voxel: for correlation and pattern-matching, kernel voxel (r,c,i) is
+// paired with the voxel offset by (r - K_rows/2, c - K_cols/2, i - K_imgs/2) from the outgoing voxel. For convolution
+// the offsets are negated. Even-sized kernels are therefore offset by half a voxel along the corresponding axis.
+//
+// Voxels whose neighbourhood extends beyond the volume, or includes any non-finite intensities, are assigned NaN. If
+// the kernel contains non-finite intensities, all voxels are assigned NaN.
+//
+// The FFT method tiles the volume using the overlap-save method so that memory use is bounded regardless of the volume
+// size. Pattern-matching is evaluated via FFT by expanding the sum of squared differences into correlations, so
+// results are subject to cancellation error when the neighbourhood and kernel nearly match.
+dense_volume
+Apply_Kernel(const dense_volume &vol,
+             const dense_volume &kernel,
+             kernel_operation op,
+             kernel_method method = kernel_method::automatic);
+
+
+// Blurs a volume using a Gaussian, optionally also estimating a derivative of the blurred volume.
+//
+// Sigmas are given in voxels along the row, column, and image axes, so anisotropic voxels can be accommodated. A zero
+// sigma disables blurring along that axis. The blur is separable and each axis is filtered with a third-order recursive
+// (Young-van Vliet) filter, so the cost per voxel does not depend on sigma. Small sigmas (< 3 voxels), where the
+// recursive approximation is least accurate, are filtered with a sampled kernel instead. Images (or blocks of voxels
+// when filtering across images) are processed concurrently.
+//
+// Non-finite voxels and voxels beyond the volume are treated as missing; the blur is renormalized using the weight of
+// the available voxels (i.e., normalized convolution). Voxels where nearly all the weight is missing are assigned NaN.
+//
+// Derivative orders (0, 1, or 2) can be requested along each axis. Derivatives are estimated using centred finite
+// differences of the blurred volume (one-sided at the volume boundaries) and are expressed per voxel.
+dense_volume
+Gaussian_Filter(const dense_volume &vol,
+                const std::array<double, 3> &sigma,
+                const std::array<long int, 3> &derivative = {{ 0L, 0L, 0L }});
+
@@ -0,0 +1,305 @@
+//Rectilinear_Volume.cc - A part of DICOMautomaton 2021. Written by hal clark.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <utility>            //Needed for std::pair.
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
+#include "Rectilinear_Volume.h"
+
+
+rectilinear_volume_index::rectilinear_volume_index(std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs){
+    if(selected_imgs.empty()){
+        throw std::invalid_argument("No images provided. Cannot index volume.");
+    }
+    if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+        throw std::invalid_argument("Images do not form a rectilinear grid. Cannot index volume.");
+    }
+
+    const auto &first = selected_imgs.front().get();
+    this->row_unit = first.row_unit.unit();
+    this->col_unit = first.col_unit.unit();
+    this->img_unit = this->col_unit.Cross(this->row_unit).unit();
+    this->pxl_dx = first.pxl_dx;
+    this->pxl_dy = first.pxl_dy;
+    this->N_rows = first.rows;
+    this->N_cols = first.columns;
+    if( (this->N_rows <= 0) || (this->N_cols <= 0) ){
+        throw std::invalid_argument("Images contain no voxels. Cannot index volume.");
+    }
+
+    // Order the images along the slice normal.
+    std::vector<std::pair<double, planar_image<float,double>*>> ordered;
+    ordered.reserve(selected_imgs.size());
+    for(auto &img_refw : selected_imgs){
+        auto *img_ptr = &(img_refw.get());
+        ordered.emplace_back( img_ptr->position(0,0).Dot(this->img_unit), img_ptr );
+    }
+    std::stable_sort(std::begin(ordered), std::end(ordered),
+                     [](const auto &L, const auto &R){ return (L.first < R.first); });
+
+    this->N_imgs = static_cast<long int>(ordered.size());
+    this->grid_zero = ordered.front().second->position(0,0);
+    const auto z_zero = ordered.front().first;
+
+    this->imgs.clear();
+    this->imgs.reserve(ordered.size());
+    for(const auto &p : ordered) this->imgs.push_back(p.second);
+
+    // Place slice boundaries halfway between adjacent image centres.
+    this->img_bounds.clear();
+    this->img_bounds.reserve(ordered.size() + 1);
+    this->img_bounds.push_back( -0.5 * ordered.front().second->pxl_dz );
+    for(size_t i = 1; i < ordered.size(); ++i){
+        const auto z_prev = ordered[i-1].first - z_zero;
+        const auto z_curr = ordered[i].first - z_zero;
+        if(!(z_prev < z_curr)){
+            throw std::invalid_argument("Images overlap spatially. Cannot index volume.");
+        }
+        this->img_bounds.push_back( 0.5 * (z_prev + z_curr) );
+    }
+    this->img_bounds.push_back( (ordered.back().first - z_zero) + 0.5 * ordered.back().second->pxl_dz );
+    if(!(this->img_bounds.front() < this->img_bounds.back())){
+        throw std::invalid_argument("Images have no thickness. Cannot index volume.");
+    }
+}
+
+static
+std::list<std::reference_wrapper<planar_image<float,double>>>
+all_images(planar_image_collection<float,double> &imagecoll){
+    std::list<std::reference_wrapper<planar_image<float,double>>> out;
+    for(auto &img : imagecoll.images) out.push_back( std::ref(img) );
+    return out;
+}
+
+rectilinear_volume_index::rectilinear_volume_index(planar_image_collection<float,double> &imagecoll)
+    : rectilinear_volume_index(all_images(imagecoll)) { }
+
+
+bool
+rectilinear_volume_index::index_of(const vec3<double> &P, long int &row, long int &col, long int &img) const {
+    const auto P_rel = (P - this->grid_zero);
+
+    const auto x = std::floor( (P_rel.Dot(this->row_unit) + 0.5 * this->pxl_dx) / this->pxl_dx );
+    const auto y = std::floor( (P_rel.Dot(this->col_unit) + 0.5 * this->pxl_dy) / this->pxl_dy );
+    const auto z = P_rel.Dot(this->img_unit);
+    if( !std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z) ) return false;
+
+    if( (x < 0.0) || (static_cast<double>(this->N_rows) <= x)
+    ||  (y < 0.0) || (static_cast<double>(this->N_cols) <= y)
+    ||  (z < this->img_bounds.front()) || (this->img_bounds.back() <= z) ){
+        return false;
+    }
+
+    const auto it = std::upper_bound(std::begin(this->img_bounds), std::end(this->img_bounds), z);
+    row = static_cast<long int>(x);
+    col = static_cast<long int>(y);
+    img = static_cast<long int>(std::distance(std::begin(this->img_bounds), it)) - 1L;
+    return true;
+}
+
+planar_image<float,double>*
+rectilinear_volume_index::image_encompassing(const vec3<double> &P) const {
+    long int row = -1;
+    long int col = -1;
+    long int img = -1;
+    return this->index_of(P, row, col, img) ? this->imgs[img] : nullptr;
+}
+
+
+
+// Returns true iff every slice boundary of the index coincides with the faces of the adjacent images, i.e., there are
+// no gaps between slices and the slices do not overlap.
+static
+bool
+slices_abut(const rectilinear_volume_index &rvi){
+    for(long int i = 0; i < rvi.N_imgs; ++i){
+        const auto pxl_dz = rvi.imgs[i]->pxl_dz;
+        const auto thickness = rvi.img_bounds[i+1] - rvi.img_bounds[i];
+        if(1.0E-3 * pxl_dz < std::abs(thickness - pxl_dz)) return false;
+    }
+    return true;
+}
+
+image_volume_index::image_volume_index(planar_image_collection<float,double> &imagecoll){
+    this->geometry.reserve(imagecoll.images.size());
+    for(const auto &img : imagecoll.images){
+        this->geometry.push_back( { &img, img.rows, img.columns, img.pxl_dx, img.pxl_dy, img.pxl_dz,
+                                    img.anchor, img.offset, img.row_unit, img.col_unit } );
+    }
+    if(imagecoll.images.empty()) return;
+
+    // Prefer the rectilinear index, which requires no per-image tests. However, it places slice boundaries midway
+    // between image centres, which only agrees with the images' own extents when adjacent slices abut. Otherwise it is
+    // retained (e.g., for ray traversal) but point lookups use the bounding volume hierarchy.
+    try{
+        this->rectilinear.emplace(imagecoll);
+        if(slices_abut(*(this->rectilinear))) return;
+    }catch(const std::exception &){ }
+
+    // Otherwise, build a bounding volume hierarchy using the axis-aligned bounding box of each image slab.
+    std::vector<std::pair<vec3<double>, vec3<double>>> boxes;
+    boxes.reserve(imagecoll.images.size());
+    this->bvh_imgs.reserve(imagecoll.images.size());
+    for(auto &img : imagecoll.images){
+        const auto row_unit = img.row_unit.unit();
+        const auto col_unit = img.col_unit.unit();
+        const auto img_unit = col_unit.Cross(row_unit).unit();
+        const auto zero = img.position(0,0);
+
+        const auto inf = std::numeric_limits<double>::infinity();
+        vec3<double> lo( inf,  inf,  inf);
+        vec3<double> hi(-inf, -inf, -inf);
+        for(const auto r : { -0.5, static_cast<double>(img.rows) - 0.5 }){
+            for(const auto c : { -0.5, static_cast<double>(img.columns) - 0.5 }){
+                for(const auto z : { -0.5, 0.5 }){
+                    const auto corner = zero + row_unit * (r * img.pxl_dx)
+                                             + col_unit * (c * img.pxl_dy)
+                                             + img_unit * (z * img.pxl_dz);
+                    lo.x = std::min(lo.x, corner.x);
+                    lo.y = std::min(lo.y, corner.y);
+                    lo.z = std::min(lo.z, corner.z);
+                    hi.x = std::max(hi.x, corner.x);
+                    hi.y = std::max(hi.y, corner.y);
+                    hi.z = std::max(hi.z, corner.z);
+                }
+            }
+        }
+
+        // Pad slightly so points on the image boundaries are not excluded by round-off.
+        const auto pad = 1.0E-6 * std::max({ 1.0, hi.x - lo.x, hi.y - lo.y, hi.z - lo.z });
+        boxes.emplace_back( lo - vec3<double>(pad, pad, pad), hi + vec3<double>(pad, pad, pad) );
+        this->bvh_imgs.push_back( &img );
+    }
+
+    this->bvh.reserve(2 * boxes.size());
+    this->bvh.emplace_back();
+    this->build_bvh(boxes, 0, 0, static_cast<long int>(boxes.size()));
+}
+
+void
+image_volume_index::build_bvh(std::vector<std::pair<vec3<double>, vec3<double>>> &boxes,
+                              long int node,
+                              long int first,
+                              long int count){
+    const long int max_leaf_size = 4;
+
+    const auto inf = std::numeric_limits<double>::infinity();
+    vec3<double> lo( inf,  inf,  inf);
+    vec3<double> hi(-inf, -inf, -inf);
+    vec3<double> c_lo( inf,  inf,  inf);
+    vec3<double> c_hi(-inf, -inf, -inf);
+    for(long int i = first; i < (first + count); ++i){
+        const auto &b = boxes[i];
+        lo = vec3<double>( std::min(lo.x, b.first.x), std::min(lo.y, b.first.y), std::min(lo.z, b.first.z) );
+        hi = vec3<double>( std::max(hi.x, b.second.x), std::max(hi.y, b.second.y), std::max(hi.z, b.second.z) );
+
+        const auto c = (b.first + b.second) * 0.5;
+        c_lo = vec3<double>( std::min(c_lo.x, c.x), std::min(c_lo.y, c.y), std::min(c_lo.z, c.z) );
+        c_hi = vec3<double>( std::max(c_hi.x, c.x), std::max(c_hi.y, c.y), std::max(c_hi.z, c.z) );
+    }
+    this->bvh[node].lo = lo;
+    this->bvh[node].hi = hi;
+
+    if(count <= max_leaf_size){
+        this->bvh[node].first = first;
+        this->bvh[node].count = count;
+        return;
+    }
+
+    // Split at the median centroid along the axis with the largest centroid extent.
+    const auto extent = c_hi - c_lo;
+    const auto centre_along = [&](const std::pair<vec3<double>, vec3<double>> &b) -> double {
+        const auto c = (b.first + b.second) * 0.5;
+        if( (extent.z >= extent.x) && (extent.z >= extent.y) ) return c.z;
+        if(extent.y >= extent.x) return c.y;
+        return c.x;
+    };
+
+    std::vector<long int> order(count);
+    for(long int i = 0; i < count; ++i) order[i] = first + i;
+    const long int half = count / 2;
+    std::nth_element(std::begin(order), std::next(std::begin(order), half), std::end(order),
+                     [&](long int L, long int R){ return centre_along(boxes[L]) < centre_along(boxes[R]); });
+
+    // Permute the boxes and images to match.
+    std::vector<std::pair<vec3<double>, vec3<double>>> boxes_sorted;
+    std::vector<planar_image<float,double>*> imgs_sorted;
+    boxes_sorted.reserve(count);
+    imgs_sorted.reserve(count);
+    for(const auto i : order){
+        boxes_sorted.push_back(boxes[i]);
+        imgs_sorted.push_back(this->bvh_imgs[i]);
+    }
+    std::copy(std::begin(boxes_sorted), std::end(boxes_sorted), std::next(std::begin(boxes), first));
+    std::copy(std::begin(imgs_sorted), std::end(imgs_sorted), std::next(std::begin(this->bvh_imgs), first));
+
+    const auto child = static_cast<long int>(this->bvh.size());
+    this->bvh[node].first = child;
+    this->bvh[node].count = 0;
+    this->bvh.emplace_back();
+    this->bvh.emplace_back();
+    this->build_bvh(boxes, child,     first,        half);
+    this->build_bvh(boxes, child + 1, first + half, count - half);
+    return;
+}
+
+std::vector<planar_image<float,double>*>
+image_volume_index::images_encompassing(const vec3<double> &P) const {
+    std::vector<planar_image<float,double>*> out;
+    this->for_each_image_encompassing(P, [&](planar_image<float,double> *img_ptr) -> void {
+        out.push_back(img_ptr);
+    });
+    return out;
+}
+
+planar_image<float,double>*
+image_volume_index::image_encompassing(const vec3<double> &P) const {
+    if(this->rectilinear && this->bvh.empty()){
+        return this->rectilinear->image_encompassing(P);
+    }
+
+    planar_image<float,double> *out = nullptr;
+    this->visit_candidates(P, [&](planar_image<float,double> *img_ptr) -> bool {
+        if(img_ptr->encompasses_point(P)){
+            out = img_ptr;
+            return false;
+        }
+        return true;
+    });
+    return out;
+}
+
+bool
+image_volume_index::is_current(const planar_image_collection<float,double> &imagecoll) const {
+    if(imagecoll.images.size() != this->geometry.size()) return false;
+
+    auto g_it = std::begin(this->geometry);
+    for(const auto &img : imagecoll.images){
+        const auto &g = *g_it;
+        if( (g.img != &img)
+        ||  (g.rows != img.rows)
+        ||  (g.columns != img.columns)
+        ||  (g.pxl_dx != img.pxl_dx)
+        ||  (g.pxl_dy != img.pxl_dy)
+        ||  (g.pxl_dz != img.pxl_dz)
+        ||  (g.anchor != img.anchor)
+        ||  (g.offset != img.offset)
+        ||  (g.row_unit != img.row_unit)
+        ||  (g.col_unit != img.col_unit) ){
+            return false;
+        }
+        ++g_it;
+    }
+    return true;
+}
+
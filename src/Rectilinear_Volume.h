@@ -0,0 +1,286 @@
+//Rectilinear_Volume.h - A part of DICOMautomaton 2021. Written by hal clark.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <list>
+#include <optional>
+#include <utility>            //Needed for std::pair.
+#include <vector>
+
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
+
+// An index over a collection of images that form a rectilinear grid.
+//
+// Images are ordered along the slice normal once, on construction, so that locating the voxel containing a point
+// requires only a handful of dot products and a binary search over slice boundaries rather than a linear scan over
+// all images. Slice thickness need not be uniform; slice boundaries are taken to be the midpoints between adjacent
+// image centres, and the outermost images extend pxl_dz/2 beyond their centres.
+//
+// Note that the index holds pointers to the indexed images. It must not outlive them, and it must be rebuilt if
+// images are added, removed, or moved.
+class rectilinear_volume_index {
+    public:
+        std::vector<planar_image<float,double>*> imgs; // Ordered along img_unit.
+
+        vec3<double> row_unit;
+        vec3<double> col_unit;
+        vec3<double> img_unit;
+        vec3<double> grid_zero; // Centre of the (0,0,0) voxel.
+
+        double pxl_dx = 0.0;
+        double pxl_dy = 0.0;
+
+        long int N_rows = 0;
+        long int N_cols = 0;
+        long int N_imgs = 0;
+
+        // The N_imgs+1 boundaries between slices, measured along img_unit relative to grid_zero.
+        std::vector<double> img_bounds;
+
+        // Throws if the images do not form a rectilinear grid.
+        explicit rectilinear_volume_index(std::list<std::reference_wrapper<planar_image<float,double>>> imgs);
+        explicit rectilinear_volume_index(planar_image_collection<float,double> &imagecoll);
+
+        // Locates the voxel containing the given point. Returns false if the point lies outside the volume.
+        bool index_of(const vec3<double> &P, long int &row, long int &col, long int &img) const;
+
+        // Returns the image containing the given point, or nullptr if the point lies outside the volume.
+        planar_image<float,double>* image_encompassing(const vec3<double> &P) const;
+
+        // Visits every voxel crossed by the line segment from A to B exactly once, in order from A to B.
+        //
+        // This is a 3D digital differential analyzer (i.e., Amanatides-Woo traversal). The segment is first clipped
+        // to the volume, so it may start and end outside it. The functor is invoked as
+        //
+        //     f(row, col, img, length, midpoint)
+        //
+        // where 'length' is the exact length of the segment within the voxel and 'midpoint' is the centre of that
+        // portion of the segment. Segments that merely graze a voxel edge or corner are not reported.
+        template <class Functor>
+        void traverse(const vec3<double> &A, const vec3<double> &B, Functor &&f) const;
+};
+
+
+// An index for locating the image(s) that contain a point, for arbitrary collections of images.
+//
+// When the images form a rectilinear grid of abutting slices, a rectilinear_volume_index is used. Otherwise (e.g., for
+// oblique, gapped, or overlapping images) a bounding volume hierarchy over the images is used, which still avoids
+// testing every image. A rectilinear grid with gapped or overlapping slices gets both: the rectilinear index for
+// traversal and the hierarchy for point lookups.
+//
+// The geometry of every image is recorded so that the index can later be checked against the collection it was built
+// from. Like rectilinear_volume_index, this index holds pointers to the indexed images.
+class image_volume_index {
+    public:
+        std::optional<rectilinear_volume_index> rectilinear; // Present only when images form a rectilinear grid.
+                                                             // Slice boundaries are midway between image centres.
+
+        explicit image_volume_index(planar_image_collection<float,double> &imagecoll);
+
+        // All images containing the point. Equivalent to planar_image_collection::get_images_which_encompass_point(),
+        // except that a point lying exactly on the face shared by two abutting slices is attributed to only one.
+        std::vector<planar_image<float,double>*> images_encompassing(const vec3<double> &P) const;
+
+        // The first image containing the point, or nullptr if there are none.
+        planar_image<float,double>* image_encompassing(const vec3<double> &P) const;
+
+        // Invokes f(planar_image<float,double> *) for each image containing the point, without allocating.
+        template <class Functor>
+        void for_each_image_encompassing(const vec3<double> &P, Functor &&f) const;
+
+        // Returns true iff the collection holds the same images, with the same geometry, as when indexed.
+        bool is_current(const planar_image_collection<float,double> &imagecoll) const;
+
+    private:
+        struct image_geometry {
+            const planar_image<float,double> *img;
+            long int rows;
+            long int columns;
+            double pxl_dx;
+            double pxl_dy;
+            double pxl_dz;
+            vec3<double> anchor;
+            vec3<double> offset;
+            vec3<double> row_unit;
+            vec3<double> col_unit;
+        };
+        std::vector<image_geometry> geometry;
+
+        struct bvh_node {
+            vec3<double> lo; // Axis-aligned bounding box.
+            vec3<double> hi;
+            long int first; // Range of bvh_imgs for leaves, or index of the first child for internal nodes.
+            long int count; // Number of images for leaves, or zero for internal nodes (children are first, first+1).
+        };
+        std::vector<bvh_node> bvh;
+        std::vector<planar_image<float,double>*> bvh_imgs;
+
+        void build_bvh(std::vector<std::pair<vec3<double>, vec3<double>>> &boxes, long int node, long int first, long int count);
+
+        template <class Functor>
+        void visit_candidates(const vec3<double> &P, Functor &&f) const;
+};
+
+
+template <class Functor>
+void
+rectilinear_volume_index::traverse(const vec3<double> &A,
+                                   const vec3<double> &B,
+                                   Functor &&f) const {
+    const auto dR = (B - A);
+    const auto seg_length = dR.length();
+    if( !(0.0 < seg_length) || !std::isfinite(seg_length) ) return;
+
+    // Work in local coordinates where voxel (i,j,k) spans [i*pxl_dx, (i+1)*pxl_dx) x [j*pxl_dy, (j+1)*pxl_dy)
+    // x [img_bounds[k], img_bounds[k+1]), and the segment is parameterized as p0 + t*d for t in [0,1].
+    const auto A_rel = (A - this->grid_zero);
+    const std::array<double,3> p0 = {{ A_rel.Dot(this->row_unit) + 0.5 * this->pxl_dx,
+                                       A_rel.Dot(this->col_unit) + 0.5 * this->pxl_dy,
+                                       A_rel.Dot(this->img_unit) }};
+    const std::array<double,3> d  = {{ dR.Dot(this->row_unit),
+                                       dR.Dot(this->col_unit),
+                                       dR.Dot(this->img_unit) }};
+    const std::array<double,3> lo = {{ 0.0,
+                                       0.0,
+                                       this->img_bounds.front() }};
+    const std::array<double,3> hi = {{ static_cast<double>(this->N_rows) * this->pxl_dx,
+                                       static_cast<double>(this->N_cols) * this->pxl_dy,
+                                       this->img_bounds.back() }};
+
+    // Clip the segment to the volume.
+    double t_enter = 0.0;
+    double t_exit  = 1.0;
+    for(size_t a = 0; a < 3; ++a){
+        if(d[a] == 0.0){
+            if( (p0[a] < lo[a]) || (hi[a] <= p0[a]) ) return;
+            continue;
+        }
+        auto t_lo = (lo[a] - p0[a]) / d[a];
+        auto t_hi = (hi[a] - p0[a]) / d[a];
+        if(t_hi < t_lo) std::swap(t_lo, t_hi);
+        t_enter = std::max(t_enter, t_lo);
+        t_exit  = std::min(t_exit, t_hi);
+    }
+    if( !(t_enter < t_exit) ) return;
+
+    // Locate the first voxel. Points lying exactly on a boundary are assigned to the voxel the ray is entering.
+    const auto clamp = [](long int x, long int N) -> long int {
+        return std::min(std::max(x, 0L), N - 1L);
+    };
+    std::array<double,3> p_enter;
+    for(size_t a = 0; a < 3; ++a) p_enter[a] = p0[a] + t_enter * d[a];
+
+    std::array<long int,3> ijk;
+    std::array<long int,3> step;
+    std::array<double,3> t_max;
+    std::array<double,3> t_delta;
+    const std::array<double,2> pxl_dl = {{ this->pxl_dx, this->pxl_dy }};
+    const std::array<long int,2> N_inplane = {{ this->N_rows, this->N_cols }};
+    const auto inf = std::numeric_limits<double>::infinity();
+
+    for(size_t a = 0; a < 2; ++a){
+        const auto x = p_enter[a] / pxl_dl[a];
+        auto i = static_cast<long int>(std::floor(x));
+        if( (d[a] < 0.0) && (static_cast<double>(i) == x) ) --i;
+        ijk[a] = clamp(i, N_inplane[a]);
+
+        step[a] = (d[a] < 0.0) ? -1L : 1L;
+        if(d[a] == 0.0){
+            t_max[a] = inf;
+            t_delta[a] = inf;
+        }else{
+            const auto next_bound = static_cast<double>(ijk[a] + ((0.0 < d[a]) ? 1L : 0L)) * pxl_dl[a];
+            t_max[a] = (next_bound - p0[a]) / d[a];
+            t_delta[a] = pxl_dl[a] / std::abs(d[a]);
+        }
+    }
+    {
+        const auto it = std::upper_bound(std::begin(this->img_bounds), std::end(this->img_bounds), p_enter[2]);
+        auto k = static_cast<long int>(std::distance(std::begin(this->img_bounds), it)) - 1L;
+        if( (d[2] < 0.0) && (0L <= k) && (this->img_bounds[k] == p_enter[2]) ) --k;
+        ijk[2] = clamp(k, this->N_imgs);
+
+        step[2] = (d[2] < 0.0) ? -1L : 1L;
+        t_delta[2] = inf; // Slice thickness can vary, so the next boundary is looked up explicitly.
+        t_max[2] = (d[2] == 0.0) ? inf
+                                 : (this->img_bounds[ijk[2] + ((0.0 < d[2]) ? 1L : 0L)] - p0[2]) / d[2];
+    }
+
+    // March through the volume. Every iteration advances one index monotonically, so this terminates after at most
+    // N_rows + N_cols + N_imgs iterations.
+    double t = t_enter;
+    while(true){
+        const auto t_next = std::min({ t_max[0], t_max[1], t_max[2], t_exit });
+        if(t < t_next){
+            const auto t_mid = 0.5 * (t + t_next);
+            f(ijk[0], ijk[1], ijk[2], (t_next - t) * seg_length, A + dR * t_mid);
+        }
+        if(t_exit <= t_next) break;
+
+        const size_t a = (t_max[0] <= t_max[1]) ? ((t_max[0] <= t_max[2]) ? 0 : 2)
+                                                : ((t_max[1] <= t_max[2]) ? 1 : 2);
+        ijk[a] += step[a];
+        if(a == 2){
+            if( (ijk[2] < 0L) || (this->N_imgs <= ijk[2]) ) break;
+            t_max[2] = (this->img_bounds[ijk[2] + ((0.0 < d[2]) ? 1L : 0L)] - p0[2]) / d[2];
+        }else{
+            if( (ijk[a] < 0L) || (N_inplane[a] <= ijk[a]) ) break;
+            t_max[a] += t_delta[a];
+        }
+        t = std::max(t, t_next);
+    }
+    return;
+}
+
+
+template <class Functor>
+void
+image_volume_index::visit_candidates(const vec3<double> &P, Functor &&f) const {
+    if(this->bvh.empty()) return;
+
+    std::vector<long int> stack;
+    stack.reserve(64);
+    stack.push_back(0);
+    while(!stack.empty()){
+        const auto &n = this->bvh[stack.back()];
+        stack.pop_back();
+        if( (P.x < n.lo.x) || (n.hi.x < P.x)
+        ||  (P.y < n.lo.y) || (n.hi.y < P.y)
+        ||  (P.z < n.lo.z) || (n.hi.z < P.z) ){
+            continue;
+        }
+        if(0 < n.count){
+            for(long int i = n.first; i < (n.first + n.count); ++i){
+                if(!f(this->bvh_imgs[i])) return;
+            }
+        }else{
+            stack.push_back(n.first + 1);
+            stack.push_back(n.first);
+        }
+    }
+    return;
+}
+
+template <class Functor>
+void
+image_volume_index::for_each_image_encompassing(const vec3<double> &P, Functor &&f) const {
+    if(this->rectilinear && this->bvh.empty()){
+        auto *img_ptr = this->rectilinear->image_encompassing(P);
+        if(img_ptr != nullptr) f(img_ptr);
+        return;
+    }
+
+    this->visit_candidates(P, [&](planar_image<float,double> *img_ptr) -> bool {
+        if(img_ptr->encompasses_point(P)) f(img_ptr);
+        return true;
+    });
+    return;
+}
+
@@ -2,21 +2,166 @@
 
 #include "Regex_Selectors.h"
 
+#include <algorithm>
 #include <string>
 #include <list>
 #include <initializer_list>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <optional>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "YgorString.h"
 #include "YgorMath.h"
 
 #include "Structs.h"
 
+// ---------------------------------- Metadata Index -----------------------------------
+//
+// Selectors are evaluated many times over the same metadata in a typical pipeline. Regexes are therefore compiled once
+// and cached. Metadata strings are interned for the duration of a single selection pass so that each distinct value
+// needs to be matched only once per pass. The interned strings are discarded afterward, so memory use is bounded by
+// the metadata being selected over rather than by everything ever selected.
+//
+// The per-object index itself is rebuilt on every selection pass, since metadata are held in plain maps that can be
+// modified at any time without notice.
+
+namespace {
+
+using interned_t = uint32_t;
+
+// A pool of interned metadata strings, scoped to a single selection pass.
+class metadata_string_pool {
+    private:
+        std::unordered_map<std::string, interned_t> ids;
+        std::vector<const std::string *> strings; // Indexed by interned ID. Map keys are never moved or removed.
+
+    public:
+        interned_t intern(const std::string &s){
+            const auto res = this->ids.emplace(s, static_cast<interned_t>(this->strings.size()));
+            if(res.second) this->strings.push_back( &(res.first->first) );
+            return res.first->second;
+        }
+
+        const std::string & get(interned_t id) const {
+            return *(this->strings.at(id));
+        }
+};
+
+// Returns the cached regex for the pattern, compiling it if necessary.
+std::shared_ptr<const std::regex> Get_Cached_Regex(const std::string &pattern){
+    static std::mutex m;
+    static std::map<std::string, std::shared_ptr<const std::regex>> cache;
+
+    std::lock_guard<std::mutex> lock(m);
+    auto it = cache.find(pattern);
+    if(it == std::end(cache)){
+        if(4096 < cache.size()) cache.clear(); // Guard against unbounded growth from generated patterns.
+        it = cache.emplace(pattern, std::make_shared<const std::regex>(pattern, std::regex::icase | 
+                                                                                std::regex::nosubs |
+                                                                                std::regex::optimize |
+                                                                                std::regex::extended)).first;
+    }
+    return it->second;
+}
+
+// Interns the value associated with a metadata key, if present.
+//
+// Consecutive objects often carry identical values, so the most recent value is remembered to avoid re-hashing it.
+class metadata_harvester {
+    private:
+        const std::string key;
+        metadata_string_pool &pool;
+        std::optional<std::pair<std::string, interned_t>> last;
+
+    public:
+        metadata_harvester(const std::string &key, metadata_string_pool &pool) : key(key), pool(pool) {}
+
+        void operator()(const std::map<std::string, std::string> &metadata, std::vector<interned_t> &ids){
+            const auto it = metadata.find(this->key);
+            if(it == std::end(metadata)) return;
+            if(!this->last || (this->last->first != it->second)){
+                this->last = std::make_pair(it->second, this->pool.intern(it->second));
+            }
+            ids.push_back(this->last->second);
+            return;
+        }
+};
+
+} // namespace.
+
 // ------------------------------------- Templates -------------------------------------
 
+// Whitelist objects using a single metadata key and value regex.
+//
+// The harvester appends the interned value(s) of the key for an object (duplicates are permitted) and returns false
+// if the object should be removed regardless of its metadata (e.g., because it is empty). Objects are retained iff all
+// harvested values match the regex. When pedantic, objects without any values are not treated as having an empty
+// value.
+//
+// A columnar index is built for the whole list first, along with an inverted index from each distinct value to the
+// objects carrying it, so each distinct value is matched against the regex only once. The pool must be the one used by
+// the harvester.
+template <class L, class H>
+L
+Whitelist_Metadata( L lops,
+                    const std::string &MetadataValueRegex,
+                    const Regex_Selector_Opts &Opts,
+                    bool pedantic,
+                    metadata_string_pool &pool,
+                    H harvest ){
+
+    const auto re = Get_Cached_Regex(MetadataValueRegex);
+
+    std::vector<uint8_t> keep(lops.size(), 1);
+    std::unordered_map<interned_t, std::vector<size_t>> inverted;
+    std::vector<interned_t> ids;
+    size_t i = 0;
+    for(const auto &l : lops){
+        ids.clear();
+        if(!harvest(l, ids)){
+            keep[i++] = 0;
+            continue;
+        }
+
+        if(ids.empty()){
+            if(Opts.nas == Regex_Selector_Opts::NAs::Include){
+                keep[i] = 1;
+            }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
+                keep[i] = 0;
+            }else if( (Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty) && !pedantic ){
+                ids.push_back( pool.intern("") );
+            }else{
+                throw std::logic_error("Regex selector NAs option not understood. Cannot continue.");
+            }
+        }
+
+        std::sort(std::begin(ids), std::end(ids));
+        ids.erase( std::unique(std::begin(ids), std::end(ids)), std::end(ids) );
+        for(const auto &id : ids) inverted[id].push_back(i);
+        ++i;
+    }
+
+    for(const auto &p : inverted){
+        if(!std::regex_match(pool.get(p.first), *re)){
+            for(const auto &j : p.second) keep[j] = 0;
+        }
+    }
+
+    L out;
+    i = 0;
+    for(const auto &l : lops){
+        if(keep[i++]) out.emplace_back(l);
+    }
+    return out;
+}
+
+
 // Whitelist image arrays or point clouds using a limited vocabulary of specifiers.
 // 
 // Note: Positional specifiers (e.g., "first") act on the current whitelist. 
@@ -219,12 +364,11 @@ Whitelist_Core( L lops,
 // --------------------------------------- Misc. ---------------------------------------
 
 // Compile and return a regex using the application-wide default settings.
+//
+// Note: compiled regexes are cached, so repeated compilation of the same pattern is cheap.
 std::regex
 Compile_Regex(const std::string& input){
-    return std::regex(input, std::regex::icase | 
-                             std::regex::nosubs |
-                             std::regex::optimize |
-                             std::regex::extended);
+    return *(Get_Cached_Regex(input));
 }
 
 // Human-readable information about how selectors can be specified.
@@ -272,48 +416,24 @@ Whitelist( std::list<std::reference_wrapper<contour_collection<double>>> ccs,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
-
-    ccs.remove_if([&](std::reference_wrapper<contour_collection<double>> cc) -> bool {
-        if(cc.get().contours.empty()) return true; // Remove collections containing no contours.
-
-        if(Opts.validation == Regex_Selector_Opts::Validation::Representative){
-            auto ValueOpt = cc.get().contours.front().GetMetadataValueAs<std::string>(MetadataKey);
-            if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                return false;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                return true;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
-            }
-            throw std::logic_error("Regex selector representative->NAs option not understood. Cannot continue.");
-
-        }else if(Opts.validation == Regex_Selector_Opts::Validation::Pedantic){
-            const auto Values = cc.get().get_distinct_values_for_key(MetadataKey);
+    const bool pedantic = (Opts.validation == Regex_Selector_Opts::Validation::Pedantic);
+    if(!pedantic && (Opts.validation != Regex_Selector_Opts::Validation::Representative)){
+        throw std::logic_error("Regex selector option not understood. Cannot continue.");
+    }
 
-            if(Values.empty()){
-                if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                    return false;
-                }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                    return true;
-                }
-                throw std::logic_error("Regex selector pedantic->NAs option not understood. Cannot continue.");
+    metadata_string_pool pool;
+    metadata_harvester harvest(MetadataKey, pool);
+    return Whitelist_Metadata(std::move(ccs), MetadataValueRegex, Opts, pedantic, pool,
+        [&](std::reference_wrapper<contour_collection<double>> cc, std::vector<interned_t> &ids) -> bool {
+            if(cc.get().contours.empty()) return false; // Remove collections containing no contours.
 
+            if(pedantic){
+                for(const auto &c : cc.get().contours) harvest(c.metadata, ids);
             }else{
-                for(const auto & Value : Values){
-                    if( !std::regex_match(Value,theregex) ) return true;
-                }
-                return false;
+                harvest(cc.get().contours.front().metadata, ids);
             }
-            throw std::logic_error("Regex selector pedantic option not understood. Cannot continue.");
-
-        }
-        throw std::logic_error("Regex selector option not understood. Cannot continue.");
-        return true; // Should never get here.
-    });
-    return ccs;
+            return true;
+        });
 }
 
 // This is a convenience routine to combine multiple filtering passes into a single logical statement.
@@ -402,49 +522,25 @@ Whitelist( std::list<std::list<std::shared_ptr<Image_Array>>::iterator> ias,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
-
-    ias.remove_if([&](std::list<std::shared_ptr<Image_Array>>::iterator iap_it) -> bool {
-        if((*iap_it) == nullptr) return true;
-        if((*iap_it)->imagecoll.images.empty()) return true; // Remove arrays containing no images.
-
-        if(Opts.validation == Regex_Selector_Opts::Validation::Representative){
-            auto ValueOpt = (*iap_it)->imagecoll.images.front().GetMetadataValueAs<std::string>(MetadataKey);
-            if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                return false;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                return true;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
-            }
-            throw std::logic_error("Regex selector representative->NAs option not understood. Cannot continue.");
-
-        }else if(Opts.validation == Regex_Selector_Opts::Validation::Pedantic){
-            const auto Values = (*iap_it)->imagecoll.get_distinct_values_for_key(MetadataKey);
+    const bool pedantic = (Opts.validation == Regex_Selector_Opts::Validation::Pedantic);
+    if(!pedantic && (Opts.validation != Regex_Selector_Opts::Validation::Representative)){
+        throw std::logic_error("Regex selector option not understood. Cannot continue.");
+    }
 
-            if(Values.empty()){
-                if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                    return false;
-                }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                    return true;
-                }
-                throw std::logic_error("Regex selector pedantic->NAs option not understood. Cannot continue.");
+    metadata_string_pool pool;
+    metadata_harvester harvest(MetadataKey, pool);
+    return Whitelist_Metadata(std::move(ias), MetadataValueRegex, Opts, pedantic, pool,
+        [&](std::list<std::shared_ptr<Image_Array>>::iterator iap_it, std::vector<interned_t> &ids) -> bool {
+            if((*iap_it) == nullptr) return false;
+            if((*iap_it)->imagecoll.images.empty()) return false; // Remove arrays containing no images.
 
+            if(pedantic){
+                for(const auto &img : (*iap_it)->imagecoll.images) harvest(img.metadata, ids);
             }else{
-                for(const auto & Value : Values){
-                    if( !std::regex_match(Value,theregex) ) return true;
-                }
-                return false;
+                harvest((*iap_it)->imagecoll.images.front().metadata, ids);
             }
-            throw std::logic_error("Regex selector pedantic option not understood. Cannot continue.");
-
-        }
-        throw std::logic_error("Regex selector option not understood. Cannot continue.");
-        return true; // Should never get here.
-    });
-    return ias;
+            return true;
+        });
 }
 
 // Whitelist image arrays using a limited vocabulary of specifiers.
@@ -512,33 +608,23 @@ Whitelist( std::list<std::list<std::shared_ptr<Point_Cloud>>::iterator> pcs,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
-
-    pcs.remove_if([&](std::list<std::shared_ptr<Point_Cloud>>::iterator pcp_it) -> bool {
-        if((*pcp_it) == nullptr) return true;
-        if((*pcp_it)->pset.points.empty()) return true; // Remove arrays containing no images.
-
-        if( // Note: Point_Clouds are dissimilar to Image_Arrays in that individual images can have different
-                  //       metadata, but point clouds cannot. We keep these options for consistency.
-                  (Opts.validation == Regex_Selector_Opts::Validation::Representative)
-              ||  (Opts.validation == Regex_Selector_Opts::Validation::Pedantic)        ){
-
-            auto ValueOpt = (*pcp_it)->pset.GetMetadataValueAs<std::string>(MetadataKey);
-            if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                return false;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                return true;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
-            }
-            throw std::logic_error("NAs option not understood. Cannot continue.");
-        }
+    if( (Opts.validation != Regex_Selector_Opts::Validation::Representative)
+    &&  (Opts.validation != Regex_Selector_Opts::Validation::Pedantic) ){
         throw std::logic_error("Regex selector option not understood. Cannot continue.");
-        return true; // Should never get here.
-    });
-    return pcs;
+    }
+
+    metadata_string_pool pool;
+    metadata_harvester harvest(MetadataKey, pool);
+    return Whitelist_Metadata(std::move(pcs), MetadataValueRegex, Opts, false, pool,
+        [&](std::list<std::shared_ptr<Point_Cloud>>::iterator pcp_it, std::vector<interned_t> &ids) -> bool {
+            if((*pcp_it) == nullptr) return false;
+            if((*pcp_it)->pset.points.empty()) return false; // Remove arrays containing no images.
+
+            // Note: Point_Clouds are dissimilar to Image_Arrays in that individual images can have different
+            //       metadata, but point clouds cannot. Both validation options are therefore equivalent.
+            harvest((*pcp_it)->pset.metadata, ids);
+            return true;
+        });
 }
 
 
@@ -611,39 +697,26 @@ Whitelist( std::list<std::list<std::shared_ptr<Surface_Mesh>>::iterator> sms,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
-
-    sms.remove_if([&](std::list<std::shared_ptr<Surface_Mesh>>::iterator smp_it) -> bool {
-        if((*smp_it) == nullptr) return true;
-        if((*smp_it)->meshes.vertices.empty()) return true; // Remove meshes containing no vertices.
-        if((*smp_it)->meshes.faces.empty()) return true; // Remove meshes containing no faces.
-
-        if( // Note: A single Surface_Mesh corresponds to one individual metadata store. While a single
-                  //       Surface_Mesh can be comprised of multiple disconnected meshes, they are herein considered
-                  //       to be part of the same logical group. As for Point_Clouds, we keep the following options for
-                  //       consistency.
-                  (Opts.validation == Regex_Selector_Opts::Validation::Representative)
-              ||  (Opts.validation == Regex_Selector_Opts::Validation::Pedantic)        ){
-
-            std::optional<std::string> ValueOpt 
-                    = ( (*smp_it)->meshes.metadata.count(MetadataKey) != 0 ) ?
-                      (*smp_it)->meshes.metadata[MetadataKey] :
-                      std::optional<std::string>();
-            if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                return false;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                return true;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
-            }
-            throw std::logic_error("NAs option not understood. Cannot continue.");
-        }
+    if( (Opts.validation != Regex_Selector_Opts::Validation::Representative)
+    &&  (Opts.validation != Regex_Selector_Opts::Validation::Pedantic) ){
         throw std::logic_error("Regex selector option not understood. Cannot continue.");
-        return true; // Should never get here.
-    });
-    return sms;
+    }
+
+    metadata_string_pool pool;
+    metadata_harvester harvest(MetadataKey, pool);
+    return Whitelist_Metadata(std::move(sms), MetadataValueRegex, Opts, false, pool,
+        [&](std::list<std::shared_ptr<Surface_Mesh>>::iterator smp_it, std::vector<interned_t> &ids) -> bool {
+            if((*smp_it) == nullptr) return false;
+            if((*smp_it)->meshes.vertices.empty()) return false; // Remove meshes containing no vertices.
+            if((*smp_it)->meshes.faces.empty()) return false; // Remove meshes containing no faces.
+
+            // Note: A single Surface_Mesh corresponds to one individual metadata store. While a single
+            //       Surface_Mesh can be comprised of multiple disconnected meshes, they are herein considered
+            //       to be part of the same logical group. As for Point_Clouds, both validation options are
+            //       therefore equivalent.
+            harvest((*smp_it)->meshes.metadata, ids);
+            return true;
+        });
 }
 
 
@@ -716,40 +789,26 @@ Whitelist( std::list<std::list<std::shared_ptr<TPlan_Config>>::iterator> tps,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
-
-    tps.remove_if([&](std::list<std::shared_ptr<TPlan_Config>>::iterator tpp_it) -> bool {
-        if((*tpp_it) == nullptr) return true;
-        if((*tpp_it)->dynamic_states.empty()) return true; // Remove plans containing no beams.
-
-        if( // Note: A TPlan_Config corresponds to one individual metadata store. While a single
-                  //       TPlan_Config can be comprised of multiple disconnected beams, they are 
-                  //       herein considered to be part of the same logical group.
-                  (Opts.validation == Regex_Selector_Opts::Validation::Representative)
-              ||  (Opts.validation == Regex_Selector_Opts::Validation::Pedantic)        ){
-
-            std::optional<std::string> ValueOpt 
-                    = ( (*tpp_it)->metadata.count(MetadataKey) != 0 ) ?
-                      (*tpp_it)->metadata[MetadataKey] :
-                      std::optional<std::string>();
+    if( (Opts.validation != Regex_Selector_Opts::Validation::Representative)
+    &&  (Opts.validation != Regex_Selector_Opts::Validation::Pedantic) ){
+        throw std::logic_error("Regex selector option not understood. Cannot continue.");
+    }
 
+    metadata_string_pool pool;
+    metadata_harvester harvest(MetadataKey, pool);
+    return Whitelist_Metadata(std::move(tps), MetadataValueRegex, Opts, false, pool,
+        [&](std::list<std::shared_ptr<TPlan_Config>>::iterator tpp_it, std::vector<interned_t> &ids) -> bool {
+            if((*tpp_it) == nullptr) return false;
+            if((*tpp_it)->dynamic_states.empty()) return false; // Remove plans containing no beams.
+
+            // Note: A TPlan_Config corresponds to one individual metadata store. While a single
+            //       TPlan_Config can be comprised of multiple disconnected beams, they are 
+            //       herein considered to be part of the same logical group.
+            //
             // TODO: support selection of Dynamic_Machine_State and Static_Machine_State metadata too.
-
-            if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                return false;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                return true;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
-            }
-            throw std::logic_error("NAs option not understood. Cannot continue.");
-        }
-        throw std::logic_error("Regex selector option not understood. Cannot continue.");
-        return true; // Should never get here.
-    });
-    return tps;
+            harvest((*tpp_it)->metadata, ids);
+            return true;
+        });
 }
 
 
@@ -821,36 +880,23 @@ Whitelist( std::list<std::list<std::shared_ptr<Line_Sample>>::iterator> lss,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
-
-    lss.remove_if([&](std::list<std::shared_ptr<Line_Sample>>::iterator lsp_it) -> bool {
-        if((*lsp_it) == nullptr) return true;
-        if((*lsp_it)->line.samples.empty()) return true; // Remove arrays containing no samples.
-
-        if( // Note: Line_Samples are dissimilar to Image_Arrays in that individual images can have different
-                  //       metadata, but point clouds cannot. We keep these options for consistency.
-                  (Opts.validation == Regex_Selector_Opts::Validation::Representative)
-              ||  (Opts.validation == Regex_Selector_Opts::Validation::Pedantic)        ){
-
-            std::optional<std::string> ValueOpt 
-                    = ( (*lsp_it)->line.metadata.count(MetadataKey) != 0 ) ?
-                      (*lsp_it)->line.metadata[MetadataKey] :
-                      std::optional<std::string>();
-            if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                return false;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                return true;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
-            }
-            throw std::logic_error("NAs option not understood. Cannot continue.");
-        }
+    if( (Opts.validation != Regex_Selector_Opts::Validation::Representative)
+    &&  (Opts.validation != Regex_Selector_Opts::Validation::Pedantic) ){
         throw std::logic_error("Regex selector option not understood. Cannot continue.");
-        return true; // Should never get here.
-    });
-    return lss;
+    }
+
+    metadata_string_pool pool;
+    metadata_harvester harvest(MetadataKey, pool);
+    return Whitelist_Metadata(std::move(lss), MetadataValueRegex, Opts, false, pool,
+        [&](std::list<std::shared_ptr<Line_Sample>>::iterator lsp_it, std::vector<interned_t> &ids) -> bool {
+            if((*lsp_it) == nullptr) return false;
+            if((*lsp_it)->line.samples.empty()) return false; // Remove arrays containing no samples.
+
+            // Note: Line_Samples are dissimilar to Image_Arrays in that individual images can have different
+            //       metadata, but line samples cannot. Both validation options are therefore equivalent.
+            harvest((*lsp_it)->line.metadata, ids);
+            return true;
+        });
 }
 
 
@@ -920,34 +966,21 @@ Whitelist( std::list<std::list<std::shared_ptr<Transform3>>::iterator> t3s,
            std::string MetadataValueRegex,
            Regex_Selector_Opts Opts ){
 
-    auto theregex = Compile_Regex(std::move(MetadataValueRegex));
-
-    t3s.remove_if([&](std::list<std::shared_ptr<Transform3>>::iterator t3p_it) -> bool {
-        if((*t3p_it) == nullptr) return true;
-        if(std::holds_alternative<std::monostate>( (*t3p_it)->transform )) return true; // Remove empty transforms.
+    if( (Opts.validation != Regex_Selector_Opts::Validation::Representative)
+    &&  (Opts.validation != Regex_Selector_Opts::Validation::Pedantic) ){
+        throw std::logic_error("Regex selector option not understood. Cannot continue.");
+    }
 
-        if( (Opts.validation == Regex_Selector_Opts::Validation::Representative)
-              ||  (Opts.validation == Regex_Selector_Opts::Validation::Pedantic)        ){
+    metadata_string_pool pool;
+    metadata_harvester harvest(MetadataKey, pool);
+    return Whitelist_Metadata(std::move(t3s), MetadataValueRegex, Opts, false, pool,
+        [&](std::list<std::shared_ptr<Transform3>>::iterator t3p_it, std::vector<interned_t> &ids) -> bool {
+            if((*t3p_it) == nullptr) return false;
+            if(std::holds_alternative<std::monostate>( (*t3p_it)->transform )) return false; // Remove empty transforms.
 
-            std::optional<std::string> ValueOpt 
-                    = ( (*t3p_it)->metadata.count(MetadataKey) != 0 ) ?
-                      (*t3p_it)->metadata[MetadataKey] :
-                      std::optional<std::string>();
-            if(ValueOpt){
-                return !(std::regex_match(ValueOpt.value(),theregex));
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Include){
-                return false;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::Exclude){
-                return true;
-            }else if(Opts.nas == Regex_Selector_Opts::NAs::TreatAsEmpty){
-                return !(std::regex_match("",theregex));
-            }
-            throw std::logic_error("NAs option not understood. Cannot continue.");
-        }
-        throw std::logic_error("Regex selector option not understood. Cannot continue.");
-        return true; // Should never get here.
-    });
-    return t3s;
+            harvest((*t3p_it)->metadata, ids);
+            return true;
+        });
 }
 
 
@@ -0,0 +1,256 @@
+//Scanline_Rasterizer.cc - A part of DICOMautomaton 2021. Written by hal clark.
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <utility>            //Needed for std::pair.
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorImages.h"
+
+#include "Scanline_Rasterizer.h"
+
+
+namespace {
+
+// A contour edge in continuous voxel coordinates, i.e., voxel (r,c) has its centre at (a,b) = (r,c).
+// Edges are oriented so that a0 < a1; edges parallel to the scanlines are discarded.
+struct raster_edge {
+    double a0;
+    double b0;
+    double a1;
+    double b1;
+    size_t contour;
+};
+
+// The crossing of an edge with a scanline.
+struct raster_crossing {
+    long int s;
+    double b;
+    size_t contour;
+};
+
+// An interior interval [b0, b1) along a scanline.
+struct raster_interval {
+    long int s;
+    double b0;
+    double b1;
+};
+
+// Finds the crossings of all edges with the scanlines a = a_first + s*step, for integer s in [0, N_s).
+//
+// An edge crosses a scanline when a0 <= a < a1, i.e., the lower vertex is included and the upper vertex is not.
+// This half-open rule ensures vertices shared by two edges are counted correctly, so each scanline has an even number
+// of crossings. Crossings are returned sorted by scanline and then by position along the scanline.
+std::vector<raster_crossing>
+scanline_crossings(const std::vector<raster_edge> &edges, double a_first, double step, long int N_s){
+    std::vector<raster_crossing> out;
+    for(const auto &e : edges){
+        // Widen the range by one scanline to guard against rounding; the exact test below decides.
+        const auto s_lo_f = std::ceil((e.a0 - a_first) / step) - 1.0;
+        const auto s_hi_f = std::ceil((e.a1 - a_first) / step);
+        if( (s_hi_f < 0.0) || (static_cast<double>(N_s) <= s_lo_f) ) continue;
+
+        const auto s_lo = std::max(0L, static_cast<long int>(s_lo_f));
+        const auto s_hi = std::min(N_s - 1L, static_cast<long int>(s_hi_f));
+        const auto slope = (e.b1 - e.b0) / (e.a1 - e.a0);
+        for(long int s = s_lo; s <= s_hi; ++s){
+            const auto a = a_first + step * static_cast<double>(s);
+            if( (a < e.a0) || (e.a1 <= a) ) continue;
+            out.push_back( { s, e.b0 + (a - e.a0) * slope, e.contour } );
+        }
+    }
+    std::sort(std::begin(out), std::end(out), [](const raster_crossing &L, const raster_crossing &R){
+        return (L.s != R.s) ? (L.s < R.s) : (L.b < R.b);
+    });
+    return out;
+}
+
+// Converts sorted crossings into interior intervals, sorted by scanline and then by position along the scanline.
+//
+// The parity rule is applied to each contour individually. If overlapping contours cancel, the parity rule is also
+// applied across contours; otherwise a point is interior if it is interior to any contour.
+std::vector<raster_interval>
+scanline_intervals(const std::vector<raster_crossing> &crossings, size_t N_contours, bool overlapping_contours_cancel){
+    std::vector<raster_interval> out;
+    std::vector<char> inside(N_contours, 0);
+    auto it = std::begin(crossings);
+    const auto end = std::end(crossings);
+    while(it != end){
+        const auto s = it->s;
+        const auto s_begin = it;
+        long int N_inside = 0;
+        bool was_interior = false;
+        double b_enter = 0.0;
+        for( ; (it != end) && (it->s == s); ++it){
+            auto &in = inside[it->contour];
+            in = (in == 0) ? 1 : 0;
+            N_inside += (in == 0) ? -1 : 1;
+
+            const bool is_interior = (overlapping_contours_cancel) ? ((N_inside % 2) == 1)
+                                                                   : (0 < N_inside);
+            if(is_interior && !was_interior){
+                b_enter = it->b;
+            }else if(!is_interior && was_interior){
+                out.push_back( { s, b_enter, it->b } );
+            }
+            was_interior = is_interior;
+        }
+
+        // Contours that were never closed along this scanline (e.g., due to non-finite vertices) are discarded.
+        for(auto r_it = s_begin; r_it != it; ++r_it) inside[r_it->contour] = 0;
+    }
+    return out;
+}
+
+} // namespace.
+
+
+double contour_raster::fraction(long int row, long int col) const {
+    const auto c_it = std::lower_bound(std::begin(this->coverage), std::end(this->coverage), std::make_pair(row, col),
+                                       [](const raster_coverage &x, const std::pair<long int, long int> &rc){
+                                           return (x.row != rc.first) ? (x.row < rc.first) : (x.col < rc.second);
+                                       });
+    if( (c_it != std::end(this->coverage)) && (c_it->row == row) && (c_it->col == col) ) return c_it->fraction;
+
+    const auto s_it = std::partition_point(std::begin(this->spans), std::end(this->spans), [row,col](const raster_span &x){
+                                               return (x.row < row) || ((x.row == row) && (x.col_end <= col));
+                                           });
+    if( (s_it != std::end(this->spans)) && (s_it->row == row) && (s_it->col_begin <= col) ) return 1.0;
+    return 0.0;
+}
+
+
+contour_raster
+Rasterize_Contour(const planar_image<float,double> &img,
+                  const contour_of_points<double> &contour,
+                  long int coverage_samples){
+    return Rasterize_Contours(img, { std::cref(contour) }, false, coverage_samples);
+}
+
+
+contour_raster
+Rasterize_Contours(const planar_image<float,double> &img,
+                   const std::vector<std::reference_wrapper<const contour_of_points<double>>> &contours,
+                   bool overlapping_contours_cancel,
+                   long int coverage_samples){
+    contour_raster out;
+    if( (img.rows <= 0) || (img.columns <= 0) ) return out;
+
+    const auto zero = img.position(0,0);
+    const auto row_unit = img.row_unit.unit();
+    const auto col_unit = img.col_unit.unit();
+
+    // Build the edge table. Each contour is implicitly closed.
+    const auto inf = std::numeric_limits<double>::infinity();
+    double b_min = inf;
+    double b_max = -inf;
+    std::vector<raster_edge> edges;
+    std::vector<std::pair<double,double>> verts;
+    for(size_t n = 0; n < contours.size(); ++n){
+        const auto &contour = contours[n].get();
+        if(contour.points.size() < 3) continue;
+
+        // Project the vertices into continuous voxel coordinates.
+        verts.clear();
+        for(const auto &p : contour.points){
+            const auto d = (p - zero);
+            verts.emplace_back( d.Dot(row_unit) / img.pxl_dx, d.Dot(col_unit) / img.pxl_dy );
+        }
+
+        for(size_t i = 0; i < verts.size(); ++i){
+            const auto &v0 = verts[i];
+            const auto &v1 = verts[(i + 1) % verts.size()];
+            if( !std::isfinite(v0.first) || !std::isfinite(v0.second)
+            ||  !std::isfinite(v1.first) || !std::isfinite(v1.second) ) continue;
+            b_min = std::min(b_min, v0.second);
+            b_max = std::max(b_max, v0.second);
+            if(v0.first == v1.first) continue;
+            if(v0.first < v1.first){
+                edges.push_back( { v0.first, v0.second, v1.first, v1.second, n } );
+            }else{
+                edges.push_back( { v1.first, v1.second, v0.first, v0.second, n } );
+            }
+        }
+    }
+    if(edges.empty()) return out;
+
+    // Voxels with centres in an interior interval along their row are interior.
+    for(const auto &x : scanline_intervals(scanline_crossings(edges, 0.0, 1.0, img.rows),
+                                           contours.size(), overlapping_contours_cancel)){
+        const auto c_begin = std::clamp(std::ceil(x.b0), 0.0, static_cast<double>(img.columns));
+        const auto c_end = std::clamp(std::ceil(x.b1), 0.0, static_cast<double>(img.columns));
+        if(c_begin < c_end){
+            out.spans.push_back( { x.s, static_cast<long int>(c_begin), static_cast<long int>(c_end) } );
+        }
+    }
+    if(coverage_samples <= 0) return out;
+
+    // Estimate fractional coverage using sub-scanlines. Along each sub-scanline coverage is exact, so a voxel's coverage
+    // is the mean covered length of its sub-scanlines.
+    const auto S = coverage_samples;
+    const auto c_lo = std::max(0L, static_cast<long int>(std::floor(b_min + 0.5)));
+    const auto c_hi = std::min(img.columns - 1L, static_cast<long int>(std::floor(b_max + 0.5)));
+    if(c_hi < c_lo) return out;
+    const auto N_c = static_cast<size_t>(c_hi - c_lo + 1);
+
+    const auto sub_intervals = scanline_intervals(scanline_crossings(edges, -0.5 + 0.5 / static_cast<double>(S),
+                                                                     1.0 / static_cast<double>(S), img.rows * S),
+                                                  contours.size(), overlapping_contours_cancel);
+
+    // Rows to visit: those with interior voxels or with any interior sub-scanline intervals.
+    std::vector<long int> rows;
+    for(const auto &s : out.spans) rows.push_back(s.row);
+    for(const auto &x : sub_intervals) rows.push_back(x.s / S);
+    std::sort(std::begin(rows), std::end(rows));
+    rows.erase(std::unique(std::begin(rows), std::end(rows)), std::end(rows));
+    std::vector<double> cov(N_c);
+    std::vector<double> status(N_c);
+    auto span_it = std::begin(out.spans);
+    auto sub_it = std::begin(sub_intervals);
+    for(const auto row : rows){
+        std::fill(std::begin(cov), std::end(cov), 0.0);
+        std::fill(std::begin(status), std::end(status), 0.0);
+
+        while( (span_it != std::end(out.spans)) && (span_it->row < row) ) ++span_it;
+        for( ; (span_it != std::end(out.spans)) && (span_it->row == row); ++span_it){
+            for(auto c = std::max(span_it->col_begin, c_lo); c < std::min(span_it->col_end, c_hi + 1L); ++c){
+                status[static_cast<size_t>(c - c_lo)] = 1.0;
+            }
+        }
+
+        // Accumulate the covered length of each interval. Voxel c spans [c - 0.5, c + 0.5).
+        const auto add_interval = [&](double b0, double b1) -> void {
+            b0 = std::max(b0, static_cast<double>(c_lo) - 0.5);
+            b1 = std::min(b1, static_cast<double>(c_hi) + 0.5);
+            if(b1 <= b0) return;
+            const auto first = std::clamp(static_cast<long int>(std::floor(b0 + 0.5)), c_lo, c_hi);
+            const auto last = std::clamp(static_cast<long int>(std::floor(b1 + 0.5)), c_lo, c_hi);
+            if(first == last){
+                cov[static_cast<size_t>(first - c_lo)] += (b1 - b0);
+                return;
+            }
+            cov[static_cast<size_t>(first - c_lo)] += (static_cast<double>(first) + 0.5 - b0);
+            for(auto c = first + 1L; c < last; ++c) cov[static_cast<size_t>(c - c_lo)] += 1.0;
+            cov[static_cast<size_t>(last - c_lo)] += (b1 - (static_cast<double>(last) - 0.5));
+            return;
+        };
+
+        while( (sub_it != std::end(sub_intervals)) && ((sub_it->s / S) < row) ) ++sub_it;
+        for( ; (sub_it != std::end(sub_intervals)) && ((sub_it->s / S) == row); ++sub_it){
+            add_interval(sub_it->b0, sub_it->b1);
+        }
+
+        for(size_t i = 0; i < N_c; ++i){
+            const auto fraction = std::clamp(cov[i] / static_cast<double>(S), 0.0, 1.0);
+            if(1.0E-9 < std::abs(fraction - status[i])){
+                out.coverage.push_back( { row, c_lo + static_cast<long int>(i), fraction } );
+            }
+        }
+    }
+    return out;
+}
+
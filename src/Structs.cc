@@ -4,9 +4,11 @@
 #include <array>
 #include <cmath>
 #include <cstdint>   //For int64_t.
+#include <cstring>   //For std::memcpy.
 #include <optional>
 #include <functional>
 #include <initializer_list>
+#include <limits>
 #include <map>
 #include <ostream>
 #include <stdexcept>
@@ -30,6 +32,10 @@
 
 #include "Structs.h"
 #include "Dose_Meld.h"
+#include "Rectilinear_Volume.h"
+#include "Image_Signature.h"
+#include "Scanline_Rasterizer.h"
+#include "Thread_Pool.h"
 
 //This is a mapping from the segmentation history to a human-readable description.
 // Try avoid using commas or tabs to make dumping as csv easier. This should in
@@ -117,12 +123,146 @@ std::string Segmentations_to_Words(const std::vector<uint32_t> &in){
 
 
 
+//-----------------------------------------------------------------------------------------------------
+//----------------------------------------- contour_roi_index -----------------------------------------
+//-----------------------------------------------------------------------------------------------------
+//Hashes the vertices of a contour so that in-place edits can be detected.
+static uint64_t contour_vertex_hash(const contour_of_points<double> &c){
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for(const auto &p : c.points){
+        for(const double x : { p.x, p.y, p.z }){
+            uint64_t bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+            bits ^= (bits >> 30);
+            bits *= 0xbf58476d1ce4e5b9ULL;
+            bits ^= (bits >> 27);
+            bits *= 0x94d049bb133111ebULL;
+            bits ^= (bits >> 31);
+            h = (h ^ bits) * 0x100000001b3ULL;
+        }
+    }
+    return h;
+}
+
+contour_roi_index::contour_roi_index(const std::list<contour_collection<double>> &ccs){
+    const auto inf = std::numeric_limits<double>::infinity();
+
+    this->rois.reserve(ccs.size());
+    for(const auto &cc : ccs){
+        this->rois.emplace_back();
+        auto &roi = this->rois.back();
+        roi.cc = &cc;
+
+        //Use the first contour that admits a sensible planar normal to orient the whole collection.
+        for(const auto &c : cc.contours){
+            if(c.points.size() < 3) continue;
+            try{
+                const auto N = c.Estimate_Planar_Normal().unit();
+                if(N.isfinite()){
+                    roi.normal = N;
+                    break;
+                }
+            }catch(const std::exception &){ }
+        }
+
+        roi.bbox_min = vec3<double>( inf,  inf,  inf);
+        roi.bbox_max = vec3<double>(-inf, -inf, -inf);
+        roi.planes.reserve(cc.contours.size());
+        for(const auto &c : cc.contours){
+            this->signatures.push_back({ &c, c.points.size(), contour_vertex_hash(c) });
+            if(c.points.empty()) continue;
+
+            double offset = 0.0;
+            for(const auto &p : c.points){
+                roi.bbox_min.x = std::min(roi.bbox_min.x, p.x);
+                roi.bbox_min.y = std::min(roi.bbox_min.y, p.y);
+                roi.bbox_min.z = std::min(roi.bbox_min.z, p.z);
+                roi.bbox_max.x = std::max(roi.bbox_max.x, p.x);
+                roi.bbox_max.y = std::max(roi.bbox_max.y, p.y);
+                roi.bbox_max.z = std::max(roi.bbox_max.z, p.z);
+                offset += p.Dot(roi.normal);
+            }
+            roi.N_vertices += c.points.size();
+            roi.planes.emplace_back( offset / static_cast<double>(c.points.size()), &c );
+        }
+        std::stable_sort(roi.planes.begin(), roi.planes.end(),
+                         [](const plane_entry &A, const plane_entry &B) -> bool {
+                             return (A.first < B.first);
+                         });
+
+        this->roi_lookup[&cc] = this->rois.size() - 1;
+    }
+}
+
+std::pair<std::vector<contour_roi_index::plane_entry>::const_iterator,
+          std::vector<contour_roi_index::plane_entry>::const_iterator>
+contour_roi_index::roi_summary::contours_between(double lo, double hi) const {
+    const auto beg = std::lower_bound(this->planes.begin(), this->planes.end(), lo,
+                                      [](const plane_entry &A, double x) -> bool { return (A.first < x); });
+    const auto end = std::upper_bound(beg, this->planes.end(), hi,
+                                      [](double x, const plane_entry &A) -> bool { return (x < A.first); });
+    return { beg, end };
+}
+
+bool contour_roi_index::roi_summary::bbox_overlaps(const vec3<double> &min,
+                                                  const vec3<double> &max,
+                                                  double margin) const {
+    if(this->N_vertices == 0) return false;
+    return !( (max.x < (this->bbox_min.x - margin)) || ((this->bbox_max.x + margin) < min.x)
+           || (max.y < (this->bbox_min.y - margin)) || ((this->bbox_max.y + margin) < min.y)
+           || (max.z < (this->bbox_min.z - margin)) || ((this->bbox_max.z + margin) < min.z) );
+}
+
+std::pair<double, double> contour_roi_index::roi_summary::extent_along(const vec3<double> &unit) const {
+    //The extremes of a box along any direction are attained at its corners.
+    const auto inf = std::numeric_limits<double>::infinity();
+    std::pair<double, double> out = { inf, -inf };
+    for(const auto x : { this->bbox_min.x, this->bbox_max.x }){
+        for(const auto y : { this->bbox_min.y, this->bbox_max.y }){
+            for(const auto z : { this->bbox_min.z, this->bbox_max.z }){
+                const auto d = vec3<double>(x, y, z).Dot(unit);
+                out.first = std::min(out.first, d);
+                out.second = std::max(out.second, d);
+            }
+        }
+    }
+    return out;
+}
+
+const contour_roi_index::roi_summary* contour_roi_index::get(const contour_collection<double> *cc) const {
+    const auto it = this->roi_lookup.find(cc);
+    return (it == this->roi_lookup.end()) ? nullptr : &(this->rois[it->second]);
+}
+
+bool contour_roi_index::is_current(const std::list<contour_collection<double>> &ccs) const {
+    if(ccs.size() != this->rois.size()) return false;
+
+    auto roi_it = this->rois.begin();
+    auto sig_it = this->signatures.begin();
+    for(const auto &cc : ccs){
+        if(roi_it->cc != &cc) return false;
+        ++roi_it;
+
+        for(const auto &c : cc.contours){
+            if( (sig_it == this->signatures.end())
+            ||  (sig_it->c != &c)
+            ||  (sig_it->N_points != c.points.size())
+            ||  (sig_it->vertex_hash != contour_vertex_hash(c)) ){
+                return false;
+            }
+            ++sig_it;
+        }
+    }
+    return (sig_it == this->signatures.end());
+}
+
+
 //-----------------------------------------------------------------------------------------------------
 //-------------------------------------------- Contour_Data -------------------------------------------
 //-----------------------------------------------------------------------------------------------------
 //Constructors.
 Contour_Data::Contour_Data() = default;
-Contour_Data::Contour_Data(const Contour_Data &in) = default;
+Contour_Data::Contour_Data(const Contour_Data &in) : ccs(in.ccs) {}
 
 //Member functions.
 void Contour_Data::operator=(const Contour_Data &rhs){
@@ -130,6 +270,15 @@ void Contour_Data::operator=(const Contour_Data &rhs){
     return;
 }
 
+std::shared_ptr<const contour_roi_index> Contour_Data::get_roi_index(){
+    std::lock_guard<std::mutex> lock(this->roi_index_mutex);
+    if( (this->roi_index == nullptr)
+    ||  !this->roi_index->is_current(this->ccs) ){
+        this->roi_index = std::make_shared<const contour_roi_index>(this->ccs);
+    }
+    return this->roi_index;
+}
+
 //This routine produces a very simple, default plot of the entirety of the data. 
 // If individual contour plots are required, use the contour_of_points::Plot() method instead.
 void Contour_Data::Plot() const {
@@ -535,6 +684,24 @@ Image_Array & Image_Array::operator=(const Image_Array &rhs){
     return *this;
 }
 
+std::shared_ptr<const image_volume_index> Image_Array::get_volume_index(){
+    std::lock_guard<std::mutex> lock(this->volume_index_mutex);
+    if( (this->volume_index == nullptr)
+    ||  !this->volume_index->is_current(this->imagecoll) ){
+        this->volume_index = std::make_shared<const image_volume_index>(this->imagecoll);
+    }
+    return this->volume_index;
+}
+
+std::shared_ptr<const image_array_signature> Image_Array::get_signature(){
+    std::lock_guard<std::mutex> lock(this->signature_mutex);
+    if( (this->signature == nullptr)
+    ||  !this->signature->is_current(this->imagecoll) ){
+        this->signature = std::make_shared<const image_array_signature>(this->imagecoll);
+    }
+    return this->signature;
+}
+
 //---------------------------------------------------------------------------------------------------------------------------
 //-------------------------------------------------------- Point_Cloud ------------------------------------------------------
 //---------------------------------------------------------------------------------------------------------------------------
@@ -1019,6 +1186,10 @@ drover_bnded_dose_stat_moments_map_t drover_bnded_dose_stat_moments_map_factory(
     drover_bnded_dose_stat_moments_map_t out(/*25, */bnded_dose_map_cmp_lambda);
     return out;
 }
+drover_bnded_dose_dvh_map_t drover_bnded_dose_dvh_map_factory(){
+    drover_bnded_dose_dvh_map_t out(/*25, */bnded_dose_map_cmp_lambda);
+    return out;
+}
 
 
 
@@ -1047,7 +1218,8 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
                                    drover_bnded_dose_min_max_dose_map_t *min_max_doses,
                                    drover_bnded_dose_pos_dose_map_t *pos_doses,
                                    const std::function<bool(bnded_dose_pos_dose_tup_t)>& Fselection,
-                                   drover_bnded_dose_stat_moments_map_t *cent_moms ) const {
+                                   drover_bnded_dose_stat_moments_map_t *cent_moms,
+                                   drover_bnded_dose_dvh_map_t *dvhs ) const {
     //This function is a general routine for working with pixels bounded by contour data. It *might* be better to stick it in 
     // the contour or pixel classes, but it seems better (at the moment) to place it in the Drover class, where we have clearly
     // indicated which contour, which dose pixels, and which CT data we want to work with.
@@ -1060,12 +1232,18 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
     //  std::map<long int,double> *mean_doses;     <-- Holds the mean dose for each ROI contour number within the contour data.
     //  ....many more implemented...   They should be fairly self-describing...
     //
+    //  drover_bnded_dose_dvh_map_t *dvhs;         <-- Bins voxel doses, weighted by voxel volume, into the histogram
+    //                                                 already present for each contour collection. Collections without a
+    //                                                 histogram are skipped, so the caller controls the binning and which
+    //                                                 ROIs are considered. All histograms are filled in a single sweep.
+    //
     // Pass a pointer to the desired container to compute the desired quantities.
     auto d = Isolate_Dose_Data(*this);
 
     //----------------------------------------- Sanity/Safety Checks ----------------------------------------
     if((pixel_doses == nullptr) && (mean_doses == nullptr) && (min_max_doses == nullptr) 
-    && (pos_doses   == nullptr) && (bulk_doses == nullptr) && (cent_moms     == nullptr) ){
+    && (pos_doses   == nullptr) && (bulk_doses == nullptr) && (cent_moms     == nullptr)
+    && (dvhs        == nullptr) ){
         FUNCWARN("No valid output pointers provided. Nothing will be computed");
         return;
     }
@@ -1141,126 +1319,146 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
         }
 
         //We now loop through all dose frames (slices) and accumulate dose within the contour bounds.
-        for(auto & image : dd_it->imagecoll.images){
-            //Note: i_it is something like std::list<planar_image<T,R>>::iterator.
-    
-            for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it){
-
-                for(auto c_it = cc_it->contours.begin(); c_it != cc_it->contours.end(); ++c_it){
-                    if(c_it->points.size() < 3) continue;
-
-                    const auto filtering_avg_point = c_it->First_N_Point_Avg(3); //Average_Point(); //Just need a point at the correct height, somewhere inside contour.
-                    if(!image.sandwiches_point_within_top_bottom_planes(filtering_avg_point)) continue;
- 
-                    //Now we have a contour of points and pixel data (note: we can ignore the z components for both) 
-                    // which may or may not lie within the contour. This is called the 'Point-in-polygon' problem and is
-                    // a well-known problem. Unfortunately, it can be a costly problem to solve. We will bound the contour with
-                    // a cartesian bounding box (in the XY plane) and poll each point. We can immediately ignore points outside the box.
-                    // This will save a considerable amount of time for small contours within a large volume, and probably won't greatly
-                    // slow the large contour/large volume case too much.
-                    //
-                    // We then examine line crossings. For a regular polygon, whether or not the number of line crossings (from the point
-                    // to infinity (in this case - the edge of the box)) is even or odd will determine whether or not the point is within
-                    // the contour. I *believe* there would be an issue if the contour would wrap around and touch exactly on some segment
-                    // (like a "C" where the two sharp edges touch to form an "O".) ***BEWARE*** that this is most likely the case!
-                    //
-                    // See http://www.visibone.com/inpoly/ (Accessed Jan 2012,) 
-                    //     http://paulbourke.net/geometry/insidepoly/ (January 2012,)
-                    //     http://stackoverflow.com/questions/217578/point-in-polygon-aka-hit-test (January 2012).
-                    //     NOTE: Some web servers/web applications used to have to implement this routine to deal with image maps. 
-                    //           Check their sources for leads if looking/scrounging for code. I would like a fully 3D version!
-                    //
-                    //     |---------------------|
-                    //     | /-----\  /--------\ |
-                    //     | |     |__|        / |
-                    //     |/                 /  |
-                    //     ||   X            /   |
-                    //     | \______________/    |
-                    //     |---------------------|
-                    //
-                    const contour_of_points<double> BB(c_it->Bounding_Box_Along(vec3<double>(1.0,0.0,0.0)));
-                    const float alrgnum(1E30);
-                    float min_x = alrgnum, max_x = -alrgnum;
-                    float min_y = alrgnum, max_y = -alrgnum;
-                    for(const auto & point : BB.points){
-                        if(point.x < min_x) min_x = point.x;
-                        if(point.x > max_x) max_x = point.x;
-                        if(point.y < min_y) min_y = point.y;
-                        if(point.y > max_y) max_y = point.y;
-                    }
-                    if((min_x == alrgnum) || (min_y == alrgnum) || (max_x == -alrgnum) || (max_y == -alrgnum)){
-                        FUNCERR("Unable to find a reasonable bounding box around this contour");
-                    }
-    
-                    //Now cycle through every pixel in the plane. This is kind of a shit way to do this, but then again this entire program is basically
-                    // a shit way to do it. I would like to have had more time to properly fix/plan/think about what I've got here...  -h
-                    for(long int i=0; i<image.rows; ++i)  for(long int j=0; j<image.columns; ++j){
-                        const auto pos = image.position(i,j);
-                        const float X = pos.x, Y = pos.y;
-    
-                        //Check if it is outside the bounding box.
-                        if(!isininc(min_x,X,max_x) || !isininc(min_y,Y,max_y)) continue;
-    
-                        bool is_in_the_polygon = false;
-                        auto p_j = --(c_it->points.end());
-                        for(auto p_i = c_it->points.begin(); p_i != c_it->points.end(); p_j = (p_i++)){
-                            //If the points cross a line, we simply toggle the 'bool is_in_the_polygon.'
-                            if( ((p_i->y <= Y) && (Y < p_j->y)) || ((p_j->y <= Y) && (Y < p_i->y)) ){ 
-                                const auto B = (p_j->x - p_i->x)*(Y - p_i->y)/(p_j->y - p_i->y);
-                                if(X < (B + p_i->x)){
-                                    is_in_the_polygon = !is_in_the_polygon;
-                                }
-                            }
-                        }
-
-                        if(is_in_the_polygon){
-                            //-----------------------------------------------------------------------------------------------------------------------
-                            //FUNCINFO("Bounding box (x,y)min (x,y)max = (" << min_x << "," << min_y << ") (" << max_x << "," << max_y << ")");
-                            //FUNCINFO("Point has (X,Y) = " << X << " " << Y);
-
-                            //NOTE: Remember: this is some integer representing dose. If we want a clamped [0:1] 
-                            // value, we would use the clamped_channel(...) member instead!
-                            const auto pointval = static_cast<int64_t>(image.value(i,j,0)); //Greyscale or R channel. We assume the channels satisfy: R = G = B.
-                            const auto pointdose = static_cast<double>(pointval); 
+        //
+        // Each contour is rasterized onto the slice with a scanline algorithm (see Scanline_Rasterizer.h), so only the
+        // covered row spans are visited. A voxel is bounded if its centre is interior according to the parity rule.
+        //
+        // Each (slice, contour collection) pair is accumulated independently and in parallel. Results are merged
+        // afterward in the original (slice, contour collection, contour, row, column) order, so outputs are ordered as
+        // they would be by a serial sweep.
+        struct bounded_voxels {
+            std::vector<double> doses;
+            int64_t dose_sum = 0;
+            int64_t N = 0;
+            double min = 1E99;
+            double max = -1E99;
+            std::vector<bnded_dose_pos_dose_tup_t> positions;
+            std::map<std::array<int,3>,double> moments;
+            std::optional<dose_volume_histogram> dvh;
+        };
 
-                            if(mean_doses != nullptr){
-                                accumulated_dose[cc_it].first  += pointval;
-                                accumulated_dose[cc_it].second += 1;
-                            }
-                            if(bulk_doses != nullptr){
-                                (*bulk_doses)[cc_it].push_back(pointdose);
-                            }
+        std::vector<const planar_image<float,double>*> images;
+        for(const auto & image : dd_it->imagecoll.images) images.push_back(&image);
 
-                            if(pixel_doses != nullptr){
-                                pixel_doses->push_back(pointdose); 
-                            }
-
-                            if(min_max_doses != nullptr){
-                                if(pointdose < (*min_max_doses)[cc_it].first)  (*min_max_doses)[cc_it].first  = pointdose; //min.
-                                if(pointdose > (*min_max_doses)[cc_it].second) (*min_max_doses)[cc_it].second = pointdose; //max.
-                            }
+        std::vector<bnded_dose_map_key_t> cc_its;
+        std::vector<dose_volume_histogram*> cc_dvhs;
+        std::vector<vec3<double>> cc_centroid_vec;
+        for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it){
+            cc_its.push_back(cc_it);
 
-                            if(pos_doses != nullptr){
-                                const vec3<double> r_dx = image.row_unit*image.pxl_dx*0.5;
-                                const vec3<double> r_dy = image.col_unit*image.pxl_dy*0.5;
-                                const auto tup = std::make_tuple(pos, r_dx, r_dy, pointdose, i, j);
+            dose_volume_histogram *dvh = nullptr;
+            if(dvhs != nullptr){
+                auto dvh_it = dvhs->find(cc_it);
+                if(dvh_it != dvhs->end()) dvh = &(dvh_it->second);
+            }
+            cc_dvhs.push_back(dvh);
+            cc_centroid_vec.push_back( (cent_moms != nullptr) ? cc_centroids[cc_it] : vec3<double>() );
+        }
+        const auto N_ccs = cc_its.size();
+        const bool need_doses = (pixel_doses != nullptr) || (bulk_doses != nullptr);
+
+        std::vector<bounded_voxels> results(images.size() * N_ccs);
+        {
+            asio_thread_pool tp;
+            for(size_t i_n = 0; i_n < images.size(); ++i_n){
+                for(size_t cc_n = 0; cc_n < N_ccs; ++cc_n){
+                    tp.submit_task([&,i_n,cc_n]() -> void {
+                        const auto &image = *(images[i_n]);
+                        const auto cc_it = cc_its[cc_n];
+                        auto &res = results[i_n * N_ccs + cc_n];
+                        if(cc_dvhs[cc_n] != nullptr){
+                            res.dvh.emplace( *(cc_dvhs[cc_n]) );
+                            res.dvh->clear();
+                        }
 
-                                if(Fselection(tup)) (*pos_doses)[cc_it].push_back(tup);
-                            }
-                            if(cent_moms != nullptr){ //Centralized moments. This routine requires a centroid for each cc.
-                                const auto cc_centroid = cc_centroids[cc_it];
-                                for(int p = 0; p < 5; ++p) for(int q = 0; q < 5; ++q) for(int r = 0; r < 5; ++r){
-                                    //const std::array<int,3> triplet = {p,q,r};
-                                    const auto spatial = pow(pos.x-cc_centroid.x,p)*pow(pos.y-cc_centroid.y,q)*pow(pos.z-cc_centroid.z,r);
-                                    const auto grid_factor = image.pxl_dx * image.pxl_dy * image.pxl_dz;
-                                    (*cent_moms)[cc_it][{p,q,r}] += spatial*pointdose*grid_factor;
+                        for(const auto & contour : cc_it->contours){
+                            if(contour.points.size() < 3) continue;
+
+                            const auto filtering_avg_point = contour.First_N_Point_Avg(3); //Just need a point at the correct height, somewhere inside contour.
+                            if(!image.sandwiches_point_within_top_bottom_planes(filtering_avg_point)) continue;
+
+                            const auto raster = Rasterize_Contour(image, contour);
+                            for(const auto &span : raster.spans){
+                                const long int i = span.row;
+                                for(long int j = span.col_begin; j < span.col_end; ++j){
+                                    const auto pos = image.position(i,j);
+
+                                    //NOTE: Remember: this is some integer representing dose. If we want a clamped [0:1] 
+                                    // value, we would use the clamped_channel(...) member instead!
+                                    const auto pointval = static_cast<int64_t>(image.value(i,j,0)); //Greyscale or R channel. We assume the channels satisfy: R = G = B.
+                                    const auto pointdose = static_cast<double>(pointval); 
+
+                                    if(mean_doses != nullptr){
+                                        res.dose_sum += pointval;
+                                        res.N += 1;
+                                    }
+                                    if(need_doses){
+                                        res.doses.push_back(pointdose);
+                                    }
+                                    if(res.dvh){ //Histograms are binned using the untruncated voxel value.
+                                        res.dvh->digest(static_cast<double>(image.value(i,j,0)), image.pxl_dx * image.pxl_dy * image.pxl_dz);
+                                    }
+                                    if(min_max_doses != nullptr){
+                                        if(pointdose < res.min) res.min = pointdose;
+                                        if(pointdose > res.max) res.max = pointdose;
+                                    }
+                                    if(pos_doses != nullptr){
+                                        const vec3<double> r_dx = image.row_unit*image.pxl_dx*0.5;
+                                        const vec3<double> r_dy = image.col_unit*image.pxl_dy*0.5;
+                                        res.positions.emplace_back(pos, r_dx, r_dy, pointdose, i, j);
+                                    }
+                                    if(cent_moms != nullptr){ //Centralized moments. This routine requires a centroid for each cc.
+                                        const auto cc_centroid = cc_centroid_vec[cc_n];
+                                        const auto grid_factor = image.pxl_dx * image.pxl_dy * image.pxl_dz;
+                                        for(int p = 0; p < 5; ++p) for(int q = 0; q < 5; ++q) for(int r = 0; r < 5; ++r){
+                                            const auto spatial = pow(pos.x-cc_centroid.x,p)*pow(pos.y-cc_centroid.y,q)*pow(pos.z-cc_centroid.z,r);
+                                            res.moments[{p,q,r}] += spatial*pointdose*grid_factor;
+                                        }
+                                    }
                                 }
                             }
-
-                            //-----------------------------------------------------------------------------------------------------------------------
                         }
+                    }); // thread pool task closure.
+                }
+            }
+        } // Wait until all threads are done.
+
+        //Merge the results in order.
+        for(size_t i_n = 0; i_n < images.size(); ++i_n){
+            for(size_t cc_n = 0; cc_n < N_ccs; ++cc_n){
+                const auto cc_it = cc_its[cc_n];
+                auto &res = results[i_n * N_ccs + cc_n];
+
+                if(mean_doses != nullptr){
+                    accumulated_dose[cc_it].first  += res.dose_sum;
+                    accumulated_dose[cc_it].second += res.N;
+                }
+                if((bulk_doses != nullptr) && !res.doses.empty()){
+                    auto &bulk = (*bulk_doses)[cc_it];
+                    bulk.insert(bulk.end(), res.doses.begin(), res.doses.end());
+                }
+                if(pixel_doses != nullptr){
+                    pixel_doses->insert(pixel_doses->end(), res.doses.begin(), res.doses.end());
+                }
+                if(res.dvh){
+                    cc_dvhs[cc_n]->merge(res.dvh.value());
+                }
+                if(min_max_doses != nullptr){
+                    auto &min_max = (*min_max_doses)[cc_it];
+                    if(res.min < min_max.first)  min_max.first  = res.min; //min.
+                    if(res.max > min_max.second) min_max.second = res.max; //max.
+                }
+                if(pos_doses != nullptr){
+                    //The selection heuristic is evaluated serially, since it need not be thread-safe.
+                    for(const auto &tup : res.positions){
+                        if(Fselection(tup)) (*pos_doses)[cc_it].push_back(tup);
                     }
                 }
+                if((cent_moms != nullptr) && !res.moments.empty()){
+                    auto &moments = (*cent_moms)[cc_it];
+                    for(const auto &m : res.moments) moments[m.first] += m.second;
+                }
+                res = bounded_voxels(); //Release memory early.
             }
         }
 
@@ -1501,8 +1699,20 @@ std::pair<double,double> Drover::Bounded_Dose_Limits() const {
 std::map<double,double>  Drover::Get_DVH() const {
     std::map<double,double> output;
 
-    std::list<double> pixel_doses = this->Bounded_Dose_Bulk_Values();
-    if(pixel_doses.empty()){
+    //Bin the voxels of all ROIs in a single sweep, and then combine them.
+    const double dDose = 0.5;
+    auto dvhs = drover_bnded_dose_dvh_map_factory();
+    if(this->Has_Contour_Data()){
+        for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it){
+            dvhs.emplace(cc_it, dose_volume_histogram(dDose));
+        }
+    }
+    this->Bounded_Dose_General(nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,&dvhs);
+
+    dose_volume_histogram combined(dDose);
+    for(const auto &dvh : dvhs) combined.merge(dvh.second);
+
+    if(combined.empty()){
         //FUNCERR("Unable to compute DVH: There was no data in the pixel_doses structure!");
         FUNCWARN("Asked to compute DVH when no voxels appear to have any dose. This is physically possible, but please be sure it is what you expected");
         //Could be due to:
@@ -1513,19 +1723,15 @@ std::map<double,double>  Drover::Get_DVH() const {
         return output;
     }
 
-    double cumulative;
+    //Sample the cumulative DVH at the bin edges, where it is exact.
+    const auto total_volume = combined.volume();
+    double frac;
     double test_dose = 0.0;
     do{
-        cumulative = 0.0;
-        for(double & pixel_dose : pixel_doses){
-            if(pixel_dose > test_dose) cumulative += 1.0;
-        }
-
-        const auto dose = test_dose;
-        const auto frac = static_cast<double>(cumulative) / static_cast<double>(pixel_doses.size());
-        output[dose] = frac;
-        test_dose += 0.5;
-    }while(cumulative != 0.0);
+        frac = combined.volume_above(test_dose) / total_volume;
+        output[test_dose] = frac;
+        test_dose += dDose;
+    }while(frac != 0.0);
     return output;
 }
 
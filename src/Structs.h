@@ -8,6 +8,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <tuple>
@@ -21,6 +22,7 @@
 #include "YgorMath.h"
 
 #include "Alignment_TPSRPM.h"
+#include "Dose_Volume_Histogram.h"
 
 
 //This is a wrapper around the YgorMath.h class "contour_of_points." It holds an instance of a contour_of_points, but also provides some meta information
@@ -68,6 +70,58 @@ namespace Segmentations {
 std::string Segmentations_to_Words(const std::vector<uint32_t> &in);
 
 
+// Per-ROI summaries for quickly culling contour collections and individual contours by location.
+//
+// For each contour collection an axis-aligned bounding box and a 'plane index' (the contours sorted by their offset
+// along the collection's planar normal) are recorded. Like image_volume_index, this index holds pointers to the indexed
+// contours. A hash of every vertex is recorded so that any later addition, removal, or edit of contours or vertices
+// can be detected.
+class contour_roi_index {
+    public:
+        using plane_entry = std::pair<double, const contour_of_points<double>*>; // (offset along normal, contour).
+
+        struct roi_summary {
+            const contour_collection<double> *cc = nullptr;
+            vec3<double> bbox_min; // Only meaningful when N_vertices != 0.
+            vec3<double> bbox_max;
+            vec3<double> normal = vec3<double>(0.0, 0.0, 1.0); // Unit normal used to order contours into planes.
+            std::vector<plane_entry> planes; // Sorted by offset. Contours without vertices are omitted.
+            size_t N_vertices = 0;
+
+            // Contours with an offset along the normal within [lo, hi], as a range of 'planes'.
+            std::pair<std::vector<plane_entry>::const_iterator,
+                      std::vector<plane_entry>::const_iterator> contours_between(double lo, double hi) const;
+
+            // Returns true iff the bounding box (inflated by 'margin') overlaps the provided box.
+            bool bbox_overlaps(const vec3<double> &min, const vec3<double> &max, double margin = 0.0) const;
+
+            // The extent of the bounding box along the provided unit vector, as [min, max]. Every vertex projects
+            // within this interval.
+            std::pair<double, double> extent_along(const vec3<double> &unit) const;
+        };
+
+        std::vector<roi_summary> rois; // In the same order as the indexed contour collections.
+
+        explicit contour_roi_index(const std::list<contour_collection<double>> &ccs);
+
+        // The summary for the provided collection, or nullptr if it was not indexed.
+        const roi_summary* get(const contour_collection<double> *cc) const;
+
+        // Returns true iff the collections hold the same contours, with the same vertices, as when indexed. This visits
+        // every vertex, but is cheaper than rebuilding the index.
+        bool is_current(const std::list<contour_collection<double>> &ccs) const;
+
+    private:
+        struct contour_signature {
+            const contour_of_points<double> *c;
+            size_t N_points;
+            uint64_t vertex_hash;
+        };
+        std::vector<contour_signature> signatures;
+        std::map<const contour_collection<double>*, size_t> roi_lookup;
+};
+
+
 //This class is used to hold a collection of contours.
 class Contour_Data {
     public:
@@ -80,6 +134,11 @@ class Contour_Data {
         //Member functions.
         void operator = (const Contour_Data &rhs);
 
+        // Returns per-ROI bounding boxes and plane indices. The index is built lazily and cached. It is rebuilt
+        // whenever contours have been added, removed, or (detectably) edited since it was built, so callers should
+        // retrieve it once before a batch of queries rather than holding it across edits.
+        std::shared_ptr<const contour_roi_index> get_roi_index();
+
         void Plot() const;     //Spits out a default plot of the (entirety) of the data. Use the contour_of_points::Plot() method for individual contours.
     
         //Unique duplication (aka 'copy factory').
@@ -111,9 +170,15 @@ std::unique_ptr<Contour_Data> Split_Per_Volume_Along_Transverse_Plane() const;
         //--- Core-Peel splitting. ---
         std::unique_ptr<Contour_Data> Split_Core_and_Peel(double frac_dist) const;
 
+    private:
+        std::mutex roi_index_mutex;
+        std::shared_ptr<const contour_roi_index> roi_index;
 };
 
 
+class image_volume_index;
+class image_array_signature;
+
 class Image_Array { //: public Base_Array {
     public:
 
@@ -127,6 +192,25 @@ class Image_Array { //: public Base_Array {
 
         //Member functions.
         Image_Array & operator=(const Image_Array &rhs); //Performs a deep copy (unless copying self).
+
+        // Returns an index for quickly locating the image(s) that contain a point. The index is built lazily and
+        // cached. It is rebuilt whenever images have been added, removed, or had their geometry altered since it was
+        // built, so callers should retrieve it once before a batch of lookups rather than holding it across edits.
+        std::shared_ptr<const image_volume_index> get_volume_index();
+
+        // Returns a summary of the geometry and voxel intensities (see Image_Signature.h). The signature is computed
+        // lazily and cached. It is recomputed whenever images have been added, removed, reallocated, or had their
+        // geometry altered, or when any voxel intensity has changed. Validating the cached signature hashes every
+        // voxel, so each call costs a full pass over the voxel data; callers should retrieve it once per batch of
+        // comparisons.
+        std::shared_ptr<const image_array_signature> get_signature();
+
+    private:
+        std::mutex volume_index_mutex;
+        std::shared_ptr<const image_volume_index> volume_index;
+
+        std::mutex signature_mutex;
+        std::shared_ptr<const image_array_signature> signature;
 };
 
 
@@ -394,6 +478,7 @@ typedef std::map<bnded_dose_map_key_t,std::tuple<double,double,double,double>,
 typedef std::tuple<vec3<double>,vec3<double>,vec3<double>,double,long int,long int> bnded_dose_pos_dose_tup_t;
 typedef std::map<bnded_dose_map_key_t,std::list<bnded_dose_pos_dose_tup_t>,         bnded_dose_map_cmp_func_t>  drover_bnded_dose_pos_dose_map_t; 
 typedef std::map<bnded_dose_map_key_t,std::map<std::array<int,3>,double>,           bnded_dose_map_cmp_func_t>  drover_bnded_dose_stat_moments_map_t;
+typedef std::map<bnded_dose_map_key_t,dose_volume_histogram,                        bnded_dose_map_cmp_func_t>  drover_bnded_dose_dvh_map_t;
 
 drover_bnded_dose_mean_dose_map_t                drover_bnded_dose_mean_dose_map_factory();
 drover_bnded_dose_centroid_map_t                 drover_bnded_dose_centroid_map_factory();
@@ -404,6 +489,7 @@ drover_bnded_dose_min_mean_max_dose_map_t        drover_bnded_dose_min_mean_max_
 drover_bnded_dose_min_mean_median_max_dose_map_t drover_bnded_dose_min_mean_median_max_dose_map_factory();
 drover_bnded_dose_pos_dose_map_t                 drover_bnded_dose_pos_dose_map_factory();
 drover_bnded_dose_stat_moments_map_t             drover_bnded_dose_stat_moments_map_factory();
+drover_bnded_dose_dvh_map_t                      drover_bnded_dose_dvh_map_factory();
 
 class Drover {
     public:
@@ -428,7 +514,8 @@ class Drover {
                                    drover_bnded_dose_min_max_dose_map_t *min_max_doses,
                                    drover_bnded_dose_pos_dose_map_t *pos_doses,
                                    const std::function<bool(bnded_dose_pos_dose_tup_t)>& Fselection,
-                                   drover_bnded_dose_stat_moments_map_t *centralized_moments ) const;
+                                   drover_bnded_dose_stat_moments_map_t *centralized_moments,
+                                   drover_bnded_dose_dvh_map_t *dvhs = nullptr ) const; //NOTE: Only ROIs with a histogram already present are binned.
     
         std::list<double> Bounded_Dose_Bulk_Values() const;                 //If the contours contain multiple organs, we get TOTAL bulk pixel values (Gy or cGy?)
         drover_bnded_dose_mean_dose_map_t Bounded_Dose_Means() const;       //Get mean dose for each contour collection. See note in source.
@@ -13,6 +13,8 @@
 #include <mutex>
 #include <limits>
 #include <cmath>
+#include <cstdint>
+#include <thread>
 
 #include <utility>            //Needed for std::pair.
 #include <algorithm>
@@ -25,6 +27,7 @@
 #define BOOST_PARAMETER_MAX_ARITY 12
 
 #include <CGAL/subdivision_method_3.h>
+#include <CGAL/convex_hull_3.h>
 #include <CGAL/OFF_to_nef_3.h>
 #include <CGAL/Min_sphere_of_spheres_d.h>
 
@@ -61,6 +64,7 @@
 #include "YgorImages.h"
 
 #include "Structs.h"
+#include "Thread_Pool.h"
 
 #include "YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
@@ -537,7 +541,7 @@ Marching_Cubes_Implementation(
         bool below_is_interior,  // Controls how the inclusion_threshold is interpretted.
                                  // If true, anything <= is considered to be interior to the surface.
                                  // If false, anything >= is considered to be interior to the surface.
-        Parameters /*params*/ ){
+        Parameters params ){
 
     const double ExteriorVal = inclusion_threshold + (below_is_interior ? 1.0 : -1.0);
 
@@ -859,238 +863,403 @@ Marching_Cubes_Implementation(
            { -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 }
     } };
 
-    // Convert an edge index to the corner vertex indices for a cube.
-    const std::array< std::array<int32_t, 2>, 12> a2iEdgeConnection { {
-        {0, 1}, {1, 2}, {2, 3}, {3, 0},  // Bottom face.
-        {4, 5}, {5, 6}, {6, 7}, {7, 4},  // Top face.
-        {0, 4}, {1, 5}, {2, 6}, {3, 7}   // Side faces.
+    // Convert a corner index to the lattice offset (row, column, image) relative to the cube's first corner.
+    //
+    // Note: Marching Cube corners coincide with image voxel centres (see below), so the lattice is the voxel grid.
+    const std::array< std::array<int32_t, 3>, 8> a2iCornerLatticeOffset { {
+        {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},  // Bottom face.
+        {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}   // Top face.
     } };
 
-    // Storage used for the final mesh triangle vertices and faces.
-    std::vector<Kernel::Point_3> mesh_triangle_verts;
-    std::vector< std::array<size_t, 3> > mesh_triangle_faces;
+    // Convert an edge index to the corner vertex indices for a cube, ordered so the first corner is always the one
+    // nearest the lattice origin. Interpolating in a consistent direction ensures every cube sharing an edge computes
+    // bitwise-identical intersections, which keeps vertex welding (below) consistent.
+    const std::array< std::array<int32_t, 2>, 12> a2iCanonicalEdgeConnection { {
+        {0, 1}, {1, 2}, {3, 2}, {0, 3},  // Bottom face.
+        {4, 5}, {5, 6}, {7, 6}, {4, 7},  // Top face.
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}   // Side faces.
+    } };
 
-    std::mutex saver_printer; // Thread synchro lock for saving shared data, logging, and counter iterating.
-    long int completed = 0;
-    const long int img_count = grid_imgs.size();
+    // Vertices are welded by indexing them on the lattice. Every vertex lies either on a lattice edge (along the row,
+    // column, or image axis) or, when the surface passes (nearly) through a voxel centre, on a lattice point. So each
+    // lattice point owns four slots, and welding is O(1) per vertex without any distance comparisons.
+    //
+    // Only the two lattice layers touched by the current layer of cubes are ever needed, so memory is
+    // O(rows*columns) per concurrently-meshed slab.
+    enum lattice_slot_t : int32_t {
+        RowEdge = 0,
+        ColumnEdge = 1,
+        ImageEdge = 2,
+        LatticePoint = 3,
+        SlotCount = 4
+    };
 
-    // Iterate over all voxels, traversing the images in order of adjacency for consistency.
+    // Tolerance for deciding if meshed vertices are identical. If too lax, then topological inconsistencies may
+    // result; if too tight, then the mesh will either be non-watertight, non-manifold, or will be constructed in an
+    // invalid way by the mesher.
+    //
+    // The following tolerance was estimated with a Gaussian-smoothed spherical phantom.
+    // If these tolerances are increased, meshing will 'wobble' around the boundary and possibly create zero-area
+    // needles and surface crossovers. However, merely setting the tolerance to zero will likely cause meshing to
+    // fail outright.
     //
-    // NOTE: The order of traversal must reflect image adjacency. This requirement could be relaxed if candidate
-    //       vertices (below) were indexed, but even this would involve extra memory usage for little gain.
+    // Vertices within this tolerance of a voxel centre are snapped to it, which welds the (otherwise distinct)
+    // vertices of all lattice edges that meet there.
+    const auto get_dvec3_tol = [](double pxl_dx, double pxl_dy, double pxl_dz) -> double {
+        constexpr auto machine_eps = std::numeric_limits<double>::epsilon();
+        return std::max( std::min( { pxl_dx, pxl_dy, pxl_dz } ) * 1E-4,
+                         std::sqrt(machine_eps) * 100.0 ); // Guard against pxl_dz = 0.
+    };
+
+    using img_refw_t = std::reference_wrapper<planar_image<float,double>>;
+    std::vector<img_refw_t> ordered_imgs;
     for(const auto &img_ptr : img_adj.int_to_img){
-        const auto img_refw = std::ref( *img_ptr );
+        ordered_imgs.emplace_back( std::ref( *img_ptr ) );
+    }
+    const auto img_count = static_cast<long int>(ordered_imgs.size());
+
+    const auto N_rows = ordered_imgs.front().get().rows;
+    const auto N_cols = ordered_imgs.front().get().columns;
+    for(const auto &img_refw : ordered_imgs){
+        if( (img_refw.get().rows != N_rows)
+        ||  (img_refw.get().columns != N_cols) ){
+            throw std::invalid_argument("Images do not all have the same number of rows and columns. Cannot continue.");
+        }
+    }
 
-        const auto pxl_dx = img_refw.get().pxl_dx;
-        const auto pxl_dy = img_refw.get().pxl_dy;
-        const auto pxl_dz = img_refw.get().pxl_dz;
+    // Cubes extend one voxel beyond the last row and column (sampling the exterior there), so the lattice does too.
+    const long int N_lattice_points = (N_rows + 1) * (N_cols + 1);
+    const long int N_layer_slots = N_lattice_points * static_cast<long int>(SlotCount);
+    const auto slot_index = [N_cols](long int row, long int col, int32_t slot) -> long int {
+        return (row * (N_cols + 1) + col) * static_cast<long int>(SlotCount) + static_cast<long int>(slot);
+    };
 
-        const auto row_unit = img_refw.get().row_unit.unit();
-        const auto col_unit = img_refw.get().col_unit.unit();
-        const auto img_unit = row_unit.Cross(col_unit).unit();
+    // Each slab is a contiguous range of images that is meshed independently. Vertices on the lattice layer shared
+    // by adjacent slabs are recorded so the slabs can be stitched back together afterward.
+    struct mc_slab_t {
+        long int img_begin = 0;
+        long int img_end = 0;
 
-        // Tolerance for deciding if meshed vertices are identical. If too lax, then topological inconsistencies may
-        // result; if too tight, then the mesh will either be non-watertight, non-manifold, or will be constructed in an
-        // invalid way by the mesher.
-        //
-        // The following tolerance was estimated with a Gaussian-smoothed spherical phantom.
-        // If these tolerances are increased, meshing will 'wobble' around the boundary and possibly create zero-area
-        // needles and surface crossovers. However, merely setting the tolerance to zero will likely cause meshing to
-        // fail outright.
-        constexpr auto machine_eps = std::numeric_limits<double>::epsilon();
-        const auto dvec3_tol = std::max(
-                                   std::min( { pxl_dx, pxl_dy, pxl_dz } ) * 1E-4,
-                                   std::sqrt(machine_eps) * 100.0 ); // Guard against pxl_dz = 0.
+        std::vector<Kernel::Point_3> verts;
+        std::vector< std::array<size_t, 3> > faces;
 
-        // List of Marching Cube voxel corner positions relative to image voxel centre.
-        //
-        // Note that the Marching cube and image voxels are not the same. They are offset such that
-        // the corner of the Marching Cube voxel is at the centre of the image voxel. This is done
-        // to avoid surface discontinuties that would arise from sampling the boundary of border
-        // voxels; numerical instability could potentially lead to random fluctuation by 1 voxel width on
-        // straight borders.
-        const std::array< vec3<double>, 8> a2fVertexOffset { {
-            (zero3),
-            (zero3 + row_unit * pxl_dx),
-            (zero3 + row_unit * pxl_dx + col_unit * pxl_dy),
-            (zero3 + col_unit * pxl_dy),
-
-            (zero3 + img_unit * pxl_dz),
-            (zero3 + row_unit * pxl_dx + img_unit * pxl_dz),
-            (zero3 + row_unit * pxl_dx + col_unit * pxl_dy + img_unit * pxl_dz),
-            (zero3 + col_unit * pxl_dy + img_unit * pxl_dz)
-        } };
-
-        // The vector needed to translate from tail to head for each edge.
-        const std::array< vec3<double>, 12> a2fEdgeDirection { {
-            row_unit * pxl_dx, // Bottom face.
-            col_unit * pxl_dy,
-            row_unit * -pxl_dx,
-            col_unit * -pxl_dy,
-
-            row_unit * pxl_dx, // Top face.
-            col_unit * pxl_dy,
-            row_unit * -pxl_dx,
-            col_unit * -pxl_dy,
-
-            img_unit * pxl_dz, // Side faces.
-            img_unit * pxl_dz,
-            img_unit * pxl_dz,
-            img_unit * pxl_dz
-        } };
-
-
-        const auto img_num = img_adj.image_to_index( img_refw );
-        const auto img_num_p1 = img_num + 1;
-        const auto img_is_adj = img_adj.index_present(img_num_p1);
-        const auto img_p1 = (img_is_adj) ? img_adj.index_to_image(img_num_p1) : img_refw;
-
-        const auto N_rows = img_refw.get().rows;
-        const auto N_cols = img_refw.get().columns;
-        for(long int row = 0; row < N_rows; ++row){
-            for(long int col = 0; col < N_cols; ++col){
-                const auto pos = img_refw.get().position(row, col);
-
-                // Sample voxel corner values.
-                std::array<double, 8> afCubeValue;
-                //
-                // Option A: Interpolate. This way is slow but extremely flexible.
-                //for(int32_t corner = 0; corner < 8; ++corner){
-                //    afCubeValue[corner] = surface_oracle(pos + a2fVertexOffset[corner]);
-                //}
-                //
-                // Option B: Align Marching Cube voxel corners with image voxel centres. This way is fast.
-                {
-                    const auto row_p1 = (row+1);
-                    const auto row_is_adj = (row_p1 < N_rows);
-
-                    const auto col_p1 = (col+1);
-                    const auto col_is_adj = (col_p1 < N_cols);
-
-                    afCubeValue[0] = img_refw.get().value(row, col, 0);
-                    afCubeValue[1] = (row_is_adj)                             ? img_refw.get().value(row_p1, col, 0)    : ExteriorVal;
-                    afCubeValue[2] = (row_is_adj && col_is_adj)               ? img_refw.get().value(row_p1, col_p1, 0) : ExteriorVal;
-                    afCubeValue[3] = (col_is_adj)                             ? img_refw.get().value(row, col_p1, 0)    : ExteriorVal;
-                    afCubeValue[4] = (img_is_adj)                             ? img_p1.get().value(row, col, 0)         : ExteriorVal;
-                    afCubeValue[5] = (row_is_adj && img_is_adj)               ? img_p1.get().value(row_p1, col, 0)      : ExteriorVal;
-                    afCubeValue[6] = (row_is_adj && col_is_adj && img_is_adj) ? img_p1.get().value(row_p1, col_p1, 0)   : ExteriorVal;
-                    afCubeValue[7] = (col_is_adj && img_is_adj)               ? img_p1.get().value(row, col_p1, 0)      : ExteriorVal;
-                }
+        std::vector< std::pair<long int, size_t> > bottom_layer; // (slot, vertex index), ordered by slot.
+        std::vector< std::pair<long int, size_t> > top_layer;    // (slot, vertex index), ordered by slot.
+        bool top_is_adj = false; // Whether the top lattice layer coincides with the next slab's bottom layer.
+    };
 
-                // Convert vertex inclusion to a bitmask.
-                int32_t iFlagIndex = 0;
-                for(int32_t corner = 0; corner < 8; ++corner){
-                    if(below_is_interior){
-                        if(afCubeValue[corner] <= inclusion_threshold) iFlagIndex |= (1 << corner);
-                    }else{
-                        if(afCubeValue[corner] >= inclusion_threshold) iFlagIndex |= (1 << corner);
-                    }
-                }
+    long int N_slabs = params.MarchingCubesSlabs;
+    if(N_slabs <= 0) N_slabs = static_cast<long int>(std::thread::hardware_concurrency());
+    N_slabs = std::clamp<long int>(N_slabs, 1, img_count);
+
+    std::vector<mc_slab_t> slabs(N_slabs);
+    for(long int i = 0; i < N_slabs; ++i){
+        slabs[i].img_begin = (img_count * i) / N_slabs;
+        slabs[i].img_end   = (img_count * (i + 1)) / N_slabs;
+    }
 
-                // Convert vertex inclusion into a list of 'involved' edges that cross the ROI surface.
-                const int32_t iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
+    std::mutex saver_printer; // Thread synchro lock for saving shared data, logging, and counter iterating.
+    long int completed = 0;
 
-                // If the cube is entirely inside or outside of the surface, then there will be no intersections.
-                if(iEdgeFlags == 0) continue;
+    const auto extract_layer = [N_layer_slots](const std::vector<int32_t> &layer) -> std::vector< std::pair<long int, size_t> > {
+        std::vector< std::pair<long int, size_t> > out;
+        for(long int i = 0; i < N_layer_slots; ++i){
+            if(0 <= layer[i]) out.emplace_back(i, static_cast<size_t>(layer[i]));
+        }
+        return out;
+    };
 
-                // Find the point of intersection of the surface with each edge.
-                std::array<vec3<double>, 12> asEdgeVertex;
-                for(int32_t edge = 0; edge < 12; edge++){
-                    if(iEdgeFlags & (1 << edge)){ // continue iff involved.
+    const auto mesh_slab = [&](mc_slab_t &slab) -> void {
+        // Vertex indices for the lattice layer at the bottom and top of the current layer of cubes. 
+        std::vector<int32_t> curr_layer(N_layer_slots, -1);
+        std::vector<int32_t> next_layer(N_layer_slots, -1);
 
-                        const double value_A = afCubeValue[a2iEdgeConnection[edge][0]];
-                        const double value_B = afCubeValue[a2iEdgeConnection[edge][1]];
+        auto &mesh_triangle_verts = slab.verts;
+        auto &mesh_triangle_faces = slab.faces;
 
-                        // Find the (approximate) point along the edge where the surface intersects, parameterized to [0:1].
-                        const double d_value = (value_B - value_A);
-                        const double inv_d_value = static_cast<double>(1.0)/d_value;
-                        const double lin_interp = (inclusion_threshold - value_A) * inv_d_value;
-                        const double surf_dl = std::isfinite(lin_interp) ? lin_interp : static_cast<double>(0.5);
-                        if(!isininc(0.0,surf_dl,1.0)){
-                            throw std::logic_error("Interpolation of surface-edge intersection failed. Refusing to continue");
+        // Iterate over all voxels, traversing the images in order of adjacency.
+        //
+        // NOTE: The order of traversal must reflect image adjacency so lattice layers can be recycled.
+        for(long int img_i = slab.img_begin; img_i < slab.img_end; ++img_i){
+            const auto img_refw = ordered_imgs[img_i];
+
+            const auto pxl_dx = img_refw.get().pxl_dx;
+            const auto pxl_dy = img_refw.get().pxl_dy;
+            const auto pxl_dz = img_refw.get().pxl_dz;
+
+            const auto row_unit = img_refw.get().row_unit.unit();
+            const auto col_unit = img_refw.get().col_unit.unit();
+            const auto img_unit = row_unit.Cross(col_unit).unit();
+
+            const auto dvec3_tol = get_dvec3_tol(pxl_dx, pxl_dy, pxl_dz);
+
+            // List of Marching Cube voxel corner positions relative to image voxel centre.
+            //
+            // Note that the Marching cube and image voxels are not the same. They are offset such that
+            // the corner of the Marching Cube voxel is at the centre of the image voxel. This is done
+            // to avoid surface discontinuties that would arise from sampling the boundary of border
+            // voxels; numerical instability could potentially lead to random fluctuation by 1 voxel width on
+            // straight borders.
+            const std::array< vec3<double>, 8> a2fVertexOffset { {
+                (zero3),
+                (zero3 + row_unit * pxl_dx),
+                (zero3 + row_unit * pxl_dx + col_unit * pxl_dy),
+                (zero3 + col_unit * pxl_dy),
+
+                (zero3 + img_unit * pxl_dz),
+                (zero3 + row_unit * pxl_dx + img_unit * pxl_dz),
+                (zero3 + row_unit * pxl_dx + col_unit * pxl_dy + img_unit * pxl_dz),
+                (zero3 + col_unit * pxl_dy + img_unit * pxl_dz)
+            } };
+
+            // The vector needed to translate from the canonical tail to head for each edge.
+            const std::array< vec3<double>, 12> a2fEdgeDirection { {
+                row_unit * pxl_dx, // Bottom face.
+                col_unit * pxl_dy,
+                row_unit * pxl_dx,
+                col_unit * pxl_dy,
+
+                row_unit * pxl_dx, // Top face.
+                col_unit * pxl_dy,
+                row_unit * pxl_dx,
+                col_unit * pxl_dy,
+
+                img_unit * pxl_dz, // Side faces.
+                img_unit * pxl_dz,
+                img_unit * pxl_dz,
+                img_unit * pxl_dz
+            } };
+            const std::array< double, 12> a2fEdgeLength { {
+                pxl_dx, pxl_dy, pxl_dx, pxl_dy,
+                pxl_dx, pxl_dy, pxl_dx, pxl_dy,
+                pxl_dz, pxl_dz, pxl_dz, pxl_dz
+            } };
+            const std::array< int32_t, 12> a2iEdgeSlot { {
+                RowEdge, ColumnEdge, RowEdge, ColumnEdge,
+                RowEdge, ColumnEdge, RowEdge, ColumnEdge,
+                ImageEdge, ImageEdge, ImageEdge, ImageEdge
+            } };
+
+            const auto img_num = img_adj.image_to_index( img_refw );
+            const auto img_num_p1 = img_num + 1;
+            const auto img_is_adj = img_adj.index_present(img_num_p1);
+            const auto img_p1 = (img_is_adj) ? img_adj.index_to_image(img_num_p1) : img_refw;
+
+            for(long int row = 0; row < N_rows; ++row){
+                for(long int col = 0; col < N_cols; ++col){
+                    const auto pos = img_refw.get().position(row, col);
+
+                    // Sample voxel corner values.
+                    std::array<double, 8> afCubeValue;
+                    //
+                    // Option A: Interpolate. This way is slow but extremely flexible.
+                    //for(int32_t corner = 0; corner < 8; ++corner){
+                    //    afCubeValue[corner] = surface_oracle(pos + a2fVertexOffset[corner]);
+                    //}
+                    //
+                    // Option B: Align Marching Cube voxel corners with image voxel centres. This way is fast.
+                    {
+                        const auto row_p1 = (row+1);
+                        const auto row_is_adj = (row_p1 < N_rows);
+
+                        const auto col_p1 = (col+1);
+                        const auto col_is_adj = (col_p1 < N_cols);
+
+                        afCubeValue[0] = img_refw.get().value(row, col, 0);
+                        afCubeValue[1] = (row_is_adj)                             ? img_refw.get().value(row_p1, col, 0)    : ExteriorVal;
+                        afCubeValue[2] = (row_is_adj && col_is_adj)               ? img_refw.get().value(row_p1, col_p1, 0) : ExteriorVal;
+                        afCubeValue[3] = (col_is_adj)                             ? img_refw.get().value(row, col_p1, 0)    : ExteriorVal;
+                        afCubeValue[4] = (img_is_adj)                             ? img_p1.get().value(row, col, 0)         : ExteriorVal;
+                        afCubeValue[5] = (row_is_adj && img_is_adj)               ? img_p1.get().value(row_p1, col, 0)      : ExteriorVal;
+                        afCubeValue[6] = (row_is_adj && col_is_adj && img_is_adj) ? img_p1.get().value(row_p1, col_p1, 0)   : ExteriorVal;
+                        afCubeValue[7] = (col_is_adj && img_is_adj)               ? img_p1.get().value(row, col_p1, 0)      : ExteriorVal;
+                    }
+
+                    // Convert vertex inclusion to a bitmask.
+                    int32_t iFlagIndex = 0;
+                    for(int32_t corner = 0; corner < 8; ++corner){
+                        if(below_is_interior){
+                            if(afCubeValue[corner] <= inclusion_threshold) iFlagIndex |= (1 << corner);
+                        }else{
+                            if(afCubeValue[corner] >= inclusion_threshold) iFlagIndex |= (1 << corner);
                         }
+                    }
 
-                        asEdgeVertex[edge] = (a2fEdgeDirection[edge] * surf_dl);
-                        asEdgeVertex[edge] += a2fVertexOffset[a2iEdgeConnection[edge][0]];
-                        asEdgeVertex[edge] += pos;
+                    // Convert vertex inclusion into a list of 'involved' edges that cross the ROI surface.
+                    const int32_t iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
+
+                    // If the cube is entirely inside or outside of the surface, then there will be no intersections.
+                    if(iEdgeFlags == 0) continue;
+
+                    // Find the point of intersection of the surface with each edge, and the lattice slot it belongs to.
+                    std::array<vec3<double>, 12> asEdgeVertex;
+                    std::array<std::pair<int32_t, long int>, 12> asEdgeKey; // (layer, slot).
+                    for(int32_t edge = 0; edge < 12; edge++){
+                        if(iEdgeFlags & (1 << edge)){ // continue iff involved.
+                            const auto corner_A = a2iCanonicalEdgeConnection[edge][0];
+                            const auto corner_B = a2iCanonicalEdgeConnection[edge][1];
+                            const double value_A = afCubeValue[corner_A];
+                            const double value_B = afCubeValue[corner_B];
+
+                            // Find the (approximate) point along the edge where the surface intersects, parameterized to [0:1].
+                            const double d_value = (value_B - value_A);
+                            const double inv_d_value = static_cast<double>(1.0)/d_value;
+                            const double lin_interp = (inclusion_threshold - value_A) * inv_d_value;
+                            const double surf_dl = std::isfinite(lin_interp) ? lin_interp : static_cast<double>(0.5);
+                            if(!isininc(0.0,surf_dl,1.0)){
+                                throw std::logic_error("Interpolation of surface-edge intersection failed. Refusing to continue");
+                            }
+
+                            // Snap to the voxel centre if the intersection is (nearly) coincident with it.
+                            int32_t snap_corner = -1;
+                            if(surf_dl * a2fEdgeLength[edge] <= dvec3_tol){
+                                snap_corner = corner_A;
+                            }else if((1.0 - surf_dl) * a2fEdgeLength[edge] <= dvec3_tol){
+                                snap_corner = corner_B;
+                            }
+
+                            if(snap_corner < 0){
+                                const auto &l = a2iCornerLatticeOffset[corner_A];
+                                asEdgeKey[edge] = { l[2], slot_index(row + l[0], col + l[1], a2iEdgeSlot[edge]) };
+                                asEdgeVertex[edge] = (a2fEdgeDirection[edge] * surf_dl);
+                                asEdgeVertex[edge] += a2fVertexOffset[corner_A];
+                            }else{
+                                const auto &l = a2iCornerLatticeOffset[snap_corner];
+                                asEdgeKey[edge] = { l[2], slot_index(row + l[0], col + l[1], LatticePoint) };
+                                asEdgeVertex[edge] = a2fVertexOffset[snap_corner];
+                            }
+                            asEdgeVertex[edge] += pos;
+                        }
                     }
-                }
 
-                // Process the triangles that were identified.
-                for(int32_t tri = 0; tri < 5; tri++){
+                    // Process the triangles that were identified.
+                    for(int32_t tri = 0; tri < 5; tri++){
 
-                    // Stop when the first -1 index is encountered (signifying there are no further triangles).
-                    if(a2iTriangleConnectionTable[iFlagIndex][3*tri] < 0) break;
+                        // Stop when the first -1 index is encountered (signifying there are no further triangles).
+                        if(a2iTriangleConnectionTable[iFlagIndex][3*tri] < 0) break;
 
-                    std::array<vec3<double>, 3> tri_verts;
-                    for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
-                        const int32_t vert_idx = a2iTriangleConnectionTable[iFlagIndex][3*tri + tri_corner];
-                        tri_verts[tri_corner] = asEdgeVertex[vert_idx];
-    
-                    }
+                        std::array<int32_t, 3> tri_edges;
+                        for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
+                            tri_edges[tri_corner] = a2iTriangleConnectionTable[iFlagIndex][3*tri + tri_corner];
+                        }
 
-                    // Determine which vertices should be used; if there are existing vertices sufficiently nearby, use
-                    // them rather than adding a new (disconnected) vertex.
-                    //
-                    // Note: Existing vertices created for adjacent voxels are more likely to be placed near the back of
-                    //       the vector. Using reverse iterators for searching rather than forward iterators more than
-                    //       halves the time this entire routine takes. 
-                    //
-                    // TODO: Below we use a generic lookup that considers the last N vertices added where N is selected
-                    //       so that it will include all possibly-adjacent voxels (in the worst case). While this works
-                    //       to limit needless complexity when there are many voxels, it is wasteful and could be
-                    //       improved. For example, spatial indexing of some kind could be used to speed up dupe vertex
-                    //       searching, or this could be fully eliminated by exploiting the grid nature or keeping an
-                    //       explicit list of vertices still reachable.
-                    //
-                    //       Note that the last-N-only lookup below implicitly assumes images are ordered AND traversed
-                    //       in adjacent order. 
-                    const auto min_consider = static_cast<long int>( ( N_rows * N_cols + 1 + std::max(N_rows, N_cols) + 1 ) * 5 * 3 );
-
-                    std::array<size_t, 3> vert_indices;
-                    std::vector<Kernel::Point_3> new_verts;
-                    for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
-                        const auto N_verts = static_cast<long int>( mesh_triangle_verts.size() );
-                        const auto consider = std::min( min_consider, N_verts );
-                        const auto rend = std::next(std::rbegin(mesh_triangle_verts), consider);
-                        auto v_it = std::find_if( //std::execution::par_unseq,
-                                                  std::rbegin(mesh_triangle_verts),
-                                                  rend,
-                                                  [=]( const Kernel::Point_3 &cv ) -> bool {
-                                                      const vec3<double> v( cv[0], cv[1], cv[2] );
-                                                      return (tri_verts[tri_corner].sq_dist(v) < (dvec3_tol*dvec3_tol));
-                                                  } );
-                        
-                        if(v_it != std::rend(mesh_triangle_verts)){
-                            vert_indices[tri_corner] = mesh_triangle_verts.size() - std::distance(std::rbegin(mesh_triangle_verts), v_it) - 1;
-                        }else{
-                            new_verts.emplace_back( Kernel::Point_3( 
-                                    tri_verts[tri_corner].x, tri_verts[tri_corner].y, tri_verts[tri_corner].z ) );
-                            vert_indices[tri_corner] = (mesh_triangle_verts.size() + new_verts.size() - 1);
+                        // Vertices were welded when they were placed on the lattice, so degenerate triangles can be
+                        // identified directly by comparing lattice slots.
+                        const auto &key_0 = asEdgeKey[tri_edges[0]];
+                        const auto &key_1 = asEdgeKey[tri_edges[1]];
+                        const auto &key_2 = asEdgeKey[tri_edges[2]];
+                        if( (key_0 == key_1)
+                        ||  (key_0 == key_2)
+                        ||  (key_1 == key_2) ){
+                            FUNCWARN("Encountered a zero-area triangle face. Ignoring it");
+                            continue;
+                        }
+
+                        // Re-use existing vertices if they have already been placed, otherwise add them.
+                        std::array<size_t, 3> vert_indices;
+                        for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
+                            const auto edge = tri_edges[tri_corner];
+                            const auto &key = asEdgeKey[edge];
+                            auto &layer = (key.first == 0) ? curr_layer : next_layer;
+                            auto &vert_index = layer[key.second];
+                            if(vert_index < 0){
+                                if(static_cast<size_t>(std::numeric_limits<int32_t>::max()) <= mesh_triangle_verts.size()){
+                                    throw std::runtime_error("Too many vertices in a single slab. Increase the number of slabs.");
+                                }
+                                vert_index = static_cast<int32_t>(mesh_triangle_verts.size());
+                                mesh_triangle_verts.emplace_back( Kernel::Point_3( 
+                                        asEdgeVertex[edge].x, asEdgeVertex[edge].y, asEdgeVertex[edge].z ) );
+                            }
+                            vert_indices[tri_corner] = static_cast<size_t>(vert_index);
                         }
-                    }
-                    if( (vert_indices[0] != vert_indices[1]) // IFF all three vertices are distinct from one another.
-                    &&  (vert_indices[0] != vert_indices[2])
-                    &&  (vert_indices[1] != vert_indices[2]) ){
                         mesh_triangle_faces.emplace_back(vert_indices);
-                        mesh_triangle_verts.insert( std::end(mesh_triangle_verts), 
-                                                    std::begin(new_verts), std::end(new_verts) );
+                    }
+
+                } // Loop over columns.
+            } // Loop over rows.
+
+            // Advance the lattice layers. The bottom layer of the slab is retained for stitching.
+            if(img_i == slab.img_begin){
+                slab.bottom_layer = extract_layer(curr_layer);
+            }
+            std::swap(curr_layer, next_layer);
+            std::fill(std::begin(next_layer), std::end(next_layer), -1);
+            if(!img_is_adj){
+                // The next image does not abut this image, so the next lattice layer is not shared.
+                std::fill(std::begin(curr_layer), std::end(curr_layer), -1);
+            }
+            if(img_i == (slab.img_end - 1)){
+                slab.top_is_adj = img_is_adj;
+                slab.top_layer = extract_layer(curr_layer);
+            }
+
+            //Report operation progress.
+            {
+                std::lock_guard<std::mutex> lock(saver_printer);
+                ++completed;
+                FUNCINFO("Completed " << completed << " of " << img_count
+                      << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+            }
+        } // Loop over images.
+        return;
+    };
+
+    // Mesh each slab.
+    if(N_slabs == 1){
+        mesh_slab(slabs.front());
+    }else{
+        asio_thread_pool tp(static_cast<size_t>(N_slabs));
+        for(auto &slab : slabs){
+            tp.submit_task([&]() -> void {
+                mesh_slab(slab);
+            }); // thread pool task closure.
+        }
+    } // Wait until all threads are done.
+
+    // Stitch the slabs together, welding vertices on shared lattice layers.
+    std::vector<Kernel::Point_3> mesh_triangle_verts;
+    std::vector< std::array<size_t, 3> > mesh_triangle_faces;
+    {
+        std::vector< std::pair<long int, size_t> > prev_top_layer; // (slot, global vertex index).
+        bool prev_top_is_adj = false;
+        for(auto &slab : slabs){
+            constexpr auto unassigned = std::numeric_limits<size_t>::max();
+            std::vector<size_t> remap(slab.verts.size(), unassigned);
+
+            if(prev_top_is_adj){
+                auto p_it = std::begin(prev_top_layer);
+                auto b_it = std::begin(slab.bottom_layer);
+                while( (p_it != std::end(prev_top_layer))
+                &&     (b_it != std::end(slab.bottom_layer)) ){
+                    if(p_it->first < b_it->first){
+                        ++p_it;
+                    }else if(b_it->first < p_it->first){
+                        ++b_it;
                     }else{
-                        FUNCWARN("Encountered a zero-area triangle face. Ignoring it");
+                        remap[b_it->second] = p_it->second;
+                        ++p_it;
+                        ++b_it;
                     }
                 }
+            }
+
+            for(size_t i = 0; i < slab.verts.size(); ++i){
+                if(remap[i] == unassigned){
+                    remap[i] = mesh_triangle_verts.size();
+                    mesh_triangle_verts.emplace_back(slab.verts[i]);
+                }
+            }
+            for(const auto &f : slab.faces){
+                mesh_triangle_faces.emplace_back( std::array<size_t, 3>{{ remap[f[0]], remap[f[1]], remap[f[2]] }} );
+            }
 
-            } // Loop over columns.
-        } // Loop over rows.
+            prev_top_layer = slab.top_layer;
+            for(auto &p : prev_top_layer) p.second = remap[p.second];
+            prev_top_is_adj = slab.top_is_adj;
 
-        //Report operation progress.
-        {
-            std::lock_guard<std::mutex> lock(saver_printer);
-            ++completed;
-            FUNCINFO("Completed " << completed << " of " << img_count
-                  << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+            slab = mc_slab_t();
         }
-    } // Loop over images.
+    }
 
     FUNCINFO("Orienting face normals..");
     CGAL::Polygon_mesh_processing::orient_polygon_soup(mesh_triangle_verts, mesh_triangle_faces);
@@ -2093,6 +2262,47 @@ SurfaceArea(const Polyhedron &mesh){
     return sarea;
 }
 
+Polyhedron
+Convex_Hull( std::list<std::reference_wrapper<contour_collection<double>>> cc_ROIs ){
+    std::vector<Kernel::Point_3> points;
+    for(const auto &cc_refw : cc_ROIs){
+        for(const auto &c : cc_refw.get().contours){
+            for(const auto &p : c.points){
+                points.emplace_back(p.x, p.y, p.z);
+            }
+        }
+    }
+
+    Polyhedron hull;
+    if(!points.empty()){
+        CGAL::convex_hull_3(std::begin(points), std::end(points), hull);
+    }
+    return hull;
+}
+
+double
+Diameter(const Polyhedron &mesh){
+    // Only the hull vertices need to be compared, which are typically far fewer than the input vertices.
+    std::vector<vec3<double>> verts;
+    verts.reserve(mesh.size_of_vertices());
+    for(auto v_it = mesh.vertices_begin(); v_it != mesh.vertices_end(); ++v_it){
+        const auto &p = v_it->point();
+        verts.emplace_back( static_cast<double>(CGAL::to_double(p.x())),
+                            static_cast<double>(CGAL::to_double(p.y())),
+                            static_cast<double>(CGAL::to_double(p.z())) );
+    }
+
+    double max_sq_dist = -1.0;
+    const auto N = verts.size();
+    for(size_t i = 0; i < N; ++i){
+        for(size_t j = i + 1; j < N; ++j){
+            max_sq_dist = std::max(max_sq_dist, verts[i].sq_dist(verts[j]));
+        }
+    }
+    if(N == 1) max_sq_dist = 0.0;
+    return (max_sq_dist < 0.0) ? std::numeric_limits<double>::quiet_NaN() : std::sqrt(max_sq_dist);
+}
+
 
 } // namespace polyhedron_processing
 
@@ -50,6 +50,11 @@ struct Parameters {
     //   many vertices to reasonably dilate or erode.
     ReproductionQuality RQ = ReproductionQuality::High;
 
+    // The number of contiguous slabs of images that Marching Cubes will mesh concurrently. Slabs are stitched together
+    // afterward, so the resultant mesh does not depend on this number. Each concurrent slab requires memory
+    // proportional to the number of voxels in a single image. If not sensible, defaults to the number of cores.
+    long int MarchingCubesSlabs = -1;
+
 };
 
 
@@ -153,5 +158,13 @@ Volume(const Polyhedron &mesh);
 double
 SurfaceArea(const Polyhedron &mesh);
 
+// Convex hull of contour vertex point clouds. The hull is flat (i.e., not closed) if all vertices are coplanar.
+Polyhedron
+Convex_Hull( std::list<std::reference_wrapper<contour_collection<double>>> cc_ROIs );
+
+// The greatest distance between any two vertices. Applied to a convex hull, this is the diameter of the hull's input.
+double
+Diameter(const Polyhedron &mesh);
+
 } // namespace polyhedron_processing
 
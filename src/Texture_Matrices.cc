@@ -0,0 +1,507 @@
+//Texture_Matrices.cc - A part of DICOMautomaton 2021. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+#include "Thread_Pool.h"
+#include "Texture_Matrices.h"
+
+
+size_t texture_volume::index(long int row, long int col, long int img) const {
+    return static_cast<size_t>((img * this->N_rows + row) * this->N_cols + col);
+}
+
+texture_volume
+Quantize_Intensities(long int N_rows,
+                     long int N_cols,
+                     long int N_imgs,
+                     const std::vector<float> &intensities,
+                     long int N_levels){
+    if(N_levels < 1){
+        throw std::invalid_argument("At least one grey level is required.");
+    }
+    if( (N_rows < 0) || (N_cols < 0) || (N_imgs < 0)
+    ||  (intensities.size() != static_cast<size_t>(N_rows * N_cols * N_imgs)) ){
+        throw std::invalid_argument("Volume dimensions are inconsistent with the number of voxels.");
+    }
+
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    for(const auto &x : intensities){
+        if(!std::isfinite(x)) continue;
+        min = std::min(min, static_cast<double>(x));
+        max = std::max(max, static_cast<double>(x));
+    }
+
+    texture_volume out;
+    out.N_rows = N_rows;
+    out.N_cols = N_cols;
+    out.N_imgs = N_imgs;
+    out.N_levels = N_levels;
+    out.levels.resize(intensities.size());
+    const auto range = max - min;
+    for(size_t i = 0; i < intensities.size(); ++i){
+        const auto x = static_cast<double>(intensities[i]);
+        if(!std::isfinite(x)){
+            out.levels[i] = -1;
+            continue;
+        }
+        auto l = (0.0 < range) ? static_cast<long int>(std::floor(static_cast<double>(N_levels) * (x - min) / range)) : 0L;
+        out.levels[i] = static_cast<int32_t>( std::clamp(l, 0L, N_levels - 1L) );
+    }
+    return out;
+}
+
+
+std::array<std::array<long int, 3>, 13>
+Texture_Directions(){
+    std::array<std::array<long int, 3>, 13> out;
+    size_t n = 0;
+    for(long int di = -1; di <= 1; ++di){
+        for(long int dr = -1; dr <= 1; ++dr){
+            for(long int dc = -1; dc <= 1; ++dc){
+                // Keep only one of each pair of opposing directions.
+                const bool positive = (0 < di) || ((di == 0) && (0 < dr)) || ((di == 0) && (dr == 0) && (0 < dc));
+                if(positive) out[n++] = {{ dr, dc, di }};
+            }
+        }
+    }
+    return out;
+}
+
+
+texture_matrix::texture_matrix(long int N_rows, long int N_cols)
+    : N_rows(N_rows),
+      N_cols(N_cols),
+      counts(static_cast<size_t>(N_rows * N_cols), 0.0) {}
+
+double & texture_matrix::at(long int row, long int col){
+    return this->counts[ static_cast<size_t>(row * this->N_cols + col) ];
+}
+
+double texture_matrix::at(long int row, long int col) const {
+    return this->counts[ static_cast<size_t>(row * this->N_cols + col) ];
+}
+
+void texture_matrix::add(const texture_matrix &other){
+    if( (this->N_rows < other.N_rows) || (this->N_cols < other.N_cols) ){
+        texture_matrix grown(std::max(this->N_rows, other.N_rows), std::max(this->N_cols, other.N_cols));
+        for(long int r = 0; r < this->N_rows; ++r){
+            for(long int c = 0; c < this->N_cols; ++c){
+                grown.at(r, c) = this->at(r, c);
+            }
+        }
+        *this = std::move(grown);
+    }
+    for(long int r = 0; r < other.N_rows; ++r){
+        for(long int c = 0; c < other.N_cols; ++c){
+            this->at(r, c) += other.at(r, c);
+        }
+    }
+    return;
+}
+
+
+namespace {
+
+// Partitions [0, N) into contiguous blocks, a few per thread so that work is balanced.
+std::vector<std::pair<long int, long int>> partition_range(long int N){
+    const auto N_threads = std::max(1L, static_cast<long int>(std::thread::hardware_concurrency()));
+    const auto N_blocks = std::max(1L, std::min(N, 2L * N_threads));
+    std::vector<std::pair<long int, long int>> out;
+    for(long int b = 0; b < N_blocks; ++b){
+        const auto first = (N * b) / N_blocks;
+        const auto last = (N * (b + 1)) / N_blocks;
+        if(first < last) out.emplace_back(first, last);
+    }
+    return out;
+}
+
+bool in_volume(const texture_volume &vol, long int r, long int c, long int i){
+    return (0 <= r) && (r < vol.N_rows)
+        && (0 <= c) && (c < vol.N_cols)
+        && (0 <= i) && (i < vol.N_imgs);
+}
+
+// Element-wise reduction of per-block matrices.
+std::vector<texture_matrix> reduce_blocks(std::vector<std::vector<texture_matrix>> &blocks){
+    if(blocks.empty()) return {};
+    auto out = std::move(blocks.front());
+    for(size_t b = 1; b < blocks.size(); ++b){
+        for(size_t d = 0; d < out.size(); ++d){
+            out[d].add(blocks[b][d]);
+        }
+    }
+    return out;
+}
+
+double safe_log2(double x){
+    return (0.0 < x) ? std::log2(x) : 0.0;
+}
+
+// Averages features over directions, ignoring directions without any counts.
+struct feature_averager {
+    std::vector<std::string> names;
+    std::vector<double> sums;
+    long int N = 0;
+
+    explicit feature_averager(std::vector<std::string> names) : names(std::move(names)), sums(this->names.size(), 0.0) {}
+
+    void add(const std::vector<double> &vals){
+        for(size_t i = 0; i < vals.size(); ++i) this->sums[i] += vals[i];
+        ++(this->N);
+        return;
+    }
+
+    texture_features_t finalize(const std::string &prefix) const {
+        texture_features_t out;
+        for(size_t i = 0; i < this->names.size(); ++i){
+            const auto val = (0 < this->N) ? (this->sums[i] / static_cast<double>(this->N))
+                                           : std::numeric_limits<double>::quiet_NaN();
+            out.emplace_back(prefix + this->names[i], val);
+        }
+        return out;
+    }
+};
+
+} // namespace.
+
+
+std::vector<texture_matrix> Compute_GLCMs(const texture_volume &vol){
+    const auto dirs = Texture_Directions();
+    const auto Ng = vol.N_levels;
+    const auto blocks = partition_range(vol.N_imgs);
+
+    // Each block of images accumulates into its own matrices, which are reduced afterward. Voxel pairs are visited
+    // one pair of rows at a time, so memory is accessed sequentially.
+    std::vector<std::vector<texture_matrix>> block_mats(blocks.size(), std::vector<texture_matrix>(dirs.size(), texture_matrix(Ng, Ng)));
+    {
+        asio_thread_pool tp;
+        for(size_t b = 0; b < blocks.size(); ++b){
+            tp.submit_task([&,b]() -> void {
+                auto &mats = block_mats[b];
+                for(long int i = blocks[b].first; i < blocks[b].second; ++i){
+                    for(size_t d = 0; d < dirs.size(); ++d){
+                        const auto dr = dirs[d][0];
+                        const auto dc = dirs[d][1];
+                        const auto di = dirs[d][2];
+                        const auto i2 = i + di;
+                        if((i2 < 0) || (vol.N_imgs <= i2)) continue;
+
+                        auto *m = mats[d].counts.data();
+                        const auto c_lo = std::max(0L, -dc);
+                        const auto c_hi = std::min(vol.N_cols, vol.N_cols - dc);
+                        for(long int r = std::max(0L, -dr); r < std::min(vol.N_rows, vol.N_rows - dr); ++r){
+                            const auto *A = &vol.levels[vol.index(r, 0, i)];
+                            const auto *B = &vol.levels[vol.index(r + dr, dc, i2)];
+                            for(long int c = c_lo; c < c_hi; ++c){
+                                const auto ga = A[c];
+                                const auto gb = B[c];
+                                if((ga < 0) || (gb < 0)) continue;
+                                m[ga * Ng + gb] += 1.0;
+                                m[gb * Ng + ga] += 1.0;
+                            }
+                        }
+                    }
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait until all threads are done.
+    return reduce_blocks(block_mats);
+}
+
+std::vector<texture_matrix> Compute_GLRLMs(const texture_volume &vol){
+    const auto dirs = Texture_Directions();
+    const auto Ng = vol.N_levels;
+    const auto L_max = std::max({ vol.N_rows, vol.N_cols, vol.N_imgs, 1L });
+    const auto blocks = partition_range(vol.N_imgs);
+
+    // Each run is counted by the block that contains its first voxel.
+    std::vector<std::vector<texture_matrix>> block_mats(blocks.size(), std::vector<texture_matrix>(dirs.size(), texture_matrix(Ng, L_max)));
+    {
+        asio_thread_pool tp;
+        for(size_t b = 0; b < blocks.size(); ++b){
+            tp.submit_task([&,b]() -> void {
+                auto &mats = block_mats[b];
+                for(long int i = blocks[b].first; i < blocks[b].second; ++i){
+                    for(size_t d = 0; d < dirs.size(); ++d){
+                        const auto dr = dirs[d][0];
+                        const auto dc = dirs[d][1];
+                        const auto di = dirs[d][2];
+                        auto &m = mats[d];
+                        for(long int r = 0; r < vol.N_rows; ++r){
+                            for(long int c = 0; c < vol.N_cols; ++c){
+                                const auto g = vol.levels[vol.index(r, c, i)];
+                                if(g < 0) continue;
+
+                                // Skip voxels that continue a run.
+                                if( in_volume(vol, r - dr, c - dc, i - di)
+                                &&  (vol.levels[vol.index(r - dr, c - dc, i - di)] == g) ) continue;
+
+                                long int len = 1;
+                                while( in_volume(vol, r + len * dr, c + len * dc, i + len * di)
+                                &&     (vol.levels[vol.index(r + len * dr, c + len * dc, i + len * di)] == g) ){
+                                    ++len;
+                                }
+                                m.at(g, len - 1) += 1.0;
+                            }
+                        }
+                    }
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait until all threads are done.
+    return reduce_blocks(block_mats);
+}
+
+texture_matrix Compute_GLSZM(const texture_volume &vol){
+    const auto Ng = vol.N_levels;
+
+    // Bucket voxels by grey level. Zones never span grey levels, so each grey level can be processed independently.
+    std::vector<std::vector<size_t>> by_level(static_cast<size_t>(Ng));
+    for(size_t k = 0; k < vol.levels.size(); ++k){
+        const auto g = vol.levels[k];
+        if(0 <= g) by_level[g].push_back(k);
+    }
+
+    // Note: each voxel's visited flag is only accessed by the task handling the voxel's grey level, so the grey level
+    //       must always be checked before the flag.
+    std::vector<uint8_t> visited(vol.levels.size(), 0);
+    std::vector<std::vector<double>> zone_counts(static_cast<size_t>(Ng)); // Indexed by zone size - 1.
+    {
+        asio_thread_pool tp;
+        for(long int g = 0; g < Ng; ++g){
+            if(by_level[g].empty()) continue;
+            tp.submit_task([&,g]() -> void {
+                auto &counts = zone_counts[g];
+                std::vector<size_t> stack;
+                const auto N_rc = vol.N_rows * vol.N_cols;
+                for(const auto seed : by_level[g]){
+                    if(visited[seed]) continue;
+                    visited[seed] = 1;
+                    stack.assign(1, seed);
+                    long int size = 0;
+                    while(!stack.empty()){
+                        const auto k = static_cast<long int>(stack.back());
+                        stack.pop_back();
+                        ++size;
+
+                        const auto i = k / N_rc;
+                        const auto r = (k % N_rc) / vol.N_cols;
+                        const auto c = k % vol.N_cols;
+                        for(long int di = -1; di <= 1; ++di){
+                            for(long int dr = -1; dr <= 1; ++dr){
+                                for(long int dc = -1; dc <= 1; ++dc){
+                                    if(!in_volume(vol, r + dr, c + dc, i + di)) continue;
+                                    const auto n = vol.index(r + dr, c + dc, i + di);
+                                    if((vol.levels[n] != g) || visited[n]) continue; // Level first; see note above.
+                                    visited[n] = 1;
+                                    stack.push_back(n);
+                                }
+                            }
+                        }
+                    }
+                    if(static_cast<long int>(counts.size()) < size) counts.resize(static_cast<size_t>(size), 0.0);
+                    counts[size - 1] += 1.0;
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait until all threads are done.
+
+    long int Z_max = 1;
+    for(const auto &counts : zone_counts) Z_max = std::max(Z_max, static_cast<long int>(counts.size()));
+    texture_matrix out(Ng, Z_max);
+    for(long int g = 0; g < Ng; ++g){
+        for(size_t z = 0; z < zone_counts[g].size(); ++z){
+            out.at(g, static_cast<long int>(z)) = zone_counts[g][z];
+        }
+    }
+    return out;
+}
+
+
+texture_features_t GLCM_Features(const std::vector<texture_matrix> &glcms){
+    feature_averager avg({ "JointMaximum",
+                           "JointAverage",
+                           "JointVariance",
+                           "JointEntropy",
+                           "DifferenceAverage",
+                           "DifferenceEntropy",
+                           "Contrast",
+                           "Dissimilarity",
+                           "InverseDifference",
+                           "InverseDifferenceMoment",
+                           "AngularSecondMoment",
+                           "Correlation",
+                           "ClusterTendency",
+                           "ClusterShade",
+                           "ClusterProminence" });
+
+    for(const auto &m : glcms){
+        const auto Ng = m.N_rows;
+        double total = 0.0;
+        for(const auto &x : m.counts) total += x;
+        if(total <= 0.0) continue;
+
+        // Matrices are symmetric, so both marginal distributions are identical.
+        std::vector<double> p_x(static_cast<size_t>(Ng), 0.0);
+        std::vector<double> p_diff(static_cast<size_t>(Ng), 0.0);
+        double joint_max = 0.0;
+        double joint_entropy = 0.0;
+        double asm_ = 0.0;
+        for(long int a = 0; a < Ng; ++a){
+            for(long int b = 0; b < Ng; ++b){
+                const auto p = m.at(a, b) / total;
+                p_x[a] += p;
+                p_diff[std::abs(a - b)] += p;
+                joint_max = std::max(joint_max, p);
+                joint_entropy -= p * safe_log2(p);
+                asm_ += p * p;
+            }
+        }
+        double mu = 0.0;
+        for(long int a = 0; a < Ng; ++a) mu += static_cast<double>(a + 1) * p_x[a];
+        double var = 0.0;
+        for(long int a = 0; a < Ng; ++a) var += std::pow(static_cast<double>(a + 1) - mu, 2.0) * p_x[a];
+
+        double diff_avg = 0.0;
+        double diff_entropy = 0.0;
+        for(long int k = 0; k < Ng; ++k){
+            diff_avg += static_cast<double>(k) * p_diff[k];
+            diff_entropy -= p_diff[k] * safe_log2(p_diff[k]);
+        }
+
+        double contrast = 0.0;
+        double dissimilarity = 0.0;
+        double inv_diff = 0.0;
+        double inv_diff_mom = 0.0;
+        double corr_num = 0.0;
+        double clust_tend = 0.0;
+        double clust_shade = 0.0;
+        double clust_prom = 0.0;
+        for(long int a = 0; a < Ng; ++a){
+            for(long int b = 0; b < Ng; ++b){
+                const auto p = m.at(a, b) / total;
+                if(p <= 0.0) continue;
+                const auto i = static_cast<double>(a + 1);
+                const auto j = static_cast<double>(b + 1);
+                const auto d = std::abs(i - j);
+                const auto s = i + j - 2.0 * mu;
+                contrast += d * d * p;
+                dissimilarity += d * p;
+                inv_diff += p / (1.0 + d);
+                inv_diff_mom += p / (1.0 + d * d);
+                corr_num += (i - mu) * (j - mu) * p;
+                clust_tend += s * s * p;
+                clust_shade += s * s * s * p;
+                clust_prom += s * s * s * s * p;
+            }
+        }
+        // A uniform region is perfectly correlated with itself.
+        const auto correlation = (0.0 < var) ? (corr_num / var) : 1.0;
+
+        avg.add({ joint_max, mu, var, joint_entropy, diff_avg, diff_entropy, contrast, dissimilarity,
+                  inv_diff, inv_diff_mom, asm_, correlation, clust_tend, clust_shade, clust_prom });
+    }
+    return avg.finalize("GLCM");
+}
+
+texture_features_t GLRLM_Features(const std::vector<texture_matrix> &glrlms, long int N_voxels){
+    feature_averager avg({ "ShortRunsEmphasis",
+                           "LongRunsEmphasis",
+                           "LowGreyLevelRunEmphasis",
+                           "HighGreyLevelRunEmphasis",
+                           "GreyLevelNonUniformity",
+                           "RunLengthNonUniformity",
+                           "RunPercentage" });
+
+    for(const auto &m : glrlms){
+        double N_runs = 0.0;
+        for(const auto &x : m.counts) N_runs += x;
+        if(N_runs <= 0.0) continue;
+
+        double sre = 0.0;
+        double lre = 0.0;
+        double lgre = 0.0;
+        double hgre = 0.0;
+        std::vector<double> by_level(static_cast<size_t>(m.N_rows), 0.0);
+        std::vector<double> by_length(static_cast<size_t>(m.N_cols), 0.0);
+        for(long int g = 0; g < m.N_rows; ++g){
+            const auto i = static_cast<double>(g + 1);
+            for(long int l = 0; l < m.N_cols; ++l){
+                const auto x = m.at(g, l);
+                if(x <= 0.0) continue;
+                const auto j = static_cast<double>(l + 1);
+                sre += x / (j * j);
+                lre += x * j * j;
+                lgre += x / (i * i);
+                hgre += x * i * i;
+                by_level[g] += x;
+                by_length[l] += x;
+            }
+        }
+        double glnu = 0.0;
+        for(const auto &x : by_level) glnu += x * x;
+        double rlnu = 0.0;
+        for(const auto &x : by_length) rlnu += x * x;
+
+        avg.add({ sre / N_runs, lre / N_runs, lgre / N_runs, hgre / N_runs, glnu / N_runs, rlnu / N_runs,
+                  N_runs / static_cast<double>(N_voxels) });
+    }
+    return avg.finalize("GLRLM");
+}
+
+texture_features_t GLSZM_Features(const texture_matrix &glszm, long int N_voxels){
+    feature_averager avg({ "SmallZoneEmphasis",
+                           "LargeZoneEmphasis",
+                           "LowGreyLevelZoneEmphasis",
+                           "HighGreyLevelZoneEmphasis",
+                           "GreyLevelNonUniformity",
+                           "ZoneSizeNonUniformity",
+                           "ZonePercentage" });
+
+    const auto &m = glszm;
+    double N_zones = 0.0;
+    for(const auto &x : m.counts) N_zones += x;
+    if(0.0 < N_zones){
+        double sze = 0.0;
+        double lze = 0.0;
+        double lgze = 0.0;
+        double hgze = 0.0;
+        std::vector<double> by_level(static_cast<size_t>(m.N_rows), 0.0);
+        std::vector<double> by_size(static_cast<size_t>(m.N_cols), 0.0);
+        for(long int g = 0; g < m.N_rows; ++g){
+            const auto i = static_cast<double>(g + 1);
+            for(long int z = 0; z < m.N_cols; ++z){
+                const auto x = m.at(g, z);
+                if(x <= 0.0) continue;
+                const auto j = static_cast<double>(z + 1);
+                sze += x / (j * j);
+                lze += x * j * j;
+                lgze += x / (i * i);
+                hgze += x * i * i;
+                by_level[g] += x;
+                by_size[z] += x;
+            }
+        }
+        double glnu = 0.0;
+        for(const auto &x : by_level) glnu += x * x;
+        double zsnu = 0.0;
+        for(const auto &x : by_size) zsnu += x * x;
+
+        avg.add({ sze / N_zones, lze / N_zones, lgze / N_zones, hgze / N_zones, glnu / N_zones, zsnu / N_zones,
+                  N_zones / static_cast<double>(N_voxels) });
+    }
+    return avg.finalize("GLSZM");
+}
+
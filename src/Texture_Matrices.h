@@ -0,0 +1,74 @@
+//Texture_Matrices.h - A part of DICOMautomaton 2021. Written by hal clark.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// A 3D volume of quantized (i.e., discretized) voxel intensities, in voxel number space.
+//
+// Voxels are stored with the column number varying fastest, then the row number, then the image number. Grey levels
+// are in [0, N_levels). Voxels outside the ROI have level -1.
+struct texture_volume {
+    long int N_rows = 0;
+    long int N_cols = 0;
+    long int N_imgs = 0;
+    long int N_levels = 0;
+    std::vector<int32_t> levels;
+
+    size_t index(long int row, long int col, long int img) const;
+};
+
+// Quantizes voxel intensities into N_levels equal-width grey levels spanning the range of intensities (i.e., 'fixed
+// bin number' discretization). Non-finite intensities are treated as being outside the ROI.
+//
+// Intensities are ordered like texture_volume::levels.
+texture_volume
+Quantize_Intensities(long int N_rows,
+                     long int N_cols,
+                     long int N_imgs,
+                     const std::vector<float> &intensities,
+                     long int N_levels);
+
+
+// The 13 unique directions connecting a voxel with its 26 neighbours, as (row, column, image) offsets.
+std::array<std::array<long int, 3>, 13>
+Texture_Directions();
+
+// A dense, row-major matrix of counts.
+struct texture_matrix {
+    long int N_rows = 0;
+    long int N_cols = 0;
+    std::vector<double> counts;
+
+    texture_matrix() = default;
+    texture_matrix(long int N_rows, long int N_cols);
+
+    double & at(long int row, long int col);
+    double at(long int row, long int col) const;
+    void add(const texture_matrix &other); // Element-wise; grows to accommodate the other matrix if necessary.
+};
+
+// Grey level co-occurrence matrices (N_levels x N_levels), one for each of the 13 directions. Co-occurrences are
+// counted symmetrically.
+std::vector<texture_matrix> Compute_GLCMs(const texture_volume &vol);
+
+// Grey level run length matrices (N_levels x longest run length), one for each of the 13 directions.
+std::vector<texture_matrix> Compute_GLRLMs(const texture_volume &vol);
+
+// Grey level size zone matrix (N_levels x largest zone size). Zones are 26-connected.
+texture_matrix Compute_GLSZM(const texture_volume &vol);
+
+
+// Texture features, named as per IBSI where possible. Features from direction-dependent matrices are computed for
+// each direction and then averaged. Grey levels are numbered from 1 when evaluating features.
+using texture_features_t = std::vector<std::pair<std::string, double>>;
+
+texture_features_t GLCM_Features(const std::vector<texture_matrix> &glcms);
+texture_features_t GLRLM_Features(const std::vector<texture_matrix> &glrlms, long int N_voxels);
+texture_features_t GLSZM_Features(const texture_matrix &glszm, long int N_voxels);
+
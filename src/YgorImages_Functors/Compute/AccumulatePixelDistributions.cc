@@ -179,7 +179,16 @@ bool AccumulatePixelDistributions(planar_image_collection<float,double> &imageco
                                 }
         
                                 // --------------- Incorporate the data into the user_data struct ------------------
-                                user_data_s->accumulated_voxels[ ROIName.value() ].emplace_back(combined_voxel_intensity);
+                                if(user_data_s->histogram_prototype){
+                                    auto h_it = user_data_s->histograms.find( ROIName.value() );
+                                    if(h_it == user_data_s->histograms.end()){
+                                        h_it = user_data_s->histograms.emplace( ROIName.value(),
+                                                                                user_data_s->histogram_prototype.value() ).first;
+                                    }
+                                    h_it->second.digest(combined_voxel_intensity);
+                                }else{
+                                    user_data_s->accumulated_voxels[ ROIName.value() ].emplace_back(combined_voxel_intensity);
+                                }
         
                                 // ----------------------------------------------------------------------------
         
@@ -5,9 +5,12 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "../../Dose_Volume_Histogram.h"
+
 
 template <class T, class R> class planar_image_collection;
 template <class T> class contour_collection;
@@ -15,6 +18,11 @@ template <class T> class contour_collection;
 
 struct AccumulatePixelDistributionsUserData {
     std::map<std::string, std::vector<double>> accumulated_voxels; // key: RawROIName.
+
+    // If a prototype is provided, voxel intensities are binned into a copy of it for each ROI instead of being
+    // collected in accumulated_voxels. Each voxel is given unit weight, so histogram volumes are voxel counts.
+    std::optional<dose_volume_histogram> histogram_prototype;
+    std::map<std::string, dose_volume_histogram> histograms; // key: RawROIName.
 };
 
 bool AccumulatePixelDistributions(planar_image_collection<float,double> &,
@@ -2,16 +2,25 @@
 
 #include <exception>
 #include <any>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <optional>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <algorithm>
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <vector>
 
 #include "../../Thread_Pool.h"
+#include "../../Rectilinear_Volume.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
 #include "Compare_Images.h"
@@ -23,6 +32,439 @@
 #include "YgorClustering.hpp"
 
 
+
+// The outcome of a distance-to-agreement search, when it can be determined without performing the search.
+enum class dta_search_outcome : uint8_t {
+    Unknown,     // The search must be performed.
+    Exhausted,   // No agreement can be found; the search would end without finding any.
+    Terminated,  // No agreement can be found; the search would be terminated early due to the gamma criteria.
+};
+
+// A DTA search that has been deferred so it can be ruled out (or not) using value-banded distance transforms.
+struct dta_search_query {
+    float val;              // The voxel value being searched for.
+    long int ref_index;     // The linear index of the reference voxel the search is centred on.
+    double reach;           // The distance from the centre voxel to the farthest voxel the search would visit.
+    dta_search_outcome outcome; // The outcome of the search if no visited voxel can agree or straddle.
+    dta_search_outcome *state;  // Where the outcome is recorded if the search is ruled out.
+};
+
+// Computes the lower envelope of parabolas centred at (possibly irregularly-spaced) sample positions 'x' with heights
+// 'f', i.e., a 1D squared distance transform (Felzenszwalb and Huttenlocher 2012; doi:10.4086/toc.2012.v008a019).
+// Infinite heights denote absent samples.
+static
+void
+lower_envelope_1D(const std::vector<double> &x,
+                  std::vector<double> &f,
+                  std::vector<long int> &v,
+                  std::vector<double> &z){
+    const auto inf = std::numeric_limits<double>::infinity();
+    const auto N = static_cast<long int>(x.size());
+    v.resize(N);
+    z.resize(N + 1);
+
+    // Parabola intersection abscissa.
+    const auto intersect = [&](long int p, long int q) -> double {
+        return 0.5 * ( (f[q] - f[p]) / (x[q] - x[p]) + (x[q] + x[p]) );
+    };
+
+    long int k = -1;
+    for(long int q = 0; q < N; ++q){
+        if(!std::isfinite(f[q])) continue;
+        if(k < 0){
+            k = 0;
+            v[0] = q;
+            z[0] = -inf;
+            z[1] = inf;
+            continue;
+        }
+        auto s = intersect(v[k], q);
+        while(s <= z[k]){ // Note: never true for k = 0 since z[0] = -inf.
+            --k;
+            s = intersect(v[k], q);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k+1] = inf;
+    }
+    if(k < 0){
+        for(auto &d : f) d = inf;
+        return;
+    }
+
+    std::vector<double> out(N);
+    long int j = 0;
+    for(long int q = 0; q < N; ++q){
+        while(z[j+1] < x[q]) ++j;
+        const auto dx = x[q] - x[v[j]];
+        out[q] = dx * dx + f[v[j]];
+    }
+    f.swap(out);
+    return;
+}
+
+// An index over the reference image array used to accelerate DTA searches.
+//
+// Voxel values are copied into a dense, (image,row,column)-ordered array. For every voxel the range of values found
+// among the neighbours considered for interpolation is also recorded, so searches can cheaply skip voxels which cannot
+// be interpolated to the target value.
+struct dta_search_index {
+    rectilinear_volume_index vol;
+    std::map<const planar_image<float,double>*, long int> img_num;
+
+    long int N_rows;
+    long int N_cols;
+    long int N_imgs;
+
+    vec3<double> origin; // Centre of the (0,0) voxel of the first image.
+    vec3<double> dr;     // Displacement between adjacent rows.
+    vec3<double> dc;     // Displacement between adjacent columns.
+    std::array<std::vector<double>, 3> x; // Voxel centre coordinates along columns, rows, and images.
+
+    std::vector<float> vals;
+    std::vector<float> nbr_min; // Excludes NaNs.
+    std::vector<float> nbr_max;
+
+    dta_search_index(std::list<std::reference_wrapper<planar_image<float,double>>> imgs,
+                     long int channel,
+                     ComputeCompareImagesUserData::InterpolationMethod interp);
+
+    long int index(long int img, long int row, long int col) const {
+        return (img * this->N_rows + row) * this->N_cols + col;
+    }
+
+    // Whether the voxel, with value 'A', might be interpolated with a neighbour to produce value 'V'.
+    bool may_interpolate(long int i, float A, float V) const {
+        if(this->nbr_min.empty()) return false; // Interpolation is disabled.
+        return ( (V < A) && (this->nbr_min[i] < V) )
+            || ( (A < V) && (V < this->nbr_max[i]) );
+    }
+
+    // Replicates the wavefront search termination logic for a search that finds no agreement, without visiting any
+    // voxels. Returns nothing if the outcome cannot be determined unambiguously.
+    std::optional<dta_search_query> plan_search(const vec3<double> &pos,
+                                                long int R_img,
+                                                long int R_row,
+                                                long int R_col,
+                                                double max_interp_dist,
+                                                const ComputeCompareImagesUserData &ud) const;
+
+    // Computes the exact squared Euclidean distance from every voxel to the nearest voxel in the mask.
+    void squared_distance_transform(const std::vector<uint8_t> &mask,
+                                    std::vector<double> &dist_sq) const;
+
+    // Rules out searches that cannot possibly find agreement, recording their outcome.
+    void resolve_searches(std::vector<dta_search_query> &queries,
+                          const ComputeCompareImagesUserData &ud) const;
+};
+
+dta_search_index::dta_search_index(std::list<std::reference_wrapper<planar_image<float,double>>> imgs,
+                                   long int channel,
+                                   ComputeCompareImagesUserData::InterpolationMethod interp) : vol(imgs) {
+    this->N_rows = this->vol.N_rows;
+    this->N_cols = this->vol.N_cols;
+    this->N_imgs = this->vol.N_imgs;
+    for(long int k = 0; k < this->N_imgs; ++k){
+        const auto &img = *(this->vol.imgs[k]);
+        if( (img.rows != this->N_rows) || (img.columns != this->N_cols) || (img.channels <= channel) ){
+            throw std::invalid_argument("Reference images are not uniform. Cannot index them.");
+        }
+        this->img_num[ this->vol.imgs[k] ] = k;
+    }
+
+    const auto &first = *(this->vol.imgs.front());
+    this->origin = first.position(0,0);
+    this->dr = (1 < this->N_rows) ? (first.position(1,0) - this->origin) : vec3<double>(0.0, 0.0, 0.0);
+    this->dc = (1 < this->N_cols) ? (first.position(0,1) - this->origin) : vec3<double>(0.0, 0.0, 0.0);
+    for(long int c = 0; c < this->N_cols; ++c) this->x[0].push_back( this->dc.length() * static_cast<double>(c) );
+    for(long int r = 0; r < this->N_rows; ++r) this->x[1].push_back( this->dr.length() * static_cast<double>(r) );
+    for(long int k = 0; k < this->N_imgs; ++k){
+        this->x[2].push_back( (this->vol.imgs[k]->position(0,0) - this->origin).Dot(this->vol.img_unit) );
+    }
+
+    const auto N = this->N_rows * this->N_cols * this->N_imgs;
+    this->vals.resize(N);
+    for(long int k = 0; k < this->N_imgs; ++k){
+        const auto &img = *(this->vol.imgs[k]);
+        for(long int r = 0; r < this->N_rows; ++r){
+            for(long int c = 0; c < this->N_cols; ++c){
+                this->vals[ this->index(k, r, c) ] = img.value(r, c, channel);
+            }
+        }
+    }
+
+    // Record the range of neighbouring values considered for interpolation, mirroring the wavefront search.
+    if(interp == ComputeCompareImagesUserData::InterpolationMethod::None) return;
+    const bool use_nnn = (interp == ComputeCompareImagesUserData::InterpolationMethod::NNN);
+    const std::array<std::array<long int, 3>, 18> offsets = {{
+            { -1,  0,  0 }, {  1,  0,  0 }, {  0, -1,  0 }, {  0,  1,  0 }, {  0,  0, -1 }, {  0,  0,  1 },
+
+            { -1,  0, -1 }, {  0, -1, -1 }, {  0,  1, -1 }, {  1,  0, -1 },
+            { -1, -1,  0 }, { -1,  1,  0 }, {  1, -1,  0 }, {  1,  1,  0 },
+            { -1,  0,  1 }, {  0, -1,  1 }, {  0,  1,  1 }, {  1,  0,  1 }
+    }};
+    const size_t N_offsets = (use_nnn) ? 18 : 6;
+
+    const auto inf = std::numeric_limits<float>::infinity();
+    this->nbr_min.assign(N, inf);
+    this->nbr_max.assign(N, -inf);
+    for(long int k = 0; k < this->N_imgs; ++k){
+        for(long int r = 0; r < this->N_rows; ++r){
+            for(long int c = 0; c < this->N_cols; ++c){
+                const auto i = this->index(k, r, c);
+                for(size_t n = 0; n < N_offsets; ++n){
+                    const auto n_row = r + offsets[n][0];
+                    const auto n_col = c + offsets[n][1];
+                    const auto n_img = k + offsets[n][2];
+                    if( !isininc(0, n_row, this->N_rows - 1L)
+                    ||  !isininc(0, n_col, this->N_cols - 1L)
+                    ||  !isininc(0, n_img, this->N_imgs - 1L) ) continue;
+
+                    const auto n_val = this->vals[ this->index(n_img, n_row, n_col) ];
+                    if(n_val < this->nbr_min[i]) this->nbr_min[i] = n_val;
+                    if(this->nbr_max[i] < n_val) this->nbr_max[i] = n_val;
+                }
+            }
+        }
+    }
+}
+
+std::optional<dta_search_query>
+dta_search_index::plan_search(const vec3<double> &pos,
+                              long int R_img,
+                              long int R_row,
+                              long int R_col,
+                              double max_interp_dist,
+                              const ComputeCompareImagesUserData &ud) const {
+    const auto inf = std::numeric_limits<double>::infinity();
+    const auto T_dta = ud.DTA_max + max_interp_dist;
+    const auto T_gamma = ud.gamma_DTA_threshold + max_interp_dist;
+
+    // Comparisons with the termination thresholds that are too close to call are left to the wavefront search, since
+    // the nearest voxel is located analytically here rather than by exhaustive comparison.
+    const auto too_close = [](double a, double b) -> bool {
+        return std::abs(a - b) <= 1.0E-9 * std::max({ 1.0, std::abs(a), std::abs(b) });
+    };
+
+    // Continuous grid coordinates of the search position.
+    const auto P = pos - this->origin;
+    const double t_row = (1 < this->N_rows) ? P.Dot(this->dr) / this->dr.Dot(this->dr) : 0.0;
+    const double t_col = (1 < this->N_cols) ? P.Dot(this->dc) / this->dc.Dot(this->dc) : 0.0;
+    const long int z_upper = static_cast<long int>( std::distance( std::begin(this->x[2]),
+        std::upper_bound( std::begin(this->x[2]), std::end(this->x[2]), P.Dot(this->vol.img_unit) ) ) );
+
+    // The voxels nearest the search position within the given range along each axis.
+    const auto candidates = [](double t, long int lo, long int hi) -> std::array<long int, 2> {
+        if(!std::isfinite(t)) t = 0.0;
+        const auto f = static_cast<long int>( std::floor(std::clamp(t, -1.0, static_cast<double>(hi) + 1.0)) );
+        return {{ std::clamp(f, lo, hi), std::clamp(f + 1L, lo, hi) }};
+    };
+    const auto img_candidates = [&](long int lo, long int hi) -> std::array<long int, 2> {
+        return {{ std::clamp(z_upper - 1L, lo, hi), std::clamp(z_upper, lo, hi) }};
+    };
+
+    const std::array<long int, 3> R = {{ R_img, R_row, R_col }};
+    const std::array<long int, 3> N = {{ this->N_imgs, this->N_rows, this->N_cols }};
+    std::array<long int, 3> lo;
+    std::array<long int, 3> hi;
+
+    long int w = 0;
+    dta_search_outcome outcome = dta_search_outcome::Unknown;
+    while(outcome == dta_search_outcome::Unknown){
+        for(size_t a = 0; a < 3; ++a){
+            lo[a] = std::max(R[a] - w, 0L);
+            hi[a] = std::min(R[a] + w, N[a] - 1L);
+        }
+
+        // Evaluate each face of the wavefront surface.
+        double nearest_dist = inf;
+        for(size_t a = 0; a < 3; ++a){
+            if( (w == 0) && (0 < a) ) break; // The first epoch contains only the centre voxel.
+            for(const auto side : { -w, w }){
+                const auto fixed = R[a] + side;
+                if(!isininc(0, fixed, N[a] - 1L)) continue;
+
+                std::array<std::array<long int, 2>, 3> cands;
+                cands[0] = img_candidates(lo[0], hi[0]);
+                cands[1] = candidates(t_row, lo[1], hi[1]);
+                cands[2] = candidates(t_col, lo[2], hi[2]);
+                cands[a] = {{ fixed, fixed }};
+                for(const auto k : cands[0]){
+                    for(const auto r : cands[1]){
+                        for(const auto c : cands[2]){
+                            const auto dist = this->vol.imgs[k]->position(r, c).distance(pos);
+                            if(dist < nearest_dist) nearest_dist = dist;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Mirror the wavefront termination criteria, assuming no agreement has been found.
+        if(!std::isfinite(nearest_dist)){
+            outcome = dta_search_outcome::Exhausted;
+            break;
+        }
+        if(too_close(nearest_dist, T_dta)) return {};
+        if(nearest_dist > T_dta){
+            outcome = dta_search_outcome::Exhausted;
+            break;
+        }
+        if(ud.gamma_terminate_when_max_exceeded){
+            if(too_close(nearest_dist, T_gamma)) return {};
+            if(nearest_dist > T_gamma){
+                outcome = dta_search_outcome::Terminated;
+                break;
+            }
+        }
+        ++w;
+    }
+
+    // The farthest any visited voxel can be from the centre voxel.
+    const std::array<const std::vector<double>*, 3> coords = {{ &(this->x[2]), &(this->x[1]), &(this->x[0]) }};
+    std::array<double, 3> extent;
+    for(size_t a = 0; a < 3; ++a){
+        const auto &x_a = *(coords[a]);
+        extent[a] = std::max( std::abs(x_a[hi[a]] - x_a[R[a]]), std::abs(x_a[R[a]] - x_a[lo[a]]) );
+    }
+
+    dta_search_query q;
+    q.val = 0.0f;
+    q.ref_index = this->index(R_img, R_row, R_col);
+    q.reach = std::hypot(extent[0], extent[1], extent[2]);
+    q.outcome = outcome;
+    q.state = nullptr;
+    return q;
+}
+
+void
+dta_search_index::squared_distance_transform(const std::vector<uint8_t> &mask,
+                                             std::vector<double> &dist_sq) const {
+    const auto inf = std::numeric_limits<double>::infinity();
+    const auto N = static_cast<long int>(mask.size());
+    dist_sq.resize(N);
+    for(long int i = 0; i < N; ++i){
+        dist_sq[i] = (mask[i] == 0) ? inf : 0.0;
+    }
+
+    // The transform is separable, so process every line of voxels along each axis in turn.
+    const std::array<long int, 3> lengths = {{ this->N_cols, this->N_rows, this->N_imgs }};
+    const std::array<long int, 3> strides = {{ 1L, this->N_cols, this->N_cols * this->N_rows }};
+    for(size_t a = 0; a < 3; ++a){
+        const auto length = lengths[a];
+        const auto stride = strides[a];
+        const auto N_lines = N / length;
+
+        // Enumerate the first voxel of each line.
+        const auto line_start = [&](long int l) -> long int {
+            return (l % stride) + (l / stride) * stride * length;
+        };
+
+        const long int N_batches = std::max<long int>(1L, std::min<long int>(N_lines, 256L));
+        asio_thread_pool tp;
+        for(long int b = 0; b < N_batches; ++b){
+            tp.submit_task([&,b]() -> void {
+                std::vector<double> f(length);
+                std::vector<long int> v;
+                std::vector<double> z;
+                for(long int l = (b * N_lines) / N_batches; l < ((b + 1) * N_lines) / N_batches; ++l){
+                    const auto start = line_start(l);
+                    for(long int i = 0; i < length; ++i) f[i] = dist_sq[start + i * stride];
+                    lower_envelope_1D(this->x[a], f, v, z);
+                    for(long int i = 0; i < length; ++i) dist_sq[start + i * stride] = f[i];
+                }
+            }); // thread pool task closure.
+        }
+    }
+    return;
+}
+
+void
+dta_search_index::resolve_searches(std::vector<dta_search_query> &queries,
+                                   const ComputeCompareImagesUserData &ud) const {
+    if(queries.empty()) return;
+    std::sort(std::begin(queries), std::end(queries),
+              [](const dta_search_query &L, const dta_search_query &R){ return (L.val < R.val); });
+
+    const auto N_queries = static_cast<long int>(queries.size());
+    const auto N_bands = std::clamp<long int>(ud.indexed_search_bands, 1L, N_queries);
+    const auto N = static_cast<long int>(this->vals.size());
+    const bool use_interp = !this->nbr_min.empty();
+    const auto machine_eps = std::sqrt(std::numeric_limits<double>::epsilon());
+
+    // Whether the computed distance rules out every voxel within the query's reach.
+    const auto beyond_reach = [](double dist_sq, const dta_search_query &q) -> bool {
+        return (q.reach * (1.0 + 1.0E-6) + 1.0E-9) < std::sqrt(dist_sq);
+    };
+
+    std::vector<uint8_t> mask(N);
+    std::vector<double> dist_sq;
+    std::vector<dta_search_query*> remaining;
+    std::vector<dta_search_query*> straddled;
+    long int N_resolved = 0;
+    for(long int b = 0; b < N_bands; ++b){
+        const auto q_begin = std::next( std::begin(queries), (b * N_queries) / N_bands );
+        const auto q_end   = std::next( std::begin(queries), ((b + 1) * N_queries) / N_bands );
+        const float lo = q_begin->val;
+        const float hi = std::prev(q_end)->val;
+
+        // Bound how far voxel values can be from the band and still be considered sufficiently equal.
+        double tol = ud.DTA_vox_val_eq_abs;
+        if(0.0 < ud.DTA_vox_val_eq_reldiff){
+            const auto max_abs = std::max( std::abs(static_cast<double>(lo)), std::abs(static_cast<double>(hi)) );
+            tol = (ud.DTA_vox_val_eq_reldiff < 1.0)
+                ? std::max({ tol, ud.DTA_vox_val_eq_reldiff * max_abs / (1.0 - ud.DTA_vox_val_eq_reldiff), 2.0 * machine_eps })
+                : std::numeric_limits<double>::infinity();
+        }
+        tol = tol * (1.0 + 1.0E-6) + std::numeric_limits<double>::min();
+        if(!std::isfinite(tol)) continue;
+        const auto agree_lo = static_cast<double>(lo) - tol;
+        const auto agree_hi = static_cast<double>(hi) + tol;
+
+        remaining.clear();
+        for(auto it = q_begin; it != q_end; ++it) remaining.push_back( &(*it) );
+
+        // Voxels that might agree with, or be interpolated to, any value in the band.
+        for(long int i = 0; i < N; ++i){
+            const auto A = this->vals[i];
+            mask[i] = ( isininc(agree_lo, A, agree_hi)
+                     || ( use_interp && ( ( (this->nbr_min[i] < hi) && (lo < A) && (this->nbr_min[i] < A) )
+                                       || ( (A < hi) && (lo < this->nbr_max[i]) && (A < this->nbr_max[i]) ) ) ) ) ? 1 : 0;
+        }
+        this->squared_distance_transform(mask, dist_sq);
+        remaining.erase( std::remove_if( std::begin(remaining), std::end(remaining),
+                                         [&](const dta_search_query *q){ return !beyond_reach(dist_sq[q->ref_index], *q); } ),
+                         std::end(remaining) );
+        if(remaining.empty()) continue;
+
+        // Straddling requires voxels both above and below the target value to be visited.
+        for(int pass = 0; pass < 2; ++pass){
+            for(long int i = 0; i < N; ++i){
+                const auto A = this->vals[i];
+                mask[i] = ((pass == 0) ? (lo < A) : (A < hi)) ? 1 : 0;
+            }
+            this->squared_distance_transform(mask, dist_sq);
+
+            straddled.clear();
+            for(auto *q : remaining){
+                if(beyond_reach(dist_sq[q->ref_index], *q)){
+                    *(q->state) = q->outcome;
+                    ++N_resolved;
+                }else{
+                    straddled.push_back(q);
+                }
+            }
+            remaining.swap(straddled);
+            if(remaining.empty()) break;
+        }
+    }
+
+    FUNCINFO("Ruled out " << N_resolved << " of " << N_queries << " DTA searches in advance");
+    return;
+}
+
+
 bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
                           std::list<std::reference_wrapper<planar_image_collection<float,double>>> external_imgs,
                           std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
@@ -85,19 +527,16 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
     };
 
     // Ensure the reference images form a regular grid.
-    {
-        std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
-        for(auto &imgcoll_refw : external_imgs){
-            for(auto &img : imgcoll_refw.get().images){
-                selected_imgs.push_back( std::ref(img) );
-            }
-        }
-
-        if(!Images_Form_Rectilinear_Grid(selected_imgs)){
-            FUNCWARN("Reference images do not form a rectilinear grid. Cannot continue");
-            return false;
+    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+    for(auto &imgcoll_refw : external_imgs){
+        for(auto &img : imgcoll_refw.get().images){
+            selected_imgs.push_back( std::ref(img) );
         }
     }
+    if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+        FUNCWARN("Reference images do not form a rectilinear grid. Cannot continue");
+        return false;
+    }
 
     // Determine how discrepancy should be estimated.
     std::function< double (const double &, const double &) > estimate_discrepancy;
@@ -140,502 +579,612 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
     mv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
 
 
-    std::mutex passing_counter; // Used to tally the gamma passing rate.
+    // Index the reference images, if requested.
+    std::unique_ptr<dta_search_index> search_index;
+    std::map<const planar_image<float,double>*, std::vector<dta_search_outcome>> search_states;
+    std::map<const planar_image<float,double>*, std::vector<dta_search_query>> search_queries;
+    if( (user_data_s->search_engine == ComputeCompareImagesUserData::SearchEngine::Indexed)
+    &&  (user_data_s->comparison_method != ComputeCompareImagesUserData::ComparisonMethod::Discrepancy) ){
+        try{
+            search_index = std::make_unique<dta_search_index>(selected_imgs, ud_channel, user_data_s->interpolation_method);
+        }catch(const std::exception &e){
+            FUNCWARN("Unable to index reference images (" << e.what() << "), using wavefront searches");
+        }
+        if(search_index){
+            for(const auto &img : imagecoll.images){
+                search_states[ &img ].assign(img.rows * img.columns, dta_search_outcome::Unknown);
+                search_queries[ &img ];
+            }
+        }
+    }
 
-    asio_thread_pool tp;
+    std::mutex passing_counter; // Used to tally the gamma passing rate.
     std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
     long int completed = 0;
     const long int img_count = imagecoll.images.size();
 
-    for(auto &img : imagecoll.images){
-        std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
-
-        tp.submit_task([&,img_refw]() -> void {
-            const auto orientation_normal = img_refw.get().image_plane().N_0.unit();
-
-            planar_image_adjacency<float,double> img_adj( {}, external_imgs, orientation_normal );
-
-            using img_ptr_t = planar_image<float,double> *;
-
-            // Identify the reference image which overlaps the whole image, if any.
-            //
-            // This approach attempts to identify a reference image which wholly overlaps the image to edit. This arrangement
-            // is common in many scenarios and can be exploited to reduce costly checks for each voxel.
-            // If no overlapping image is found, another lookup is performed for each voxel (which is much slower).
-            auto overlapping_img_refws = img_adj.get_wholly_overlapping_images(img_refw);
-            img_ptr_t int_img_ptr = (overlapping_img_refws.empty()) ? nullptr
-                                                                    : std::addressof(overlapping_img_refws.front().get());
-            if(overlapping_img_refws.empty()) FUNCWARN("No wholly overlapping reference images found, using slower per-voxel sampling");
+    // Compares a single image. When surveying, images are not altered and the DTA searches that would be performed are
+    // instead recorded for assessment with the search index.
+    const auto compare_image = [&](std::reference_wrapper<planar_image<float,double>> img_refw, bool survey) -> void {
+        const auto orientation_normal = img_refw.get().image_plane().N_0.unit();
+
+        planar_image_adjacency<float,double> img_adj( {}, external_imgs, orientation_normal );
+
+        using img_ptr_t = planar_image<float,double> *;
+
+        // Identify the reference image which overlaps the whole image, if any.
+        //
+        // This approach attempts to identify a reference image which wholly overlaps the image to edit. This arrangement
+        // is common in many scenarios and can be exploited to reduce costly checks for each voxel.
+        // If no overlapping image is found, another lookup is performed for each voxel (which is much slower).
+        auto overlapping_img_refws = img_adj.get_wholly_overlapping_images(img_refw);
+        img_ptr_t int_img_ptr = (overlapping_img_refws.empty()) ? nullptr
+                                                                : std::addressof(overlapping_img_refws.front().get());
+        if(overlapping_img_refws.empty() && !survey) FUNCWARN("No wholly overlapping reference images found, using slower per-voxel sampling");
+
+        // Map reference image adjacency indices onto the search index, if one is available.
+        const dta_search_index *l_index = search_index.get();
+        std::vector<long int> adj_to_index;
+        if(l_index != nullptr){
+            bool forward = true;
+            bool reverse = true;
+            for(long int i = 0; i < l_index->N_imgs; ++i){
+                const auto it = img_adj.index_present(i) ? l_index->img_num.find( std::addressof(img_adj.index_to_image(i).get()) )
+                                                         : std::end(l_index->img_num);
+                if(it == std::end(l_index->img_num)){
+                    forward = reverse = false;
+                    break;
+                }
+                adj_to_index.push_back(it->second);
+                forward = forward && (it->second == i);
+                reverse = reverse && (it->second == (l_index->N_imgs - 1L - i));
+            }
+            if(!forward && !reverse){
+                if(!survey) FUNCWARN("Reference image adjacency does not match the search index, using wavefront searches");
+                l_index = nullptr;
+            }
+        }
+        if(survey && (l_index == nullptr)) return;
+        auto *l_states = (l_index == nullptr) ? nullptr : &(search_states.at( std::addressof(img_refw.get()) ));
+        auto *l_queries = (l_index == nullptr) ? nullptr : &(search_queries.at( std::addressof(img_refw.get()) ));
 
 
-            auto f_bounded = [&,img_refw](long int E_row, long int E_col, long int channel, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-                if( !isininc( user_data_s->inc_lower_threshold, voxel_val, user_data_s->inc_upper_threshold) ){
-                    return; // No-op if outside of the thresholds.
-                }
-                if( channel != ud_channel){
-                    return; // No-op if this is the wrong channel.
-                }
+        auto f_bounded = [&,img_refw](long int E_row, long int E_col, long int channel, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
+            if( !isininc( user_data_s->inc_lower_threshold, voxel_val, user_data_s->inc_upper_threshold) ){
+                return; // No-op if outside of the thresholds.
+            }
+            if( channel != ud_channel){
+                return; // No-op if this is the wrong channel.
+            }
 
-                do{ // Do-while-false, so we can break out early.
-                    const auto edit_val = voxel_val;
+            do{ // Do-while-false, so we can break out early.
+                const auto edit_val = voxel_val;
 
-                    // Get the position of the voxel in the overlapping reference image.
-                    const auto pos = img_refw.get().position(E_row, E_col);
+                // Get the position of the voxel in the overlapping reference image.
+                const auto pos = img_refw.get().position(E_row, E_col);
 
-                    // If no wholly overlapping image was identified, perform a lookup for this specific voxel.
-                    img_ptr_t l_int_img_ptr = int_img_ptr;
-                    if(l_int_img_ptr == nullptr){
-                        try{
-                            l_int_img_ptr = std::addressof( img_adj.position_to_image(pos).get() );
-                        }catch(const std::exception &){
-                            voxel_val = inaccessible_val; // Cannot assess this voxel.
-                            return;
-                        }
+                // If no wholly overlapping image was identified, perform a lookup for this specific voxel.
+                img_ptr_t l_int_img_ptr = int_img_ptr;
+                if(l_int_img_ptr == nullptr){
+                    try{
+                        l_int_img_ptr = std::addressof( img_adj.position_to_image(pos).get() );
+                    }catch(const std::exception &){
+                        voxel_val = inaccessible_val; // Cannot assess this voxel.
+                        return;
                     }
+                }
 
-                    // Ensure the image supports the specified channel.
-                    if(l_int_img_ptr->channels <= channel){
-                        voxel_val = inaccessible_val;
-                        break;
-                    }
+                // Ensure the image supports the specified channel.
+                if(l_int_img_ptr->channels <= channel){
+                    voxel_val = inaccessible_val;
+                    break;
+                }
 
-                    // Calculate the index in the intersecting image.
-                    const auto index = l_int_img_ptr->index(pos, channel);
-                    if(index < 0){ // If not valid, ignore the voxel.
-                        voxel_val = inaccessible_val;
-                        break;
-                    }
+                // Calculate the index in the intersecting image.
+                const auto index = l_int_img_ptr->index(pos, channel);
+                if(index < 0){ // If not valid, ignore the voxel.
+                    voxel_val = inaccessible_val;
+                    break;
+                }
 
-                    // Verify if the voxel needs to be compared.
-                    const auto ring_0_val = l_int_img_ptr->value(index);
-                    if(!isininc( user_data_s->ref_img_inc_lower_threshold, ring_0_val, user_data_s->ref_img_inc_upper_threshold)){
-                        voxel_val = inaccessible_val;
-                        break;
-                    }
+                // Verify if the voxel needs to be compared.
+                const auto ring_0_val = l_int_img_ptr->value(index);
+                if(!isininc( user_data_s->ref_img_inc_lower_threshold, ring_0_val, user_data_s->ref_img_inc_upper_threshold)){
+                    voxel_val = inaccessible_val;
+                    break;
+                }
 
-                    // Determine the row, column, and image numbers for the reference image.
-                    const auto rcc = l_int_img_ptr->row_column_channel_from_index(index);
-                    const auto R_row = std::get<0>(rcc);
-                    const auto R_col = std::get<1>(rcc);
-                    if(!img_adj.image_present( std::ref( *l_int_img_ptr ) )){
-                        throw std::logic_error("One or more images were not included in the image adjacency determination. Refusing to continue.");
-                    }
-                    const auto R_num = img_adj.image_to_index( std::ref( *l_int_img_ptr ) );
+                // Determine the row, column, and image numbers for the reference image.
+                const auto rcc = l_int_img_ptr->row_column_channel_from_index(index);
+                const auto R_row = std::get<0>(rcc);
+                const auto R_col = std::get<1>(rcc);
+                if(!img_adj.image_present( std::ref( *l_int_img_ptr ) )){
+                    throw std::logic_error("One or more images were not included in the image adjacency determination. Refusing to continue.");
+                }
+                const auto R_num = img_adj.image_to_index( std::ref( *l_int_img_ptr ) );
 
 //-------------
 // TODO: determine the largest pxl_dz from all images and use it here instead.
 
-                    // Determine the smallest dimension of the voxel, protecting against the pxl_dz = 0 case.
-                    const auto pxl_dx = l_int_img_ptr->pxl_dx;
-                    const auto pxl_dy = l_int_img_ptr->pxl_dy;
-                    const auto pxl_dz = l_int_img_ptr->pxl_dz;
-                    const auto pxl_dl = std::max( std::min({ pxl_dx, pxl_dy, pxl_dz }), 10.0 * machine_eps );
+                // Determine the smallest dimension of the voxel, protecting against the pxl_dz = 0 case.
+                const auto pxl_dx = l_int_img_ptr->pxl_dx;
+                const auto pxl_dy = l_int_img_ptr->pxl_dy;
+                const auto pxl_dz = l_int_img_ptr->pxl_dz;
+                const auto pxl_dl = std::max( std::min({ pxl_dx, pxl_dy, pxl_dz }), 10.0 * machine_eps );
 
-                    // The max distance separating adjacent next-next-nearest neighbouring (i.e., 3D diagonally-adjacent) voxels. 
-                    const auto max_interp_dist = std::hypot( pxl_dx, pxl_dy, pxl_dz ); 
+                // The max distance separating adjacent next-next-nearest neighbouring (i.e., 3D diagonally-adjacent) voxels. 
+                const auto max_interp_dist = std::hypot( pxl_dx, pxl_dy, pxl_dz ); 
 //-------------
 
-                    // Ensure the voxel position in the edit image and reference image match reasonably.
-                    const auto ring_0_pos = l_int_img_ptr->position(R_row, R_col);
-                    if(ring_0_pos.distance(pos) > pxl_dl){ // If no suitable voxel for discrepancy testing, ignore voxel.
-                        voxel_val = inaccessible_val;
-                        break;
-                    }
+                // Ensure the voxel position in the edit image and reference image match reasonably.
+                const auto ring_0_pos = l_int_img_ptr->position(R_row, R_col);
+                if(ring_0_pos.distance(pos) > pxl_dl){ // If no suitable voxel for discrepancy testing, ignore voxel.
+                    voxel_val = inaccessible_val;
+                    break;
+                }
 
-                    // Perform a discrepancy comparison.
-                    const auto Disc = estimate_discrepancy(edit_val, ring_0_val);
+                // Perform a discrepancy comparison.
+                const auto Disc = estimate_discrepancy(edit_val, ring_0_val);
 
-                    // If computing the gamma index, check if we can avoid a costly DTA search.
-                    if( (user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex) 
-                    &&  (user_data_s->gamma_terminate_when_max_exceeded)
-                    &&  (Disc > user_data_s->gamma_Dis_threshold) ){
+                // If computing the gamma index, check if we can avoid a costly DTA search.
+                if( (user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex) 
+                &&  (user_data_s->gamma_terminate_when_max_exceeded)
+                &&  (Disc > user_data_s->gamma_Dis_threshold) ){
+                    voxel_val = user_data_s->gamma_terminated_early;
+                    break;
+                }
+
+                // Perform a DTA analysis IFF needed.
+                double Dist = std::numeric_limits<double>::infinity();
+                if( (user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::DTA)
+                    ||
+                    ( 
+                       (user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex)
+                       &&
+                       (std::isfinite(Disc)) 
+                    ) ){
+
+                    // Consult the search index, which may have ruled out this search in advance. When surveying,
+                    // only record the search so it can be assessed later.
+                    auto search_outcome = dta_search_outcome::Unknown;
+                    if(l_index != nullptr){
+                        auto &l_state = (*l_states)[ E_row * img_refw.get().columns + E_col ];
+                        if(survey){
+                            auto q = l_index->plan_search(pos, adj_to_index.at(R_num), R_row, R_col,
+                                                          max_interp_dist, *user_data_s);
+                            if(q){
+                                q.value().val = edit_val;
+                                q.value().state = &l_state;
+                                l_queries->push_back(q.value());
+                            }
+                            return;
+                        }
+                        search_outcome = l_state;
+                    }
+                    if(search_outcome == dta_search_outcome::Terminated){
                         voxel_val = user_data_s->gamma_terminated_early;
-                        break;
+                        return;
                     }
 
-                    // Perform a DTA analysis IFF needed.
-                    double Dist = std::numeric_limits<double>::infinity();
-                    if( (user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::DTA)
-                        ||
-                        ( 
-                           (user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex)
-                           &&
-                           (std::isfinite(Disc)) 
-                        ) ){
-
-                        // Create a growing 3D 'wavefront' in which the outer shell of a rectangular bunch of adjacent
-                        // voxels is evaluated compared to the edit image's voxel value.
-                        long int w = 0;                  // Neighbour voxel wavefront epoch number.
-                        bool encountered_lower = false;  // Whether a voxel lower than required was found.
-                        bool encountered_higher = false; // Whether a voxel higher than required was found.
-                        while(true){
-                            double nearest_dist = std::numeric_limits<double>::infinity(); // Nearest of any voxel considered in this wavefront.
-
-                            // Evaluate all voxels on this wavefront before proceeding.
-                            for(long int k = -w; k < (w+1); ++k){
-                                const auto l_num = R_num + k; // Adjacent image number.
-                                if(!img_adj.index_present(l_num)) continue; // This adjacent image does not exist.
-                                auto adj_img_ptr = std::addressof( img_adj.index_to_image(l_num).get() );
+                    // Create a growing 3D 'wavefront' in which the outer shell of a rectangular bunch of adjacent
+                    // voxels is evaluated compared to the edit image's voxel value.
+                    long int w = 0;                  // Neighbour voxel wavefront epoch number.
+                    bool encountered_lower = false;  // Whether a voxel lower than required was found.
+                    bool encountered_higher = false; // Whether a voxel higher than required was found.
+                    while(search_outcome == dta_search_outcome::Unknown){
+                        double nearest_dist = std::numeric_limits<double>::infinity(); // Nearest of any voxel considered in this wavefront.
+
+                        // Evaluate all voxels on this wavefront before proceeding.
+                        for(long int k = -w; k < (w+1); ++k){
+                            const auto l_num = R_num + k; // Adjacent image number.
+                            if(!img_adj.index_present(l_num)) continue; // This adjacent image does not exist.
+                            auto adj_img_ptr = std::addressof( img_adj.index_to_image(l_num).get() );
+                            const auto adj_index_img = (l_index == nullptr) ? -1L : adj_to_index[l_num];
 
 // TODO: try generate either the full range (-w...w) or merely endpoints (-w,w) based on whether |k|=w.                                
-                                for(long int i = -w; i < (w+1); ++i){ 
-                                    const auto l_row = R_row + i;
-                                    if(!isininc(0, l_row, adj_img_ptr->rows-1)) continue; // Wavefront surface not valid.
+                            for(long int i = -w; i < (w+1); ++i){ 
+                                const auto l_row = R_row + i;
+                                if(!isininc(0, l_row, adj_img_ptr->rows-1)) continue; // Wavefront surface not valid.
 // TODO: try generate either the full range (-w...w) or merely endpoints (-w,w) based on whether |k|=w.                                
-                                    for(long int j = -w; j < (w+1); ++j){
-                                        const auto l_col = R_col + j;
-                                        if(!isininc(0, l_col, adj_img_ptr->columns-1)) continue; // Wavefront surface not valid.
-
-                                        // We only consider the voxels on the wavefront's surface . The wavefront is
-                                        // characterized by at least one of i, j, or k being equal to w or -w.
-                                        if( !(   (std::abs(k) == w)
-                                              || (std::abs(i) == w)
-                                              || (std::abs(j) == w) ) ) continue; // Not on the wavefront surface.
-
-                                        // Update the current nearest suitable voxel, if appropriate.
+                                for(long int j = -w; j < (w+1); ++j){
+                                    const auto l_col = R_col + j;
+                                    if(!isininc(0, l_col, adj_img_ptr->columns-1)) continue; // Wavefront surface not valid.
+
+                                    // We only consider the voxels on the wavefront's surface . The wavefront is
+                                    // characterized by at least one of i, j, or k being equal to w or -w.
+                                    if( !(   (std::abs(k) == w)
+                                          || (std::abs(i) == w)
+                                          || (std::abs(j) == w) ) ) continue; // Not on the wavefront surface.
+
+                                    // Update the current nearest suitable voxel, if appropriate.
+                                    //
+                                    // Note: We often have to continue to search to ensure no better match is available.
+                                    //       This is because we search a rectangular wavefront but are interested in an
+                                    //       ellipsoid (or spherical) shell of voxels.
+                                    const auto adj_img_val = adj_img_ptr->value(l_row, l_col, channel);
+                                    const auto adj_vox_pos = adj_img_ptr->position(l_row, l_col);
+                                    //const auto adj_vox_dist = adj_vox_pos.distance(ring_0_pos);
+                                    const auto adj_vox_dist = adj_vox_pos.distance(pos);
+                                    if(adj_vox_dist < nearest_dist) nearest_dist = adj_vox_dist;
+
+                                    // Check if voxel values have been seen both above and below the desired value.
+                                    // If so, then the grid can be interpolated (at some unknown location) to achieve
+                                    // the desired value, so we count the current voxel as a match (necessarily
+                                    // over-estimating the value somewhat).
+                                    const bool is_lower = (adj_img_val < edit_val);
+                                    const bool is_higher = (edit_val < adj_img_val);
+                                    if(!encountered_lower && is_lower){
+                                        encountered_lower = true;
+                                    }
+                                    if(!encountered_higher && is_higher){
+                                        encountered_higher = true;
+                                    }
+                                        
+                                    // Evaluate whether this voxel should be marked as the current best.
+                                    if( ( encountered_lower && is_higher )
+                                    ||  ( encountered_higher && is_lower ) ){
+                                        // If this voxel is one of two that straddle the target value, then consider
+                                        // it as a match. However, since we don't know exactly where the transition
+                                        // point is, we have to assume the worst-case distance so a more precise
+                                        // estimate will not be obliterated. So we tack on the maximum distance to
+                                        // the next-next-nearest (i.e., 3D diagonal) adjancet voxel.
                                         //
-                                        // Note: We often have to continue to search to ensure no better match is available.
-                                        //       This is because we search a rectangular wavefront but are interested in an
-                                        //       ellipsoid (or spherical) shell of voxels.
-                                        const auto adj_img_val = adj_img_ptr->value(l_row, l_col, channel);
-                                        const auto adj_vox_pos = adj_img_ptr->position(l_row, l_col);
-                                        //const auto adj_vox_dist = adj_vox_pos.distance(ring_0_pos);
-                                        const auto adj_vox_dist = adj_vox_pos.distance(pos);
-                                        if(adj_vox_dist < nearest_dist) nearest_dist = adj_vox_dist;
-
-                                        // Check if voxel values have been seen both above and below the desired value.
-                                        // If so, then the grid can be interpolated (at some unknown location) to achieve
-                                        // the desired value, so we count the current voxel as a match (necessarily
-                                        // over-estimating the value somewhat).
-                                        const bool is_lower = (adj_img_val < edit_val);
-                                        const bool is_higher = (edit_val < adj_img_val);
-                                        if(!encountered_lower && is_lower){
-                                            encountered_lower = true;
+                                        // Note that if the voxel dimensions are small, then this will probably
+                                        // suffice. Otherwise, proper interpolation should be preferred. This is how
+                                        // we bias the result to (more safely, in the case of the gamma comparison)
+                                        // overestimate distance and thus not ruin a more accurate interpolated value. 
+                                        const auto worst_case_straddle_dist = adj_vox_dist + max_interp_dist;
+                                        if(worst_case_straddle_dist < Dist){
+                                            Dist = worst_case_straddle_dist;
                                         }
-                                        if(!encountered_higher && is_higher){
-                                            encountered_higher = true;
+                                    }
+
+                                    // Check if we can mark the voxel as the current best outright, without
+                                    // having to interpolate.
+                                    if( ( std::abs(adj_img_val - edit_val) < user_data_s->DTA_vox_val_eq_abs )
+                                    ||  ( relative_diff(adj_img_val, edit_val) < user_data_s->DTA_vox_val_eq_reldiff ) ){
+                                        if(adj_vox_dist < Dist){
+                                            Dist = adj_vox_dist;
                                         }
-                                            
-                                        // Evaluate whether this voxel should be marked as the current best.
-                                        if( ( encountered_lower && is_higher )
-                                        ||  ( encountered_higher && is_lower ) ){
-                                            // If this voxel is one of two that straddle the target value, then consider
-                                            // it as a match. However, since we don't know exactly where the transition
-                                            // point is, we have to assume the worst-case distance so a more precise
-                                            // estimate will not be obliterated. So we tack on the maximum distance to
-                                            // the next-next-nearest (i.e., 3D diagonal) adjancet voxel.
-                                            //
-                                            // Note that if the voxel dimensions are small, then this will probably
-                                            // suffice. Otherwise, proper interpolation should be preferred. This is how
-                                            // we bias the result to (more safely, in the case of the gamma comparison)
-                                            // overestimate distance and thus not ruin a more accurate interpolated value. 
-                                            const auto worst_case_straddle_dist = adj_vox_dist + max_interp_dist;
-                                            if(worst_case_straddle_dist < Dist){
-                                                Dist = worst_case_straddle_dist;
-                                            }
-                                        }
-
-                                        // Check if we can mark the voxel as the current best outright, without
-                                        // having to interpolate.
-                                        if( ( std::abs(adj_img_val - edit_val) < user_data_s->DTA_vox_val_eq_abs )
-                                        ||  ( relative_diff(adj_img_val, edit_val) < user_data_s->DTA_vox_val_eq_reldiff ) ){
-                                            if(adj_vox_dist < Dist){
-                                                Dist = adj_vox_dist;
-                                            }
 
-                                        // Interpolate the neighbours.
-                                        //
-                                        // If neighbouring voxel values have been seen both above and below the
-                                        // target value, then the grid can be interpolated (at some unknown location) to achieve
-                                        // the target value. 
-                                        //
-                                        // However, the interpolation can only possibly be better than the current by a
-                                        // certain amount.
-                                        }else if(adj_vox_dist < (Dist + max_interp_dist)){
-
-                                            // Sample the (6) 3D nearest neighbours and interpolate between them if necessary.
-                                            // 
-                                            // Note that this technique merely interpolates along the edges of the voxel-to-voxel grid.
-                                            // It is robust and comparable in speed to no interpolation.
-                                            if( (user_data_s->interpolation_method == ComputeCompareImagesUserData::InterpolationMethod::NN)
-                                            ||  (user_data_s->interpolation_method == ComputeCompareImagesUserData::InterpolationMethod::NNN) ){
-
-                                                // In pixel coordinates, these points are all a distance of sqrt(1)=1 from the centre voxel.
-                                                std::array<std::array<long int, 3>, 6> nn_triplets = {{
-                                                        { -1,  0,  0 },
-                                                        {  1,  0,  0 },
-                                                        {  0, -1,  0 },
-                                                        {  0,  1,  0 },
-                                                        {  0,  0, -1 },
-                                                        {  0,  0,  1 }
-                                                }};
-
-                                                for(const auto &triplets : nn_triplets){
-                                                    const auto nn_row = l_row + triplets[0];
-                                                    const auto nn_col = l_col + triplets[1];
-                                                    const auto nn_img = l_num + triplets[2];
-
-                                                    if(img_adj.index_present(nn_img)
-                                                    && isininc(0, nn_row, adj_img_ptr->rows - 1L)
-                                                    && isininc(0, nn_col, adj_img_ptr->columns - 1L) ){
-                                                    
-                                                        auto nn_img_refw = img_adj.index_to_image(nn_img);
-                                                        const auto nn_val = nn_img_refw.get().value(nn_row, nn_col, channel);
-
-                                                        const bool nn_is_lower = (nn_val < edit_val);
-                                                        const bool nn_is_higher = (edit_val < nn_val);
-
-                                                        // Skip this neighbour if it does not complement the central
-                                                        // voxel and therefore cannot be interpolated to the target
-                                                        // value.
-                                                        //if( !( (nn_is_lower || is_lower) && (nn_is_higher || is_higher) ) ) continue;
-                                                        // equiv to:  (?)
-                                                        if( !( (is_higher && nn_is_lower) || (is_lower && nn_is_higher) ) ) continue;
-
-                                                        // Determine the 3D point at which the target value is reached.
-                                                        const auto nn_pos = nn_img_refw.get().position(nn_row, nn_col);
-                                                        const auto nn_v_unit = (adj_vox_pos - nn_pos).unit();
-                                                        //if( ! nn_v_unit.isfinite() ) continue;
-                                                        if( ! nn_v_unit.isfinite() ){
-                                                            throw std::logic_error("Diagonal and centre overlap. Cannot continue.");
-                                                        }
-
-                                                        // Abandon the calculation if the point is on the wrong side of
-                                                        // the centre voxel (and thus the interpolation will necessarily
-                                                        // be further away than the centre voxel).
-                                                        //if( (pos - nn_pos).Dot(nn_v_unit) <= 0.0 ) continue;
-                                                        //if( (pos - nn_pos).Dot(nn_v_unit) >= 0.0 ) continue;
-
-                                                        // Since either:
-                                                        //    adj_img_val <= edit_val <= nn_val
-                                                        // or
-                                                        //    adj_img_val >= edit_val >= nn_val
-                                                        // then
-                                                        //   |adj_img_val - nn_val| >= |edit_val - nn_val|.
-                                                        // so we can use this to scale the translation from nn to adj_img.
-                                                        const auto dR = nn_pos.distance( adj_vox_pos );
-                                                        const auto d_target = std::abs(edit_val - nn_val);
-                                                        const auto d_val = std::abs(adj_img_val - nn_val);
-                                                        const auto R_target = nn_pos + (nn_v_unit * dR * d_target / d_val);
-
-                                                        const auto R_dist = R_target.distance(pos);
-                                                        if(R_dist < Dist) Dist = R_dist;
-                                                    } // If: triplet is valid.
-                                                } // Loop over adjacent neighbours.
-                                            } // If: using NN interpolation.
-                                            
-                                            // Sample the (12) 3D next-nearest neighbours and interpolate between them if necessary.
-                                            // 
-                                            // Note that this technique interpolates the planar diagonal along the edges of the voxel-to-voxel grid.
-                                            // It requires solving a quadratic polynomial and is therefore more computationally demanding.
-                                            // Numerical difficulties are also amplified, which results in lower accuracy than nearest-neighbour
-                                            // interpolation.
-                                            if(user_data_s->interpolation_method == ComputeCompareImagesUserData::InterpolationMethod::NNN){
-                                                //In pixel coordinates, these points are all sqrt(2) distance from the centre voxel.
-                                                // The following triplets come in packs of triplets: the first triplet is the diagonal position
-                                                // and the second and third triplets are corners which are needed for interpolation.
-                                                //
-                                                // As you can see, the corners can be summed to give the diagonals; they could also be decomposed
-                                                // this way, but it seemed easier to just write them all out.
-                                                std::array<std::array<std::array<long int, 3>, 3>, 12> nnn_triplets = {{
-                                                        {{ { -1,  0, -1 },   {  0,  0, -1 },  { -1,  0,  0 } }},
-                                                        {{ {  0, -1, -1 },   {  0,  0, -1 },  {  0, -1,  0 } }},
-                                                        {{ {  0,  1, -1 },   {  0,  0, -1 },  {  0,  1,  0 } }},
-                                                        {{ {  1,  0, -1 },   {  0,  0, -1 },  {  1,  0,  0 } }},
-                                                                        
-                                                        {{ { -1, -1,  0 },   {  0, -1,  0 },  { -1,  0,  0 } }},
-                                                        {{ { -1,  1,  0 },   {  0,  1,  0 },  { -1,  0,  0 } }},
-                                                        {{ {  1, -1,  0 },   {  0, -1,  0 },  {  1,  0,  0 } }},
-                                                        {{ {  1,  1,  0 },   {  0,  1,  0 },  {  1,  0,  0 } }},
-                                                                        
-                                                        {{ { -1,  0,  1 },   {  0,  0,  1 },  { -1,  0,  0 } }},
-                                                        {{ {  0, -1,  1 },   {  0,  0,  1 },  {  0, -1,  0 } }},
-                                                        {{ {  0,  1,  1 },   {  0,  0,  1 },  {  0,  1,  0 } }},
-                                                        {{ {  1,  0,  1 },   {  0,  0,  1 },  {  1,  0,  0 } }}
-                                                }};
-
-                                                for(const auto &t_triplets : nnn_triplets){
-                                                    const auto diag_row = l_row + t_triplets[0][0];  // Diagonal.
-                                                    const auto diag_col = l_col + t_triplets[0][1];
-                                                    const auto diag_img = l_num + t_triplets[0][2];
-
-                                                    const auto cA_row = l_row + t_triplets[1][0];  // Corner A.
-                                                    const auto cA_col = l_col + t_triplets[1][1];
-                                                    const auto cA_img = l_num + t_triplets[1][2];
-
-                                                    const auto cB_row = l_row + t_triplets[2][0];  // Corner B.
-                                                    const auto cB_col = l_col + t_triplets[2][1];
-                                                    const auto cB_img = l_num + t_triplets[2][2];  
-
-                                                    if(img_adj.index_present(diag_img)
-                                                    && img_adj.index_present(cA_img)
-                                                    && img_adj.index_present(cB_img)
-                                                    && isininc(0, diag_row, adj_img_ptr->rows - 1L)
-                                                    && isininc(0, diag_col, adj_img_ptr->columns - 1L)
-                                                    && isininc(0, cA_row,   adj_img_ptr->rows - 1L)
-                                                    && isininc(0, cA_col,   adj_img_ptr->columns - 1L)
-                                                    && isininc(0, cB_row,   adj_img_ptr->rows - 1L)
-                                                    && isininc(0, cB_col,   adj_img_ptr->columns - 1L) ){
-                                                    
-                                                        auto diag_img_refw = img_adj.index_to_image(diag_img);
-                                                        const auto diag_val = diag_img_refw.get().value(diag_row, diag_col, channel);
-
-                                                        const bool diag_is_lower = (diag_val < edit_val);
-                                                        const bool diag_is_higher = (edit_val < diag_val);
-
-                                                        // Skip this neighbour if it does not complement the central
-                                                        // voxel and therefore cannot be interpolated to the target
-                                                        // value.
-                                                        if( !( (is_higher && diag_is_lower) || (is_lower && diag_is_higher) ) ) continue;
-
-                                                        auto cA_img_refw  = img_adj.index_to_image(cA_img);
-                                                        auto cB_img_refw  = img_adj.index_to_image(cB_img);
-                                                        const auto cA_val = cA_img_refw.get().value(cA_row, cA_col, channel);
-                                                        const auto cB_val = cB_img_refw.get().value(cB_row, cB_col, channel);
-
-                                                        // Determine the 3D point at which the target value is reached.
-                                                        const auto a = adj_img_val - edit_val;
-                                                        const auto b = (cA_val - adj_img_val) + (cB_val - adj_img_val);
-                                                        const auto d = diag_val + adj_img_val - cA_val - cB_val;
-
-                                                        const auto x_a = (-b + std::sqrt( b*b - 4.0*d*a ) ) / (2.0 * d);
-                                                        const auto x_b = (-b - std::sqrt( b*b - 4.0*d*a ) ) / (2.0 * d);
-                                                        if(!std::isfinite(x_a) && !std::isfinite(x_b)) continue;
-
-                                                        auto x = (isininc(0.0, x_a, 1.0)) ? x_a : x_b;
-
-                                                        if( !(isininc(0.0, x_a, 1.0)) && !(isininc(0.0, x_b, 1.0)) ){
-                                                            // This is probably a numerical error. Accept values slightly
-                                                            // beyond the limits.
-                                                            const auto x_a_c = std::clamp(x_a, 0.0, 1.0);
-                                                            const auto x_b_c = std::clamp(x_b, 0.0, 1.0);
-                                                            x = (std::abs(x_a - x_a_c) < std::abs(x_b - x_b_c)) ? x_a_c : x_b_c;
-                                                        }
-
-                                                        if( (isininc(0.0, x_a, 1.0)) && (isininc(0.0, x_b, 1.0)) ){
-                                                            // This is probably a numerical error. Accept the value closest
-                                                            // to the middle of the range since the phony root is likely to
-                                                            // hover around the range extrema.
-                                                            x = (std::abs(x_a - 0.5) < std::abs(x_b - 0.5)) ? x_a : x_b;
-                                                        }
-
-                                                        const auto diag_pos = diag_img_refw.get().position(diag_row, diag_col);
-                                                        const auto diag_v = (diag_pos - adj_vox_pos);
-                                                        if( ! diag_v.isfinite() ){
-                                                            throw std::logic_error("Diagonal and centre overlap. Cannot continue.");
-                                                        }
-
-                                                        // Abandon the calculation if the point is on the wrong side of
-                                                        // the centre voxel (and thus the interpolation will necessarily
-                                                        // be further away than the centre voxel).
-                                                        //if( (pos - diag_pos).Dot(diag_v_unit) <= 0.0 ) continue;
-                                                        //if( (pos - diag_pos).Dot(diag_v_unit) >= 0.0 ) continue;
-
-                                                        const auto R_target = adj_vox_pos + (diag_v * x);
-                                                        const auto R_dist = R_target.distance(pos);
-                                                        if(R_dist < Dist){
-                                                            Dist = R_dist;
-                                                        }
-
-                                                    } // If: triplet is valid.
-                                                } // Loop over adjacent neighbours.
-                                            } // If: using NNN interpolation.
-
-
-                                        } // If-else: avoid interpolating neighbours.
-                                    } // Loop: j.
-                                } // Loop: i.
-                            } // Loop: k.
-
-                            if((Dist + max_interp_dist) < nearest_dist){
-                                // It is now impossible to improve the DTA because the next wavefront will all necessarily
-                                // be further away. So terminate the search.
-                                break; // note: voxel_val set below.
-                            }
-                            
-                            if(!std::isfinite(nearest_dist)){
-                                // No voxels found to assess within this epoch. Further epochs will be futile, so
-                                // discontinue the search, taking whatever value (finite or infinite) was found to be best.
-                                break; // note: voxel_val set below.
-                            }
-                            
-                            if(nearest_dist > (user_data_s->DTA_max + max_interp_dist)){
-                                // Terminate the search if the user has instructed so.
-                                // Take the current best value if there is any.
-                                break; // note: voxel_val set below.
-                            }
-
-                            // If computing the gamma index, check if we can avoid continuing the DTA search since gamma
-                            // will necessarily be >1 at this point.
-                            if( (user_data_s->gamma_terminate_when_max_exceeded)
-                            &&  (nearest_dist > (user_data_s->gamma_DTA_threshold + max_interp_dist)) ){
-                                voxel_val = user_data_s->gamma_terminated_early;
-                                return;
-                            }
+                                    // Interpolate the neighbours.
+                                    //
+                                    // If neighbouring voxel values have been seen both above and below the
+                                    // target value, then the grid can be interpolated (at some unknown location) to achieve
+                                    // the target value. 
+                                    //
+                                    // However, the interpolation can only possibly be better than the current by a
+                                    // certain amount. If indexed, neighbourhoods that cannot straddle the target value
+                                    // are also skipped.
+                                    }else if( (adj_vox_dist < (Dist + max_interp_dist))
+                                          &&  ( (l_index == nullptr)
+                                             || l_index->may_interpolate( l_index->index(adj_index_img, l_row, l_col),
+                                                                          adj_img_val, edit_val ) ) ){
+
+                                        // Sample the (6) 3D nearest neighbours and interpolate between them if necessary.
+                                        // 
+                                        // Note that this technique merely interpolates along the edges of the voxel-to-voxel grid.
+                                        // It is robust and comparable in speed to no interpolation.
+                                        if( (user_data_s->interpolation_method == ComputeCompareImagesUserData::InterpolationMethod::NN)
+                                        ||  (user_data_s->interpolation_method == ComputeCompareImagesUserData::InterpolationMethod::NNN) ){
+
+                                            // In pixel coordinates, these points are all a distance of sqrt(1)=1 from the centre voxel.
+                                            std::array<std::array<long int, 3>, 6> nn_triplets = {{
+                                                    { -1,  0,  0 },
+                                                    {  1,  0,  0 },
+                                                    {  0, -1,  0 },
+                                                    {  0,  1,  0 },
+                                                    {  0,  0, -1 },
+                                                    {  0,  0,  1 }
+                                            }};
+
+                                            for(const auto &triplets : nn_triplets){
+                                                const auto nn_row = l_row + triplets[0];
+                                                const auto nn_col = l_col + triplets[1];
+                                                const auto nn_img = l_num + triplets[2];
+
+                                                if(img_adj.index_present(nn_img)
+                                                && isininc(0, nn_row, adj_img_ptr->rows - 1L)
+                                                && isininc(0, nn_col, adj_img_ptr->columns - 1L) ){
+                                                
+                                                    auto nn_img_refw = img_adj.index_to_image(nn_img);
+                                                    const auto nn_val = nn_img_refw.get().value(nn_row, nn_col, channel);
+
+                                                    const bool nn_is_lower = (nn_val < edit_val);
+                                                    const bool nn_is_higher = (edit_val < nn_val);
+
+                                                    // Skip this neighbour if it does not complement the central
+                                                    // voxel and therefore cannot be interpolated to the target
+                                                    // value.
+                                                    //if( !( (nn_is_lower || is_lower) && (nn_is_higher || is_higher) ) ) continue;
+                                                    // equiv to:  (?)
+                                                    if( !( (is_higher && nn_is_lower) || (is_lower && nn_is_higher) ) ) continue;
+
+                                                    // Determine the 3D point at which the target value is reached.
+                                                    const auto nn_pos = nn_img_refw.get().position(nn_row, nn_col);
+                                                    const auto nn_v_unit = (adj_vox_pos - nn_pos).unit();
+                                                    //if( ! nn_v_unit.isfinite() ) continue;
+                                                    if( ! nn_v_unit.isfinite() ){
+                                                        throw std::logic_error("Diagonal and centre overlap. Cannot continue.");
+                                                    }
+
+                                                    // Abandon the calculation if the point is on the wrong side of
+                                                    // the centre voxel (and thus the interpolation will necessarily
+                                                    // be further away than the centre voxel).
+                                                    //if( (pos - nn_pos).Dot(nn_v_unit) <= 0.0 ) continue;
+                                                    //if( (pos - nn_pos).Dot(nn_v_unit) >= 0.0 ) continue;
+
+                                                    // Since either:
+                                                    //    adj_img_val <= edit_val <= nn_val
+                                                    // or
+                                                    //    adj_img_val >= edit_val >= nn_val
+                                                    // then
+                                                    //   |adj_img_val - nn_val| >= |edit_val - nn_val|.
+                                                    // so we can use this to scale the translation from nn to adj_img.
+                                                    const auto dR = nn_pos.distance( adj_vox_pos );
+                                                    const auto d_target = std::abs(edit_val - nn_val);
+                                                    const auto d_val = std::abs(adj_img_val - nn_val);
+                                                    const auto R_target = nn_pos + (nn_v_unit * dR * d_target / d_val);
+
+                                                    const auto R_dist = R_target.distance(pos);
+                                                    if(R_dist < Dist) Dist = R_dist;
+                                                } // If: triplet is valid.
+                                            } // Loop over adjacent neighbours.
+                                        } // If: using NN interpolation.
+                                        
+                                        // Sample the (12) 3D next-nearest neighbours and interpolate between them if necessary.
+                                        // 
+                                        // Note that this technique interpolates the planar diagonal along the edges of the voxel-to-voxel grid.
+                                        // It requires solving a quadratic polynomial and is therefore more computationally demanding.
+                                        // Numerical difficulties are also amplified, which results in lower accuracy than nearest-neighbour
+                                        // interpolation.
+                                        if(user_data_s->interpolation_method == ComputeCompareImagesUserData::InterpolationMethod::NNN){
+                                            //In pixel coordinates, these points are all sqrt(2) distance from the centre voxel.
+                                            // The following triplets come in packs of triplets: the first triplet is the diagonal position
+                                            // and the second and third triplets are corners which are needed for interpolation.
+                                            //
+                                            // As you can see, the corners can be summed to give the diagonals; they could also be decomposed
+                                            // this way, but it seemed easier to just write them all out.
+                                            std::array<std::array<std::array<long int, 3>, 3>, 12> nnn_triplets = {{
+                                                    {{ { -1,  0, -1 },   {  0,  0, -1 },  { -1,  0,  0 } }},
+                                                    {{ {  0, -1, -1 },   {  0,  0, -1 },  {  0, -1,  0 } }},
+                                                    {{ {  0,  1, -1 },   {  0,  0, -1 },  {  0,  1,  0 } }},
+                                                    {{ {  1,  0, -1 },   {  0,  0, -1 },  {  1,  0,  0 } }},
+                                                                    
+                                                    {{ { -1, -1,  0 },   {  0, -1,  0 },  { -1,  0,  0 } }},
+                                                    {{ { -1,  1,  0 },   {  0,  1,  0 },  { -1,  0,  0 } }},
+                                                    {{ {  1, -1,  0 },   {  0, -1,  0 },  {  1,  0,  0 } }},
+                                                    {{ {  1,  1,  0 },   {  0,  1,  0 },  {  1,  0,  0 } }},
+                                                                    
+                                                    {{ { -1,  0,  1 },   {  0,  0,  1 },  { -1,  0,  0 } }},
+                                                    {{ {  0, -1,  1 },   {  0,  0,  1 },  {  0, -1,  0 } }},
+                                                    {{ {  0,  1,  1 },   {  0,  0,  1 },  {  0,  1,  0 } }},
+                                                    {{ {  1,  0,  1 },   {  0,  0,  1 },  {  1,  0,  0 } }}
+                                            }};
+
+                                            for(const auto &t_triplets : nnn_triplets){
+                                                const auto diag_row = l_row + t_triplets[0][0];  // Diagonal.
+                                                const auto diag_col = l_col + t_triplets[0][1];
+                                                const auto diag_img = l_num + t_triplets[0][2];
+
+                                                const auto cA_row = l_row + t_triplets[1][0];  // Corner A.
+                                                const auto cA_col = l_col + t_triplets[1][1];
+                                                const auto cA_img = l_num + t_triplets[1][2];
+
+                                                const auto cB_row = l_row + t_triplets[2][0];  // Corner B.
+                                                const auto cB_col = l_col + t_triplets[2][1];
+                                                const auto cB_img = l_num + t_triplets[2][2];  
+
+                                                if(img_adj.index_present(diag_img)
+                                                && img_adj.index_present(cA_img)
+                                                && img_adj.index_present(cB_img)
+                                                && isininc(0, diag_row, adj_img_ptr->rows - 1L)
+                                                && isininc(0, diag_col, adj_img_ptr->columns - 1L)
+                                                && isininc(0, cA_row,   adj_img_ptr->rows - 1L)
+                                                && isininc(0, cA_col,   adj_img_ptr->columns - 1L)
+                                                && isininc(0, cB_row,   adj_img_ptr->rows - 1L)
+                                                && isininc(0, cB_col,   adj_img_ptr->columns - 1L) ){
+                                                
+                                                    auto diag_img_refw = img_adj.index_to_image(diag_img);
+                                                    const auto diag_val = diag_img_refw.get().value(diag_row, diag_col, channel);
+
+                                                    const bool diag_is_lower = (diag_val < edit_val);
+                                                    const bool diag_is_higher = (edit_val < diag_val);
+
+                                                    // Skip this neighbour if it does not complement the central
+                                                    // voxel and therefore cannot be interpolated to the target
+                                                    // value.
+                                                    if( !( (is_higher && diag_is_lower) || (is_lower && diag_is_higher) ) ) continue;
+
+                                                    auto cA_img_refw  = img_adj.index_to_image(cA_img);
+                                                    auto cB_img_refw  = img_adj.index_to_image(cB_img);
+                                                    const auto cA_val = cA_img_refw.get().value(cA_row, cA_col, channel);
+                                                    const auto cB_val = cB_img_refw.get().value(cB_row, cB_col, channel);
+
+                                                    // Determine the 3D point at which the target value is reached.
+                                                    const auto a = adj_img_val - edit_val;
+                                                    const auto b = (cA_val - adj_img_val) + (cB_val - adj_img_val);
+                                                    const auto d = diag_val + adj_img_val - cA_val - cB_val;
+
+                                                    const auto x_a = (-b + std::sqrt( b*b - 4.0*d*a ) ) / (2.0 * d);
+                                                    const auto x_b = (-b - std::sqrt( b*b - 4.0*d*a ) ) / (2.0 * d);
+                                                    if(!std::isfinite(x_a) && !std::isfinite(x_b)) continue;
+
+                                                    auto x = (isininc(0.0, x_a, 1.0)) ? x_a : x_b;
+
+                                                    if( !(isininc(0.0, x_a, 1.0)) && !(isininc(0.0, x_b, 1.0)) ){
+                                                        // This is probably a numerical error. Accept values slightly
+                                                        // beyond the limits.
+                                                        const auto x_a_c = std::clamp(x_a, 0.0, 1.0);
+                                                        const auto x_b_c = std::clamp(x_b, 0.0, 1.0);
+                                                        x = (std::abs(x_a - x_a_c) < std::abs(x_b - x_b_c)) ? x_a_c : x_b_c;
+                                                    }
+
+                                                    if( (isininc(0.0, x_a, 1.0)) && (isininc(0.0, x_b, 1.0)) ){
+                                                        // This is probably a numerical error. Accept the value closest
+                                                        // to the middle of the range since the phony root is likely to
+                                                        // hover around the range extrema.
+                                                        x = (std::abs(x_a - 0.5) < std::abs(x_b - 0.5)) ? x_a : x_b;
+                                                    }
+
+                                                    const auto diag_pos = diag_img_refw.get().position(diag_row, diag_col);
+                                                    const auto diag_v = (diag_pos - adj_vox_pos);
+                                                    if( ! diag_v.isfinite() ){
+                                                        throw std::logic_error("Diagonal and centre overlap. Cannot continue.");
+                                                    }
+
+                                                    // Abandon the calculation if the point is on the wrong side of
+                                                    // the centre voxel (and thus the interpolation will necessarily
+                                                    // be further away than the centre voxel).
+                                                    //if( (pos - diag_pos).Dot(diag_v_unit) <= 0.0 ) continue;
+                                                    //if( (pos - diag_pos).Dot(diag_v_unit) >= 0.0 ) continue;
+
+                                                    const auto R_target = adj_vox_pos + (diag_v * x);
+                                                    const auto R_dist = R_target.distance(pos);
+                                                    if(R_dist < Dist){
+                                                        Dist = R_dist;
+                                                    }
+
+                                                } // If: triplet is valid.
+                                            } // Loop over adjacent neighbours.
+                                        } // If: using NNN interpolation.
+
+
+                                    } // If-else: avoid interpolating neighbours.
+                                } // Loop: j.
+                            } // Loop: i.
+                        } // Loop: k.
+
+                        if((Dist + max_interp_dist) < nearest_dist){
+                            // It is now impossible to improve the DTA because the next wavefront will all necessarily
+                            // be further away. So terminate the search.
+                            break; // note: voxel_val set below.
+                        }
+                        
+                        if(!std::isfinite(nearest_dist)){
+                            // No voxels found to assess within this epoch. Further epochs will be futile, so
+                            // discontinue the search, taking whatever value (finite or infinite) was found to be best.
+                            break; // note: voxel_val set below.
+                        }
+                        
+                        if(nearest_dist > (user_data_s->DTA_max + max_interp_dist)){
+                            // Terminate the search if the user has instructed so.
+                            // Take the current best value if there is any.
+                            break; // note: voxel_val set below.
+                        }
 
-                            // Otherwise, advance the wavefront and continue searching.
-                            ++w;
+                        // If computing the gamma index, check if we can avoid continuing the DTA search since gamma
+                        // will necessarily be >1 at this point.
+                        if( (user_data_s->gamma_terminate_when_max_exceeded)
+                        &&  (nearest_dist > (user_data_s->gamma_DTA_threshold + max_interp_dist)) ){
+                            voxel_val = user_data_s->gamma_terminated_early;
+                            return;
                         }
+
+                        // Otherwise, advance the wavefront and continue searching.
+                        ++w;
                     }
+                }
 
-                    // Assign the voxel a value.
-                    if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::Discrepancy){
-                        voxel_val = Disc;
+                if(survey) return;
 
-                    }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::DTA){
-                        if(std::isfinite(Dist)){
-                            voxel_val = Dist;
-                        }else{
-                            voxel_val = inaccessible_val;
-                        }
+                // Assign the voxel a value.
+                if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::Discrepancy){
+                    voxel_val = Disc;
 
-                    }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex){
-                        std::lock_guard<std::mutex> lock(passing_counter);
-                        user_data_s->count += 1;
+                }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::DTA){
+                    if(std::isfinite(Dist)){
+                        voxel_val = Dist;
+                    }else{
+                        voxel_val = inaccessible_val;
+                    }
 
-                        if(std::isfinite(Dist) && std::isfinite(Disc)){
-                            voxel_val = std::sqrt( std::pow(Dist / user_data_s->gamma_DTA_threshold, 2.0)
-                                                 + std::pow(Disc / user_data_s->gamma_Dis_threshold, 2.0) );
+                }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex){
+                    std::lock_guard<std::mutex> lock(passing_counter);
+                    user_data_s->count += 1;
 
-                            if(voxel_val < 1.0) user_data_s->passed += 1;
-                        }else{
-                            voxel_val = inaccessible_val;
-                        }
+                    if(std::isfinite(Dist) && std::isfinite(Disc)){
+                        voxel_val = std::sqrt( std::pow(Dist / user_data_s->gamma_DTA_threshold, 2.0)
+                                             + std::pow(Disc / user_data_s->gamma_Dis_threshold, 2.0) );
 
+                        if(voxel_val < 1.0) user_data_s->passed += 1;
                     }else{
-                        throw std::logic_error("Unrecognized comparison operation requested. Refusing to continue.");
+                        voxel_val = inaccessible_val;
                     }
-                    return;
-                }while(false);
+
+                }else{
+                    throw std::logic_error("Unrecognized comparison operation requested. Refusing to continue.");
+                }
                 return;
-            };
+            }while(false);
+            return;
+        };
 
+        if(survey){
+            // Leave the voxels untouched; only the searches that would be performed are recorded.
+            auto f_survey = [&](long int E_row, long int E_col, long int channel, std::reference_wrapper<planar_image<float,double>> l_img_refw, float &voxel_val) {
+                auto l_voxel_val = voxel_val;
+                f_bounded(E_row, E_col, channel, l_img_refw, l_voxel_val);
+                return;
+            };
             Mutate_Voxels<float,double>( img_refw,
                                          { img_refw },
                                          ccsl, 
                                          mv_opts, 
-                                         f_bounded );
-
-            if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::Discrepancy){
-                UpdateImageDescription( img_refw, "Compared (discrepancy)" );
-            }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::DTA){
-                UpdateImageDescription( img_refw, "Compared (DTA)" );
-            }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex){
-                UpdateImageDescription( img_refw, "Compared (gamma-index)" );
-            }
-            UpdateImageWindowCentreWidth( img_refw );
-
-            //Report operation progress.
-            {
-                std::lock_guard<std::mutex> lock(saver_printer);
-                ++completed;
-                FUNCINFO("Completed " << completed << " of " << img_count
-                      << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+                                         f_survey );
+            return;
+        }
+
+        Mutate_Voxels<float,double>( img_refw,
+                                     { img_refw },
+                                     ccsl, 
+                                     mv_opts, 
+                                     f_bounded );
+
+        if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::Discrepancy){
+            UpdateImageDescription( img_refw, "Compared (discrepancy)" );
+        }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::DTA){
+            UpdateImageDescription( img_refw, "Compared (DTA)" );
+        }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex){
+            UpdateImageDescription( img_refw, "Compared (gamma-index)" );
+        }
+        UpdateImageWindowCentreWidth( img_refw );
+
+        //Report operation progress.
+        {
+            std::lock_guard<std::mutex> lock(saver_printer);
+            ++completed;
+            FUNCINFO("Completed " << completed << " of " << img_count
+                  << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+        }
+    };
+
+    if(search_index){
+        {
+            asio_thread_pool tp;
+            for(auto &img : imagecoll.images){
+                std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
+                tp.submit_task([&,img_refw]() -> void {
+                    compare_image(img_refw, true);
+                }); // thread pool task closure.
             }
-        }); // thread pool task closure.
+        }
 
+        std::vector<dta_search_query> queries;
+        for(auto &p : search_queries){
+            queries.insert( std::end(queries), std::begin(p.second), std::end(p.second) );
+            p.second = std::vector<dta_search_query>();
+        }
+        search_index->resolve_searches(queries, *user_data_s);
     }
 
+    asio_thread_pool tp;
+    for(auto &img : imagecoll.images){
+        std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
+        tp.submit_task([&,img_refw]() -> void {
+            compare_image(img_refw, false);
+        }); // thread pool task closure.
+    }
 
     return true;
 }
@@ -102,6 +102,28 @@ struct ComputeCompareImagesUserData {
         NNN,        // Next-nearest-neighbour interpolation, along with NN and a simple straddle method.
     } interpolation_method = InterpolationMethod::NN;
 
+    // The engine used to perform the DTA search. Both engines give identical results.
+    //
+    // The wavefront engine grows a rectangular wavefront around each voxel until agreement is found or the search is
+    // abandoned.
+    //
+    // The indexed engine first partitions the voxels that require a search into bands of similar value. For each band,
+    // exact Euclidean distance transforms of the reference voxels that could possibly agree (or straddle) are computed,
+    // which bound the distance to agreement from below. Searches that are guaranteed to fail (e.g., voxels in regions
+    // with a systematic discrepancy) are resolved directly from these bounds. The remaining searches use the wavefront,
+    // but skip interpolating voxels whose neighbourhood cannot straddle the target value. The indexed engine requires
+    // additional memory proportional to the number of reference voxels, but can be much faster when many voxels fail or
+    // when reference images are finely sampled.
+    enum class
+    SearchEngine {
+        Wavefront,  // Exhaustive wavefront search for every voxel.
+        Indexed,    // Value-banded distance transform bounds, followed by a pruned wavefront search.
+    } search_engine = SearchEngine::Wavefront;
+
+    // The (maximum) number of value bands used by the indexed engine. Narrower bands provide tighter bounds, but each
+    // band requires several distance transforms of the reference images.
+    long int indexed_search_bands = 32;
+
 
     // -----------------------------
     // Parameters for all comparisons involving discrepancy.
@@ -7,11 +7,17 @@
 #include <list>
 #include <map>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <vector>
 
 #include "../../Thread_Pool.h"
+#include "../../Dose_Volume_Histogram.h"
+#include "../../Scanline_Rasterizer.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
 #include "Extract_Histograms.h"
@@ -29,13 +35,16 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
                       std::any user_data ){
 
     // This routine extracts histograms from the bounded voxels of an image array. It can be used to generate
-    // dose-volume histograms (DVHs) in differential form. These can be post-processed to generate cumulative DVHs and
-    // axes-normalized variants of either differential or cumulative DVHs.
+    // dose-volume histograms (DVHs) in differential and cumulative form. These can be post-processed to generate
+    // axes-normalized variants of either.
+    //
+    // Voxels are visited once and binned directly, so the histograms for all logical partitions are generated in a
+    // single sweep without needing to first determine the range of voxel values.
     //
     // Note: Non-finite voxels are excluded from analysis and do not contribute to the volume. If absolute volume is
     //       required, ensure all voxels are finite prior to invoking this routine.
     //
-    // Note: This routine will consume a lot of memory if the resolution is too fine.
+    // Note: This routine will consume a lot of memory if the resolution is too fine, unless adaptive binning is used.
     //
     // Note: The image collection and contour collections will not be altered.
     //
@@ -99,119 +108,22 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
         }
     }
 
-    // Determine voxel value extrema for each logical partition.
-    std::map<std::string,               // ROIName.
-             std::pair<double,          // Minimum voxel value (within the user's inclusive range).
-                       double>>         // Maximum voxel value (within the user's inclusive range).
-                       voxel_extrema;
-
-    { // Scope for thread pool.
-        asio_thread_pool tp;
-        std::mutex saver;
-        std::mutex printer;
-        long int completed = 0;
-        const long int img_count = imagecoll.images.size();
-
-        for(auto &img : imagecoll.images){
-            std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
-            tp.submit_task([&,img_refw]() -> void {
-
-                // Cycle over all the alike-named contour collections.
-                for(auto & named_ccsl : named_ccsls){
-                    double local_minimum = std::numeric_limits<double>::infinity();
-                    double local_maximum = -local_minimum;
-
-                    auto f_bounded = [&](long int /*E_row*/, 
-                                         long int /*E_col*/,
-                                         long int channel,
-                                         std::reference_wrapper<planar_image<float,double>> /*l_img_refw*/,
-                                         float &voxel_val) {
-                        if( ( (user_data_s->channel < 0) || (user_data_s->channel == channel))
-                        &&  std::isfinite(voxel_val)  // Ignore infinite and NaN voxels.
-                        &&  (user_data_s->lower_threshold <= voxel_val)
-                        &&  (voxel_val <= user_data_s->upper_threshold) ){
-                            if(voxel_val < local_minimum) local_minimum = voxel_val;
-                            if(local_maximum < voxel_val) local_maximum = voxel_val;
-                        }
-                        return;
-                    };
-
-                    Mutate_Voxels<float,double>( img_refw,
-                                                 { img_refw },
-                                                 named_ccsl.second, 
-                                                 user_data_s->mutation_opts, 
-                                                 f_bounded );
-
-                    // Merge the results.
-                    if( std::isfinite(local_minimum) 
-                    &&  std::isfinite(local_maximum) ){
-                        std::lock_guard<std::mutex> lock(saver);
-
-                        const auto key = named_ccsl.first;
-                        if(voxel_extrema.count(key) == 0){
-                            voxel_extrema[key] = std::make_pair(local_minimum, local_maximum);
-                        }else{
-                            if(local_minimum < voxel_extrema[key].first)  voxel_extrema[key].first  = local_minimum;
-                            if(voxel_extrema[key].second < local_maximum) voxel_extrema[key].second = local_maximum;
-                        }
-                    }
-                } // Loop over all named ccs.
-
-                //Report operation progress.
-                {
-                    std::lock_guard<std::mutex> lock(printer);
-                    ++completed;
-                    FUNCINFO("Completed " << completed << " of " << img_count
-                          << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
-                }
-
-            }); // thread pool task closure.
-        } // Loop over all images.
-    }
-
-
-    // Allocate storage for each logical partition.
-    std::map<std::string, size_t> bin_counts;
-    std::map<std::string, double> bin_widths;
-    std::map<std::string,                        // ROIName.
-             std::vector<std::array<double,4>>>  // Differential histogram with implicit bin numbering (min to max).
-                 raw_diff_histograms;
-    std::set<std::string> to_purge; // Groups to purge because they are invalid.
-    for(const auto &extrema : voxel_extrema){
-        const auto key = extrema.first;
-
-        const auto voxel_min = extrema.second.first;
-        const auto voxel_max = extrema.second.second;
-        const auto range = (voxel_max - voxel_min);
-        const auto count_f = range / user_data_s->dDose;
-        if( !std::isfinite(count_f)
-        ||  (1.0E9 < count_f) // approx 10 GB just for the bin values, actual usage would be higher.
-        ||  (count_f <= 1.0) ){
-            FUNCWARN("Excessive or invalid number of bins required for key '" << key << "'. Skipping it");
-            to_purge.insert(key);
-            continue;
-        }
-        const auto bin_count = static_cast<size_t>(std::ceil( count_f ));
-        const auto bin_width = range / static_cast<double>(bin_count);
-
-        // Prepare the histograms bins.
-        //
-        // Note: bin values are centred.
-        std::vector<std::array<double,4>> hist(bin_count, {0.0, 0.0, 0.0, 0.0} );
-        for(size_t i = 0; i < bin_count; ++i){
-            hist[i][0] = voxel_min 
-                       + (bin_width * static_cast<double>(i)) 
-                       + (bin_width * 0.5);
+    const bool overlap_cancels = (user_data_s->mutation_opts.contouroverlap
+                                      == Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations);
+    const auto N_pv = user_data_s->partial_volume_samples;
+    if(0 < N_pv){
+        if(user_data_s->mutation_opts.contouroverlap == Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations){
+            throw std::invalid_argument("Partial-volume weighting does not support honouring contour orientations.");
         }
 
-        bin_counts.emplace(key, bin_count);
-        bin_widths.emplace(key, bin_width);
-        raw_diff_histograms.emplace(key, hist);
+        // Visit every voxel that might be partially interior. Fractions are computed explicitly.
+        user_data_s->mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
     }
-    for(const auto &key : to_purge) voxel_extrema.extract(key);
 
-
-    // Visit all voxels to build the histograms.
+    // Visit all voxels once, binning them into a histogram for each logical partition.
+    //
+    // Each task accumulates private histograms which are merged afterward, so there is no contention while binning.
+    std::map<std::string, dose_volume_histogram> histograms;
     {
         asio_thread_pool tp;
         std::mutex saver;
@@ -228,31 +140,26 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
                 const auto pxl_dz = img_refw.get().pxl_dz;
                 const auto pxl_vol = pxl_dx * pxl_dy * pxl_dz;
 
-                std::vector<size_t> shuttle;  // Thread-specific storage buffer.
-                const size_t N_shuttle = 1000; // Size of buffer.
-                shuttle.reserve(N_shuttle);
-
                 for(auto & named_ccsl : named_ccsls){
                     const auto key = named_ccsl.first;
-                    if(bin_counts.count(key) != 1) continue; // Group did not enclose any voxels.
-
-                    const auto bin_count = bin_counts.at(key);
-                    const auto bin_width = bin_widths.at(key);
-                    const auto voxel_min = voxel_extrema.at(key).first;
-                    //const auto voxel_max = voxel_extrema.at(key).second;
-                    std::vector<std::array<double,4>> &raw_diff_hist(raw_diff_histograms.at(key));
-
-                    // Sub-routine to add all counts from the buffer and then reset the buffer.
-                    const auto add_counts = [&]() -> void {
-                        std::lock_guard<std::mutex> lock(saver);
-                        for(const auto &bin_N : shuttle) raw_diff_hist[bin_N][2] += pxl_vol;
-                        shuttle.clear();
-                        shuttle.reserve(N_shuttle);
-                        return;
-                    };
+                    dose_volume_histogram dvh(user_data_s->dDose, 0.0, user_data_s->max_bins);
+
+                    // Partial-volume fractions are estimated for all contours intersecting the image at once.
+                    contour_raster raster;
+                    if(0 < N_pv){
+                        std::vector<std::reference_wrapper<const contour_of_points<double>>> cs;
+                        for(auto &cc_refw : named_ccsl.second){
+                            for(const auto &c : cc_refw.get().contours){
+                                if(c.points.size() < 3) continue;
+                                if(!img_refw.get().encompasses_contour_of_points(c)) continue;
+                                cs.emplace_back( std::cref(c) );
+                            }
+                        }
+                        raster = Rasterize_Contours(img_refw.get(), cs, overlap_cancels, N_pv);
+                    }
 
-                    auto f_bounded = [&](long int /*E_row*/, 
-                                         long int /*E_col*/,
+                    auto f_bounded = [&](long int E_row,
+                                         long int E_col,
                                          long int channel,
                                          std::reference_wrapper<planar_image<float,double>> /*l_img_refw*/,
                                          float &voxel_val){
@@ -262,13 +169,11 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
                         &&  (user_data_s->lower_threshold <= voxel_val)
                         &&  (voxel_val <= user_data_s->upper_threshold) ){
 
-                            const auto d_low = voxel_val - voxel_min;
-                            const auto bin_N = std::clamp( static_cast<size_t>( std::floor(d_low/bin_width) ),
-                                                           static_cast<size_t>(0),
-                                                           static_cast<size_t>(bin_count-1) );
-                            //raw_diff_hist.at(bin_N)[2] += pxl_vol;
-                            shuttle.push_back(bin_N);
-                            if(N_shuttle == shuttle.size()) add_counts();
+                            double weight = pxl_vol;
+                            if(0 < N_pv){
+                                weight *= raster.fraction(E_row, E_col);
+                            }
+                            dvh.digest(voxel_val, weight);
                         }
                         return;
                     };
@@ -279,7 +184,15 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
                                                  user_data_s->mutation_opts, 
                                                  f_bounded );
 
-                    add_counts(); // Commit all remaining bins from the shuttle.
+                    if(!dvh.empty()){
+                        std::lock_guard<std::mutex> lock(saver);
+                        auto h_it = histograms.find(key);
+                        if(h_it == histograms.end()){
+                            histograms.emplace(key, dvh);
+                        }else{
+                            h_it->second.merge(dvh);
+                        }
+                    }
                 } // Loop over all named ccs.
 
                 //Report operation progress.
@@ -294,92 +207,42 @@ bool ComputeExtractHistograms(planar_image_collection<float,double> &imagecoll,
         } // Loop over all images.
     }
 
-    // Prepare differential histograms.
+    // Prepare differential and cumulative histograms.
     for(auto & named_ccsl : named_ccsls){
         const auto key = named_ccsl.first;
 
-        if( (bin_counts.count(key) != 1)
-        ||  (bin_counts[key] < 2) ){
-            FUNCWARN("Computed histogram with few enclosed voxels, or excessively coarse resolution. Skipping");
+        auto h_it = histograms.find(key);
+        if(h_it == histograms.end()){
+            FUNCWARN("Computed histogram with no enclosed voxels. Skipping");
             continue;
             //Could be due to:
             // -contours being too small (much smaller than voxel size).
             // -dose and contours not aligning properly. Maybe due to incorrect offsets/rotations/coordinate system?
             // -dose/contours not being present. Maybe accidentally?
-            // -dDose being too large.
-        }
-
-        user_data_s->differential_histograms[key].samples.swap( raw_diff_histograms.at(key) );
-
-        user_data_s->differential_histograms[key].metadata["Modality"]        = "Histogram"; 
-        user_data_s->differential_histograms[key].metadata["HistogramType"]   = "Differential";
-        user_data_s->differential_histograms[key].metadata["AbscissaScaling"] = "None"; // Absolute values in DICOM units, Gy.
-        user_data_s->differential_histograms[key].metadata["OrdinateScaling"] = "None"; // Absolute values in DICOM units, mm^3.
-
-        const auto voxel_min = voxel_extrema.at(key).first;
-        const auto voxel_max = voxel_extrema.at(key).second;
-        //const auto range = (voxel_max - voxel_min);
-        //const auto bin_count = bin_counts.at(key);
-        //const auto bin_width = bin_widths.at(key);
-
-        Stats::Running_Sum<double> x_v;
-        Stats::Running_Sum<double> v;
-        std::vector<std::array<double,4>> &hist_samples( user_data_s->differential_histograms[key].samples );
-        for(const auto &s : hist_samples){
-            x_v.Digest(s[0]*s[2]);
-            v.Digest(s[2]);
-        }
-        const auto voxel_mean = x_v.Current_Sum() / v.Current_Sum();
-        if(!std::isfinite(voxel_mean)){
-            throw std::runtime_error("Unable to estimate distribution mean. Refusing to continue.");
         }
-
-        user_data_s->differential_histograms[key].metadata["DistributionMin"]  = std::to_string(voxel_min);
-        user_data_s->differential_histograms[key].metadata["DistributionMean"] = std::to_string(voxel_mean);
-        user_data_s->differential_histograms[key].metadata["DistributionMax"]  = std::to_string(voxel_max);
+        const auto &dvh = h_it->second;
+
+        auto &diff = user_data_s->differential_histograms[key];
+        diff = dvh.differential();
+        diff.metadata["Modality"]         = "Histogram"; 
+        diff.metadata["HistogramType"]    = "Differential";
+        diff.metadata["AbscissaScaling"]  = "None"; // Absolute values in DICOM units, Gy.
+        diff.metadata["OrdinateScaling"]  = "None"; // Absolute values in DICOM units, mm^3.
+        diff.metadata["DistributionMin"]  = std::to_string(dvh.min());
+        diff.metadata["DistributionMean"] = std::to_string(dvh.mean());
+        diff.metadata["DistributionMax"]  = std::to_string(dvh.max());
+
+        auto &cumul = user_data_s->cumulative_histograms[key];
+        cumul = dvh.cumulative();
+        cumul.metadata = diff.metadata;
+        cumul.metadata["HistogramType"]   = "Cumulative";
 
         const auto x_eps = std::numeric_limits<double>::infinity();  // Ignore the abscissa.
-        //const auto y_eps = 0.0001;
         const auto y_eps = std::sqrt( 10.0 * std::numeric_limits<double>::epsilon() );
-        {
-            auto purged = user_data_s->differential_histograms[key].Purge_Redundant_Samples(x_eps, y_eps);
-            user_data_s->differential_histograms[key].samples.swap(purged.samples);
-        }
-    }
-
-    // Prepare cumulative histograms.
-    //
-    // Note: This step could be made optional to reduce memory usage. Also, the normalization could be adjusted.
-    for(auto & hist : user_data_s->differential_histograms){
-        const auto key = hist.first;
-
-        user_data_s->cumulative_histograms[key] = hist.second;
-        user_data_s->cumulative_histograms[key].metadata["HistogramType"] = "Cumulative";
-
-        const auto bin_width = bin_widths.at(key);
-        const auto extra_bin_x = user_data_s->cumulative_histograms[key].samples.back()[0] + bin_width;
-        user_data_s->cumulative_histograms[key].push_back(extra_bin_x, 0.0);
-
-        std::vector<std::array<double,4>> &hist_samples( user_data_s->cumulative_histograms[key].samples );
-        const auto N_bins = hist_samples.size();
-
-        Stats::Running_Sum<double> rs;
-        for(size_t i = 0; i < N_bins; ++i){
-            const auto j = (N_bins - 1) - i;
-            rs.Digest(hist_samples[j][2]);
-            hist_samples[j][2] = rs.Current_Sum();
+        for(auto *h : { &diff, &cumul }){
+            auto purged = h->Purge_Redundant_Samples(x_eps, y_eps);
+            h->samples.swap(purged.samples);
         }
-        //const auto final_sum = rs.Current_Sum();
-
-        //if(false){
-        //}else if(user_data_s->cumulative_type == ComputeExtractHistogramsUserData::CumulativeType::OrdinateScaled){
-        //    user_data_s->cumulative_histograms[key].metadata["OrdinateScaling"] = "Normalized"; // Fractional, spanning [0:1].
-        //    for(auto & s : hist_samples){
-        //        s[2] /= final_sum;
-        //    }
-        //}else{
-        //    throw std::invalid_argument("Encountered cumulative histogram scaling option. Cannot continue.");
-        //}
     }
 
     FUNCINFO("Generated " << user_data_s->differential_histograms.size() << " histograms");
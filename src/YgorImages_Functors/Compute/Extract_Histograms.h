@@ -32,7 +32,24 @@ struct ComputeExtractHistogramsUserData {
     // -----------------------------
     // The width of histogram bins, in DICOM units (nominally Gy).
     //
+    // Bins are aligned to zero. If max_bins is non-zero, binning is adaptive: bins start with width dDose and are
+    // merged pairwise (doubling the width) whenever more than max_bins bins would otherwise be needed.
+    //
     double dDose = 1.0;
+    long int max_bins = 0;
+
+    // -----------------------------
+    // Partial-volume weighting.
+    //
+    // If positive, voxels straddling an ROI boundary contribute only the fraction of their volume that lies within the
+    // ROI. The fraction is estimated by the scanline rasterizer (see Scanline_Rasterizer.h), which divides each row of
+    // voxels into N sub-scanlines, where N is this value, and computes coverage along each sub-scanline exactly.
+    // Otherwise, each voxel deemed interior contributes its whole volume.
+    //
+    // Note: contour orientation is not considered when estimating fractions, so partial-volume weighting cannot be
+    //       combined with the 'HonourOppositeOrientations' contour overlap option.
+    //
+    long int partial_volume_samples = 0;
 
     // -----------------------------
     // The (inclusive) range of voxels to consider, in DICOM units (nominally Gy).
@@ -0,0 +1,542 @@
+//Resample_Images.cc.
+
+#include <algorithm>
+#include <any>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+#include "../../Thread_Pool.h"
+#include "../ConvenienceRoutines.h"
+
+#include "Resample_Images.h"
+
+
+namespace {
+
+// The voxels of a single channel of the source images, stored with the column number varying fastest, then the row
+// number, then the slice number. Holds B-spline coefficients rather than intensities after prefiltering.
+struct source_volume {
+    long int N_rows = 0;
+    long int N_cols = 0;
+    long int N_slices = 0;
+    std::vector<float> voxels;
+    std::vector<uint8_t> nonfinite; // Only populated if some of the original voxels are not finite.
+
+    size_t index(long int row, long int col, long int slice) const {
+        return static_cast<size_t>((slice * this->N_rows + row) * this->N_cols + col);
+    }
+};
+
+// Maps the distance along the source image normal to a fractional slice number.
+//
+// Slices need not be evenly spaced, in which case the map is piecewise linear.
+struct slice_map {
+    std::vector<double> s; // Position of each slice along the normal, in increasing order.
+    bool regular = true;
+    double ds = 1.0;
+    double half_thickness = 0.0;
+
+    // Returns false if the position is not within the slab covered by the slices. Otherwise the fractional slice
+    // number, clamped to the range of slices, is provided.
+    bool to_index(double pos, double &x) const {
+        const auto N = static_cast<long int>(this->s.size());
+        if( !std::isfinite(pos)
+        ||  (pos < (this->s.front() - this->half_thickness))
+        ||  ((this->s.back() + this->half_thickness) < pos) ){
+            return false;
+        }
+        if(pos <= this->s.front()){
+            x = 0.0;
+        }else if(this->s.back() <= pos){
+            x = static_cast<double>(N - 1);
+        }else if(this->regular){
+            x = std::clamp((pos - this->s.front()) / this->ds, 0.0, static_cast<double>(N - 1));
+        }else{
+            const auto it = std::upper_bound(std::begin(this->s), std::end(this->s), pos);
+            const auto i = static_cast<long int>(std::distance(std::begin(this->s), it)) - 1;
+            x = static_cast<double>(i) + (pos - this->s[i]) / (this->s[i + 1] - this->s[i]);
+        }
+        return true;
+    }
+};
+
+// Confines a fractional voxel number to the voxels, returning false if it is more than half a voxel beyond them.
+bool confine(double &x, long int N){
+    if( !std::isfinite(x)
+    ||  (x < -0.5)
+    ||  ((static_cast<double>(N) - 0.5) < x) ){
+        return false;
+    }
+    x = std::clamp(x, 0.0, static_cast<double>(N - 1));
+    return true;
+}
+
+// Reflects a voxel number about the volume boundaries (without repeating the boundary voxel).
+long int mirror(long int i, long int N){
+    if(N == 1) return 0;
+    const auto period = 2 * (N - 1);
+    i = std::abs(i) % period;
+    return (N <= i) ? period - i : i;
+}
+
+float sample_nearest(const source_volume &v, double r, double c, double s){
+    const auto row = static_cast<long int>(std::lround(r));
+    const auto col = static_cast<long int>(std::lround(c));
+    const auto slice = static_cast<long int>(std::lround(s));
+    return v.voxels[ v.index(row, col, slice) ];
+}
+
+float sample_trilinear(const source_volume &v, double r, double c, double s){
+    const auto split = [](double x, long int N, std::array<long int, 2> &i, std::array<double, 2> &w){
+        const auto i0 = std::min(static_cast<long int>(std::floor(x)), std::max(0L, N - 2L));
+        const auto t = x - static_cast<double>(i0);
+        i = {{ i0, std::min(i0 + 1L, N - 1L) }};
+        w = {{ 1.0 - t, t }};
+    };
+    std::array<long int, 2> ir, ic, is;
+    std::array<double, 2> wr, wc, ws;
+    split(r, v.N_rows, ir, wr);
+    split(c, v.N_cols, ic, wc);
+    split(s, v.N_slices, is, ws);
+
+    double sum = 0.0;
+    double weight = 0.0;
+    for(size_t k = 0; k < 2; ++k){
+        for(size_t j = 0; j < 2; ++j){
+            for(size_t l = 0; l < 2; ++l){
+                const auto w = ws[k] * wr[j] * wc[l];
+                if(w == 0.0) continue;
+                const auto val = v.voxels[ v.index(ir[j], ic[l], is[k]) ];
+                if(!std::isfinite(val)) continue;
+                sum += w * static_cast<double>(val);
+                weight += w;
+            }
+        }
+    }
+    return (weight < 1E-6) ? std::numeric_limits<float>::quiet_NaN()
+                           : static_cast<float>(sum / weight);
+}
+
+// Cubic B-spline basis weights for the four voxels surrounding a fractional voxel number.
+void bspline_weights(double x, long int N, std::array<long int, 4> &i, std::array<double, 4> &w){
+    const auto i0 = static_cast<long int>(std::floor(x));
+    const auto t = x - static_cast<double>(i0);
+    const auto t2 = t * t;
+    const auto t3 = t2 * t;
+    const auto u = 1.0 - t;
+    w = {{ u * u * u / 6.0,
+           (3.0 * t3 - 6.0 * t2 + 4.0) / 6.0,
+           (-3.0 * t3 + 3.0 * t2 + 3.0 * t + 1.0) / 6.0,
+           t3 / 6.0 }};
+    for(long int k = 0; k < 4; ++k) i[k] = mirror(i0 - 1L + k, N);
+}
+
+// Evaluates the B-spline using prefiltered coefficients. Falls back to trilinear interpolation (of the original
+// voxels) wherever the support overlaps non-finite voxels.
+float sample_bspline(const source_volume &coeffs, const source_volume &orig, double r, double c, double s){
+    std::array<long int, 4> ir, ic, is;
+    std::array<double, 4> wr, wc, ws;
+    bspline_weights(r, coeffs.N_rows, ir, wr);
+    bspline_weights(c, coeffs.N_cols, ic, wc);
+    bspline_weights(s, coeffs.N_slices, is, ws);
+
+    if(!coeffs.nonfinite.empty()){
+        for(const auto k : is){
+            for(const auto j : ir){
+                for(const auto l : ic){
+                    if(coeffs.nonfinite[ coeffs.index(j, l, k) ] != 0) return sample_trilinear(orig, r, c, s);
+                }
+            }
+        }
+    }
+
+    double sum = 0.0;
+    for(size_t k = 0; k < 4; ++k){
+        double sum_r = 0.0;
+        for(size_t j = 0; j < 4; ++j){
+            const float *line = &coeffs.voxels[ coeffs.index(ir[j], 0, is[k]) ];
+            const auto sum_c = wc[0] * line[ic[0]]
+                             + wc[1] * line[ic[1]]
+                             + wc[2] * line[ic[2]]
+                             + wc[3] * line[ic[3]];
+            sum_r += wr[j] * sum_c;
+        }
+        sum += ws[k] * sum_r;
+    }
+    return static_cast<float>(sum);
+}
+
+// Converts N_lanes interleaved lines of length N from intensities to cubic B-spline coefficients in place, assuming
+// mirror boundaries. Element n of lane l is located at data[n * stride + l].
+//
+// See M. Unser, IEEE Signal Processing Magazine 16 (1999) 22-38. Lanes are processed in lockstep so the innermost
+// loops run over contiguous memory.
+void bspline_prefilter_lanes(float *data, long int N, size_t stride, long int N_lanes, std::vector<double> &buf){
+    if(N < 2) return;
+    const auto L = static_cast<size_t>(N_lanes);
+    const auto z = std::sqrt(3.0) - 2.0;
+    const auto gain = (1.0 - z) * (1.0 - 1.0 / z);
+
+    buf.resize(static_cast<size_t>(N) * L);
+    for(long int n = 0; n < N; ++n){
+        const float *in = &data[static_cast<size_t>(n) * stride];
+        double *o = &buf[static_cast<size_t>(n) * L];
+        for(size_t l = 0; l < L; ++l) o[l] = gain * static_cast<double>(in[l]);
+    }
+
+    // Initial causal coefficient. The mirrored signal is summed until the contribution is negligible.
+    std::vector<double> init(L, 0.0);
+    const auto horizon = static_cast<long int>(std::ceil(std::log(1E-9) / std::log(std::abs(z))));
+    if(horizon < N){
+        double zn = 1.0;
+        for(long int n = 0; n < horizon; ++n){
+            const double *c = &buf[static_cast<size_t>(n) * L];
+            for(size_t l = 0; l < L; ++l) init[l] += zn * c[l];
+            zn *= z;
+        }
+    }else{
+        const auto iz = 1.0 / z;
+        double zn = z;
+        double z2n = std::pow(z, static_cast<double>(N - 1));
+        const double *c_first = &buf[0];
+        const double *c_last = &buf[static_cast<size_t>(N - 1) * L];
+        for(size_t l = 0; l < L; ++l) init[l] = c_first[l] + z2n * c_last[l];
+        z2n *= z2n * iz;
+        for(long int n = 1; n < (N - 1); ++n){
+            const double *c = &buf[static_cast<size_t>(n) * L];
+            for(size_t l = 0; l < L; ++l) init[l] += (zn + z2n) * c[l];
+            zn *= z;
+            z2n *= iz;
+        }
+        for(size_t l = 0; l < L; ++l) init[l] /= (1.0 - zn * zn);
+    }
+    std::copy(std::begin(init), std::end(init), &buf[0]);
+
+    // Causal pass.
+    for(long int n = 1; n < N; ++n){
+        double *c = &buf[static_cast<size_t>(n) * L];
+        const double *c_prev = c - L;
+        for(size_t l = 0; l < L; ++l) c[l] += z * c_prev[l];
+    }
+
+    // Anti-causal pass.
+    {
+        double *c_last = &buf[static_cast<size_t>(N - 1) * L];
+        const double *c_prev = c_last - L;
+        for(size_t l = 0; l < L; ++l) c_last[l] = (z / (z * z - 1.0)) * (z * c_prev[l] + c_last[l]);
+    }
+    for(long int n = N - 2; 0 <= n; --n){
+        double *c = &buf[static_cast<size_t>(n) * L];
+        const double *c_next = c + L;
+        for(size_t l = 0; l < L; ++l) c[l] = z * (c_next[l] - c[l]);
+    }
+
+    for(long int n = 0; n < N; ++n){
+        float *out = &data[static_cast<size_t>(n) * stride];
+        const double *c = &buf[static_cast<size_t>(n) * L];
+        for(size_t l = 0; l < L; ++l) out[l] = static_cast<float>(c[l]);
+    }
+    return;
+}
+
+// Converts the volume intensities to cubic B-spline coefficients, separably along each axis.
+//
+// Non-finite voxels are replaced with zeros before filtering; they are recorded so sampling can avoid them.
+void bspline_prefilter(source_volume &v){
+    for(auto &val : v.voxels){
+        if(!std::isfinite(val)){
+            if(v.nonfinite.empty()){
+                v.nonfinite.resize(v.voxels.size(), 0);
+            }
+            v.nonfinite[ static_cast<size_t>(std::distance(v.voxels.data(), &val)) ] = 1;
+            val = 0.0f;
+        }
+    }
+
+    const auto N_slice = v.N_rows * v.N_cols;
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < v.N_slices; ++k){
+            tp.submit_task([&,k]() -> void {
+                std::vector<double> buf;
+                float *slice = &v.voxels[ v.index(0, 0, k) ];
+
+                // Along columns, one row at a time.
+                for(long int r = 0; r < v.N_rows; ++r){
+                    bspline_prefilter_lanes(slice + r * v.N_cols, v.N_cols, 1, 1, buf);
+                }
+
+                // Along rows, with every column as a lane.
+                bspline_prefilter_lanes(slice, v.N_rows, static_cast<size_t>(v.N_cols), v.N_cols, buf);
+            }); // thread pool task closure.
+        }
+    } // Wait until all threads are done.
+
+    // Across slices, in blocks of (row, column) positions.
+    {
+        const long int block = 1024;
+        asio_thread_pool tp;
+        for(long int first = 0; first < N_slice; first += block){
+            tp.submit_task([&,first]() -> void {
+                std::vector<double> buf;
+                const auto lanes = std::min(block, N_slice - first);
+                bspline_prefilter_lanes(&v.voxels[static_cast<size_t>(first)], v.N_slices,
+                                        static_cast<size_t>(N_slice), lanes, buf);
+            }); // thread pool task closure.
+        }
+    } // Wait until all threads are done.
+    return;
+}
+
+} // namespace.
+
+
+bool ComputeResampleImages(planar_image_collection<float,double> &imagecoll,
+                      std::list<std::reference_wrapper<planar_image_collection<float,double>>> external_imgs,
+                      std::list<std::reference_wrapper<contour_collection<double>>> /*ccsl*/,
+                      std::any user_data ){
+
+    // This routine resamples a rectilinear source image array onto the geometry of the provided images, which can be
+    // arbitrarily positioned and oriented.
+    //
+    // Outgoing voxel positions are (optionally) transformed and then converted to fractional voxel numbers in the
+    // source image array. Since the conversion is linear (for affine transformations), fractional voxel numbers are
+    // computed incrementally along each outgoing row in a form that can be vectorized. Outgoing images are processed
+    // in parallel.
+    //
+    // Outgoing voxels within half a voxel of the source image array are sampled as if they were on the boundary, and
+    // voxels beyond are assigned the out-of-bounds value.
+
+    //We require a valid ComputeResampleImagesUserData struct packed into the user_data.
+    ComputeResampleImagesUserData *user_data_s;
+    try{
+        user_data_s = std::any_cast<ComputeResampleImagesUserData *>(user_data);
+    }catch(const std::exception &e){
+        FUNCWARN("Unable to cast user_data to appropriate format. Cannot continue with computation");
+        return false;
+    }
+
+    if(external_imgs.size() != 1){
+        FUNCWARN("A single source image array must be provided. Cannot continue with computation");
+        return false;
+    }
+    if(user_data_s->affine && user_data_s->warp){
+        throw std::invalid_argument("Only a single transformation can be provided.");
+    }
+
+    std::vector<std::reference_wrapper<planar_image<float,double>>> src_imgs;
+    std::list<std::reference_wrapper<planar_image<float,double>>> src_imgs_l;
+    for(auto &img : external_imgs.front().get().images){
+        src_imgs.push_back( std::ref(img) );
+        src_imgs_l.push_back( std::ref(img) );
+    }
+    if(src_imgs.empty()){
+        FUNCWARN("No source images provided. Cannot continue with computation");
+        return false;
+    }
+    if(!Images_Form_Rectilinear_Grid(src_imgs_l)){
+        FUNCWARN("Source images do not form a rectilinear grid. Cannot continue");
+        return false;
+    }
+
+    // Establish the source image array geometry.
+    const auto &src_first = src_imgs.front().get();
+    const auto row_unit = src_first.row_unit.unit();
+    const auto col_unit = src_first.col_unit.unit();
+    const auto ortho_unit = row_unit.Cross(col_unit).unit();
+    const auto pxl_dx = src_first.pxl_dx;
+    const auto pxl_dy = src_first.pxl_dy;
+
+    std::sort( std::begin(src_imgs), std::end(src_imgs),
+               [&](const auto &A, const auto &B){
+                   return ortho_unit.Dot(A.get().position(0, 0)) < ortho_unit.Dot(B.get().position(0, 0));
+               });
+    const auto origin = src_imgs.front().get().position(0, 0);
+
+    slice_map sm;
+    for(const auto &img_refw : src_imgs){
+        sm.s.push_back( ortho_unit.Dot(img_refw.get().position(0, 0) - origin) );
+    }
+    sm.half_thickness = 0.5 * src_first.pxl_dz;
+    if(1 < sm.s.size()){
+        sm.ds = (sm.s.back() - sm.s.front()) / static_cast<double>(sm.s.size() - 1);
+        for(size_t i = 1; i < sm.s.size(); ++i){
+            const auto ds = sm.s[i] - sm.s[i - 1];
+            if(ds < 1E-6){
+                throw std::invalid_argument("Source images overlap. Select a single image volume.");
+            }
+            if(1E-3 * sm.ds < std::abs(ds - sm.ds)) sm.regular = false;
+        }
+    }
+
+    const long int N_rows = src_first.rows;
+    const long int N_cols = src_first.columns;
+    const auto N_slices = static_cast<long int>(src_imgs.size());
+    const long int N_src_chnls = src_first.channels;
+
+    // Determine which source channel populates each outgoing channel.
+    std::vector<long int> chnls;
+    if(user_data_s->channel < 0){
+        for(long int c = 0; c < N_src_chnls; ++c) chnls.push_back(c);
+    }else if(user_data_s->channel < N_src_chnls){
+        chnls.push_back(user_data_s->channel);
+    }else{
+        throw std::invalid_argument("Selected channel is not present in the source images.");
+    }
+    for(const auto &img : imagecoll.images){
+        if(img.channels != static_cast<long int>(chnls.size())){
+            throw std::invalid_argument("Outgoing images have an unexpected number of channels.");
+        }
+    }
+
+    // Gather the source voxels into contiguous volumes, one per channel.
+    std::vector<source_volume> volumes;
+    for(const auto chnl : chnls){
+        volumes.emplace_back();
+        auto &v = volumes.back();
+        v.N_rows = N_rows;
+        v.N_cols = N_cols;
+        v.N_slices = N_slices;
+        v.voxels.resize(static_cast<size_t>(N_rows * N_cols * N_slices));
+        for(long int k = 0; k < N_slices; ++k){
+            const auto &img = src_imgs[k].get();
+            for(long int r = 0; r < N_rows; ++r){
+                for(long int c = 0; c < N_cols; ++c){
+                    v.voxels[ v.index(r, c, k) ] = img.value(r, c, chnl);
+                }
+            }
+        }
+    }
+    std::vector<source_volume> coefficients;
+    if(user_data_s->kernel == ComputeResampleImagesUserData::Kernel::CubicBSpline){
+        coefficients = volumes;
+        for(auto &v : coefficients) bspline_prefilter(v);
+    }
+
+    // Resample each outgoing image.
+    std::exception_ptr error;
+    {
+        asio_thread_pool tp;
+        std::mutex saver_printer; // Who gets to record errors, print to the console, and iterate the counter.
+        long int completed = 0;
+        const long int img_count = imagecoll.images.size();
+
+        for(auto &img : imagecoll.images){
+            std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
+
+            tp.submit_task([&,img_refw]() -> void {
+                try{
+                    auto &out = img_refw.get();
+                    const auto N_out_rows = out.rows;
+                    const auto N_out_cols = out.columns;
+                    const auto step_row = out.row_unit * out.pxl_dx;
+                    const auto step_col = out.col_unit * out.pxl_dy;
+
+                    // Position of the first voxel and the displacements between adjacent voxels, after transformation.
+                    auto p_00 = out.position(0, 0);
+                    auto p_10 = p_00 + step_row;
+                    auto p_01 = p_00 + step_col;
+                    if(user_data_s->affine){
+                        auto t = user_data_s->affine.value();
+                        t.apply_to(p_00);
+                        t.apply_to(p_10);
+                        t.apply_to(p_01);
+                    }
+                    const auto dp_row = p_10 - p_00;
+                    const auto dp_col = p_01 - p_00;
+
+                    std::vector<double> fr(N_out_cols);
+                    std::vector<double> fc(N_out_cols);
+                    std::vector<double> fs(N_out_cols);
+
+                    for(long int row = 0; row < N_out_rows; ++row){
+
+                        // Compute the fractional source voxel numbers for the whole row.
+                        if(user_data_s->warp){
+                            const auto p_row = out.position(row, 0);
+                            for(long int col = 0; col < N_out_cols; ++col){
+                                const auto d = user_data_s->warp(p_row + step_col * static_cast<double>(col)) - origin;
+                                fr[col] = row_unit.Dot(d) / pxl_dx;
+                                fc[col] = col_unit.Dot(d) / pxl_dy;
+                                fs[col] = ortho_unit.Dot(d);
+                            }
+                        }else{
+                            const auto d = (p_00 + dp_row * static_cast<double>(row)) - origin;
+                            const auto fr_0 = row_unit.Dot(d) / pxl_dx;
+                            const auto fc_0 = col_unit.Dot(d) / pxl_dy;
+                            const auto fs_0 = ortho_unit.Dot(d);
+                            const auto dfr = row_unit.Dot(dp_col) / pxl_dx;
+                            const auto dfc = col_unit.Dot(dp_col) / pxl_dy;
+                            const auto dfs = ortho_unit.Dot(dp_col);
+                            for(long int col = 0; col < N_out_cols; ++col){
+                                const auto x = static_cast<double>(col);
+                                fr[col] = fr_0 + dfr * x;
+                                fc[col] = fc_0 + dfc * x;
+                                fs[col] = fs_0 + dfs * x;
+                            }
+                        }
+
+                        for(long int col = 0; col < N_out_cols; ++col){
+                            auto r = fr[col];
+                            auto c = fc[col];
+                            double s = 0.0;
+                            const bool in_bounds = confine(r, N_rows)
+                                                && confine(c, N_cols)
+                                                && sm.to_index(fs[col], s);
+
+                            for(size_t i = 0; i < chnls.size(); ++i){
+                                auto val = user_data_s->out_of_bounds_value;
+                                if(in_bounds){
+                                    if(user_data_s->kernel == ComputeResampleImagesUserData::Kernel::Nearest){
+                                        val = sample_nearest(volumes[i], r, c, s);
+                                    }else if(user_data_s->kernel == ComputeResampleImagesUserData::Kernel::Trilinear){
+                                        val = sample_trilinear(volumes[i], r, c, s);
+                                    }else if(user_data_s->kernel == ComputeResampleImagesUserData::Kernel::CubicBSpline){
+                                        val = sample_bspline(coefficients[i], volumes[i], r, c, s);
+                                    }else{
+                                        throw std::invalid_argument("Unrecognized kernel.");
+                                    }
+                                }
+                                out.reference(row, col, static_cast<long int>(i)) = val;
+                            }
+                        }
+                    }
+
+                    UpdateImageDescription( img_refw, user_data_s->description );
+                    UpdateImageWindowCentreWidth( img_refw );
+
+                }catch(const std::exception &){
+                    std::lock_guard<std::mutex> lock(saver_printer);
+                    if(!error) error = std::current_exception();
+                    return;
+                }
+
+                //Report operation progress.
+                {
+                    std::lock_guard<std::mutex> lock(saver_printer);
+                    ++completed;
+                    FUNCINFO("Completed " << completed << " of " << img_count
+                          << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait until all threads are done.
+    if(error) std::rethrow_exception(error);
+
+    return true;
+}
+
@@ -0,0 +1,64 @@
+//Resample_Images.h.
+#pragma once
+
+#include <any>
+#include <functional>
+#include <limits>
+#include <list>
+#include <optional>
+#include <string>
+
+#include "YgorMath.h"
+
+
+template <class T, class R> class planar_image_collection;
+template <class T> class contour_collection;
+
+struct ComputeResampleImagesUserData {
+
+    // -----------------------------
+    // The interpolation kernel to use.
+    enum class
+    Kernel {
+        Nearest,       // Nearest-neighbour. Voxel values are copied without alteration.
+        Trilinear,     // Trilinear interpolation. Non-finite voxels are ignored and the remaining weights renormalized.
+        CubicBSpline,  // Cubic B-spline interpolation. Smooth, but may overshoot near sharp edges.
+    } kernel = Kernel::Trilinear;
+
+
+    // -----------------------------
+    // The channel to resample. If negative, all channels are resampled.
+    //
+    // Note: Outgoing images must have a single channel if a specific channel is selected, or the same number of
+    // channels as the source images otherwise.
+    long int channel = -1;
+
+
+    // -----------------------------
+    // The value assigned to outgoing voxels that do not overlap the source images.
+    float out_of_bounds_value = std::numeric_limits<float>::quiet_NaN();
+
+
+    // -----------------------------
+    // An optional transformation mapping outgoing voxel positions to the positions at which source images are sampled.
+    //
+    // An affine transformation is exploited to step along rows incrementally. A general transformation (e.g., a
+    // deformable registration) is evaluated for every voxel and must be thread-safe. At most one should be provided.
+    std::optional<affine_transform<double>> affine;
+    std::function<vec3<double>(const vec3<double> &)> warp;
+
+
+    // -----------------------------
+    // The description to imbue images with.
+    std::string description;
+
+};
+
+// Resamples a single source image array (passed in as the only external image collection) onto the geometry of the
+// provided images, which are overwritten. The source images must form a rectilinear grid, but the outgoing images can
+// have any geometry.
+bool ComputeResampleImages(planar_image_collection<float,double> &,
+                          std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
+                          std::list<std::reference_wrapper<contour_collection<double>>>,
+                          std::any ud );
+
@@ -2,6 +2,8 @@
 
 #include <exception>
 #include <any>
+#include <array>
+#include <cmath>
 #include <optional>
 #include <functional>
 #include <list>
@@ -18,6 +20,7 @@
 
 #include "YgorClustering.hpp"
 #include "../../Thread_Pool.h"
+#include "../../Rectilinear_Convolution.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
 #include "Volumetric_Neighbourhood_Sampler.h"
@@ -37,6 +40,11 @@ bool ComputeVolumetricSpatialBlur(planar_image_collection<float,double> &imageco
     // 7x7x7 voxels. If voxels are inaccessible or non-finite they will be ignored and other voxels in the neighbourhood
     // will be more heavily weighted.
     //
+    // The 'open' Gaussian accepts an arbitrary sigma in DICOM units along each direction. It is evaluated using a
+    // recursive filter over the whole image array, so the cost does not depend on sigma. Non-finite voxels and voxels
+    // beyond the image array are ignored in the same way. Only voxels bounded by the contours are altered, but voxels
+    // outside the contours contribute to the blur.
+    //
     // Note: The provided image collection must be rectilinear. This requirement comes foremost from a limitation of the
     // implementation. 
     //
@@ -168,6 +176,95 @@ bool ComputeVolumetricSpatialBlur(planar_image_collection<float,double> &imageco
             }
         }
 
+    }else if(user_data_s->estimator == VolumetricSpatialBlurEstimator::Gaussian_Open){
+        std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+        for(auto &img : imagecoll.images){
+            selected_imgs.push_back( std::ref(img) );
+        }
+        if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+            FUNCWARN("Images do not form a rectilinear grid. Cannot continue");
+            return false;
+        }
+
+        const auto orientation_normal = Average_Contour_Normals(ccsl);
+        planar_image_adjacency<float,double> adj( {}, { { std::ref(imagecoll) } }, orientation_normal );
+        if(adj.int_to_img.empty()){
+            return true;
+        }
+        const auto first_refw = adj.index_to_image(0L);
+        const long int N_rows = first_refw.get().rows;
+        const long int N_columns = first_refw.get().columns;
+        const long int N_channels = first_refw.get().channels;
+        const auto N_imgs = static_cast<long int>(adj.int_to_img.size());
+
+        // Convert sigma to voxel units. Images need not be abutting, so the slice spacing is estimated from the image
+        // positions along the normal.
+        auto slice_spacing = first_refw.get().pxl_dz;
+        if(1 < N_imgs){
+            const auto last_refw = adj.index_to_image(N_imgs - 1L);
+            const auto dist = std::abs( orientation_normal.Dot( last_refw.get().center() - first_refw.get().center() ) );
+            slice_spacing = dist / static_cast<double>(N_imgs - 1L);
+            if(!Images_Form_Regular_Grid(selected_imgs)){
+                FUNCWARN("Images are not regularly spaced; using the average slice spacing");
+            }
+        }
+        const std::array<double, 3> spacing = {{ first_refw.get().pxl_dx,
+                                                 first_refw.get().pxl_dy,
+                                                 slice_spacing }};
+        std::array<double, 3> sigma;
+        for(size_t a = 0; a < 3; ++a){
+            const bool degenerate = (a == 2) && (N_imgs <= 1); // No blurring is possible across a single image.
+            sigma[a] = ( degenerate || (user_data_s->gaussian_sigma[a] == 0.0) ) ? 0.0
+                                                                                 : user_data_s->gaussian_sigma[a] / spacing[a];
+            if( !std::isfinite(sigma[a]) || (sigma[a] < 0.0) ){
+                throw std::invalid_argument("Gaussian sigma is not valid for this image array.");
+            }
+        }
+        FUNCINFO("Using Gaussian sigma of " << sigma[0] << ", " << sigma[1] << ", " << sigma[2] << " voxels");
+
+        std::map<long int, dense_volume> outgoing;
+        for(long int chnl = 0; chnl < N_channels; ++chnl){
+            if( (0 <= user_data_s->channel) && (chnl != user_data_s->channel) ) continue;
+
+            dense_volume vol(N_rows, N_columns, N_imgs);
+            for(long int i = 0; i < N_imgs; ++i){
+                const auto l_img_refw = adj.index_to_image(i);
+                for(long int r = 0; r < N_rows; ++r){
+                    for(long int c = 0; c < N_columns; ++c){
+                        vol.at(r, c, i) = l_img_refw.get().value(r, c, chnl);
+                    }
+                }
+            }
+            outgoing[chnl] = Gaussian_Filter(vol, sigma);
+        }
+
+        // Update the voxels bounded by the ROIs.
+        Mutate_Voxels_Opts mv_opts;
+        mv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
+        mv_opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
+        mv_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+        mv_opts.aggregate      = Mutate_Voxels_Opts::Aggregate::First;
+        mv_opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+        mv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
+
+        for(auto &img : imagecoll.images){
+            std::reference_wrapper< planar_image<float, double>> img_refw( std::ref(img) );
+            const auto img_num = adj.image_to_index( img_refw );
+
+            auto f_bounded = [&](long int E_row, long int E_col, long int channel, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
+                auto o_it = outgoing.find(channel);
+                if(o_it == std::end(outgoing)) return;
+                voxel_val = static_cast<float>( o_it->second.at(E_row, E_col, img_num) );
+                return;
+            };
+
+            Mutate_Voxels<float,double>( img_refw,
+                                         { img_refw },
+                                         ccsl,
+                                         mv_opts,
+                                         f_bounded );
+        }
+
     }else{
         throw std::invalid_argument("Unrecognized user-provided estimator argument.");
     }
@@ -177,13 +274,19 @@ bool ComputeVolumetricSpatialBlur(planar_image_collection<float,double> &imageco
     std::string img_desc;
     if(user_data_s->estimator == VolumetricSpatialBlurEstimator::Gaussian){
         img_desc += "volumetric Gaussian blurred";
+        img_desc += " (in pixel coord.s)";
+
+    }else if(user_data_s->estimator == VolumetricSpatialBlurEstimator::Gaussian_Open){
+        img_desc += "volumetric Gaussian blurred (open; sigma=";
+        img_desc += std::to_string(user_data_s->gaussian_sigma[0]) + ",";
+        img_desc += std::to_string(user_data_s->gaussian_sigma[1]) + ",";
+        img_desc += std::to_string(user_data_s->gaussian_sigma[2]) + ")";
+        img_desc += " (in DICOM coord.s)";
 
     }else{
         throw std::invalid_argument("Unrecognized user-provided estimator");
     }
 
-    img_desc += " (in pixel coord.s)";
-
     for(auto &img : imagecoll.images){
         UpdateImageDescription( std::ref(img), img_desc );
         UpdateImageWindowCentreWidth( std::ref(img) );
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <any>
+#include <array>
 #include <functional>
 #include <list>
 
@@ -11,7 +12,8 @@ template <class T> class contour_collection;
 
 typedef enum { // Controls which blur is computed.
 
-    Gaussian // Numerically-approximated Gaussian with fixed (3-sigma) extent.
+    Gaussian,     // Numerically-approximated Gaussian with fixed (3-sigma) extent.
+    Gaussian_Open // Recursive Gaussian with arbitrary (possibly anisotropic) sigma in DICOM units.
 
 } VolumetricSpatialBlurEstimator;
 
@@ -22,6 +24,10 @@ struct ComputeVolumetricSpatialBlurUserData {
     // The channel to analyze. If negative, all channels are analyzed.
     long int channel = -1;
 
+    // The Gaussian sigma (in DICOM units, i.e., mm) along the row, column, and image-normal directions. Only used by
+    // the Gaussian_Open estimator. A zero sigma disables blurring along that direction.
+    std::array<double, 3> gaussian_sigma = {{ 1.0, 1.0, 1.0 }};
+
 };
 
 bool ComputeVolumetricSpatialBlur(planar_image_collection<float,double> &,
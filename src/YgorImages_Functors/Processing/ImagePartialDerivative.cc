@@ -6,8 +6,10 @@
 #include <list>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "../ConvenienceRoutines.h"
+#include "../../Rectilinear_Convolution.h"
 #include "ImagePartialDerivative.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
@@ -53,6 +55,42 @@ bool ImagePartialDerivative(
     Stats::Running_MinMax<float> minmax_pixel;
     const auto pi = std::acos(-1.0);
 
+    //The derivative-of-Gaussian estimator blurs and differentiates whole images at once, so the derivatives are
+    // computed up-front. Note that 'row-aligned' derivatives vary along a row (i.e., with the column number).
+    std::vector<dense_volume> gauss_ra; // One per channel.
+    std::vector<dense_volume> gauss_ca;
+    std::vector<dense_volume> gauss_cross;
+    if(user_data_s->order == PartialDerivativeEstimator::gaussian){
+        const auto sigma = user_data_s->gaussian_sigma;
+        if( !std::isfinite(sigma) || (sigma <= 0.0) ){
+            throw std::invalid_argument("Gaussian sigma must be positive.");
+        }
+        const bool need_ra = (user_data_s->method == PartialDerivativeMethod::row_aligned)
+                          || (user_data_s->method == PartialDerivativeMethod::magnitude)
+                          || (user_data_s->method == PartialDerivativeMethod::orientation)
+                          || (user_data_s->method == PartialDerivativeMethod::non_maximum_suppression);
+        const bool need_ca = (user_data_s->method == PartialDerivativeMethod::column_aligned)
+                          || (user_data_s->method == PartialDerivativeMethod::magnitude)
+                          || (user_data_s->method == PartialDerivativeMethod::orientation)
+                          || (user_data_s->method == PartialDerivativeMethod::non_maximum_suppression);
+        const bool need_cross = (user_data_s->method == PartialDerivativeMethod::cross);
+        if(!need_ra && !need_ca && !need_cross){
+            throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
+        }
+
+        for(auto chan = 0; chan < first_img_it->channels; ++chan){
+            dense_volume vol(first_img_it->rows, first_img_it->columns, 1);
+            for(auto row = 0; row < first_img_it->rows; ++row){
+                for(auto col = 0; col < first_img_it->columns; ++col){
+                    vol.at(row, col, 0) = static_cast<double>(first_img_it->value(row, col, chan));
+                }
+            }
+            gauss_ra.emplace_back( need_ra ? Gaussian_Filter(vol, {{ sigma, sigma, 0.0 }}, {{ 0L, 1L, 0L }}) : dense_volume() );
+            gauss_ca.emplace_back( need_ca ? Gaussian_Filter(vol, {{ sigma, sigma, 0.0 }}, {{ 1L, 0L, 0L }}) : dense_volume() );
+            gauss_cross.emplace_back( need_cross ? Gaussian_Filter(vol, {{ sigma, sigma, 0.0 }}, {{ 1L, 1L, 0L }}) : dense_volume() );
+        }
+    }
+
     //Loop over the rows, columns, and channels.
     for(auto row = 0; row < working.rows; ++row){
         for(auto col = 0; col < working.columns; ++col){
@@ -281,6 +319,36 @@ bool ImagePartialDerivative(
                     }else{
                         throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
                     }
+                }else if(user_data_s->order == PartialDerivativeEstimator::gaussian){
+                    if(user_data_s->method == PartialDerivativeMethod::row_aligned){
+                        newval = static_cast<float>( gauss_ra[chan].at(row, col, 0) );
+
+                    }else if(user_data_s->method == PartialDerivativeMethod::column_aligned){
+                        newval = static_cast<float>( gauss_ca[chan].at(row, col, 0) );
+
+                    }else if(user_data_s->method == PartialDerivativeMethod::cross){
+                        newval = static_cast<float>( gauss_cross[chan].at(row, col, 0) );
+
+                    }else if(user_data_s->method == PartialDerivativeMethod::magnitude){
+                        const auto ra = gauss_ra[chan].at(row, col, 0);
+                        const auto ca = gauss_ca[chan].at(row, col, 0);
+                        newval = std::hypot(ra,ca);
+
+                    }else if(user_data_s->method == PartialDerivativeMethod::orientation){
+                        const auto ra = gauss_ra[chan].at(row, col, 0);
+                        const auto ca = gauss_ca[chan].at(row, col, 0);
+                        newval = std::atan2(ca,ra) + pi;
+
+                    }else if(user_data_s->method == PartialDerivativeMethod::non_maximum_suppression){
+                        const auto ra = gauss_ra[chan].at(row, col, 0);
+                        const auto ca = gauss_ca[chan].at(row, col, 0);
+                        newval = std::hypot(ra,ca); // magnitude.
+                        nms_newval = std::atan2(ca,ra) + pi; // orientation.
+
+                    }else{
+                        throw std::invalid_argument("Selected method not applicable to selected order or estimator.");
+                    }
+
                 }else{
                     throw std::invalid_argument("Unrecognized user-provided derivative order.");
                 }
@@ -381,6 +449,9 @@ bool ImagePartialDerivative(
     }else if(user_data_s->order == PartialDerivativeEstimator::second){
         img_desc += "Second-order partial deriv.,";
 
+    }else if(user_data_s->order == PartialDerivativeEstimator::gaussian){
+        img_desc += "Deriv. of Gaussian (sigma=" + std::to_string(user_data_s->gaussian_sigma) + "),";
+
     }else{
         throw std::invalid_argument("Unrecognized user-provided derivative order.");
     }
@@ -27,7 +27,10 @@ typedef enum { // Controls which image derivatives are computed.
     Scharr_5x5,  //Approximately rotationally-symmetric.
 
     // Centered second-order finite-difference derivatives.
-    second
+    second,
+
+    // Derivative-of-Gaussian with adjustable sigma. Suitable for noisy images.
+    gaussian
 
 } PartialDerivativeEstimator;
 
@@ -53,6 +56,9 @@ struct ImagePartialDerivativeUserData {
     PartialDerivativeEstimator order = PartialDerivativeEstimator::Scharr_3x3;
     PartialDerivativeMethod method = PartialDerivativeMethod::magnitude;
 
+    // Parameters for the derivative-of-Gaussian estimator.
+    double gaussian_sigma = 1.0; // sigma in pixel coordinates.
+
 };
 
 
@@ -1,4 +1,6 @@
 
+#include <array>
+#include <cmath>
 #include <exception>
 #include <functional>
 #include <limits>
@@ -7,6 +9,7 @@
 #include <string>
 
 #include "../ConvenienceRoutines.h"
+#include "../../Rectilinear_Convolution.h"
 #include "In_Image_Plane_Blur.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
@@ -39,18 +42,36 @@ bool InPlaneImageBlur(
     //Record the min and max actual pixel values for windowing purposes.
     Stats::Running_MinMax<float> minmax_pixel;
 
-    //There is a dedicated function for non-fixed ("open") Gaussian blur.
+    //Non-fixed ("open") Gaussian blur uses a recursive filter, so the cost does not depend on sigma.
     if(user_data_s->estimator == BlurEstimator::gaussian_open){
-        working.Gaussian_Pixel_Blur({ }, user_data_s->gaussian_sigma);
-
-        //Loop over the rows, columns, and channels.
-        for(auto row = 0; row < working.rows; ++row){
-            for(auto col = 0; col < working.columns; ++col){
-                for(auto chan = 0; chan < working.channels; ++chan){
-                    minmax_pixel.Digest( working.value(row, col, chan) );
-                }//Loop over channels.
-            } //Loop over cols
-        } //Loop over rows
+        auto sigma_r = user_data_s->gaussian_sigma;
+        auto sigma_c = user_data_s->gaussian_sigma;
+        if(user_data_s->gaussian_sigma_in_dicom_units){
+            sigma_r /= working.pxl_dx;
+            sigma_c /= working.pxl_dy;
+        }
+        if( !std::isfinite(sigma_r) || !std::isfinite(sigma_c) || (sigma_r < 0.0) || (sigma_c < 0.0) ){
+            throw std::invalid_argument("Gaussian sigma is not valid for this image.");
+        }
+
+        for(auto chan = 0; chan < working.channels; ++chan){
+            dense_volume vol(working.rows, working.columns, 1);
+            for(auto row = 0; row < working.rows; ++row){
+                for(auto col = 0; col < working.columns; ++col){
+                    vol.at(row, col, 0) = static_cast<double>(working.value(row, col, chan));
+                }
+            }
+
+            const auto blurred = Gaussian_Filter(vol, {{ sigma_r, sigma_c, 0.0 }});
+
+            for(auto row = 0; row < working.rows; ++row){
+                for(auto col = 0; col < working.columns; ++col){
+                    const auto newval = static_cast<float>(blurred.at(row, col, 0));
+                    working.reference(row, col, chan) = newval;
+                    minmax_pixel.Digest(newval);
+                }
+            }
+        }//Loop over channels.
 
     }else{
         //Loop over the rows, columns, and channels.
@@ -108,7 +129,12 @@ bool InPlaneImageBlur(
     }else{
         throw std::invalid_argument("Unrecognized user-provided blur estimator.");
     }
-    img_desc += " (in pixel coord.s)";
+    if( (user_data_s->estimator == BlurEstimator::gaussian_open)
+    &&  user_data_s->gaussian_sigma_in_dicom_units ){
+        img_desc += " (in DICOM coord.s)";
+    }else{
+        img_desc += " (in pixel coord.s)";
+    }
 
     UpdateImageDescription( std::ref(*first_img_it), img_desc );
     UpdateImageWindowCentreWidth( std::ref(*first_img_it), minmax_pixel );
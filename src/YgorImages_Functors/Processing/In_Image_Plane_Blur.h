@@ -30,7 +30,11 @@ struct InPlaneImageBlurUserData {
     BlurEstimator estimator = BlurEstimator::gaussian_open;
 
     //Parameters for non-fixed estimators.
-    double gaussian_sigma = 1.5; // sigma in pixel coordinates.
+    double gaussian_sigma = 1.5; // sigma in pixel coordinates, or DICOM units if requested below.
+
+    // Whether gaussian_sigma is specified in DICOM units (i.e., mm). If so, the sigma in pixel coordinates is computed
+    // separately along rows and columns, which accommodates non-square pixels.
+    bool gaussian_sigma_in_dicom_units = false;
 
 };
 
@@ -5,7 +5,10 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/iterator/iterator_traits.hpp>
 #include <cstddef>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <exception>
 #include <any>
 #include <optional>
@@ -21,12 +24,15 @@
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "../../Common_Boost_Serialization.h"
 #include "../../Common_Plotting.h"
 #include "../../KineticModel_1Compartment2Input_5Param_Chebyshev_Common.h"
 #include "../../KineticModel_1Compartment2Input_5Param_Chebyshev_LevenbergMarquardt.h"
+#include "../../Thread_Pool.h"
 #include "../ConvenienceRoutines.h"
 #include "Liver_Kinetic_1Compartment2Input_5Param_Chebyshev_Common.h"
 #include "Liver_Kinetic_1Compartment2Input_5Param_Chebyshev_LevenbergMarquardt.h"
@@ -39,6 +45,18 @@
 
 static std::mutex out_img_mutex;
 
+//Invocations may themselves be run concurrently (e.g., one per image), so the available cores are divided among the
+// concurrent invocations to avoid oversubscription.
+static std::atomic<long int> concurrent_invocations(0);
+
+//Registers an invocation for the lifetime of the guard, including when an exception is thrown.
+struct concurrent_invocation_guard {
+    const long int count; // The number of concurrent invocations, including this one.
+
+    concurrent_invocation_guard() : count(++concurrent_invocations) {}
+    ~concurrent_invocation_guard(){ --concurrent_invocations; }
+};
+
 bool
 KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collection<float,double>::images_list_it_t first_img_it,
                         std::list<planar_image_collection<float,double>::images_list_it_t> selected_img_its,
@@ -182,10 +200,18 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
     Stats::Running_MinMax<float> minmax_k2;
 
 
-    //Perform a loop with no payload to determine how many optimizations will be needed.
+    //Identify the voxels that need to be fitted, and prepare the contours for fast is-point-within-the-polygon checks.
+    // Each voxel is fitted once, even if it is enclosed by several contours.
     //
     // NOTE: We expect optimization to take far longer than cycling through the contours and images.
-    double Expected_Operation_Count = 0.0;
+    struct prepared_contour {
+        plane<double> BestFitPlane;
+        contour_of_points<double> ProjectedContour;
+    };
+    std::vector<prepared_contour> prepared_contours;
+    std::map<long int, std::map<long int, size_t>> voxels_to_fit; // row -> column -> index of first enclosing contour.
+    const bool AlreadyProjected = true;
+
     for(auto &ccs : cc_ROIs){
         for(auto & contour : ccs.get().contours){
             if(contour.points.empty()) continue;
@@ -196,128 +222,108 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
                 FUNCWARN("Missing necessary tags for reporting analysis results. Cannot continue");
                 return false;
             }
-            
-    /*
-            //Construct a bounding box to reduce computational demand of checking every voxel.
-            auto BBox = roi_it->Bounding_Box_Along(row_unit, 1.0);
-            auto BBoxBestFitPlane = BBox.Least_Squares_Best_Fit_Plane(vec3<double>(0.0,0.0,1.0));
-            auto BBoxProjectedContour = BBox.Project_Onto_Plane_Orthogonally(BBoxBestFitPlane);
-            const bool BBoxAlreadyProjected = true;
-    */
     
             //Prepare a contour for fast is-point-within-the-polygon checking.
             auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
             auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-            const bool AlreadyProjected = true;
+            prepared_contours.push_back( { BestFitPlane, ProjectedContour } );
+            const auto contour_index = prepared_contours.size() - 1;
     
             for(auto row = 0; row < first_img_it->rows; ++row){
                 for(auto col = 0; col < first_img_it->columns; ++col){
                     //Figure out the spatial location of the present voxel.
                     const auto point = first_img_it->position(row,col);
     
-    /*
-                    //Check if within the bounding box. It will generally be cheaper than the full contour (4 points vs. ? points).
-                    auto BBoxProjectedPoint = BBoxBestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                    if(!BBoxProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BBoxBestFitPlane,
-                                                                                        BBoxProjectedPoint,
-                                                                                        BBoxAlreadyProjected)) continue;
-    */
-    
                     //Perform a more detailed check to see if we are in the ROI.
                     auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
                     if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
                                                                                    ProjectedPoint,
                                                                                    AlreadyProjected)){
-                        for(auto chan = 0; chan < first_img_it->channels; ++chan){
-   
-                            Expected_Operation_Count += 1.0;
-                        }//Loop over channels.
-    
-                    //If we're in the bounding box but not the ROI, do something.
-                    }else{
-                        //for(auto chan = 0; chan < first_img_it->channels; ++chan){
-                        //    const auto curr_val = working.value(row, col, chan);
-                        //    if(curr_val != 0) FUNCERR("There are overlapping ROI bboxes. This code currently cannot handle this. "
-                        //                              "You will need to run the functor individually on the overlapping ROIs.");
-                        //    working.reference(row, col, chan) = static_cast<float>(10);
-                        //}
-                    } // If is in ROI or ROI bbox.
+                        voxels_to_fit[row].emplace(col, contour_index);
+                    }
                 } //Loop over cols
             } //Loop over rows
         } //Loop over ROIs.
     } //Loop over contour_collections.
 
+    double Expected_Operation_Count = 0.0;
+    for(const auto &row_voxels : voxels_to_fit){
+        Expected_Operation_Count += static_cast<double>(row_voxels.second.size() * first_img_it->channels);
+    }
+
+
+    //Time metadata is needed for every image. It is verified up front because exceptions cannot escape the workers.
+    std::vector<double> img_dts;
+    img_dts.reserve(selected_img_its.size());
+    for(const auto &img_it : selected_img_its){
+        const auto dt = img_it->GetMetadataValueAs<double>("dt");
+        if(!dt) throw std::invalid_argument("Image is missing time metadata. Cannot continue.");
+        img_dts.push_back(dt.value());
+    }
 
 
-    //Loop over the cc_ROIs, rois, rows, columns, channels, and finally any selected images (if applicable).
-    //for(const auto &roi : rois){
+    //Fit the voxels. Rows are fitted concurrently.
+    //
+    // Within a row, voxels are fitted in order and each fit is warm-started from the converged parameters of the
+    // adjacent (previously fitted) voxel, if that fit succeeded. Neighbouring voxels tend to have similar kinetics, so
+    // this considerably reduces the number of iterations needed. Each task keeps its own model state and time course
+    // buffer, which are reused for every voxel in the row. The Chebyshev AIF and VIF approximations are shared
+    // read-only among all fits.
+    std::mutex shared_mutex; // Guards the counters, windowing statistics, console, plotting, and errors.
+    std::exception_ptr error;
     boost::posix_time::ptime start_t = boost::posix_time::microsec_clock::local_time();
     double Actual_Operation_Count = 0.0;
-    for(auto &ccs : cc_ROIs){
-        for(auto & contour : ccs.get().contours){
-            if(contour.points.empty()) continue;
-            //if(first_img_it->encompasses_contour_of_points(*it)) rois.push_back(it);
-
-            //auto roi = *it;
-            if(! first_img_it->encompasses_contour_of_points(contour)) continue;
+    {
+        const concurrent_invocation_guard invocation;
+        const auto hw_threads = std::max<long int>(1, static_cast<long int>(std::thread::hardware_concurrency()));
+        const auto l_threads = std::max<long int>(1, hw_threads / invocation.count);
+
+        asio_thread_pool tp(static_cast<size_t>(l_threads));
+        for(const auto &row_voxels : voxels_to_fit){
+            const auto *row_voxels_ptr = &row_voxels;
+            tp.submit_task([&,row_voxels_ptr]() -> void {
+                try{
+                    const auto row = row_voxels_ptr->first;
+
+                    auto l_model_state = model_state;
+                    auto channel_time_course = std::make_shared<samples_1D<double>>();
+
+                    //The converged parameters of the previous voxel in this row, for each channel.
+                    long int prev_col = -2;
+                    std::vector<std::optional<KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters>> prev_fits(first_img_it->channels);
+
+                    for(const auto &col_contour : row_voxels_ptr->second){
+                        const auto col = col_contour.first;
+                        const auto &pc = prepared_contours[col_contour.second];
+                        const bool is_adjacent = (col == (prev_col + 1));
+                        prev_col = col;
 
-            const auto ROIName =  contour.GetMetadataValueAs<std::string>("ROIName");
-            if(!ROIName){
-                FUNCWARN("Missing necessary tags for reporting analysis results. Cannot continue");
-                return false;
-            }
- 
-    /*
-            //Construct a bounding box to reduce computational demand of checking every voxel.
-            auto BBox = roi_it->Bounding_Box_Along(row_unit, 1.0);
-            auto BBoxBestFitPlane = BBox.Least_Squares_Best_Fit_Plane(vec3<double>(0.0,0.0,1.0));
-            auto BBoxProjectedContour = BBox.Project_Onto_Plane_Orthogonally(BBoxBestFitPlane);
-            const bool BBoxAlreadyProjected = true;
-    */
-    
-            //Prepare a contour for fast is-point-within-the-polygon checking.
-            auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-            auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-            const bool AlreadyProjected = true;
-    
-            for(auto row = 0; row < first_img_it->rows; ++row){
-                for(auto col = 0; col < first_img_it->columns; ++col){
-                    //Figure out the spatial location of the present voxel.
-                    const auto point = first_img_it->position(row,col);
-    
-    /*
-                    //Check if within the bounding box. It will generally be cheaper than the full contour (4 points vs. ? points).
-                    auto BBoxProjectedPoint = BBoxBestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                    if(!BBoxProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BBoxBestFitPlane,
-                                                                                        BBoxProjectedPoint,
-                                                                                        BBoxAlreadyProjected)) continue;
-    */
-    
-                    //Perform a more detailed check to see if we are in the ROI.
-                    auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                    if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                   ProjectedPoint,
-                                                                                   AlreadyProjected)){
                         for(auto chan = 0; chan < first_img_it->channels; ++chan){
+                            auto &prev_fit = prev_fits[chan];
+                            if(!is_adjacent) prev_fit.reset();
 
                             //Provide a prediction time.
-                            if(Actual_Operation_Count > 0.5){
-                                boost::posix_time::ptime current_t = boost::posix_time::microsec_clock::local_time();
-                                auto elapsed_dt = (current_t - start_t).total_milliseconds();
-                                auto expected_dt_f = static_cast<double>(elapsed_dt) * (Expected_Operation_Count/Actual_Operation_Count);
-                                auto expected_dt = static_cast<long int>(expected_dt_f);
-                                boost::posix_time::ptime predicted_dt( start_t + boost::posix_time::milliseconds(expected_dt) );
-                                FUNCINFO("Progress: " 
-                                    << Actual_Operation_Count << "/" << Expected_Operation_Count << " = " 
-                                    << static_cast<double>(static_cast<size_t>(1000.0*Actual_Operation_Count/Expected_Operation_Count))/10.0 
-                                    << "%. Expected finish time: " << predicted_dt);
+                            {
+                                std::lock_guard<std::mutex> lock(shared_mutex);
+                                if(Actual_Operation_Count > 0.5){
+                                    boost::posix_time::ptime current_t = boost::posix_time::microsec_clock::local_time();
+                                    auto elapsed_dt = (current_t - start_t).total_milliseconds();
+                                    auto expected_dt_f = static_cast<double>(elapsed_dt) * (Expected_Operation_Count/Actual_Operation_Count);
+                                    auto expected_dt = static_cast<long int>(expected_dt_f);
+                                    boost::posix_time::ptime predicted_dt( start_t + boost::posix_time::milliseconds(expected_dt) );
+                                    FUNCINFO("Progress: " 
+                                        << Actual_Operation_Count << "/" << Expected_Operation_Count << " = " 
+                                        << static_cast<double>(static_cast<size_t>(1000.0*Actual_Operation_Count/Expected_Operation_Count))/10.0 
+                                        << "%. Expected finish time: " << predicted_dt);
+                                }
+                                Actual_Operation_Count += 1.0;
                             }
-                            Actual_Operation_Count += 1.0;
 
                             //Cycle over the grouped images (temporal slices, or whatever the user has decided).
                             // Harvest the time course or any other voxel-specific numbers.
-                            auto channel_time_course = std::make_shared<samples_1D<double>>();
+                            channel_time_course->samples.clear();
                             channel_time_course->uncertainties_known_to_be_independent_and_random = true;
+                            auto dt_it = std::begin(img_dts);
                             for(auto & img_it : selected_img_its){
                                 //Collect the datum of voxels and nearby voxels for an average.
                                 std::list<double> in_pixs;
@@ -329,28 +335,26 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
                                         //Check if the coordinates are legal and in the ROI.
                                         if( !isininc(0,lrow,img_it->rows-1) || !isininc(0,lcol,img_it->columns-1) ) continue;
     
-                                        //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
-                                        //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
                                         const auto neighbourpoint = first_img_it->position(lrow,lcol);
-                                        auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
-                                        if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                        ProjectedNeighbourPoint,
-                                                                                                        AlreadyProjected)) continue;
+                                        auto ProjectedNeighbourPoint = pc.BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
+                                        if(!pc.ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(pc.BestFitPlane,
+                                                                                                           ProjectedNeighbourPoint,
+                                                                                                           AlreadyProjected)) continue;
                                         const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
                                         in_pixs.push_back(val);
                                     }
                                 }
-                                auto dt = img_it->GetMetadataValueAs<double>("dt");
-                                if(!dt) FUNCERR("Image is missing time metadata. Bailing");
+                                const auto dt = *(dt_it++);
 
                                 const auto avg_val = Stats::Mean(in_pixs);
                                 if(in_pixs.size() < min_datum) continue; //If contours are too narrow so that there is too few datum for meaningful results.
-                                //const auto avg_val_sigma = std::sqrt(Stats::Unbiased_Var_Est(in_pixs))/std::sqrt(1.0*in_pixs.size());
-                                //channel_time_course.push_back(dt.value(), 0.0, avg_val, avg_val_sigma, InhibitSort);
-                                channel_time_course->push_back(dt.value(), 0.0, avg_val, 0.0, InhibitSort);
+                                channel_time_course->push_back(dt, 0.0, avg_val, 0.0, InhibitSort);
                             }
                             channel_time_course->stable_sort();
-                            if(channel_time_course->empty()) continue;
+                            if(channel_time_course->empty()){
+                                prev_fit.reset();
+                                continue;
+                            }
   
                             //Correct any unaccounted-for contrast enhancement shifts. 
                             // (If we don't do this, the optimizer goes crazy because the model has to be zero at t=0.)
@@ -375,18 +379,16 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
                             // This routine fits a pharmacokinetic model to the observed liver perfusion data using a 
                             // Chebyshev polynomial approximation scheme.
 
-                            model_state.FittingPerformed = false;
-                            model_state.cROI = channel_time_course;
-                            model_state.k1A  = std::numeric_limits<double>::quiet_NaN();
-                            model_state.tauA = std::numeric_limits<double>::quiet_NaN();
-                            model_state.k1V  = std::numeric_limits<double>::quiet_NaN();
-                            model_state.tauV = std::numeric_limits<double>::quiet_NaN();
-                            model_state.k2   = std::numeric_limits<double>::quiet_NaN();
-
-                            //KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters after_state = Optimize_LevenbergMarquardt_3Param(model_state);
-                            KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters after_state = Optimize_LevenbergMarquardt_5Param(model_state);
+                            l_model_state.FittingPerformed = false;
+                            l_model_state.cROI = channel_time_course;
+                            l_model_state.k1A  = (prev_fit) ? prev_fit->k1A  : std::numeric_limits<double>::quiet_NaN();
+                            l_model_state.tauA = (prev_fit) ? prev_fit->tauA : std::numeric_limits<double>::quiet_NaN();
+                            l_model_state.k1V  = (prev_fit) ? prev_fit->k1V  : std::numeric_limits<double>::quiet_NaN();
+                            l_model_state.tauV = (prev_fit) ? prev_fit->tauV : std::numeric_limits<double>::quiet_NaN();
+                            l_model_state.k2   = (prev_fit) ? prev_fit->k2   : std::numeric_limits<double>::quiet_NaN();
 
-                            if(!after_state.FittingSuccess) ++Minimization_Failure_Count;
+                            //KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters after_state = Optimize_LevenbergMarquardt_3Param(l_model_state);
+                            KineticModel_1Compartment2Input_5Param_Chebyshev_Parameters after_state = Optimize_LevenbergMarquardt_5Param(l_model_state);
 
                             const double RSS  = after_state.RSS;
                             const double k1A  = after_state.k1A;
@@ -394,14 +396,37 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
                             const double k1V  = after_state.k1V;
                             const double tauV = after_state.tauV;
                             const double k2   = after_state.k2;
+
+                            if( after_state.FittingSuccess
+                            &&  std::isfinite(k1A) && std::isfinite(tauA)
+                            &&  std::isfinite(k1V) && std::isfinite(tauV)
+                            &&  std::isfinite(k2) ){
+                                prev_fit = after_state;
+                            }else{
+                                prev_fit.reset();
+                            }
+
+                            //Update pixel values. Voxels are fitted exactly once, so no other task will write them.
+                            const auto k1A_f  = static_cast<float>(k1A);
+                            const auto tauA_f = static_cast<float>(tauA);
+                            const auto k1V_f  = static_cast<float>(k1V);
+                            const auto tauV_f = static_cast<float>(tauV);
+                            const auto k2_f   = static_cast<float>(k2);
+
+                            {
+                                out_img_k1A.get().reference(row, col, chan)  = k1A_f;
+                                out_img_tauA.get().reference(row, col, chan) = tauA_f;
+                                out_img_k1V.get().reference(row, col, chan)  = k1V_f;
+                                out_img_tauV.get().reference(row, col, chan) = tauV_f;
+                                out_img_k2.get().reference(row, col, chan)   = k2_f;
+                            }
+
+                            std::lock_guard<std::mutex> lock(shared_mutex);
+                            if(!after_state.FittingSuccess) ++Minimization_Failure_Count;
+
                             if(true) FUNCINFO("k1A,tauA,k1V,tauV,k2,RSS = " << k1A << ", " << tauA << ", " 
                                               << k1V << ", " << tauV << ", " << k2 << ", " << RSS);
 
-                            const auto LiverPerfusion = (k1A + k1V);
-                            const auto MeanTransitTime = 1.0 / k2;
-                            const auto ArterialFraction = 100.0 * k1A / LiverPerfusion;
-                            const auto DistributionVolume = 100.0 * LiverPerfusion * MeanTransitTime;
-
                             //==============================================================================
                             // Plot the fitted model with the ROI time course.
                             if(PixelsToPlot.count( {row, col}) != 0){ 
@@ -422,46 +447,23 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_LevenbergMarquardt(planar_image_collect
 
                                 PlotTimeCourses("Raw ROI and Fitted Model", time_courses, {});
                             }
-                            
                             //==============================================================================
- 
-                            //Update pixel values.
-                            const auto k1A_f  = static_cast<float>(k1A);
-                            const auto tauA_f = static_cast<float>(tauA);
-                            const auto k1V_f  = static_cast<float>(k1V);
-                            const auto tauV_f = static_cast<float>(tauV);
-                            const auto k2_f   = static_cast<float>(k2);
 
                             minmax_k1A.Digest(k1A_f);
                             minmax_tauA.Digest(tauA_f);
                             minmax_k1V.Digest(k1V_f);
                             minmax_tauV.Digest(tauV_f);
                             minmax_k2.Digest(k2_f);
-
-                            {
-                                out_img_k1A.get().reference(row, col, chan)  = k1A_f;
-                                out_img_tauA.get().reference(row, col, chan) = tauA_f;
-                                out_img_k1V.get().reference(row, col, chan)  = k1V_f;
-                                out_img_tauV.get().reference(row, col, chan) = tauV_f;
-                                out_img_k2.get().reference(row, col, chan)   = k2_f;
-                            }
-                            // ----------------------------------------------------------------------------
-    
                         }//Loop over channels.
-    
-                    //If we're in the bounding box but not the ROI, do something.
-                    }else{
-                        //for(auto chan = 0; chan < first_img_it->channels; ++chan){
-                        //    const auto curr_val = working.value(row, col, chan);
-                        //    if(curr_val != 0) FUNCERR("There are overlapping ROI bboxes. This code currently cannot handle this. "
-                        //                              "You will need to run the functor individually on the overlapping ROIs.");
-                        //    working.reference(row, col, chan) = static_cast<float>(10);
-                        //}
-                    } // If is in ROI or ROI bbox.
-                } //Loop over cols
-            } //Loop over rows
-        } //Loop over ROIs.
-    } //Loop over contour_collections.
+                    } //Loop over cols
+                }catch(const std::exception &){
+                    std::lock_guard<std::mutex> lock(shared_mutex);
+                    if(!error) error = std::current_exception();
+                }
+            }); // thread pool task closure.
+        } //Loop over rows
+    } // Wait until all threads are done.
+    if(error) std::rethrow_exception(error);
 
     FUNCWARN("Minimization failure count: " << Minimization_Failure_Count);
 
@@ -1,16 +1,46 @@
 
+#include <algorithm>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 
 #include "../ConvenienceRoutines.h"
+#include "../ROI_Mask_Cache.h"
 #include "Partitioned_Image_Voxel_Visitor_Mutator.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
 
 template <class T> class contour_collection;
 
+//Compares the contour data covered by ROI_Voxel_Mask_Contours_Hash(). Vertices are compared exactly.
+static bool same_contour_vertices(const std::list<std::reference_wrapper<contour_collection<double>>> &A,
+                                  const std::list<contour_collection<double>> &B){
+    if(A.size() != B.size()) return false;
+    auto B_it = std::begin(B);
+    for(const auto &cc_refw : A){
+        const auto &A_cs = cc_refw.get().contours;
+        const auto &B_cs = (B_it++)->contours;
+        if(A_cs.size() != B_cs.size()) return false;
+        auto Bc_it = std::begin(B_cs);
+        for(const auto &a : A_cs){
+            const auto &b = *(Bc_it++);
+            if( (a.closed != b.closed)
+            ||  !std::equal(std::begin(a.points), std::end(a.points), std::begin(b.points), std::end(b.points),
+                            [](const vec3<double> &p, const vec3<double> &q){
+                                return (p.x == q.x) && (p.y == q.y) && (p.z == q.z);
+                            }) ){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 bool PartitionedImageVoxelVisitorMutator(planar_image_collection<float,double>::images_list_it_t first_img_it,
                         std::list<planar_image_collection<float,double>::images_list_it_t> selected_img_its,
                         std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
@@ -44,16 +74,74 @@ bool PartitionedImageVoxelVisitorMutator(planar_image_collection<float,double>::
         throw std::invalid_argument("No contours provided. Cannot continue");
     }
 
-    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
-    for(auto &img_it : selected_img_its) selected_imgs.push_back( std::ref(*img_it) );
-
-    Mutate_Voxels<float,double>( std::ref(*first_img_it),
-                                 selected_imgs, 
-                                 ccsl, 
-                                 user_data_s->mutation_opts, 
-                                 user_data_s->f_bounded,
-                                 user_data_s->f_unbounded,
-                                 user_data_s->f_visitor );
+    //When each voxel is only mutated using its own value, the voxels bounded by the contours can be looked up in a
+    // shared cache rather than re-testing them against the contours. Otherwise, defer entirely to Mutate_Voxels().
+    const auto &opts = user_data_s->mutation_opts;
+    if( (opts.editstyle == Mutate_Voxels_Opts::EditStyle::InPlace)
+    &&  (opts.aggregate == Mutate_Voxels_Opts::Aggregate::First)
+    &&  (opts.adjacency == Mutate_Voxels_Opts::Adjacency::SingleVoxel)
+    &&  (selected_img_its.size() == 1)
+    &&  (selected_img_its.front() == first_img_it) ){
+        //The contours are hashed once and shared by all images, since hashing visits every vertex. A memoized hash is
+        // only used if the contours exactly match the copy that was hashed.
+        using hashed_contours_t = PartitionedImageVoxelVisitorMutatorUserData::hashed_contours;
+        auto &memo = *(user_data_s->contours_hash);
+        std::shared_ptr<const hashed_contours_t> hashed;
+        {
+            std::lock_guard<std::mutex> lock(memo.m);
+            hashed = memo.latest;
+        }
+        if( (hashed == nullptr) || !same_contour_vertices(ccsl, hashed->ccs) ){
+            auto rehashed = std::make_shared<hashed_contours_t>();
+            for(const auto &cc_refw : ccsl) rehashed->ccs.push_back( cc_refw.get() );
+            rehashed->hash = ROI_Voxel_Mask_Contours_Hash(ccsl);
+            hashed = rehashed;
+
+            std::lock_guard<std::mutex> lock(memo.m);
+            memo.latest = hashed;
+        }
+        const auto contours_hash = hashed->hash;
+
+        auto &img = *first_img_it;
+        const auto mask = Get_ROI_Voxel_Mask(img, ccsl, contours_hash, opts);
+
+        //Voxels are visited in the same order as Mutate_Voxels(): the bounded or unbounded functor is applied, then
+        // the visitor, and then the value is written back.
+        auto run_it = std::begin(mask->runs);
+        const auto run_end = std::end(mask->runs);
+        for(long int row = 0; row < img.rows; ++row){
+            for(long int col = 0; col < img.columns; ++col){
+                while( (run_it != run_end)
+                   &&  ( (run_it->row < row) || ((run_it->row == row) && (run_it->col_end <= col)) ) ) ++run_it;
+                const bool is_bounded = (run_it != run_end)
+                                     && (run_it->row == row)
+                                     && (run_it->col_begin <= col);
+
+                for(long int chan = 0; chan < img.channels; ++chan){
+                    float v = img.value(row, col, chan);
+                    if(is_bounded){
+                        if(user_data_s->f_bounded) user_data_s->f_bounded(row, col, chan, std::ref(img), v);
+                    }else{
+                        if(user_data_s->f_unbounded) user_data_s->f_unbounded(row, col, chan, std::ref(img), v);
+                    }
+                    if(user_data_s->f_visitor) user_data_s->f_visitor(row, col, chan, std::ref(img), v);
+                    img.reference(row, col, chan) = v;
+                }
+            }
+        }
+
+    }else{
+        std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+        for(auto &img_it : selected_img_its) selected_imgs.push_back( std::ref(*img_it) );
+
+        Mutate_Voxels<float,double>( std::ref(*first_img_it),
+                                     selected_imgs, 
+                                     ccsl, 
+                                     user_data_s->mutation_opts, 
+                                     user_data_s->f_bounded,
+                                     user_data_s->f_unbounded,
+                                     user_data_s->f_visitor );
+    }
 
 
     //Alter the first image's metadata to reflect that averaging has occurred. You might want to consider
@@ -4,11 +4,15 @@
 
 #include <cmath>
 #include <any>
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <vector>
 
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -27,6 +31,19 @@ struct PartitionedImageVoxelVisitorMutatorUserData {
     std::function<void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &)> f_visitor;   // Applied to all voxels.
     
     std::string description; // If non-empty, used to update image metadata.
+
+    // The hash of the contours used to look up cached ROI masks. It is computed once and shared by all invocations
+    // using this struct. Each invocation compares its contours with a copy of the hashed contours, which avoids
+    // rehashing, and the hash is recomputed whenever they differ.
+    struct hashed_contours {
+        std::list<contour_collection<double>> ccs;
+        uint64_t hash = 0;
+    };
+    struct contours_hash_memo {
+        std::mutex m;
+        std::shared_ptr<const hashed_contours> latest;
+    };
+    std::shared_ptr<contours_hash_memo> contours_hash = std::make_shared<contours_hash_memo>();
 };
 
 
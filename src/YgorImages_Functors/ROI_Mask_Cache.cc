@@ -0,0 +1,215 @@
+//ROI_Mask_Cache.cc.
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+#include "ROI_Mask_Cache.h"
+
+
+size_t roi_voxel_mask::memory_usage() const {
+    return sizeof(*this) + this->runs.capacity() * sizeof(run);
+}
+
+
+namespace {
+
+// Scrambles the bits of a 64-bit word (the SplitMix64 finalizer).
+uint64_t mix_bits(uint64_t x){
+    x ^= (x >> 30);
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= (x >> 27);
+    x *= 0x94d049bb133111ebULL;
+    x ^= (x >> 31);
+    return x;
+}
+
+uint64_t hash_combine(uint64_t h, uint64_t x){
+    return (h ^ mix_bits(x)) * 0x100000001b3ULL;
+}
+
+uint64_t hash_combine(uint64_t h, double x){
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return hash_combine(h, bits);
+}
+
+uint64_t hash_combine(uint64_t h, const vec3<double> &v){
+    return hash_combine(hash_combine(hash_combine(h, v.x), v.y), v.z);
+}
+
+uint64_t contours_hash(const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl){
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for(const auto &cc_refw : ccsl){
+        h = hash_combine(h, static_cast<uint64_t>(cc_refw.get().contours.size()));
+        for(const auto &c : cc_refw.get().contours){
+            h = hash_combine(h, static_cast<uint64_t>(c.closed));
+            h = hash_combine(h, static_cast<uint64_t>(c.points.size()));
+            for(const auto &p : c.points) h = hash_combine(h, p);
+        }
+    }
+    return h;
+}
+
+uint64_t geometry_hash(const planar_image<float,double> &img){
+    uint64_t h = 0xcbf29ce484222325ULL;
+    h = hash_combine(h, img.pxl_dx);
+    h = hash_combine(h, img.pxl_dy);
+    h = hash_combine(h, img.pxl_dz);
+    h = hash_combine(h, img.anchor);
+    h = hash_combine(h, img.offset);
+    h = hash_combine(h, img.row_unit);
+    h = hash_combine(h, img.col_unit);
+    return h;
+}
+
+using mask_key_t = std::tuple<uint64_t,  // Contour hash.
+                              uint64_t,  // Image geometry hash.
+                              long int,  // Image rows.
+                              long int,  // Image columns.
+                              int,       // Inclusivity.
+                              int,       // Contour overlap.
+                              int>;      // Mask modification.
+
+class roi_voxel_mask_cache {
+    private:
+        std::mutex m;
+        const size_t budget = 256UL * 1024UL * 1024UL; // Approximate, in bytes.
+        size_t usage = 0;
+
+        // Most recently used first.
+        std::list<std::pair<mask_key_t, std::shared_ptr<const roi_voxel_mask>>> lru;
+        std::map<mask_key_t, decltype(lru)::iterator> index;
+
+        void evict(){
+            while( (this->budget < this->usage) && !this->lru.empty() ){
+                const auto &last = this->lru.back();
+                this->usage -= last.second->memory_usage();
+                this->index.erase(last.first);
+                this->lru.pop_back();
+            }
+            return;
+        }
+
+    public:
+        std::shared_ptr<const roi_voxel_mask> find(const mask_key_t &key){
+            std::lock_guard<std::mutex> lock(this->m);
+            const auto it = this->index.find(key);
+            if(it == std::end(this->index)) return nullptr;
+            this->lru.splice(std::begin(this->lru), this->lru, it->second);
+            return it->second->second;
+        }
+
+        void insert(const mask_key_t &key, const std::shared_ptr<const roi_voxel_mask> &mask){
+            std::lock_guard<std::mutex> lock(this->m);
+            if(this->index.count(key) != 0) return; // Computed concurrently by another thread.
+            this->lru.emplace_front(key, mask);
+            this->index[key] = std::begin(this->lru);
+            this->usage += mask->memory_usage();
+            this->evict();
+            return;
+        }
+};
+
+roi_voxel_mask_cache & ROI_Voxel_Mask_Cache(){
+    static roi_voxel_mask_cache cache;
+    return cache;
+}
+
+} // namespace.
+
+
+std::shared_ptr<const roi_voxel_mask>
+Get_ROI_Voxel_Mask(const planar_image<float,double> &img,
+                   const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                   const Mutate_Voxels_Opts &opts){
+    return Get_ROI_Voxel_Mask(img, ccsl, contours_hash(ccsl), opts);
+}
+
+std::shared_ptr<const roi_voxel_mask>
+Get_ROI_Voxel_Mask(const planar_image<float,double> &img,
+                   const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                   uint64_t contours_hash,
+                   const Mutate_Voxels_Opts &opts){
+
+    const mask_key_t key( contours_hash,
+                          geometry_hash(img),
+                          img.rows,
+                          img.columns,
+                          static_cast<int>(opts.inclusivity),
+                          static_cast<int>(opts.contouroverlap),
+                          static_cast<int>(opts.maskmod) );
+    auto &cache = ROI_Voxel_Mask_Cache();
+    if(auto mask = cache.find(key)) return mask;
+
+    // Defer to Mutate_Voxels() using a single-channel scratch image with the same geometry so that the bounding
+    // semantics are identical.
+    planar_image<float,double> scratch;
+    scratch.init_orientation(img.row_unit, img.col_unit);
+    scratch.init_buffer(img.rows, img.columns, 1);
+    scratch.init_spatial(img.pxl_dx, img.pxl_dy, img.pxl_dz, img.anchor, img.offset);
+
+    Mutate_Voxels_Opts scratch_opts;
+    scratch_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
+    scratch_opts.aggregate      = Mutate_Voxels_Opts::Aggregate::First;
+    scratch_opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+    scratch_opts.maskmod        = opts.maskmod;
+    scratch_opts.contouroverlap = opts.contouroverlap;
+    scratch_opts.inclusivity    = opts.inclusivity;
+
+    std::vector<uint8_t> bounded(static_cast<size_t>(img.rows * img.columns), 0);
+    const auto f_bounded = [&](long int row, long int col, long int, std::reference_wrapper<planar_image<float,double>>, float &){
+        bounded[static_cast<size_t>(row * img.columns + col)] = 1;
+    };
+
+    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+    selected_imgs.push_back( std::ref(scratch) );
+    Mutate_Voxels<float,double>( std::ref(scratch),
+                                 selected_imgs,
+                                 ccsl,
+                                 scratch_opts,
+                                 f_bounded,
+                                 {},
+                                 {} );
+
+    // Run-length encode the mask.
+    auto mask = std::make_shared<roi_voxel_mask>();
+    mask->rows = img.rows;
+    mask->columns = img.columns;
+    for(long int row = 0; row < img.rows; ++row){
+        const auto *r = &bounded[static_cast<size_t>(row * img.columns)];
+        for(long int col = 0; col < img.columns; ){
+            if(r[col] == 0){
+                ++col;
+                continue;
+            }
+            const auto col_begin = col;
+            while( (col < img.columns) && (r[col] != 0) ) ++col;
+            mask->runs.push_back( { static_cast<int32_t>(row),
+                                    static_cast<int32_t>(col_begin),
+                                    static_cast<int32_t>(col) } );
+        }
+    }
+    mask->runs.shrink_to_fit();
+
+    std::shared_ptr<const roi_voxel_mask> out = mask;
+    cache.insert(key, out);
+    return out;
+}
+
+uint64_t ROI_Voxel_Mask_Contours_Hash(const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl){
+    return contours_hash(ccsl);
+}
+
@@ -0,0 +1,55 @@
+//ROI_Mask_Cache.h.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+
+// A binary mask indicating which voxels of an image are bounded by a set of ROI contours.
+//
+// Bounded voxels are stored as runs along each row, which is compact for typical ROIs.
+struct roi_voxel_mask {
+    struct run {
+        int32_t row;
+        int32_t col_begin; // Inclusive.
+        int32_t col_end;   // Exclusive.
+    };
+
+    long int rows = 0;
+    long int columns = 0;
+    std::vector<run> runs; // Sorted by row and then column. Runs do not overlap.
+
+    size_t memory_usage() const;
+};
+
+
+// Returns the mask of voxels bounded by the contours, exactly as determined by Mutate_Voxels() using the inclusivity,
+// contour overlap, and mask modification options. All other options are ignored.
+//
+// Masks are cached process-wide and keyed on the contour vertices, the image geometry, and the relevant options, so
+// repeated queries (e.g., by separate operations in a pipeline) are only computed once. The cache holds no references
+// to contours or images, so modifying either simply results in a cache miss. Least-recently used masks are evicted once
+// the cache holds roughly 256 MiB. This routine is thread-safe.
+std::shared_ptr<const roi_voxel_mask>
+Get_ROI_Voxel_Mask(const planar_image<float,double> &img,
+                   const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                   const Mutate_Voxels_Opts &opts);
+
+// As above, but using a hash of the contours precomputed by ROI_Voxel_Mask_Contours_Hash(). Hashing the contours
+// visits every vertex, so callers requesting masks for many images using the same contours should hash them once.
+std::shared_ptr<const roi_voxel_mask>
+Get_ROI_Voxel_Mask(const planar_image<float,double> &img,
+                   const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+                   uint64_t contours_hash,
+                   const Mutate_Voxels_Opts &opts);
+
+// Returns the hash of the contour vertices used to key cached masks.
+uint64_t ROI_Voxel_Mask_Contours_Hash(const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl);
+
@@ -2,6 +2,8 @@
 #include <limits>
 #include <utility>
 #include <iostream>
+#include <cmath>
+#include <chrono>
 
 #include "YgorMath.h"
 
@@ -44,3 +46,133 @@ TEST_CASE( "thin_plate_spline class" ){
     }
 }
 
+
+#ifdef DCMA_USE_EIGEN
+TEST_CASE( "AlignViaTPSRPM scalable options" ){
+    // An asymmetric lattice and a smoothly warped copy, with the order of points reversed so the correspondence is
+    // not trivially the identity.
+    point_set<double> ps_moving;
+    for(long int i = 0; i < 6; ++i){
+        for(long int j = 0; j < 5; ++j){
+            for(long int k = 0; k < 4; ++k){
+                ps_moving.points.emplace_back( vec3<double>( 1.0 * i + 0.1 * j,
+                                                             1.3 * j + 0.05 * k * k,
+                                                             0.9 * k + 0.02 * i * j ) );
+            }
+        }
+    }
+    point_set<double> ps_stationary;
+    for(auto it = ps_moving.points.rbegin(); it != ps_moving.points.rend(); ++it){
+        const auto &p = *it;
+        ps_stationary.points.emplace_back( vec3<double>( p.x + 0.2 * std::sin(0.3 * p.y),
+                                                         p.y + 0.1 * std::cos(0.4 * p.z),
+                                                         p.z + 0.15 ) );
+    }
+    const auto N_moving = static_cast<long int>(ps_moving.points.size());
+
+    AlignViaTPSRPMParams params;
+    params.T_step = 0.85;
+    params.N_iters_at_fixed_T = 3;
+
+    SUBCASE("a distant cutoff and all control points reproduce the dense result"){
+        auto params_dense = params;
+        const auto t_dense = AlignViaTPSRPM(params_dense, ps_moving, ps_stationary);
+        REQUIRE( t_dense );
+
+        auto params_trunc = params;
+        params_trunc.softassign_cutoff = 1.0E6;
+        params_trunc.N_control_points = N_moving;
+        const auto t_trunc = AlignViaTPSRPM(params_trunc, ps_moving, ps_stationary);
+        REQUIRE( t_trunc );
+
+        REQUIRE( t_dense.value().W_A.num_rows() == t_trunc.value().W_A.num_rows() );
+        REQUIRE( t_dense.value().W_A.num_cols() == t_trunc.value().W_A.num_cols() );
+        for(long int r = 0; r < t_dense.value().W_A.num_rows(); ++r){
+            for(long int c = 0; c < t_dense.value().W_A.num_cols(); ++c){
+                REQUIRE( t_dense.value().W_A.read_coeff(r, c) == t_trunc.value().W_A.read_coeff(r, c) );
+            }
+        }
+    }
+
+    SUBCASE("control points, truncation, warm starts, and the conjugate gradient solver"){
+        const long int N_ctrl = 20;
+        params.N_control_points = N_ctrl;
+        params.softassign_cutoff = 3.0;
+        params.Sinkhorn_warm_start = true;
+        params.solution_method = AlignViaTPSRPMParams::SolutionMethod::ConjugateGradient;
+
+        const auto t1 = std::chrono::steady_clock::now();
+        const auto t_opt = AlignViaTPSRPM(params, ps_moving, ps_stationary);
+        const auto t2 = std::chrono::steady_clock::now();
+        MESSAGE( "Scalable TPS-RPM took " << std::chrono::duration<double>(t2 - t1).count() << " s" );
+        REQUIRE( t_opt );
+
+        const auto &t = t_opt.value();
+        REQUIRE( static_cast<long int>(t.control_points.points.size()) == N_ctrl );
+        REQUIRE( t.W_A.num_rows() == (N_ctrl + 4) );
+        for(const auto &p : ps_moving.points){
+            const auto p_t = t.transform(p);
+            REQUIRE( p_t.isfinite() );
+        }
+    }
+}
+
+TEST_CASE( "AlignViaTPSRPM scalable options with large point sets" ){
+    // A unit-spaced lattice and a smoothly warped copy. The warp is small compared to the lattice spacing, so the true
+    // correspondence is known: the order of points is reversed.
+    point_set<double> ps_moving;
+    for(long int i = 0; i < 10; ++i){
+        for(long int j = 0; j < 10; ++j){
+            for(long int k = 0; k < 12; ++k){
+                ps_moving.points.emplace_back( vec3<double>( 1.0 * i, 1.0 * j, 1.0 * k ) );
+            }
+        }
+    }
+    point_set<double> ps_stationary;
+    for(auto it = ps_moving.points.rbegin(); it != ps_moving.points.rend(); ++it){
+        const auto &p = *it;
+        ps_stationary.points.emplace_back( vec3<double>( p.x + 0.2 * std::sin(0.3 * p.y),
+                                                         p.y + 0.1 * std::cos(0.4 * p.z),
+                                                         p.z + 0.15 ) );
+    }
+    const auto N = static_cast<long int>(ps_moving.points.size());
+    REQUIRE( N == 1200 );
+
+    const long int N_ctrl = 64;
+    AlignViaTPSRPMParams params;
+    params.T_step = 0.85;
+    params.N_iters_at_fixed_T = 3;
+    params.N_control_points = N_ctrl;
+    params.softassign_cutoff = 3.0;
+    params.Sinkhorn_warm_start = true;
+    params.solution_method = AlignViaTPSRPMParams::SolutionMethod::ConjugateGradient;
+    params.report_final_correspondence = true;
+
+    const auto t1 = std::chrono::steady_clock::now();
+    const auto t_opt = AlignViaTPSRPM(params, ps_moving, ps_stationary);
+    const auto t2 = std::chrono::steady_clock::now();
+    MESSAGE( "Scalable TPS-RPM with " << N << " points took " << std::chrono::duration<double>(t2 - t1).count() << " s" );
+    REQUIRE( t_opt );
+
+    const auto &t = t_opt.value();
+    REQUIRE( static_cast<long int>(t.control_points.points.size()) == N_ctrl );
+    REQUIRE( t.W_A.num_rows() == (N_ctrl + 4) );
+
+    // The recovered correspondence should be (nearly) exact.
+    REQUIRE( static_cast<long int>(params.final_move_correspondence.size()) == N );
+    long int N_correct = 0;
+    for(const auto &c : params.final_move_correspondence){
+        if(c.second == (N - 1 - c.first)) ++N_correct;
+    }
+    REQUIRE( 0.95 * static_cast<double>(N) <= static_cast<double>(N_correct) );
+
+    // The warped moving points should land near their counterparts, well within the lattice spacing.
+    double mean_err = 0.0;
+    for(long int i = 0; i < N; ++i){
+        const auto p_t = t.transform(ps_moving.points[i]);
+        REQUIRE( p_t.isfinite() );
+        mean_err += p_t.distance(ps_stationary.points[N - 1 - i]) / static_cast<double>(N);
+    }
+    REQUIRE( mean_err < 0.1 );
+}
+#endif // DCMA_USE_EIGEN
@@ -0,0 +1,132 @@
+
+#include <utility>
+#include <iostream>
+#include <functional>
+#include <cmath>
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "YgorMath.h"
+#include "YgorImages.h"
+
+#include "Scanline_Rasterizer.h"
+
+
+// A 4x4 image with unit voxels and voxel (r,c) centred at (x,y,z) = (r,c,0).
+static planar_image<float,double> make_image(){
+    planar_image<float,double> img;
+    img.init_orientation( vec3<double>(1.0, 0.0, 0.0), vec3<double>(0.0, 1.0, 0.0) );
+    img.init_buffer(4, 4, 1);
+    img.init_spatial(1.0, 1.0, 1.0, vec3<double>(0.0, 0.0, 0.0), vec3<double>(0.0, 0.0, 0.0));
+    return img;
+}
+
+// An axis-aligned square contour spanning [lo, hi] along both rows and columns.
+static contour_of_points<double> make_square(double lo, double hi){
+    contour_of_points<double> c;
+    c.closed = true;
+    c.points.emplace_back( vec3<double>(lo, lo, 0.0) );
+    c.points.emplace_back( vec3<double>(hi, lo, 0.0) );
+    c.points.emplace_back( vec3<double>(hi, hi, 0.0) );
+    c.points.emplace_back( vec3<double>(lo, hi, 0.0) );
+    return c;
+}
+
+static std::vector<std::vector<double>> fractions(const contour_raster &raster){
+    std::vector<std::vector<double>> out(4, std::vector<double>(4, 0.0));
+    for(long int r = 0; r < 4; ++r){
+        for(long int c = 0; c < 4; ++c){
+            out[r][c] = raster.fraction(r, c);
+        }
+    }
+    return out;
+}
+
+
+TEST_CASE( "Rasterize_Contour" ){
+    const auto img = make_image();
+
+    // Voxel centres 1 and 2 lie within [0.75, 2.25), but no voxel is wholly covered.
+    const auto square = make_square(0.75, 2.25);
+
+    SUBCASE("spans include voxels with interior centres"){
+        const auto raster = Rasterize_Contour(img, square);
+        REQUIRE( raster.spans.size() == 2 );
+        REQUIRE( raster.spans[0].row == 1 );
+        REQUIRE( raster.spans[0].col_begin == 1 );
+        REQUIRE( raster.spans[0].col_end == 3 );
+        REQUIRE( raster.spans[1].row == 2 );
+        REQUIRE( raster.spans[1].col_begin == 1 );
+        REQUIRE( raster.spans[1].col_end == 3 );
+        REQUIRE( raster.coverage.empty() );
+
+        REQUIRE( fractions(raster) == std::vector<std::vector<double>>({ { 0.0, 0.0, 0.0, 0.0 },
+                                                                         { 0.0, 1.0, 1.0, 0.0 },
+                                                                         { 0.0, 1.0, 1.0, 0.0 },
+                                                                         { 0.0, 0.0, 0.0, 0.0 } }) );
+    }
+
+    SUBCASE("fractional coverage along the boundary"){
+        // Each covered voxel overlaps the square over 0.75 x 0.75. Four sub-scanlines resolve this exactly.
+        const auto raster = Rasterize_Contour(img, square, 4);
+        REQUIRE( raster.spans.size() == 2 );
+        REQUIRE( fractions(raster) == std::vector<std::vector<double>>({ { 0.0, 0.0,    0.0,    0.0 },
+                                                                         { 0.0, 0.5625, 0.5625, 0.0 },
+                                                                         { 0.0, 0.5625, 0.5625, 0.0 },
+                                                                         { 0.0, 0.0,    0.0,    0.0 } }) );
+    }
+
+    SUBCASE("degenerate contours are ignored"){
+        contour_of_points<double> line;
+        line.points.emplace_back( vec3<double>(0.0, 0.0, 0.0) );
+        line.points.emplace_back( vec3<double>(3.0, 3.0, 0.0) );
+        const auto raster = Rasterize_Contour(img, line, 4);
+        REQUIRE( raster.spans.empty() );
+        REQUIRE( raster.coverage.empty() );
+    }
+}
+
+TEST_CASE( "Rasterize_Contours" ){
+    const auto img = make_image();
+
+    // The squares cover voxels [0,1] x [0,1] and [1,2] x [1,2], respectively, and overlap at voxel (1,1).
+    const auto A = make_square(-0.5, 1.5);
+    const auto B = make_square(0.5, 2.5);
+    const std::vector<std::reference_wrapper<const contour_of_points<double>>> cs = { std::cref(A), std::cref(B) };
+
+    SUBCASE("overlapping contours are joined"){
+        const auto raster = Rasterize_Contours(img, cs, false, 4);
+        REQUIRE( raster.coverage.empty() );
+        REQUIRE( fractions(raster) == std::vector<std::vector<double>>({ { 1.0, 1.0, 0.0, 0.0 },
+                                                                         { 1.0, 1.0, 1.0, 0.0 },
+                                                                         { 0.0, 1.0, 1.0, 0.0 },
+                                                                         { 0.0, 0.0, 0.0, 0.0 } }) );
+    }
+
+    SUBCASE("overlapping contours cancel"){
+        const auto raster = Rasterize_Contours(img, cs, true, 4);
+        REQUIRE( raster.coverage.empty() );
+        REQUIRE( fractions(raster) == std::vector<std::vector<double>>({ { 1.0, 1.0, 0.0, 0.0 },
+                                                                         { 1.0, 0.0, 1.0, 0.0 },
+                                                                         { 0.0, 1.0, 1.0, 0.0 },
+                                                                         { 0.0, 0.0, 0.0, 0.0 } }) );
+    }
+
+    SUBCASE("fractional coverage of joined contours"){
+        // Shifting both squares by a quarter voxel leaves the corner voxels partially covered.
+        const auto C = make_square(-0.25, 1.75);
+        const auto D = make_square(0.75, 2.75);
+        const auto raster = Rasterize_Contours(img, { std::cref(C), std::cref(D) }, false, 4);
+
+        double area = 0.0;
+        for(const auto &row : fractions(raster)) for(const auto &f : row) area += f;
+        REQUIRE( area == 7.0 ); // Two 2x2 squares overlapping over 1x1.
+
+        REQUIRE( raster.fraction(0, 0) == 0.5625 );
+        REQUIRE( raster.fraction(1, 1) == 1.0 );
+        REQUIRE( raster.fraction(2, 2) == 1.0 );
+        REQUIRE( raster.fraction(3, 3) == 0.0625 );
+    }
+}
+
@@ -0,0 +1,135 @@
+
+#include <limits>
+#include <utility>
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "Texture_Matrices.h"
+
+
+// Returns the index of the direction with the given (row, column, image) offsets.
+static size_t direction_index(long int dr, long int dc, long int di){
+    const auto dirs = Texture_Directions();
+    for(size_t d = 0; d < dirs.size(); ++d){
+        if( (dirs[d][0] == dr) && (dirs[d][1] == dc) && (dirs[d][2] == di) ) return d;
+    }
+    REQUIRE( false );
+    return 0;
+}
+
+static void require_matrix(const texture_matrix &m, const std::vector<std::vector<double>> &expected){
+    REQUIRE( m.N_rows == static_cast<long int>(expected.size()) );
+    for(long int r = 0; r < m.N_rows; ++r){
+        REQUIRE( m.N_cols == static_cast<long int>(expected[r].size()) );
+        for(long int c = 0; c < m.N_cols; ++c){
+            REQUIRE( m.at(r, c) == expected[r][c] );
+        }
+    }
+}
+
+
+TEST_CASE( "Quantize_Intensities" ){
+    const auto nan = std::numeric_limits<float>::quiet_NaN();
+    const std::vector<float> intensities = { 0.0f, 1.0f, 2.0f, 3.0f, nan, 1.5f };
+
+    const auto vol = Quantize_Intensities(2, 3, 1, intensities, 4);
+    REQUIRE( vol.N_rows == 2 );
+    REQUIRE( vol.N_cols == 3 );
+    REQUIRE( vol.N_imgs == 1 );
+    REQUIRE( vol.N_levels == 4 );
+    REQUIRE( vol.levels == std::vector<int32_t>({ 0, 1, 2, 3, -1, 2 }) );
+
+    REQUIRE_THROWS( Quantize_Intensities(2, 2, 1, intensities, 4) );
+    REQUIRE_THROWS( Quantize_Intensities(2, 3, 1, intensities, 0) );
+}
+
+TEST_CASE( "texture matrices for a 4x4x1 volume" ){
+    // The grey levels are:
+    //
+    //   0 0 1 1
+    //   0 0 1 1
+    //   0 2 2 2
+    //   2 2 3 3
+    //
+    texture_volume vol;
+    vol.N_rows = 4;
+    vol.N_cols = 4;
+    vol.N_imgs = 1;
+    vol.N_levels = 4;
+    vol.levels = { 0, 0, 1, 1,
+                   0, 0, 1, 1,
+                   0, 2, 2, 2,
+                   2, 2, 3, 3 };
+
+    const auto d_row = direction_index(0, 1, 0); // Along a row.
+    const auto d_col = direction_index(1, 0, 0); // Along a column.
+    const auto d_img = direction_index(0, 0, 1); // Across images.
+
+    SUBCASE("GLCM"){
+        const auto glcms = Compute_GLCMs(vol);
+        REQUIRE( glcms.size() == 13 );
+        require_matrix( glcms[d_row], { { 4.0, 2.0, 1.0, 0.0 },
+                                        { 2.0, 4.0, 0.0, 0.0 },
+                                        { 1.0, 0.0, 6.0, 1.0 },
+                                        { 0.0, 0.0, 1.0, 2.0 } } );
+        require_matrix( glcms[d_col], { { 6.0, 0.0, 2.0, 0.0 },
+                                        { 0.0, 4.0, 2.0, 0.0 },
+                                        { 2.0, 2.0, 2.0, 2.0 },
+                                        { 0.0, 0.0, 2.0, 0.0 } } );
+        require_matrix( glcms[d_img], { { 0.0, 0.0, 0.0, 0.0 },
+                                        { 0.0, 0.0, 0.0, 0.0 },
+                                        { 0.0, 0.0, 0.0, 0.0 },
+                                        { 0.0, 0.0, 0.0, 0.0 } } );
+    }
+
+    SUBCASE("GLRLM"){
+        const auto glrlms = Compute_GLRLMs(vol);
+        REQUIRE( glrlms.size() == 13 );
+        require_matrix( glrlms[d_row], { { 1.0, 2.0, 0.0, 0.0 },
+                                         { 0.0, 2.0, 0.0, 0.0 },
+                                         { 0.0, 1.0, 1.0, 0.0 },
+                                         { 0.0, 1.0, 0.0, 0.0 } } );
+        require_matrix( glrlms[d_col], { { 0.0, 1.0, 1.0, 0.0 },
+                                         { 0.0, 2.0, 0.0, 0.0 },
+                                         { 3.0, 1.0, 0.0, 0.0 },
+                                         { 2.0, 0.0, 0.0, 0.0 } } );
+
+        // Every voxel is a run of length one across images.
+        require_matrix( glrlms[d_img], { { 5.0, 0.0, 0.0, 0.0 },
+                                         { 4.0, 0.0, 0.0, 0.0 },
+                                         { 5.0, 0.0, 0.0, 0.0 },
+                                         { 2.0, 0.0, 0.0, 0.0 } } );
+    }
+
+    SUBCASE("GLSZM"){
+        require_matrix( Compute_GLSZM(vol), { { 0.0, 0.0, 0.0, 0.0, 1.0 },
+                                              { 0.0, 0.0, 0.0, 1.0, 0.0 },
+                                              { 0.0, 0.0, 0.0, 0.0, 1.0 },
+                                              { 0.0, 1.0, 0.0, 0.0, 0.0 } } );
+    }
+
+    SUBCASE("voxels outside the ROI are ignored"){
+        vol.levels.back() = -1;
+
+        const auto glcms = Compute_GLCMs(vol);
+        require_matrix( glcms[d_row], { { 4.0, 2.0, 1.0, 0.0 },
+                                        { 2.0, 4.0, 0.0, 0.0 },
+                                        { 1.0, 0.0, 6.0, 1.0 },
+                                        { 0.0, 0.0, 1.0, 0.0 } } );
+
+        const auto glrlms = Compute_GLRLMs(vol);
+        require_matrix( glrlms[d_row], { { 1.0, 2.0, 0.0, 0.0 },
+                                         { 0.0, 2.0, 0.0, 0.0 },
+                                         { 0.0, 1.0, 1.0, 0.0 },
+                                         { 1.0, 0.0, 0.0, 0.0 } } );
+
+        require_matrix( Compute_GLSZM(vol), { { 0.0, 0.0, 0.0, 0.0, 1.0 },
+                                              { 0.0, 0.0, 0.0, 1.0, 0.0 },
+                                              { 0.0, 0.0, 0.0, 0.0, 1.0 },
+                                              { 1.0, 0.0, 0.0, 0.0, 0.0 } } );
+    }
+}
+
@@ -23,12 +23,16 @@ if [ ! -f doctest/doctest.h ] ; then
     wget -q 'https://raw.githubusercontent.com/onqtam/doctest/master/doctest/doctest.h' -O doctest/doctest.h
 fi
 
-g++ -std=c++17 -Wall -I. -I"${REPOROOT}/src" \
+g++ -std=c++17 -Wall -DDCMA_USE_EIGEN -I. -I"${REPOROOT}/src" \
   Main.cc \
   {,"${REPOROOT}/src/"}Alignment_TPSRPM.cc \
+  "${REPOROOT}/src/Alignment_Rigid.cc" \
+  {,"${REPOROOT}/src/"}Texture_Matrices.cc \
+  {,"${REPOROOT}/src/"}Scanline_Rasterizer.cc \
   -o run_tests \
   -pthread \
   -lboost_system \
+  -lboost_thread \
   -lygor
 
 ./run_tests #--success